@@ -15,6 +15,7 @@
 *           2014/01/27  1.7 fix bug on default output time format
 *-----------------------------------------------------------------------------*/
 #include <stdarg.h>
+#include <sys/stat.h>
 #include "rtklib.h"
 
 static const char rcsid[]="$Id: rnx2rtkp.c,v 1.1 2008/07/17 21:55:16 ttaka Exp $";
@@ -22,6 +23,49 @@ static const char rcsid[]="$Id: rnx2rtkp.c,v 1.1 2008/07/17 21:55:16 ttaka Exp $
 #define PROGNAME    "rnx2rtkp"          /* program name */
 #define MAXFILE     8                   /* max number of input files */
 #define SQR(x)      ((x)*(x))
+
+typedef struct {                        /* system frequency/pco mapping type */
+    int sys;                            /* navigation system (SYS_???) */
+    const char *name;                   /* system name of output file */
+    int maxprn;                         /* max prn number */
+    int lf1,lf2;                        /* wavelength index of iono-free LC */
+    int pf1,pf2;                        /* antenna pco index of iono-free LC */
+} sysmap_t;
+
+/* frequency/pco mapping of systems ------------------------------------------
+* iono-free LC of precise clocks. wavelength index is of nav->lam[] by
+* satwavelen() and pco index is of pcv_t off[] by antex frequency
+* {1,2,5,6,7,8}
+*-----------------------------------------------------------------------------*/
+static const sysmap_t sysmaps[]={
+    {SYS_GPS,"gps",MAXPRNGPS,0,1,0,1},  /* L1/L2 */
+    {SYS_GAL,"gal",MAXPRNGAL,0,2,0,2},  /* E1/E5a */
+    {SYS_CMP,"bds",MAXPRNCMP,0,2,1,3}   /* B1I/B3I */
+};
+#define NSYSMAP     ((int)(sizeof(sysmaps)/sizeof(*sysmaps)))
+
+#define NSTATTYPE   4                   /* stat types (rad,at,ct,clk) */
+#define STATXMIN    1E-4                /* min magnitude of histogram (m) */
+#define STATGAMMA   1.02                /* bin ratio of stat histogram */
+#define NSTATBIN    931                 /* bins per sign (STATXMIN-1E4 m) */
+
+typedef struct {                        /* streaming statistics type */
+    double n;                           /* number of samples */
+    double mean,m2;                     /* mean and sum of squared deviations */
+    double min,max;                     /* min and max */
+    unsigned int hist[2*NSTATBIN+1];    /* log-binned histogram (-max...max) */
+} stat_t;
+
+typedef struct {                        /* orbit/clock error statistics type */
+    stat_t day[MAXSAT][NSTATTYPE];      /* satellites of the day */
+    stat_t all[MAXSAT][NSTATTYPE];      /* satellites of all days */
+    stat_t sysday[NSYSMAP][NSTATTYPE];  /* systems of the day */
+    stat_t sysall[NSYSMAP][NSTATTYPE];  /* systems of all days */
+} orbstat_t;
+
+static const char *stattype[]={"rad","at","ct","clk"};
+static const char statid[]="ORBSTAT1";  /* id of daily statistics file */
+
 /* help text -----------------------------------------------------------------*/
 static const char *help[]={
 "",
@@ -86,27 +130,498 @@ static void printhelp(void)
     for (i=0;i<(int)(sizeof(help)/sizeof(*help));i++) fprintf(stderr,"%s\n",help[i]);
     exit(0);
 }
+/* open product file -----------------------------------------------------------
+* open precise/broadcast product file. if the file does not exist, the
+* compressed file (.gz, .Z) is opened and uncompressed on the fly.
+* the opened file path is set to the file name.
+*-----------------------------------------------------------------------------*/
+static FILE *openprod(char *file, int size)
+{
+    static const char *ext[]={".gz",".Z",".GZ",".z"};
+    FILE *fp;
+    char path[1024];
+    int i;
+    
+    if ((fp=fopen(file,"r"))) return fp;
+    
+    for (i=0;i<(int)(sizeof(ext)/sizeof(*ext));i++) {
+        sprintf(path,"%.1000s%s",file,ext[i]);
+        if (!(fp=fopen(path,"rb"))) continue;
+        fclose(fp);
+        
+        if ((int)strlen(path)<size) strcpy(file,path);
+        return uncfopen(path,NULL);
+    }
+    return NULL;
+}
+/* iono-free LC z-offset of satellite antenna pco (m) ------------------------*/
+static double pcoz(const nav_t *nav, const pcv_t *pcv, int sat,
+                   const sysmap_t *map)
+{
+    const double *lam=nav->lam[sat-1];
+    double gamma,C1,C2;
+    
+    if (lam[map->lf1]<=0.0||lam[map->lf2]<=0.0) return 0.0;
+    
+    gamma=SQR(lam[map->lf2])/SQR(lam[map->lf1]);
+    C1=gamma/(gamma-1.0);
+    C2=-1.0 /(gamma-1.0);
+    return C1*pcv->off[map->pf1][2]+C2*pcv->off[map->pf2][2];
+}
+/* compare precise and broadcast orbit/clock of a satellite --------------------
+* args   : gtime_t time     I   time (gpst)
+*          int    sat       I   satellite number
+*          sysmap_t *map    I   frequency/pco mapping of the system
+*          nav_t  *nav      I   navigation data
+*          int    opt       I   sat position option
+*                               (0: center of mass, 1: antenna phase center)
+*          double *rs       O   precise sat position/velocity (ecef) (m|m/s)
+*          double *pce      O   precise orbit (rac) and clock (m) {r,a,c,clk}
+*          double *bce      O   broadcast orbit (rac) and clock (m) {r,a,c,clk}
+* return : status (1:ok,0:no precise or broadcast ephemeris)
+* notes  : orbits are rac components referenced to the precise orbit. clocks
+*          include relativistic effect correction
+*-----------------------------------------------------------------------------*/
+static int compsat(gtime_t time, int sat, const sysmap_t *map,
+                   const nav_t *nav, int opt, double *rs, double *pce,
+                   double *bce)
+{
+    double rs_bce[6],dts_pce[2],dts_bce[2],var,dant[3]={0};
+    int i,svh;
+    
+    /* precise satellite position and clock */
+    if (!peph2pos(time,sat,nav,opt,rs,dts_pce,&var)) return 0;
+    
+    ecef2rac(rs,rs,pce); /* use precise orbit as reference */
+    
+    if (!opt) { /* precise clock: APC -> CoM */
+        dts_pce[0]+=pcoz(nav,nav->pcvs+sat-1,sat,map)/CLIGHT;
+    }
+    /* broadcast satellite position and clock */
+    if (!ephpos(time,time,sat,nav,-1,rs_bce,dts_bce,&var,&svh)) return 0;
+    
+    if (!opt) { /* broadcast position and clock: APC -> CoM */
+        satantoff_bce(time,rs_bce,sat,nav,dant);
+        for (i=0;i<3;i++) rs_bce[i]-=dant[i];
+        dts_bce[0]+=pcoz(nav,nav->pcvsb+sat-1,sat,map)/CLIGHT;
+    }
+    ecef2rac(rs,rs_bce,bce);
+    
+    pce[3]=CLIGHT*dts_pce[0];
+    bce[3]=CLIGHT*dts_bce[0];
+    return 1;
+}
+/* add sample to streaming statistics -----------------------------------------
+* update mean and variance by welford's algorithm and the histogram with
+* logarithmic bins of relative width STATGAMMA-1 as a mergeable sketch of
+* quantiles
+*-----------------------------------------------------------------------------*/
+static void addstat(stat_t *st, double x)
+{
+    double d=x-st->mean;
+    int k=0;
+    
+    if (st->n<=0.0||x<st->min) st->min=x;
+    if (st->n<=0.0||x>st->max) st->max=x;
+    st->n+=1.0;
+    st->mean+=d/st->n;
+    st->m2+=d*(x-st->mean);
+    
+    if (fabs(x)>STATXMIN) {
+        k=(int)ceil(log(fabs(x)/STATXMIN)/log(STATGAMMA));
+        if (k>NSTATBIN) k=NSTATBIN;
+        if (x<0.0) k=-k;
+    }
+    st->hist[NSTATBIN+k]++;
+}
+/* merge streaming statistics ------------------------------------------------*/
+static void mergestat(stat_t *st, const stat_t *s)
+{
+    double n=st->n+s->n,d=s->mean-st->mean;
+    int i;
+    
+    if (s->n<=0.0) return;
+    if (st->n<=0.0) {
+        *st=*s;
+        return;
+    }
+    if (s->min<st->min) st->min=s->min;
+    if (s->max>st->max) st->max=s->max;
+    st->m2+=s->m2+d*d*st->n*s->n/n;
+    st->mean+=d*s->n/n;
+    st->n=n;
+    for (i=0;i<2*NSTATBIN+1;i++) st->hist[i]+=s->hist[i];
+}
+/* quantile of streaming statistics --------------------------------------------
+* args   : stat_t *st       I   streaming statistics
+*          double p         I   probability (0-1)
+*          int    absv      I   quantile of absolute values (0:off,1:on)
+* return : quantile (relative error <= (STATGAMMA-1)/(STATGAMMA+1))
+*-----------------------------------------------------------------------------*/
+static double quantile(const stat_t *st, double p, int absv)
+{
+    double r=p*(st->n-1.0),c=0.0,x,xmax;
+    int k;
+    
+    if (st->n<=0.0) return 0.0;
+    
+    if (absv) {
+        for (k=0;k<NSTATBIN;k++) {
+            c+=st->hist[NSTATBIN+k]+(k>0?st->hist[NSTATBIN-k]:0);
+            if (c>r) break;
+        }
+    }
+    else {
+        for (k=-NSTATBIN;k<NSTATBIN;k++) {
+            if ((c+=st->hist[NSTATBIN+k])>r) break;
+        }
+    }
+    x=k==0?0.0:2.0*STATXMIN*pow(STATGAMMA,abs(k))/(1.0+STATGAMMA);
+    if (k<0) x=-x;
+    
+    if (absv) {
+        xmax=fabs(st->min)>fabs(st->max)?fabs(st->min):fabs(st->max);
+        return x>xmax?xmax:x;
+    }
+    return x<st->min?st->min:(x>st->max?st->max:x);
+}
+/* overbounding sigma of streaming statistics ----------------------------------
+* min sigma of zero-mean gaussian distribution of which the two-sided tail
+* probabilities overbound the ones of samples at the levels with enough tail
+* samples (n*(1-p)>=1)
+*-----------------------------------------------------------------------------*/
+static double sigob(const stat_t *st)
+{
+    static const double p[]={0.6827,0.9545,0.99,0.999,0.9999,0.99999};
+    static const double z[]={1.0,2.0,2.5758,3.2905,3.8906,4.4172};
+    double sig=0.0,s;
+    int i;
+    
+    for (i=0;i<(int)(sizeof(p)/sizeof(*p));i++) {
+        if (st->n*(1.0-p[i])<1.0) break;
+        if ((s=quantile(st,p[i],1)/z[i])>sig) sig=s;
+    }
+    return sig;
+}
+/* output streaming statistics -----------------------------------------------*/
+static void outstat(FILE *fp, const char *sys, int year, int doy, int prn,
+                    const stat_t *st)
+{
+    double std,rms;
+    int i;
+    
+    if (!fp) return;
+    
+    for (i=0;i<NSTATTYPE;i++,st++) {
+        if (st->n<=0.0) continue;
+        std=st->n>1.0?sqrt(st->m2/(st->n-1.0)):0.0;
+        rms=sqrt(SQR(st->mean)+st->m2/st->n);
+        fprintf(fp,"%s,%d,%d,%d,%s,%.0f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,"
+                "%.4f,%.4f,%.4f,%.4f\n",sys,year,doy,prn,stattype[i],st->n,
+                st->mean,std,rms,st->min,st->max,quantile(st,0.5,0),
+                quantile(st,0.6827,1),quantile(st,0.95,1),
+                quantile(st,0.99,1),quantile(st,0.999,1),sigob(st));
+    }
+}
+/* output orbit/clock error statistics of the day ------------------------------
+* output statistics of satellites and systems of the day (doy>0) and merge
+* them to the statistics of all days, or output statistics of all days (doy=0)
+* (fp=NULL: merge without output)
+*-----------------------------------------------------------------------------*/
+static void outorbstat(FILE *fp, orbstat_t *st, int navsys, int year, int doy)
+{
+    stat_t (*sat)[NSTATTYPE],(*sys)[NSTATTYPE];
+    int i,j,k,prn;
+    
+    sat=doy>0?st->day:st->all;
+    sys=doy>0?st->sysday:st->sysall;
+    
+    for (i=0;i<NSYSMAP;i++) {
+        if (!(navsys&sysmaps[i].sys)) continue;
+        
+        for (prn=1;prn<=sysmaps[i].maxprn;prn++) {
+            if ((j=satno(sysmaps[i].sys,prn)-1)<0) continue;
+            outstat(fp,sysmaps[i].name,year,doy,prn,sat[j]);
+            if (doy<=0) continue;
+            for (k=0;k<NSTATTYPE;k++) {
+                mergestat(st->sysday[i]+k,sat[j]+k);
+                mergestat(st->all[j]+k,sat[j]+k);
+            }
+            memset(sat[j],0,sizeof(stat_t)*NSTATTYPE);
+        }
+        outstat(fp,sysmaps[i].name,year,doy,0,sys[i]);
+        if (doy<=0) continue;
+        for (k=0;k<NSTATTYPE;k++) mergestat(st->sysall[i]+k,sys[i]+k);
+        memset(sys[i],0,sizeof(stat_t)*NSTATTYPE);
+    }
+    if (fp) fflush(fp);
+}
+/* save statistics of satellites of the day ------------------------------------
+* save non-empty statistics of satellites of the day with sparse histograms
+* args   : char     *file   I   daily statistics file
+*          orbstat_t *st    I   statistics (st->day)
+*          int      year    I   year
+*          int      doy     I   day of year
+* return : status (1:ok,0:error)
+*-----------------------------------------------------------------------------*/
+static int savestat(const char *file, const orbstat_t *st, int year, int doy)
+{
+    FILE *fp;
+    const stat_t *s;
+    double val[5];
+    int i,j,k,n,hdr[2];
+    
+    if (!(fp=fopen(file,"wb"))) return 0;
+    
+    hdr[0]=year; hdr[1]=doy;
+    fwrite(statid,1,8,fp);
+    fwrite(hdr,sizeof(int),2,fp);
+    
+    for (i=0;i<MAXSAT;i++) for (j=0;j<NSTATTYPE;j++) {
+        if ((s=st->day[i]+j)->n<=0.0) continue;
+        for (k=n=0;k<2*NSTATBIN+1;k++) if (s->hist[k]) n++;
+        hdr[0]=i+1; hdr[1]=j;
+        val[0]=s->n; val[1]=s->mean; val[2]=s->m2; val[3]=s->min; val[4]=s->max;
+        fwrite(hdr,sizeof(int),2,fp);
+        fwrite(val,sizeof(double),5,fp);
+        fwrite(&n,sizeof(int),1,fp);
+        for (k=0;k<2*NSTATBIN+1;k++) {
+            if (!s->hist[k]) continue;
+            fwrite(&k,sizeof(int),1,fp);
+            fwrite(s->hist+k,sizeof(unsigned int),1,fp);
+        }
+    }
+    if (ferror(fp)) {
+        fclose(fp);
+        return 0;
+    }
+    fclose(fp);
+    return 1;
+}
+/* read statistics of satellites of the day ------------------------------------
+* read daily statistics file and merge statistics to st->day
+* args   : char     *file   I   daily statistics file
+*          orbstat_t *st    IO  statistics (st->day)
+*          int      year    I   year
+*          int      doy     I   day of year
+* return : status (1:ok,0:error)
+*-----------------------------------------------------------------------------*/
+static int readstat(const char *file, orbstat_t *st, int year, int doy)
+{
+    static stat_t s;
+    FILE *fp;
+    double val[5];
+    char id[8];
+    int k,n,hdr[2],stat=1;
+    
+    if (!(fp=fopen(file,"rb"))) return 0;
+    
+    if (fread(id,1,8,fp)!=8||memcmp(id,statid,8)||
+        fread(hdr,sizeof(int),2,fp)!=2||hdr[0]!=year||hdr[1]!=doy) {
+        fclose(fp);
+        return 0;
+    }
+    while (fread(hdr,sizeof(int),2,fp)==2) {
+        memset(&s,0,sizeof(s));
+        if (hdr[0]<1||hdr[0]>MAXSAT||hdr[1]<0||hdr[1]>=NSTATTYPE||
+            fread(val,sizeof(double),5,fp)!=5||fread(&n,sizeof(int),1,fp)!=1||
+            n<0||n>2*NSTATBIN+1) {
+            stat=0;
+            break;
+        }
+        s.n=val[0]; s.mean=val[1]; s.m2=val[2]; s.min=val[3]; s.max=val[4];
+        for (;n>0;n--) {
+            if (fread(&k,sizeof(int),1,fp)!=1||k<0||k>2*NSTATBIN||
+                fread(s.hist+k,sizeof(unsigned int),1,fp)!=1) {
+                stat=0;
+                break;
+            }
+        }
+        if (!stat) break;
+        mergestat(st->day[hdr[0]-1]+hdr[1],&s);
+    }
+    fclose(fp);
+    return stat;
+}
+/* product file paths of the day ---------------------------------------------*/
+static void prodpath(gtime_t time, int use_mx, const char *sp3ac,
+                     const char *clkac, const char *brdac, char *sp3file,
+                     char *clkfile, char *rnxfile)
+{
+    double ep[6],tow;
+    int year,doy,week,dow;
+    
+    time2epoch(time,ep);
+    year=(int)ep[0];
+    doy=(int)time2doy(time);
+    tow=time2gpst(time,&week);
+    dow=(int)floor(tow/86400.0);
+    
+    if (!use_mx) {
+        sprintf(sp3file,"D:/GNSS_DATA/product/%d/%s%d%d.eph",week,sp3ac,week,
+                dow);
+        sprintf(clkfile,"D:/GNSS_DATA/product/%d/%s%d%d.clk",week,clkac,week,
+                dow);
+        sprintf(rnxfile,"./brd_%s_%d/%s%03d0.%02dn",brdac,year,brdac,doy,
+                year%100);
+    }
+    else {
+        /* mgex products of the analysis center of sp3 for clock */
+        sprintf(sp3file,"D:/GNSS_DATA/product/mgex/%d/%s0MGXFIN_%d%03d0000_"
+                "01D_05M_ORB.SP3",week,sp3ac,year,doy);
+        sprintf(clkfile,"D:/GNSS_DATA/product/mgex/%d/%s0MGXFIN_%d%03d0000_"
+                "01D_30S_CLK.CLK",week,sp3ac,year,doy);
+        sprintf(rnxfile,"D:/GNSS_DATA/data/%d/%03d/BRDC00IGS_R_%d%03d0000_"
+                "01D_MN.rnx",year,doy,year,doy);
+    }
+}
+/* fingerprint of input files of the day ---------------------------------------
+* crc-32 of paths, sizes and modified times of the product files of the day
+* and the adjacent days used for interpolation, and the output options
+* (compressed files are used if uncompressed files do not exist)
+*-----------------------------------------------------------------------------*/
+static unsigned int dayprint(gtime_t time, int use_mx, const char *sp3ac,
+                             const char *clkac, const char *brdac,
+                             const char *opts)
+{
+    static const char *ext[]={"",".gz",".Z",".GZ",".z"};
+    struct stat st;
+    char buff[4096],*p=buff,files[3][256],path[1024];
+    int i,j,k;
+    
+    p+=sprintf(p,"%.255s;",opts);
+    for (i=-1;i<=1;i++) {
+        prodpath(timeadd(time,i*86400.0),use_mx,sp3ac,clkac,brdac,files[0],
+                 files[1],files[2]);
+        for (j=0;j<3;j++) {
+            for (k=0;k<(int)(sizeof(ext)/sizeof(*ext));k++) {
+                sprintf(path,"%.1000s%s",files[j],ext[k]);
+                if (!stat(path,&st)) break;
+            }
+            if (k<(int)(sizeof(ext)/sizeof(*ext))) {
+                p+=sprintf(p,"%.255s %.0f %.0f;",path,(double)st.st_size,
+                           (double)st.st_mtime);
+            }
+            else p+=sprintf(p,"%.255s -;",files[j]);
+        }
+    }
+    return rtk_crc32((unsigned char *)buff,(int)(p-buff));
+}
+/* read manifest of completed days ---------------------------------------------
+* read lines "year doy fingerprint" of the manifest (later lines precede)
+* args   : char   *file     I   manifest file
+*          gtime_t ts       I   start day
+*          int    nday      I   number of days
+*          int    *done     O   completed days (0:not completed,1:completed)
+*          unsigned int *print O fingerprints of completed days
+* return : number of completed days
+*-----------------------------------------------------------------------------*/
+static int readmanifest(const char *file, gtime_t ts, int nday, int *done,
+                        unsigned int *print)
+{
+    FILE *fp;
+    double ep[6]={0,1,1};
+    char buff[256];
+    int i,year,doy,n=0;
+    unsigned int fp32;
+    
+    for (i=0;i<nday;i++) done[i]=0;
+    
+    if (!(fp=fopen(file,"r"))) return 0;
+    
+    while (fgets(buff,sizeof(buff),fp)) {
+        if (sscanf(buff,"%d %d %x",&year,&doy,&fp32)<3) continue;
+        ep[0]=year;
+        i=(int)floor(timediff(timeadd(epoch2time(ep),(doy-1)*86400.0),ts)/
+                     86400.0+0.5);
+        if (i<0||i>=nday) continue;
+        done[i]=1;
+        print[i]=fp32;
+    }
+    fclose(fp);
+    for (i=0;i<nday;i++) n+=done[i];
+    return n;
+}
+/* add completed day to manifest ---------------------------------------------*/
+static int addmanifest(const char *file, int year, int doy, unsigned int print)
+{
+    FILE *fp;
+    
+    if (!(fp=fopen(file,"a"))) return 0;
+    fprintf(fp,"%04d %03d %08X\n",year,doy,print);
+    fclose(fp);
+    return 1;
+}
+/* shard marker file -------------------------------------------------------*/
+static void shardfile(char *file, const char *tag, int i_proc, int n_proc)
+{
+    sprintf(file,"./new_shard_%s_%d_%d.txt",tag,i_proc,n_proc);
+}
+/* write shard marker when the days of process are finished ------------------*/
+static int addshard(const char *tag, int i_proc, int n_proc, int n_pending)
+{
+    FILE *fp;
+    char file[256];
+    
+    shardfile(file,tag,i_proc,n_proc);
+    if (!(fp=fopen(file,"w"))) return 0;
+    fprintf(fp,"%d %d %d\n",i_proc,n_proc,n_pending);
+    fclose(fp);
+    return 1;
+}
+/* test shard markers of all processes ---------------------------------------*/
+static int testshards(const char *tag, int n_proc)
+{
+    struct stat st;
+    char file[256];
+    int i;
+    
+    for (i=0;i<n_proc;i++) {
+        shardfile(file,tag,i,n_proc);
+        if (stat(file,&st)) return 0;
+    }
+    return 1;
+}
 /* rnx2rtkp main -------------------------------------------------------------*/
 int main(int argc, char **argv)
 {
     prcopt_t prcopt=prcopt_default;
     prcopt.mode  =PMODE_KINEMA;
-    // prcopt.navsys=SYS_GPS|SYS_GLO|SYS_GAL;
-    // prcopt.navsys=SYS_GPS;
-    prcopt.navsys=SYS_GAL;
-    int max_prn = prcopt.navsys==SYS_GPS?MAXPRNGPS:MAXPRNGAL;
+    // systems to compare in a pass, output to a file per system (sysmaps[])
+    prcopt.navsys=SYS_GPS|SYS_GAL|SYS_CMP;
     prcopt.refpos=1;
     prcopt.glomodear=1;
     prcopt.sateph = 1; // 0 for broadcast ephemeris; 1 for precise ephemeris
     prcopt.nf = 2;
-
+    
     // data source setting
     /* 1 for mixture constellation 
      （MGEX will be used for precise product, and IGS will be used for broadcast);
       0 for GPS only */ 
     int use_mx = 1; 
     char * usr_outstr = "test_ic";
-
+    
+    // output setting
+    double step = 60*5; // time resolution. Seconds
+    int opt = 0; //sat postion option (0: center of mass, 1: antenna phase center)
+    int out_raw = 1; // 1: dump all samples to csv per system; 0: off
+    int out_stat = 1; // 1: statistics per satellite/day/system; 0: off
+    // days are split among processes: "rnx2orbclk [i_proc n_proc]" processes
+    // the days with (day-1)%n_proc==i_proc; completed days are recorded in the
+    // manifest with fingerprints of the input files and skipped in reruns.
+    // each process writes a shard marker when finished and only process 0
+    // merges the statistics of all days after all shard markers are present
+    // (rerun "rnx2orbclk 0 n_proc" to merge if process 0 finished earlier)
+    int i_proc = 0, n_proc = 1;
+    if(argc>=3){
+        i_proc=atoi(argv[1]);
+        n_proc=atoi(argv[2]);
+        if(n_proc<1||i_proc<0||i_proc>=n_proc){
+            fprintf(stderr,"invalid process: %s %s\n",argv[1],argv[2]);
+            return -1;
+        }
+    }
+    
     nav_t navs={0};         /* navigation data */
     pcvs_t pcvss={0};        /* receiver antenna parameters */
     pcvs_t pcvsr={0};        /* satellite antenna parameters */
@@ -116,9 +631,11 @@ int main(int argc, char **argv)
     nav->nc=nav->ncmax=0;
     nav->eph =NULL; nav->n =nav->nmax =0;
     prcopt_t *popt = &prcopt;
-
-    FILE* log_file = fopen("log.txt", "w"); // record
-
+    
+    char logfile[32]="log.txt";
+    if(n_proc>1) sprintf(logfile, "log_%d.txt",i_proc);
+    FILE* log_file = fopen(logfile, "w"); // record
+    
     char * station_sp3 = "cod";
     char * station_clk = "cod";
     char * brd_agent = "sugl"; // "sugl" for Stanford clean broadcast ephemeris;  "brdc" for IGS ephemeris
@@ -139,46 +656,54 @@ int main(int argc, char **argv)
     time2epoch(s_time,ep);
     int s_year=(int)ep[0];
     int total_day = (int)(abs(timediff(e_time, s_time))/86400);
-
+    
+    /* days to be processed (index: 1-total_day, 0 and total_day+1: adjacent days) */
+    char optstr[64], manifest[128], shardtag[96];
+    sprintf(optstr, "opt=%d raw=%d stat=%d step=%.0f",opt,out_raw,out_stat,step);
+    sprintf(manifest, "./new_manifest_%s%s.txt",opt?"apc":"com",usr_outstr);
+    sprintf(shardtag, "%s%s",opt?"apc":"com",usr_outstr);
+    char shard[256];
+    shardfile(shard,shardtag,i_proc,n_proc);
+    remove(shard); // marker of a previous run
+    int *done = (int *)calloc(total_day+2,sizeof(int));
+    int *pending = (int *)calloc(total_day+2,sizeof(int));
+    int *readfail = (int *)calloc(total_day+2,sizeof(int)); // unreadable products
+    unsigned int *prints = (unsigned int *)calloc(total_day+2,sizeof(unsigned int));
+    readmanifest(manifest,s_time,total_day,done+1,prints+1);
+    int n_pending=0;
+    for(int cnt=1;cnt<=total_day;cnt++){
+        if((cnt-1)%n_proc!=i_proc) continue;
+        gtime_t inq_time_s=timeadd(s_time,(cnt-1)*86400);
+        unsigned int print=dayprint(inq_time_s,use_mx,station_sp3,station_clk,brd_agent,optstr);
+        if(done[cnt]&&prints[cnt]==print){
+            continue; // completed with the same input files
+        }
+        prints[cnt]=print;
+        pending[cnt]=1;
+        n_pending++;
+    }
+    fprintf(log_file, "Days to process : %d/%d (manifest: %s)\n",n_pending,total_day,manifest);
+    
     /*read all related files*/
     FILE *fp_sp3, *fp_clk, *fp;
-    gtime_t skipdates[100];
-    gtime_t* ptr_skipdates = skipdates;
     
     // Notice: read one more day before and after the period of interest to guarantee the correctness of interpolation 
     for(int cnt_buff=0;cnt_buff<=total_day+1;cnt_buff++){ 
+        // read products of the pending days and the adjacent days only
+        int need=0;
+        for(int k=cnt_buff-1;k<=cnt_buff+1;k++){
+            if(k>=1&&k<=total_day&&pending[k]) need=1;
+        }
+        if(!need) continue;
+        
         gtime_t inq_time_buff=timeadd(s_time,(cnt_buff-1)*86400);// time of first inquire in current doy
-        double ep[6];
-        time2epoch(inq_time_buff,ep);
-        int year_buff=(int)ep[0];
-        char yearStr[5];
-        sprintf(yearStr, "%d", year_buff);
-        char yy_buff[3];
-        strcpy(yy_buff, &yearStr[2]);
         int doy_buff = time2doy(inq_time_buff);
-        char ddd_buff_str[4];
-        if(doy_buff<10){sprintf(ddd_buff_str, "00%d",doy_buff);}
-        else if(doy_buff<100){sprintf(ddd_buff_str, "0%d",doy_buff);}
-        else{sprintf(ddd_buff_str, "%d",doy_buff);}
-
-        int week_buff;
-        double tow_buff = time2gpst(inq_time_buff,&week_buff);
-        int dow_buff=(int)floor(tow_buff/86400.0);
-
+        
         /* read precise ephemeris files*/
-        char sp3file[100];
-        // sprintf(sp3file, "./pce_%d/%s%d%d.sp3", year_buff,station_sp3,week_buff,dow_buff);
-        // sprintf(sp3file, "./test/com18775.sp3");
-        if(!use_mx){
-            sprintf(sp3file, "D:/GNSS_DATA/product/%d/%s%d%d.eph",week_buff,station_sp3,week_buff,dow_buff);
-        }
-        else{
-            sprintf(sp3file, "D:/GNSS_DATA/product/mgex/%d/%s0MGXFIN_%d%s0000_01D_05M_ORB.SP3",week_buff,station_sp3,year_buff,ddd_buff_str);
-            // sprintf(sp3file, "D:/GNSS_DATA/product/mgex/%d/GFZ0MGXRAP_%d%s0000_01D_05M_ORB.SP3",week_buff,year_buff,ddd_buff_str);
-            // sprintf(sp3file, "D:/GNSS_DATA/product/mgex/%d/GFZ2R03FIN_%d%s0000_01D_05M_ORB.SP3",week_buff,year_buff,ddd_buff_str);
-        }
-
-        fp_sp3=fopen(sp3file,"r");
+        char sp3file[256],clkfile[256],rnxfile[256];
+        prodpath(inq_time_buff,use_mx,station_sp3,station_clk,brd_agent,sp3file,clkfile,rnxfile);
+        
+        fp_sp3=openprod(sp3file,sizeof(sp3file));
         gtime_t time_tmp={0};
         double bfact[2]={0};
         int ns,sats_tmp[MAXSAT]={0};
@@ -199,8 +724,7 @@ int main(int argc, char **argv)
         
         if(!ns){
             fprintf(log_file, "Read head failed : %s\n",sp3file);
-            *ptr_skipdates=inq_time_buff;
-            ptr_skipdates++;
+            readfail[cnt_buff]=1;
             continue;
         }
         else{
@@ -209,30 +733,17 @@ int main(int argc, char **argv)
             fclose(fp_sp3);
         }
         
-
+        
         // /*read head of precise clock file */
         double ver;
         int sys,tsys;
         char tobs[6][MAXOBSTYPE][4]={{""}};
         char type=' ';
         sta_t *sta;
-        char clkfile[100];
-        // sprintf(clkfile, "./clk_%d/%s%d%d.clk", year_buff,station_clk,week_buff,dow_buff);
-        // sprintf(clkfile, "./test/com18775.clk");
-        if(!use_mx){
-            sprintf(clkfile, "D:/GNSS_DATA/product/%d/%s%d%d.clk",week_buff,station_clk,week_buff,dow_buff);
-        }
-        else{
-            sprintf(clkfile, "D:/GNSS_DATA/product/mgex/%d/%s0MGXFIN_%d%s0000_01D_30S_CLK.CLK",week_buff,station_sp3,year_buff,ddd_buff_str);
-            // sprintf(clkfile, "D:/GNSS_DATA/product/mgex/%d/GFZ2R03FIN_%d%s0000_01D_30S_CLK.CLK",week_buff,year_buff,ddd_buff_str);
-            // sprintf(clkfile, "D:/GNSS_DATA/product/mgex/%d/GFZ0MGXRAP_%d%s0000_01D_30S_CLK.CLK",week_buff,year_buff,ddd_buff_str);
-            // sprintf(clkfile, "D:/GNSS_DATA/product/mgex/%d/IGS2R03FIN_%d%s0000_01D_30S_CLK.CLK",week_buff,year_buff,ddd_buff_str);
-        }
-        fp_clk=fopen(clkfile,"r");
+        fp_clk=openprod(clkfile,sizeof(clkfile));
         if(!readrnxh(fp_clk,&ver,&type,&sys,&tsys,tobs,nav,stas)){//read rinex header
             fprintf(log_file, "Read head failed : %s\n",clkfile);
-            *ptr_skipdates=inq_time_buff;
-            ptr_skipdates++;
+            readfail[cnt_buff]=1;
             continue;
         }
         /*read precise clock file*/
@@ -240,26 +751,16 @@ int main(int argc, char **argv)
         if ( (ver==3.04 && !readrnxclk_304(fp_clk,popt->rnxopt[0],doy_buff,nav))
              ||(!readrnxclk(fp_clk,popt->rnxopt[0],doy_buff,nav)) ){
             fprintf(log_file, "Read file failed : %s\n",clkfile);
-            *ptr_skipdates=inq_time_buff;
-            ptr_skipdates++;
+            readfail[cnt_buff]=1;
             continue;
         }
         fclose(fp_clk);
-
+        
         /* read navigation data */
-        char rnxfile[100];
-        if(!use_mx){
-            sprintf(rnxfile, "./brd_%s_%d/%s%s0.%sn", brd_agent,year_buff,brd_agent,ddd_buff_str,yy_buff);
-        }
-        else{
-            sprintf(rnxfile, "D:/GNSS_DATA/data/%d/%s/BRDC00IGS_R_%d%s0000_01D_MN.rnx",year_buff,ddd_buff_str,year_buff,ddd_buff_str);
-            // sprintf(rnxfile, "D:/GNSS_DATA/data/%d/%s/BRDM00DLR_S_%d%s0000_01D_MN.rnx",year_buff,ddd_buff_str,year_buff,ddd_buff_str);
-        }
-        fp=fopen(rnxfile,"r");
+        fp=openprod(rnxfile,sizeof(rnxfile));
         if(!readrnxh(fp,&ver,&type,&sys,&tsys,tobs,nav,stas)){//read rinex header
             fprintf(log_file, "Read head failed : %s\n",rnxfile);
-            *ptr_skipdates=inq_time_buff;
-            ptr_skipdates++;
+            readfail[cnt_buff]=1;
             continue;
         }
         else{
@@ -268,8 +769,7 @@ int main(int argc, char **argv)
                     // use stanford post-clean broadcast ephemeris 
                     if(!readrnxnav_stanford(fp,popt->rnxopt[0],ver,sys,nav)){ //read rinex body
                         fprintf(log_file, "Read body failed : %s\n",rnxfile);
-                        *ptr_skipdates=inq_time_buff;
-                        ptr_skipdates++;
+                        readfail[cnt_buff]=1;
                         continue;
                     }
                 }
@@ -277,8 +777,7 @@ int main(int argc, char **argv)
                     // use igs broadcast ephemeris
                     if(!readrnxnav(fp,popt->rnxopt[0],ver,sys,nav)){//read rinex body
                         fprintf(log_file, "Read body failed : %s\n",rnxfile);
-                        *ptr_skipdates=inq_time_buff;
-                        ptr_skipdates++;
+                        readfail[cnt_buff]=1;
                         continue;
                     }
                 }
@@ -287,18 +786,17 @@ int main(int argc, char **argv)
                 // use mix broadcast ephemeris
                 if(!readrnxnav_mgex(fp,popt->rnxopt[0],ver,sys,nav)){//read rinex body
                     fprintf(log_file, "Read body failed : %s\n",rnxfile);
-                    *ptr_skipdates=inq_time_buff;
-                    ptr_skipdates++;
+                    readfail[cnt_buff]=1;
                     continue;
                 }
             }
-            
+        
         }
         fclose(fp);
     }
     uniqnav(nav); //delete duplicated ephemeris
     combpclk(nav); //unique and combine ephemeris and precise clock 
-
+    
     /* read satellite antenna parameters */
     if(s_time.time < 1485648000){ // corresponding to 2017-01-29 00:00:00
         const char *atxfile = "./igs08.atx";
@@ -312,20 +810,23 @@ int main(int argc, char **argv)
         const char *atxfile = "./igs20.atx";
         readpcv(atxfile,&pcvss);
     }
-
+    
     /* set antenna paramters for precise product*/
     setpcv(s_time,&prcopt,&navs,&pcvss,&pcvsr,stas);
-
+    
     /* print antenna paramters of precise product */
     // GPS prn: 1-32
     // Galileo prn: 1-36
     printf("APC offset of precise products\n");
-    for(int prn=1;prn<=max_prn;prn++){ //inquire satellite number
-        int sat_no=satno(prcopt.navsys,prn);
-        const pcv_t *pcv_tmp =nav->pcvs+sat_no-1;
-        printf("sat %d: x=%f, y=%f, z=%f\n",sat_no,pcv_tmp->off[0][0],pcv_tmp->off[0][1],pcv_tmp->off[0][2]);
+    for(int i=0;i<NSYSMAP;i++){
+        if(!(prcopt.navsys&sysmaps[i].sys)) continue;
+        for(int prn=1;prn<=sysmaps[i].maxprn;prn++){ //inquire satellite number
+            int sat_no=satno(sysmaps[i].sys,prn);
+            const pcv_t *pcv_tmp =nav->pcvs+sat_no-1;
+            printf("sat %d: x=%f, y=%f, z=%f\n",sat_no,pcv_tmp->off[0][0],pcv_tmp->off[0][1],pcv_tmp->off[0][2]);
+        }
     }
-
+    
     /* set GPS antenna paramters for broadcast product according to NGA document*/
     for (int i=0;i<32;i++) {
         int satno = i+1;
@@ -371,7 +872,7 @@ int main(int argc, char **argv)
         ppcv->off[1][0]=x;ppcv->off[1][1]=y;ppcv->off[1][2]=z;
         nav->pcvsb[i]=*ppcv;
     }
-
+    
     /* set Galileo antenna paramters for broadcast product according to Galileo metadata*/
     FILE *gal_info_file = fopen("./Galileo_SatServiceInfo.txt", "r");
     char line[1024]; 
@@ -432,46 +933,70 @@ int main(int argc, char **argv)
         line_cnt+=1;
     }
     fclose(gal_info_file); 
-
+    
     /* print antenna paramters of broadcast product */
     // GPS prn: 1-32
     // Galileo prn: 1-36
     printf("APC offset of broadcast products\n");
-    for(int prn=1;prn<=max_prn;prn++){ //inquire satellite number
-        int sat_no=satno(prcopt.navsys,prn);
-        const pcv_t *pcv_tmp =nav->pcvsb+sat_no-1;
-        printf("sat %d: x=%f, y=%f, z=%f\n",sat_no,pcv_tmp->off[0][0],pcv_tmp->off[0][1],pcv_tmp->off[0][2]);
+    for(int i=0;i<NSYSMAP;i++){
+        if(!(prcopt.navsys&sysmaps[i].sys)) continue;
+        for(int prn=1;prn<=sysmaps[i].maxprn;prn++){ //inquire satellite number
+            int sat_no=satno(sysmaps[i].sys,prn);
+            const pcv_t *pcv_tmp =nav->pcvsb+sat_no-1;
+            printf("sat %d: x=%f, y=%f, z=%f\n",sat_no,pcv_tmp->off[0][0],pcv_tmp->off[0][1],pcv_tmp->off[0][2]);
+        }
     }
-
-
+    
+    
     /* Generate result of interest */
-    double step = 60*5; // time resolution. Seconds
-    int opt = 0; //sat postion option (0: center of mass, 1: antenna phase center)
-    char savefile[100];
-    if(opt){sprintf(savefile, "./new_outpos_apc_%d%s.csv",s_year,usr_outstr);}
-    else{sprintf(savefile, "./new_outpos_com_%d%s.csv",s_year,usr_outstr);}
-    FILE* out_file = fopen(savefile, "w"); // Open in "append" mode
-    // fprintf(out_file, "Year,Doy,SoD,PRN,Xp,Yp,Zp,dtp,Xb,Yb,Zb,dtb,clkDiff\n");
-    fprintf(out_file, "Year,Doy,SoD,PRN,Xp,Yp,Zp,Rp,Ap,Cp,dtp,Rb,Ab,Cb,dtb,radDiff,atDiff,ctDiff,clkDiff\n");
+    char savefile[128];
+    FILE* out_files[NSYSMAP]={0}; // output file per system of the day
+    FILE* stat_file = NULL; // output file of statistics
+    orbstat_t *orbstat = NULL; // statistics of orbit/clock errors
+    if(out_stat&&!(orbstat=(orbstat_t *)calloc(1,sizeof(orbstat_t)))){
+        fprintf(log_file, "Memory allocation error\n");
+    }
     for(int cnt=1;cnt<=total_day;cnt++){
+        if(!pending[cnt]) continue;
         gtime_t inq_time_s=timeadd(s_time,(cnt-1)*86400);// time of first inquire in current doy
         double ep[6];
         time2epoch(inq_time_s,ep);
         int year=(int)ep[0];
         int doy = time2doy(inq_time_s);
-
+        
         /*judge whether the inquire date is valid*/
-        for(gtime_t *ptr = ptr_skipdates;ptr!=skipdates;--ptr){
-            time2epoch(*ptr,ep);
-            int year_tmp=(int)ep[0];
-            int doy_tmp = time2doy(*ptr);
-            if(year == year_tmp && doy == doy_tmp){
+        if(readfail[cnt]){
+            fprintf(log_file, "Skip day : %d %03d\n",year,doy);
+            continue;
+        }
+        
+        /* open output files of the day */
+        int status=1;
+        for(int i=0;i<NSYSMAP&&out_raw;i++){
+            if(!(prcopt.navsys&sysmaps[i].sys)) continue;
+            sprintf(savefile, "./new_outpos_%s_%d%03d%s_%s.csv",opt?"apc":"com",year,doy,usr_outstr,sysmaps[i].name);
+            if(!(out_files[i] = fopen(savefile, "w"))){
+                fprintf(log_file, "Open failed : %s\n",savefile);
+                status=0;
                 continue;
             }
+            // fprintf(out_files[i], "Year,Doy,SoD,PRN,Xp,Yp,Zp,dtp,Xb,Yb,Zb,dtb,clkDiff\n");
+            fprintf(out_files[i], "Year,Doy,SoD,PRN,Xp,Yp,Zp,Rp,Ap,Cp,dtp,Rb,Ab,Cb,dtb,radDiff,atDiff,ctDiff,clkDiff\n");
         }
-
+        if(orbstat){
+            sprintf(savefile, "./new_outstat_%s_%d%03d%s.csv",opt?"apc":"com",year,doy,usr_outstr);
+            if(!(stat_file=fopen(savefile, "w"))){
+                fprintf(log_file, "Open failed : %s\n",savefile);
+                status=0;
+            }
+            else{
+                // PRN=0: all satellites of the system; A??: quantiles of absolute values
+                fprintf(stat_file, "Sys,Year,Doy,PRN,Type,N,Mean,Std,RMS,Min,Max,Q50,A68,A95,A99,A999,SigOB\n");
+            }
+        }
+        
         for(int i_epoch=0;i_epoch<86400/step;i_epoch++){
-
+            
             gtime_t inq_time=timeadd(inq_time_s,step*i_epoch);// inquire time
             char s_inq[32];
             time2str(inq_time, s_inq,1);
@@ -479,92 +1004,102 @@ int main(int argc, char **argv)
             gtime_t tut0;
             int sod=time2sec(inq_time,&tut0);
             
-            // GPS prn: 1-32
-            // Galileo prn: 1-30
-            for(int prn=1;prn<=max_prn;prn++){ //inquire satellite number
-                int sat=satno(prcopt.navsys,prn);
-                int n_inq = 1; // number of inquires (each inquire is to solve the precise position and clock of a given satellite at given time)
-                
-                /* precise satellite position and clock with relativistic effect correction */
-                double *rs_pce,*dts_pce,*var_pce;
-                rs_pce=mat(6,n_inq); dts_pce=mat(2,n_inq); var_pce=mat(1,n_inq);
-                if(!peph2pos(inq_time,sat,nav,opt,rs_pce,dts_pce,var_pce)){
-                    continue;
-                }
-                // printf("finalus: %s; %ld;   %d; pclk: %.15Lf\n",s_inq, inq_time.time, prn, dts_pce[0]);
-                /* precise position transformation: ECEF->RAC */
-                double pos_pce_rac[3];
-                ecef2rac(rs_pce,rs_pce,pos_pce_rac); // use precise orbit as reference
-                
-                if(!opt){
-                /* precise clock transformation: APC->CoM */
-                    const double *lam_tmp=nav->lam[sat-1];
-                    const pcv_t *pcv_tmp =nav->pcvs+sat-1;
-                    int f1,f2; //freqs[]={1,2,5,6,7,8,0};
-                    if(prcopt.navsys==SYS_GPS){f1=0,f2=1;}
-                    else if(prcopt.navsys==SYS_GAL){f1=0,f2=2;}
-                    double gamma,C1,C2;
-                    gamma=SQR(lam_tmp[f2])/SQR(lam_tmp[f1]);
-                    C1=gamma/(gamma-1.0);
-                    C2=-1.0 /(gamma-1.0);
-                    double apc_LC_z = C1*pcv_tmp->off[f1][2]+C2*pcv_tmp->off[f2][2]; // z-direction APC offset in the ionosphere-free combination in satellite body frame
-                    dts_pce[0] = dts_pce[0] + apc_LC_z/CLIGHT; // APC -> MoC 
-                }   
-                
-                /* broadcast satellite position and clock with relativistic effect correction */
-                double *rs_bce,*dts_bce,*var_bce;
-                int svh_bce[n_inq];
-                rs_bce=mat(6,n_inq); dts_bce=mat(2,n_inq); var_bce=mat(1,n_inq); 
-                if(!ephpos(inq_time,inq_time,sat,nav,-1,rs_bce,dts_bce,var_bce,svh_bce)){
-                    continue;
-                }
-                // printf("finalus: %s; %ld;   %d; clk: %.15Lf\n",s_inq,inq_time.time, prn, dts_bce[0]);
-
-                if(!opt){
-                /* broadcast position transformation: APC->CoM */
-                    double dant_bce[3]={0}; // APC offeset in ECEF
-                    satantoff_bce(inq_time,rs_bce,sat,nav,dant_bce); 
-                    for (int ii=0;ii<3;ii++) {
-                        rs_bce[ii]=rs_bce[ii] - dant_bce[ii]; // negative sign: APC->CoM
+            // all systems are evaluated against the same loaded products
+            for(int i=0;i<NSYSMAP;i++){
+                if(!(prcopt.navsys&sysmaps[i].sys)) continue;
+                for(int prn=1;prn<=sysmaps[i].maxprn;prn++){ //inquire satellite number
+                    int sat=satno(sysmaps[i].sys,prn);
+                    double rs_pce[6],pce[4],bce[4]; // rac orbit & clock {r,a,c,clk}
+                    
+                    if(!compsat(inq_time,sat,sysmaps+i,nav,opt,rs_pce,pce,bce)){
+                        continue;
                     }
+                    if(orbstat){
+                        for(int j=0;j<NSTATTYPE;j++){
+                            addstat(orbstat->day[sat-1]+j,pce[j]-bce[j]);
+                        }
+                    }
+                    if(!out_files[i]) continue;
+                    fprintf(out_files[i], "%d,%d,%d,%d,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf\n",
+                    year,doy,sod,prn, 
+                    rs_pce[0],rs_pce[1],rs_pce[2],// ECEF precise orbit
+                    pce[0],pce[1],pce[2],pce[3], // RAC precise orbit & clock
+                    bce[0],bce[1],bce[2],bce[3], // RAC broadcast orbit & clock
+                    pce[0]-bce[0], // radDiff
+                    pce[1]-bce[1], // atDiff
+                    pce[2]-bce[2], // ctDiff
+                    pce[3]-bce[3]); // clkDiff
                 }
-                /* broadcast position transformation: ECEF->RAC */
-                double pos_bce_rac[3];
-                ecef2rac(rs_pce,rs_bce,pos_bce_rac); // use precise orbit as reference
-                
-                if(!opt){
-                /* broadcast clock transformation: APC->CoM */
-                    const double *lam_tmp=nav->lam[sat-1];
-                    int f1,f2; //freqs[]={1,2,5,6,7,8,0};
-                    if(prcopt.navsys==SYS_GPS){f1=0,f2=1;}
-                    else if(prcopt.navsys==SYS_GAL){f1=0,f2=2;}
-                    double gamma,C1,C2;
-                    gamma=SQR(lam_tmp[f2])/SQR(lam_tmp[f1]);
-                    C1=gamma/(gamma-1.0);
-                    C2=-1.0 /(gamma-1.0);
-                    const pcv_t *pcv_tmp_bce =nav->pcvsb+sat-1;
-                    double apc_LC_z_bce = C1*pcv_tmp_bce->off[f1][2]+C2*pcv_tmp_bce->off[f2][2]; // z-direction APC offset in the ionosphere-free combination in satellite body frame
-                    dts_bce[0] = dts_bce[0] + apc_LC_z_bce/CLIGHT; // APC -> MoC 
-                }
-
-                fprintf(out_file, "%d,%d,%d,%d,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf\n",
-                year,doy,sod,prn, 
-                rs_pce[0],rs_pce[1],rs_pce[2],// ECEF precise orbit
-                // rs_bce[0],rs_bce[1],rs_bce[2], // ECEF broadcast orbit
-                pos_pce_rac[0],pos_pce_rac[1],pos_pce_rac[2],CLIGHT*dts_pce[0], // RAC precise orbit & clock
-                pos_bce_rac[0],pos_bce_rac[1],pos_bce_rac[2],CLIGHT*dts_bce[0], // RAC broadcast orbit & clock
-                pos_pce_rac[0]-pos_bce_rac[0], // radDiff
-                pos_pce_rac[1]-pos_bce_rac[1], // atDiff
-                pos_pce_rac[2]-pos_bce_rac[2], // ctDiff
-                CLIGHT*(dts_pce[0]-dts_bce[0])); // clkDiff
-                
-                int aa;
-                aa=0;
             }
         }
+        /* close output files and record the completed day in the manifest */
+        for(int i=0;i<NSYSMAP;i++){
+            if(!out_files[i]) continue;
+            if(ferror(out_files[i])) status=0;
+            fclose(out_files[i]);
+            out_files[i]=NULL;
+        }
+        if(orbstat){
+            sprintf(savefile, "./new_outstat_%s_%d%03d%s.bin",opt?"apc":"com",year,doy,usr_outstr);
+            if(!savestat(savefile,orbstat,year,doy)){
+                fprintf(log_file, "Write failed : %s\n",savefile);
+                status=0;
+            }
+            outorbstat(stat_file,orbstat,prcopt.navsys,year,doy);
+            if(stat_file){
+                if(ferror(stat_file)) status=0;
+                fclose(stat_file);
+                stat_file=NULL;
+            }
+        }
+        if(status&&!addmanifest(manifest,year,doy,prints[cnt])){
+            fprintf(log_file, "Write failed : %s\n",manifest);
+        }
+    }
+    /* mark the days of this process finished */
+    if(!addshard(shardtag,i_proc,n_proc,n_pending)){
+        fprintf(log_file, "Write failed : %s\n",shard);
+    }
+    /* statistics of all days merged from the daily statistics of completed days
+       by process 0 after all processes finished */
+    if(orbstat&&(i_proc!=0||!testshards(shardtag,n_proc))){
+        if(i_proc==0){
+            fprintf(log_file, "Statistics of all days : skipped until all %d processes finish\n",n_proc);
+        }
+        free(orbstat);
+        orbstat=NULL;
+    }
+    if(orbstat){
+        memset(orbstat,0,sizeof(orbstat_t));
+        int n_done=readmanifest(manifest,s_time,total_day,done+1,prints+1);
+        for(int cnt=1;cnt<=total_day;cnt++){
+            if(!done[cnt]) continue;
+            gtime_t inq_time_s=timeadd(s_time,(cnt-1)*86400);
+            double ep[6];
+            time2epoch(inq_time_s,ep);
+            int year=(int)ep[0];
+            int doy = time2doy(inq_time_s);
+            sprintf(savefile, "./new_outstat_%s_%d%03d%s.bin",opt?"apc":"com",year,doy,usr_outstr);
+            if(!readstat(savefile,orbstat,year,doy)){
+                fprintf(log_file, "Read file failed : %s\n",savefile);
+                n_done--;
+            }
+            outorbstat(NULL,orbstat,prcopt.navsys,year,doy);
+        }
+        sprintf(savefile, "./new_outstat_%s_%d%s.csv",opt?"apc":"com",s_year,usr_outstr);
+        if(!(stat_file=fopen(savefile, "w"))){
+            fprintf(log_file, "Open failed : %s\n",savefile);
+        }
+        else{
+            // PRN=0: all satellites of the system; Doy=0: all days; A??: quantiles of absolute values
+            fprintf(stat_file, "Sys,Year,Doy,PRN,Type,N,Mean,Std,RMS,Min,Max,Q50,A68,A95,A99,A999,SigOB\n");
+            outorbstat(stat_file,orbstat,prcopt.navsys,s_year,0);
+            fclose(stat_file);
+        }
+        fprintf(log_file, "Statistics of all days : %d/%d days\n",n_done,total_day);
+        free(orbstat);
     }
-    // Close the log file
-    fclose(out_file);
+    free(done); free(pending); free(readfail); free(prints);
     fclose(log_file);
     return 0;
 }
@@ -351,7 +351,7 @@ extern void readsp3(const char *file, nav_t *nav, int opt)
         if (!strstr(ext+1,"sp3")&&!strstr(ext+1,".SP3")&&
             !strstr(ext+1,"eph")&&!strstr(ext+1,".EPH")) continue;
         
-        if (!(fp=fopen(efiles[i],"r"))) {
+        if (!(fp=uncfopen(efiles[i],NULL))) {
             trace(2,"sp3 file open error %s\n",efiles[i]);
             continue;
         }
@@ -390,7 +390,7 @@ extern int readsap(const char *file, gtime_t time, nav_t *nav)
         pcv=searchpcv(i+1,"",time,&pcvs);
         nav->pcvs[i]=pcv?*pcv:pcv0;
     }
-    free(pcvs.pcv);
+    freepcv(&pcvs);
     return 1;
 }
 /* read dcb parameters file --------------------------------------------------*/
@@ -403,7 +403,7 @@ static int readdcbf(const char *file, nav_t *nav)
     
     trace(3,"readdcbf: file=%s\n",file);
     
-    if (!(fp=fopen(file,"r"))) {
+    if (!(fp=uncfopen(file,NULL))) {
         trace(2,"dcb parameters file open error: %s\n",file);
         return 0;
     }
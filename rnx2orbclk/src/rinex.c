@@ -1640,20 +1640,15 @@ static int readrnxfile(const char *file, gtime_t ts, gtime_t te, double tint,
                        obs_t *obs, nav_t *nav, sta_t *sta)
 {
     FILE *fp;
-    int cstat,stat;
-    char tmpfile[1024];
+    int stat;
     
     trace(3,"readrnxfile: file=%s flag=%d index=%d\n",file,flag,index);
     
     if (sta) init_sta(sta);
     
-    /* uncompress file */
-    if ((cstat=uncompress(file,tmpfile))<0) {
-        trace(2,"rinex file uncompact error: %s\n",file);
-        return 0;
-    }
-    if (!(fp=fopen(cstat?tmpfile:file,"r"))) {
-        trace(2,"rinex file open error: %s\n",cstat?tmpfile:file);
+    /* open file with uncompression */
+    if (!(fp=uncfopen(file,NULL))) {
+        trace(2,"rinex file open error: %s\n",file);
         return 0;
     }
     /* read rinex file */
@@ -1661,9 +1656,6 @@ static int readrnxfile(const char *file, gtime_t ts, gtime_t te, double tint,
     
     fclose(fp);
     
-    /* delete temporary file */
-    if (cstat) remove(tmpfile);
-    
     return stat;
 }
 /* read rinex obs and nav files ------------------------------------------------
@@ -523,6 +523,9 @@ typedef struct {        /* antenna parameter type */
 typedef struct {        /* antenna parameters type */
     int n,nmax;         /* number of data/allocated */
     pcv_t *pcv;         /* antenna parameters data */
+    int nidx;           /* number of indexed data (index valid if nidx==n) */
+    int *sidx;          /* satellite antennas sorted by sat and valid start */
+    int satp[MAXSAT+1]; /* start of satellite antennas of sat in sidx */
 } pcvs_t;
 
 typedef struct {        /* almanac type */
@@ -1294,6 +1297,7 @@ extern void matmul(const char *tr, int n, int k, int m, double alpha,
 extern int  matinv(double *A, int n);
 extern int  solve (const char *tr, const double *A, const double *Y, int n,
                    int m, double *X);
+extern int  matsetblas(const char *lib);
 extern int  lsq   (const double *A, const double *y, int n, int m, double *x,
                    double *Q);
 extern int  filter(double *x, double *P, const double *H, const double *v,
@@ -1366,6 +1370,7 @@ extern int  readerp(const char *file, erp_t *erp);
 extern int  geterp (const erp_t *erp, gtime_t time, double *val);
 
 /* debug trace functions -----------------------------------------------------*/
+extern void traceasync(int ena);
 extern void traceopen(const char *file);
 extern void traceclose(void);
 extern void tracelevel(int level);
@@ -1380,6 +1385,23 @@ extern void tracepeph(int level, const nav_t *nav);
 extern void tracepclk(int level, const nav_t *nav);
 extern void traceb   (int level, const unsigned char *p, int n);
 
+/* gate trace() and tracet() by the level before evaluation of the arguments.
+   -DTRACEMAX=n limits the max level of debug trace compiled in */
+#ifdef TRACE
+#ifndef TRACEMAX
+#define TRACEMAX    5                   /* max level of debug trace */
+#endif
+extern int tracelvl;
+
+#define trace(level,...) \
+    do {if ((level)<=TRACEMAX&&(level)<=tracelvl) (trace)(level,__VA_ARGS__);} while (0)
+#define tracet(level,...) \
+    do {if ((level)<=TRACEMAX&&(level)<=tracelvl) (tracet)(level,__VA_ARGS__);} while (0)
+#else
+#define trace(level,...)  do {if (0) (trace)(level,__VA_ARGS__);} while (0)
+#define tracet(level,...) do {if (0) (tracet)(level,__VA_ARGS__);} while (0)
+#endif
+
 /* platform dependent functions ----------------------------------------------*/
 extern int execcmd(const char *cmd);
 extern int expath (const char *path, char *paths[], int nmax);
@@ -1421,8 +1443,10 @@ extern void stec_free(nav_t *nav);
 
 /* antenna models ------------------------------------------------------------*/
 extern int  readpcv(const char *file, pcvs_t *pcvs);
+extern void pcvsetsnap(int ena);
 extern pcv_t *searchpcv(int sat, const char *type, gtime_t time,
                         const pcvs_t *pcvs);
+extern void freepcv(pcvs_t *pcvs);
 extern void antmodel(const pcv_t *pcv, const double *del, const double *azel,
                      int opt, double *dant);
 extern void antmodel_s(const pcv_t *pcv, double nadir, double *dant);
@@ -1463,6 +1487,9 @@ extern int outrnxnavb (FILE *fp, const rnxopt_t *opt, const eph_t *eph);
 extern int outrnxgnavb(FILE *fp, const rnxopt_t *opt, const geph_t *geph);
 extern int outrnxhnavb(FILE *fp, const rnxopt_t *opt, const seph_t *seph);
 extern int uncompress(const char *file, char *uncfile);
+extern FILE *uncfopen(const char *file, int *plain);
+extern int uncompfile(const char *file, const char *outfile, int zip,
+                      int crx);
 extern int convrnx(int format, rnxopt_t *opt, const char *file, char **ofile);
 extern int  init_rnxctr (rnxctr_t *rnx);
 extern void free_rnxctr (rnxctr_t *rnx);
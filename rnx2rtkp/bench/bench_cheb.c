@@ -0,0 +1,204 @@
+/*------------------------------------------------------------------------------
+* bench_cheb.c : chebyshev compressed ephemeris benchmark
+*
+* history : 2026/10/18  1.0 new
+*-----------------------------------------------------------------------------*/
+#include "rtklib.h"
+
+#define PROGNAME    "bench_cheb"        /* program name */
+
+/* help text -----------------------------------------------------------------*/
+static const char *help[]={
+"",
+" usage: bench_cheb [option]... file ...",
+"",
+" Fit chebyshev compressed ephemeris to the broadcast ephemerides (rinex nav)",
+" or precise ephemerides (sp3 and rinex clock) of the input files, compare",
+" positions and clocks by cheb2pos() with satpos() at random times and",
+" satellites, and time the queries. File types are detected by extensions",
+" (*.sp3,*.SP3,*.eph,*.EPH: sp3, *.clk,*.CLK: rinex clock, others: rinex).",
+"",
+" -?        print help",
+" -prec     fit precise ephemerides instead of broadcast ephemerides",
+" -span s   time span of a segment (s) [3600]",
+" -deg n    degree of polynomials [10]",
+" -n num    number of random queries [100000]",
+" -o file   save segment table to file",
+" -i file   read segment table from file instead of fitting",
+};
+/* print help ----------------------------------------------------------------*/
+static void printhelp(void)
+{
+    int i;
+    for (i=0;i<(int)(sizeof(help)/sizeof(*help));i++) fprintf(stderr,"%s\n",help[i]);
+    exit(0);
+}
+/* uniform random number in [0,1) --------------------------------------------*/
+static double urand(unsigned int *seed)
+{
+    *seed=*seed*1103515245u+12345u;
+    return (*seed>>8)/16777216.0;
+}
+/* read navigation data files ------------------------------------------------*/
+static void readnavf(char **files, int n, nav_t *nav)
+{
+    char *ext;
+    int i;
+    
+    for (i=0;i<n;i++) {
+        if (!(ext=strrchr(files[i],'.'))) ext="";
+        
+        if (!strcmp(ext,".sp3")||!strcmp(ext,".SP3")||!strcmp(ext,".eph")||
+            !strcmp(ext,".EPH")) {
+            readsp3(files[i],nav,0);
+        }
+        else if (!strcmp(ext,".clk")||!strcmp(ext,".CLK")) {
+            readrnxc(files[i],nav);
+        }
+        else readrnx(files[i],0,"",NULL,nav,NULL);
+    }
+    uniqnav(nav);
+}
+/* time span of navigation data ----------------------------------------------*/
+static int navspan(const nav_t *nav, int prec, gtime_t *ts, gtime_t *te)
+{
+    int i;
+    
+    if (prec) {
+        if (nav->ne<=0) return 0;
+        *ts=nav->peph[0].time;
+        *te=nav->peph[nav->ne-1].time;
+        return 1;
+    }
+    if (nav->n<=0) return 0;
+    *ts=*te=nav->eph[0].toe;
+    for (i=1;i<nav->n;i++) {
+        if (timediff(nav->eph[i].toe,*ts)<0.0) *ts=nav->eph[i].toe;
+        if (timediff(nav->eph[i].toe,*te)>0.0) *te=nav->eph[i].toe;
+    }
+    return 1;
+}
+/* compare cheb2pos() with satpos() and time queries -------------------------*/
+static void benchquery(const cheph_t *ceph, const nav_t *nav, gtime_t ts,
+                       gtime_t te, int nq)
+{
+    gtime_t *time,teph;
+    double rs[6],dts[2],var,rsc[6],dtsc[2],dr[3],err,errp=0.0,errc=0.0;
+    double errv=0.0,rmsp=0.0,rmsc=0.0,errs=0.0,t1,t2;
+    unsigned int seed=1,tick;
+    int i,j,k,*sat,svh,n=0;
+    
+    time=(gtime_t *)malloc(sizeof(gtime_t)*nq);
+    sat=(int *)malloc(sizeof(int)*nq);
+    
+    /* random queries with available segments */
+    for (i=j=0;i<nq&&j<nq*100;j++) {
+        time[i]=timeadd(ts,urand(&seed)*timediff(te,ts));
+        sat[i]=1+(int)(urand(&seed)*MAXSAT);
+        if (!cheb2pos(time[i],sat[i],ceph,rsc,dtsc,NULL)) continue;
+        
+        /* ephemeris selected by time (switch of broadcast ephemerides) */
+        if (satpos(time[i],time[i],sat[i],ceph->ephopt,nav,rs,dts,&var,&svh)) {
+            for (k=0;k<3;k++) dr[k]=rs[k]-rsc[k];
+            if ((err=norm(dr,3))>errs) errs=err;
+        }
+        /* ephemeris selected by segment center (fit error) */
+        k=(int)floor(timediff(time[i],ceph->ts)/ceph->span);
+        teph=timeadd(ceph->ts,ceph->span*(k+0.5));
+        if (!satpos(time[i],teph,sat[i],ceph->ephopt,nav,rs,dts,&var,&svh)) {
+            continue;
+        }
+        for (k=0;k<3;k++) dr[k]=rs[k]-rsc[k];
+        err=norm(dr,3);
+        if (err>errp) errp=err;
+        rmsp+=err*err;
+        err=fabs(dts[0]-dtsc[0])*CLIGHT;
+        if (err>errc) errc=err;
+        rmsc+=err*err;
+        for (k=0;k<3;k++) dr[k]=rs[k+3]-rsc[k+3];
+        if ((err=norm(dr,3))>errv) errv=err;
+        i++; n++;
+    }
+    nq=i;
+    if (nq<=0) {
+        fprintf(stderr,"no query\n");
+        free(time); free(sat);
+        return;
+    }
+    tick=tickget();
+    for (i=0;i<nq;i++) {
+        satpos(time[i],time[i],sat[i],ceph->ephopt,nav,rs,dts,&var,&svh);
+    }
+    t1=(tickget()-tick)*1E6/nq;
+    tick=tickget();
+    for (i=0;i<nq;i++) {
+        cheb2pos(time[i],sat[i],ceph,rs,dts,&var);
+    }
+    t2=(tickget()-tick)*1E6/nq;
+    
+    printf("queries        : %d\n",nq);
+    printf("pos error (m)  : max=%.4f rms=%.4f\n",errp,sqrt(rmsp/n));
+    printf("clk error (m)  : max=%.4f rms=%.4f\n",errc,sqrt(rmsc/n));
+    printf("vel error (m/s): max=%.5f\n",errv);
+    printf("pos error (m)  : max=%.4f (teph=time)\n",errs);
+    printf("satpos   (ns)  : %.0f\n",t1);
+    printf("cheb2pos (ns)  : %.0f (x%.1f)\n",t2,t2>0.0?t1/t2:0.0);
+    free(time); free(sat);
+}
+/* main ----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    nav_t nav={0};
+    cheph_t ceph={0};
+    gtime_t ts,te;
+    double span=3600.0,errp=0.0,errc=0.0;
+    unsigned int tick;
+    char *files[MAXEXFILE],*outfile="",*infile="";
+    int i,n=0,nq=100000,deg=10,prec=0,stat;
+    
+    for (i=1;i<argc;i++) {
+        if      (!strcmp(argv[i],"-prec")) prec=1;
+        else if (!strcmp(argv[i],"-span")&&i+1<argc) span=atof(argv[++i]);
+        else if (!strcmp(argv[i],"-deg" )&&i+1<argc) deg=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-n"   )&&i+1<argc) nq=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-o"   )&&i+1<argc) outfile=argv[++i];
+        else if (!strcmp(argv[i],"-i"   )&&i+1<argc) infile=argv[++i];
+        else if (*argv[i]=='-') printhelp();
+        else if (n<MAXEXFILE) files[n++]=argv[i];
+    }
+    if (n<=0) printhelp();
+    
+    readnavf(files,n,&nav);
+    
+    if (!navspan(&nav,prec,&ts,&te)) {
+        fprintf(stderr,"no ephemeris data\n");
+        return -1;
+    }
+    tick=tickget();
+    if (*infile) stat=readcheb(infile,&ceph);
+    else stat=chebfit(ts,te,span,deg,&nav,prec?EPHOPT_PREC:EPHOPT_BRDC,&ceph);
+    if (stat<0) {
+        fprintf(stderr,"chebyshev ephemeris %s error\n",*infile?"read":"fit");
+        return -1;
+    }
+    printf("%s %s: %s",PROGNAME,*infile?"read":"fit",time_str(ceph.ts,0));
+    printf("-%s span=%.0f deg=%d\n",time_str(te,0),ceph.span,ceph.deg);
+    printf("%-15s: %d (%.1f ms)\n","segments",ceph.n,(double)(tickget()-tick));
+    printf("%-15s: %.1f KB\n","table size",
+           (sizeof(int)*MAXSAT*ceph.nseg+ceph.n*(sizeof(double)*4*(ceph.deg+1)+
+            sizeof(float)*3))/1024.0);
+    for (i=0;i<ceph.n;i++) {
+        if (ceph.err[i*2  ]>errp) errp=ceph.err[i*2  ];
+        if (ceph.err[i*2+1]>errc) errc=ceph.err[i*2+1];
+    }
+    printf("%-15s: pos=%.4f clk=%.4f\n","max fit err (m)",errp,errc);
+    
+    if (*outfile&&!savecheb(outfile,&ceph)) {
+        fprintf(stderr,"chebyshev ephemeris save error: %s\n",outfile);
+    }
+    benchquery(&ceph,&nav,ts,te,nq);
+    
+    freecheb(&ceph);
+    freenav(&nav,0xFF);
+    return 0;
+}
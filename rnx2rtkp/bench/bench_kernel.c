@@ -0,0 +1,494 @@
+/*------------------------------------------------------------------------------
+* bench_kernel.c : core kernel and end-to-end benchmarks
+*
+* history : 2026/10/18  1.0 new
+*-----------------------------------------------------------------------------*/
+#include <stdarg.h>
+#include "rtklib.h"
+
+#define PROGNAME    "bench_kernel"      /* program name */
+#define MAXBENCH    64                  /* max number of benchmark results */
+#define NREP        3                   /* number of repetitions */
+#define NGLO        24                  /* number of synthetic glonass ephs */
+#define NFILT       40                  /* number of states for filter */
+#define MFILT       20                  /* number of measurements for filter */
+#define NAMB        16                  /* number of ambiguities for lambda */
+#define NMAT        64                  /* size of matrix for matmul */
+#define TSP3        900.0               /* sp3 epoch interval (s) */
+
+/* help text -----------------------------------------------------------------*/
+static const char *help[]={
+"",
+" usage: bench_kernel [option]...",
+"        bench_kernel -cmp old.json new.json",
+"",
+" Run micro-benchmarks of core kernels (eph2pos, geph2pos, peph2pos, pntpos,",
+" filter, lambda, matmul, rinex obs and sp3 readers) and timed end-to-end",
+" commands, and write the results as JSON. Each benchmark is repeated and the",
+" minimum time per operation is reported. Precise ephemerides for peph2pos",
+" and the sp3 reader are generated from the broadcast ephemerides. With",
+" -cmp, the results of two JSON files are compared as new/old time ratios.",
+"",
+" -?        print help",
+" -obs file rinex obs file [none]",
+" -nav file rinex nav file [none]",
+" -t time   min time of a repetition (ms) [200]",
+" -c commit commit id written to JSON [\"\"]",
+" -run name cmd  time command cmd as end-to-end benchmark name",
+" -o file   output JSON file [stdout]",
+};
+typedef struct {                        /* benchmark result type */
+    char name[64];                      /* benchmark name */
+    char unit[16];                      /* unit of value */
+    double value;                       /* time per operation */
+    double nop;                         /* number of operations */
+} result_t;
+
+typedef struct {                        /* benchmark context type */
+    obs_t obs;                          /* observation data */
+    nav_t nav;                          /* broadcast navigation data */
+    nav_t pnav;                         /* precise ephemeris data */
+    geph_t geph[NGLO];                  /* synthetic glonass ephemerides */
+    int *iepoch,nepoch;                 /* index of epochs in obs data */
+    const char *obsfile;                /* rinex obs file */
+    char sp3file[1024];                 /* generated sp3 file */
+    double *x,*P,*H,*v,*R,*x_,*P_;      /* filter data */
+    double *a,*Q,*F,s[2];               /* lambda data */
+    double *A,*B,*C;                    /* matmul data */
+} ctx_t;
+
+typedef double (*benchfunc_t)(ctx_t *ctx); /* benchmark function type */
+
+static result_t results[MAXBENCH];      /* benchmark results */
+static int nresult=0;                   /* number of benchmark results */
+static unsigned int mintime=200;        /* min time of a repetition (ms) */
+static unsigned int seed=1;             /* seed of random numbers */
+
+/* print help ----------------------------------------------------------------*/
+static void printhelp(void)
+{
+    int i;
+    for (i=0;i<(int)(sizeof(help)/sizeof(*help));i++) fprintf(stderr,"%s\n",help[i]);
+    exit(0);
+}
+/* uniform random number in [-1,1] -------------------------------------------*/
+static double urand(void)
+{
+    seed=seed*1103515245u+12345u;
+    return ((seed>>8)&0xFFFF)/32767.5-1.0;
+}
+/* add benchmark result ------------------------------------------------------*/
+static void addresult(const char *name, const char *unit, double value,
+                      double nop)
+{
+    if (nresult>=MAXBENCH) return;
+    strncpy(results[nresult].name,name,63);
+    strncpy(results[nresult].unit,unit,15);
+    results[nresult].value=value;
+    results[nresult++].nop=nop;
+    fprintf(stderr,"%-24s %14.1f %s\n",name,value,unit);
+}
+/* run benchmark -------------------------------------------------------------*/
+static void runbench(const char *name, benchfunc_t func, ctx_t *ctx)
+{
+    unsigned int tick,t;
+    double nop,ns,nsmin=0.0,nopmin=0.0;
+    int i;
+    
+    for (i=0;i<NREP;i++) {
+        tick=tickget();
+        nop=0.0;
+        do {
+            nop+=func(ctx);
+        } while ((t=tickget()-tick)<mintime);
+        
+        if (nop<=0.0) return;
+        ns=t*1E6/nop;
+        if (i==0||ns<nsmin) {nsmin=ns; nopmin=nop;}
+    }
+    addresult(name,"ns/op",nsmin,nopmin);
+}
+/* run end-to-end command ----------------------------------------------------*/
+static void runcmd(const char *name, const char *cmd)
+{
+    unsigned int tick,t,tmin=0;
+    int i;
+    
+    for (i=0;i<NREP;i++) {
+        tick=tickget();
+        if (system(cmd)) {
+            fprintf(stderr,"command error: %s\n",cmd);
+            return;
+        }
+        t=tickget()-tick;
+        if (i==0||t<tmin) tmin=t;
+    }
+    addresult(name,"ms",(double)tmin,1.0);
+}
+/* kernel benchmarks ---------------------------------------------------------*/
+static double bench_eph2pos(ctx_t *ctx)
+{
+    double rs[6],dts[2],var;
+    int i;
+    
+    for (i=0;i<ctx->nav.n;i++) {
+        eph2pos(timeadd(ctx->nav.eph[i].toe,600.0),ctx->nav.eph+i,rs,dts,&var);
+    }
+    return ctx->nav.n;
+}
+static double bench_geph2pos(ctx_t *ctx)
+{
+    double rs[6],dts[2],var;
+    int i;
+    
+    for (i=0;i<NGLO;i++) {
+        geph2pos(timeadd(ctx->geph[i].toe,900.0),ctx->geph+i,rs,dts,&var);
+    }
+    return NGLO;
+}
+static double bench_peph2pos(ctx_t *ctx)
+{
+    gtime_t time;
+    double rs[6],dts[2],var;
+    int i,prn,n=0;
+    
+    for (i=0;i<16;i++) {
+        time=timeadd(ctx->pnav.peph[0].time,3600.0+i*4321.0);
+        for (prn=1;prn<=MAXPRNGPS;prn++) {
+            peph2pos(time,satno(SYS_GPS,prn),&ctx->pnav,0,rs,dts,&var);
+            n++;
+        }
+    }
+    return n;
+}
+static double bench_pntpos(ctx_t *ctx)
+{
+    prcopt_t opt=prcopt_default;
+    sol_t sol;
+    char msg[128];
+    int i,n=0;
+    
+    memset(&sol,0,sizeof(sol_t));
+    opt.navsys=SYS_GPS;
+    
+    for (i=0;i<ctx->nepoch&&n<100;i++,n++) {
+        pntpos(ctx->obs.data+ctx->iepoch[i],ctx->iepoch[i+1]-ctx->iepoch[i],
+               &ctx->nav,&opt,&sol,NULL,NULL,msg);
+    }
+    return n;
+}
+static double bench_filter(ctx_t *ctx)
+{
+    matcpy(ctx->x_,ctx->x,NFILT,1);
+    matcpy(ctx->P_,ctx->P,NFILT,NFILT);
+    filter(ctx->x_,ctx->P_,ctx->H,ctx->v,ctx->R,NFILT,MFILT);
+    return 1.0;
+}
+static double bench_lambda(ctx_t *ctx)
+{
+    lambda(NAMB,2,ctx->a,ctx->Q,ctx->F,ctx->s);
+    return 1.0;
+}
+static double bench_matmul(ctx_t *ctx)
+{
+    matmul("NN",NMAT,NMAT,NMAT,1.0,ctx->A,ctx->B,0.0,ctx->C);
+    return 1.0;
+}
+static double bench_readrnxobsb(ctx_t *ctx)
+{
+    gtime_t t0={0};
+    obs_t obs={0};
+    
+    readrnxt(ctx->obsfile,1,t0,t0,0.0,"",&obs,NULL,NULL);
+    free(obs.data);
+    return 1.0;
+}
+static double bench_readsp3b(ctx_t *ctx)
+{
+    nav_t nav={0};
+    
+    readsp3(ctx->sp3file,&nav,0);
+    free(nav.peph);
+    return 1.0;
+}
+/* generate synthetic glonass ephemerides ------------------------------------*/
+static void gengeph(ctx_t *ctx, gtime_t time)
+{
+    const double r=25510E3,v=3953.0,inc=64.8*D2R;
+    double u;
+    int i;
+    
+    for (i=0;i<NGLO;i++) {
+        u=i*2.0*PI/NGLO;
+        ctx->geph[i].sat=satno(SYS_GLO,i+1);
+        ctx->geph[i].toe=ctx->geph[i].tof=time;
+        ctx->geph[i].pos[0]= r*cos(u);
+        ctx->geph[i].pos[1]= r*sin(u)*cos(inc);
+        ctx->geph[i].pos[2]= r*sin(u)*sin(inc);
+        ctx->geph[i].vel[0]=-v*sin(u);
+        ctx->geph[i].vel[1]= v*cos(u)*cos(inc);
+        ctx->geph[i].vel[2]= v*cos(u)*sin(inc);
+        ctx->geph[i].taun=1E-5*urand();
+    }
+}
+/* generate precise ephemerides and sp3 file from broadcast ephemerides ------*/
+static int genpeph(ctx_t *ctx, const char *file)
+{
+    FILE *fp;
+    peph_t *peph;
+    gtime_t t0;
+    double ep[6],rs[6],dts[2],var;
+    int i,j,k,prn,svh,n=(int)(86400.0/TSP3)+1;
+    
+    if (ctx->nav.n<=0) return 0;
+    
+    if (!(ctx->pnav.peph=(peph_t *)calloc(sizeof(peph_t),n))) return 0;
+    ctx->pnav.ne=ctx->pnav.nemax=n;
+    
+    time2epoch(ctx->nav.eph[0].toe,ep);
+    ep[3]=ep[4]=ep[5]=0.0;
+    t0=epoch2time(ep);
+    
+    for (i=0;i<n;i++) {
+        peph=ctx->pnav.peph+i;
+        peph->time=timeadd(t0,i*TSP3);
+        for (prn=1;prn<=MAXPRNGPS;prn++) {
+            j=satno(SYS_GPS,prn)-1;
+            if (!satpos(peph->time,peph->time,j+1,EPHOPT_BRDC,&ctx->nav,rs,dts,
+                        &var,&svh)) continue;
+            for (k=0;k<3;k++) peph->pos[j][k]=rs[k];
+            peph->pos[j][3]=dts[0];
+        }
+    }
+    if (!(fp=fopen(file,"w"))) return 0;
+    
+    fprintf(fp,"#cP%4.0f %2.0f %2.0f %2.0f %2.0f %11.8f %7d ORBIT IGS14 BCT  BNC\n",
+            ep[0],ep[1],ep[2],ep[3],ep[4],ep[5],n);
+    fprintf(fp,"## bench_kernel\n");
+    for (i=0;i<5;i++) {
+        fprintf(fp,i==0?"+   %2d   ":"+        ",MAXPRNGPS);
+        for (j=0;j<17;j++) {
+            prn=i*17+j+1;
+            if (prn<=MAXPRNGPS) fprintf(fp,"G%02d",prn); else fprintf(fp,"  0");
+        }
+        fprintf(fp,"\n");
+    }
+    for (i=0;i<5;i++) fprintf(fp,"++       \n");
+    fprintf(fp,"%%c G  cc GPS ccc cccc cccc cccc cccc ccccc ccccc ccccc ccccc\n");
+    fprintf(fp,"%%c cc cc ccc ccc cccc cccc cccc cccc ccccc ccccc ccccc ccccc\n");
+    fprintf(fp,"%%f  1.2500000  1.025000000  0.00000000000  0.000000000000000\n");
+    fprintf(fp,"%%f  0.0000000  0.000000000  0.00000000000  0.000000000000000\n");
+    for (i=0;i<6;i++) fprintf(fp,"%%i    0    0    0    0      0      0      0      0         0\n");
+    
+    for (i=0;i<n;i++) {
+        peph=ctx->pnav.peph+i;
+        time2epoch(peph->time,ep);
+        fprintf(fp,"*  %4.0f %2.0f %2.0f %2.0f %2.0f %11.8f\n",ep[0],ep[1],ep[2],
+                ep[3],ep[4],ep[5]);
+        for (prn=1;prn<=MAXPRNGPS;prn++) {
+            j=satno(SYS_GPS,prn)-1;
+            if (norm(peph->pos[j],3)<=0.0) {
+                fprintf(fp,"PG%02d %13.6f %13.6f %13.6f %13.6f\n",prn,0.0,0.0,
+                        0.0,999999.999999);
+                continue;
+            }
+            fprintf(fp,"PG%02d %13.6f %13.6f %13.6f %13.6f\n",prn,
+                    peph->pos[j][0]*1E-3,peph->pos[j][1]*1E-3,
+                    peph->pos[j][2]*1E-3,peph->pos[j][3]*1E6);
+        }
+    }
+    fprintf(fp,"EOF\n");
+    fclose(fp);
+    return 1;
+}
+/* initialize benchmark context ----------------------------------------------*/
+static int initctx(ctx_t *ctx, const char *obsfile, const char *navfile)
+{
+    gtime_t t0={0};
+    int i,n;
+    
+    ctx->obsfile=obsfile;
+    
+    if (*navfile) {
+        readrnxt(navfile,1,t0,t0,0.0,"",NULL,&ctx->nav,NULL);
+        if (ctx->nav.n<=0&&ctx->nav.ng<=0) {
+            fprintf(stderr,"no nav data: %s\n",navfile);
+            return 0;
+        }
+        uniqnav(&ctx->nav);
+    }
+    if (*obsfile) {
+        readrnxt(obsfile,1,t0,t0,0.0,"",&ctx->obs,NULL,NULL);
+        if (ctx->obs.n<=0) {
+            fprintf(stderr,"no obs data: %s\n",obsfile);
+            return 0;
+        }
+        sortobs(&ctx->obs);
+        if (!(ctx->iepoch=imat(ctx->obs.n+1,1))) {
+            fprintf(stderr,"memory allocation error\n");
+            return 0;
+        }
+        for (i=n=0;i<ctx->obs.n;i++) {
+            if (i==0||timediff(ctx->obs.data[i].time,ctx->obs.data[i-1].time)!=0.0) {
+                ctx->iepoch[n++]=i;
+            }
+        }
+        ctx->iepoch[n]=ctx->obs.n;
+        ctx->nepoch=n;
+    }
+    gengeph(ctx,ctx->nav.n>0?ctx->nav.eph[0].toe:gpst2time(1877,0.0));
+    
+    sprintf(ctx->sp3file,"%s.sp3",PROGNAME);
+    if (!genpeph(ctx,ctx->sp3file)) ctx->sp3file[0]='\0';
+    
+    /* filter: states, diagonal covariance and random design matrix */
+    ctx->x=mat(NFILT,1); ctx->P=zeros(NFILT,NFILT); ctx->H=mat(NFILT,MFILT);
+    ctx->v=mat(MFILT,1); ctx->R=zeros(MFILT,MFILT);
+    ctx->x_=mat(NFILT,1); ctx->P_=mat(NFILT,NFILT);
+    for (i=0;i<NFILT;i++) {
+        ctx->x[i]=100.0*urand();
+        ctx->P[i+i*NFILT]=1.0+fabs(urand());
+    }
+    for (i=0;i<NFILT*MFILT;i++) ctx->H[i]=urand();
+    for (i=0;i<MFILT;i++) {
+        ctx->v[i]=urand();
+        ctx->R[i+i*MFILT]=0.01;
+    }
+    /* lambda: float ambiguities and positive definite covariance */
+    ctx->a=mat(NAMB,1); ctx->Q=mat(NAMB,NAMB); ctx->F=mat(NAMB,2);
+    ctx->A=mat(NMAT,NMAT); ctx->B=mat(NMAT,NMAT); ctx->C=mat(NMAT,NMAT);
+    for (i=0;i<NMAT*NMAT;i++) {
+        ctx->A[i]=urand(); ctx->B[i]=urand();
+    }
+    matmul("NT",NAMB,NAMB,NAMB,0.01,ctx->A,ctx->A,0.0,ctx->Q);
+    for (i=0;i<NAMB;i++) {
+        ctx->Q[i+i*NAMB]+=0.01;
+        ctx->a[i]=10.0*urand();
+    }
+    return 1;
+}
+/* free benchmark context ----------------------------------------------------*/
+static void freectx(ctx_t *ctx)
+{
+    freeobs(&ctx->obs);
+    freenav(&ctx->nav,0xFF);
+    free(ctx->pnav.peph);
+    free(ctx->iepoch);
+    free(ctx->x); free(ctx->P); free(ctx->H); free(ctx->v); free(ctx->R);
+    free(ctx->x_); free(ctx->P_);
+    free(ctx->a); free(ctx->Q); free(ctx->F);
+    free(ctx->A); free(ctx->B); free(ctx->C);
+    if (*ctx->sp3file) remove(ctx->sp3file);
+}
+/* write results as JSON -----------------------------------------------------*/
+static void writejson(FILE *fp, const char *commit)
+{
+    char str[64];
+    int i;
+    
+    time2str(timeget(),str,0);
+    fprintf(fp,"{\n");
+    fprintf(fp,"  \"program\": \"%s\",\n",PROGNAME);
+    fprintf(fp,"  \"version\": \"%s %s\",\n",VER_RTKLIB,PATCH_LEVEL);
+    fprintf(fp,"  \"commit\": \"%s\",\n",commit);
+    fprintf(fp,"  \"date\": \"%s\",\n",str);
+    fprintf(fp,"  \"results\": [\n");
+    for (i=0;i<nresult;i++) {
+        fprintf(fp,"    {\"name\": \"%s\", \"unit\": \"%s\", \"value\": %.1f, "
+                "\"ops\": %.0f}%s\n",results[i].name,results[i].unit,
+                results[i].value,results[i].nop,i<nresult-1?",":"");
+    }
+    fprintf(fp,"  ]\n}\n");
+}
+/* read results from JSON written by writejson() -----------------------------*/
+static int readjson(const char *file, result_t *res, int nmax)
+{
+    FILE *fp;
+    char buff[1024],*p;
+    int n=0;
+    
+    if (!(fp=fopen(file,"r"))) {
+        fprintf(stderr,"file open error: %s\n",file);
+        return 0;
+    }
+    while (fgets(buff,sizeof(buff),fp)&&n<nmax) {
+        if (!(p=strstr(buff,"{\"name\": "))) continue;
+        if (sscanf(p,"{\"name\": \"%63[^\"]\", \"unit\": \"%15[^\"]\", "
+                   "\"value\": %lf, \"ops\": %lf",res[n].name,res[n].unit,
+                   &res[n].value,&res[n].nop)==4) n++;
+    }
+    fclose(fp);
+    return n;
+}
+/* compare results of two JSON files -----------------------------------------*/
+static int cmpjson(const char *file1, const char *file2)
+{
+    static result_t res1[MAXBENCH],res2[MAXBENCH];
+    int i,j,n1,n2;
+    
+    if (!(n1=readjson(file1,res1,MAXBENCH))||!(n2=readjson(file2,res2,MAXBENCH))) {
+        return -1;
+    }
+    printf("%-24s %14s %14s %6s %8s\n","name","old","new","unit","new/old");
+    for (i=0;i<n2;i++) {
+        for (j=0;j<n1;j++) if (!strcmp(res1[j].name,res2[i].name)) break;
+        if (j>=n1||res1[j].value<=0.0) {
+            printf("%-24s %14s %14.1f %6s\n",res2[i].name,"-",res2[i].value,
+                   res2[i].unit);
+            continue;
+        }
+        printf("%-24s %14.1f %14.1f %6s %8.3f\n",res2[i].name,res1[j].value,
+               res2[i].value,res2[i].unit,res2[i].value/res1[j].value);
+    }
+    return 0;
+}
+/* bench_kernel main ---------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    static ctx_t ctx;
+    FILE *fp=stdout;
+    char *obsfile="",*navfile="",*outfile="",*commit="";
+    char *runs[MAXBENCH][2];
+    int i,nrun=0;
+    
+    for (i=1;i<argc;i++) {
+        if      (!strcmp(argv[i],"-obs")&&i+1<argc) obsfile=argv[++i];
+        else if (!strcmp(argv[i],"-nav")&&i+1<argc) navfile=argv[++i];
+        else if (!strcmp(argv[i],"-t"  )&&i+1<argc) mintime=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-c"  )&&i+1<argc) commit=argv[++i];
+        else if (!strcmp(argv[i],"-o"  )&&i+1<argc) outfile=argv[++i];
+        else if (!strcmp(argv[i],"-run")&&i+2<argc) {
+            if (nrun<MAXBENCH) {
+                runs[nrun][0]=argv[++i];
+                runs[nrun++][1]=argv[++i];
+            }
+            else i+=2;
+        }
+        else if (!strcmp(argv[i],"-cmp")&&i+2<argc) {
+            return cmpjson(argv[i+1],argv[i+2]);
+        }
+        else printhelp();
+    }
+    if (!initctx(&ctx,obsfile,navfile)) return -1;
+    if (ctx.nav.n>0) runbench("eph2pos",bench_eph2pos,&ctx);
+    runbench("geph2pos",bench_geph2pos,&ctx);
+    if (ctx.pnav.ne>0) runbench("peph2pos",bench_peph2pos,&ctx);
+    if (ctx.nav.n>0&&ctx.nepoch>0) runbench("pntpos",bench_pntpos,&ctx);
+    runbench("filter",bench_filter,&ctx);
+    runbench("lambda",bench_lambda,&ctx);
+    runbench("matmul",bench_matmul,&ctx);
+    if (*obsfile) runbench("readrnxobsb",bench_readrnxobsb,&ctx);
+    if (*ctx.sp3file) runbench("readsp3b",bench_readsp3b,&ctx);
+    
+    for (i=0;i<nrun;i++) runcmd(runs[i][0],runs[i][1]);
+    
+    freectx(&ctx);
+    
+    if (*outfile&&!(fp=fopen(outfile,"w"))) {
+        fprintf(stderr,"file open error: %s\n",outfile);
+        return -1;
+    }
+    writejson(fp,commit);
+    if (fp!=stdout) fclose(fp);
+    return 0;
+}
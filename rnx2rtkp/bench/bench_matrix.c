@@ -0,0 +1,364 @@
+/*------------------------------------------------------------------------------
+* bench_matrix.c : matrix routine benchmark
+*
+* history : 2026/10/18  1.0 new
+*-----------------------------------------------------------------------------*/
+#include <stdarg.h>
+#include "rtklib.h"
+
+#define PROGNAME    "bench_matrix"      /* program name */
+#define NREP        3                   /* number of repetitions */
+
+/* help text -----------------------------------------------------------------*/
+static const char *help[]={
+"",
+" usage: bench_matrix [option]...",
+"",
+" Compare matmul(), matinv() and solve() of the library with the reference",
+" kernels (naive triple loop and Crout LU of the previous implementation) for",
+" the matrix sizes of the kalman filter in rtkpos() and pppos(), and check the",
+" maximum relative difference of the results. With -blas, the library routines",
+" are also timed with the BLAS/LAPACK library loaded by matsetblas().",
+"",
+" -?        print help",
+" -t time   min time of a repetition (ms) [200]",
+" -blas lib BLAS/LAPACK library (auto: search default libraries) [off]",
+};
+typedef struct {                        /* benchmark case type */
+    const char *name;                   /* case name */
+    int n,m;                            /* number of states and measurements */
+} case_t;
+
+typedef struct {                        /* matrix kernels type */
+    void (*matmul)(const char *, int, int, int, double, const double *,
+                   const double *, double, double *);
+    int (*matinv)(double *, int);
+    int (*solve)(const char *, const double *, const double *, int, int,
+                 double *);
+} kern_t;
+
+typedef struct {                        /* benchmark data type */
+    const kern_t *kern;                 /* matrix kernels */
+    int n,m;                            /* number of states and measurements */
+    double *x,*P,*H,*v,*R,*xp,*Pp;      /* filter data */
+    double *F,*Q,*K,*I;                 /* filter work */
+    double *A,*B,*C,*Y,*X;              /* matmul, matinv and solve data */
+} data_t;
+
+typedef double (*benchfunc_t)(data_t *data); /* benchmark function type */
+
+/* matrix sizes of rtkpos() and pppos() (n: active states, m: measurements) --*/
+static const case_t cases[]={
+    {"pntpos"          ,  4,  10},      /* lsq() of single point positioning */
+    {"rtkpos_static"   ,  3,  24},      /* static rtk with fixed ambiguities */
+    {"rtkpos_kine_gps" , 29,  36},      /* kinematic L1+L2, 10 sats */
+    {"rtkpos_kine_gr"  , 45,  68},      /* kinematic L1+L2, gps+glo 18 sats */
+    {"pppos_kine_gps"  , 20,  14},      /* ppp kinematic iono-free, 7 sats */
+    {"pppos_kine_gr"   , 47,  36},      /* ppp kinematic iono-free, 18 sats */
+    {"pppos_kine_grec" , 88,  80},      /* ppp kinematic gps+glo+gal+bds */
+    {"pppos_ion_grec"  ,168, 160},      /* ppp with estimated iono, 40 sats */
+    {NULL,0,0}
+};
+static unsigned int mintime=200;        /* min time of a repetition (ms) */
+static unsigned int seed=1;             /* seed of random numbers */
+
+/* print help ----------------------------------------------------------------*/
+static void printhelp(void)
+{
+    int i;
+    for (i=0;i<(int)(sizeof(help)/sizeof(*help));i++) fprintf(stderr,"%s\n",help[i]);
+    exit(0);
+}
+/* uniform random number in [-1,1] -------------------------------------------*/
+static double urand(void)
+{
+    seed=seed*1103515245u+12345u;
+    return ((seed>>8)&0xFFFF)/32767.5-1.0;
+}
+/* reference kernels (previous implementation without LAPACK) ----------------*/
+static void ref_matmul(const char *tr, int n, int k, int m, double alpha,
+                       const double *A, const double *B, double beta,
+                       double *C)
+{
+    double d;
+    int i,j,x,f=tr[0]=='N'?(tr[1]=='N'?1:2):(tr[1]=='N'?3:4);
+    
+    for (i=0;i<n;i++) for (j=0;j<k;j++) {
+        d=0.0;
+        switch (f) {
+            case 1: for (x=0;x<m;x++) d+=A[i+x*n]*B[x+j*m]; break;
+            case 2: for (x=0;x<m;x++) d+=A[i+x*n]*B[j+x*k]; break;
+            case 3: for (x=0;x<m;x++) d+=A[x+i*m]*B[x+j*m]; break;
+            case 4: for (x=0;x<m;x++) d+=A[x+i*m]*B[j+x*k]; break;
+        }
+        if (beta==0.0) C[i+j*n]=alpha*d; else C[i+j*n]=alpha*d+beta*C[i+j*n];
+    }
+}
+static int ref_ludcmp(double *A, int n, int *indx, double *d)
+{
+    double big,s,tmp,*vv=mat(n,1);
+    int i,imax=0,j,k;
+    
+    *d=1.0;
+    for (i=0;i<n;i++) {
+        big=0.0; for (j=0;j<n;j++) if ((tmp=fabs(A[i+j*n]))>big) big=tmp;
+        if (big>0.0) vv[i]=1.0/big; else {free(vv); return -1;}
+    }
+    for (j=0;j<n;j++) {
+        for (i=0;i<j;i++) {
+            s=A[i+j*n]; for (k=0;k<i;k++) s-=A[i+k*n]*A[k+j*n]; A[i+j*n]=s;
+        }
+        big=0.0;
+        for (i=j;i<n;i++) {
+            s=A[i+j*n]; for (k=0;k<j;k++) s-=A[i+k*n]*A[k+j*n]; A[i+j*n]=s;
+            if ((tmp=vv[i]*fabs(s))>=big) {big=tmp; imax=i;}
+        }
+        if (j!=imax) {
+            for (k=0;k<n;k++) {
+                tmp=A[imax+k*n]; A[imax+k*n]=A[j+k*n]; A[j+k*n]=tmp;
+            }
+            *d=-(*d); vv[imax]=vv[j];
+        }
+        indx[j]=imax;
+        if (A[j+j*n]==0.0) {free(vv); return -1;}
+        if (j!=n-1) {
+            tmp=1.0/A[j+j*n]; for (i=j+1;i<n;i++) A[i+j*n]*=tmp;
+        }
+    }
+    free(vv);
+    return 0;
+}
+static void ref_lubksb(const double *A, int n, const int *indx, double *b)
+{
+    double s;
+    int i,ii=-1,ip,j;
+    
+    for (i=0;i<n;i++) {
+        ip=indx[i]; s=b[ip]; b[ip]=b[i];
+        if (ii>=0) for (j=ii;j<i;j++) s-=A[i+j*n]*b[j]; else if (s) ii=i;
+        b[i]=s;
+    }
+    for (i=n-1;i>=0;i--) {
+        s=b[i]; for (j=i+1;j<n;j++) s-=A[i+j*n]*b[j]; b[i]=s/A[i+i*n];
+    }
+}
+static int ref_matinv(double *A, int n)
+{
+    double d,*B;
+    int i,j,*indx;
+    
+    indx=imat(n,1); B=mat(n,n); matcpy(B,A,n,n);
+    if (ref_ludcmp(B,n,indx,&d)) {free(indx); free(B); return -1;}
+    for (j=0;j<n;j++) {
+        for (i=0;i<n;i++) A[i+j*n]=0.0;
+        A[j+j*n]=1.0;
+        ref_lubksb(B,n,indx,A+j*n);
+    }
+    free(indx); free(B);
+    return 0;
+}
+static int ref_solve(const char *tr, const double *A, const double *Y, int n,
+                     int m, double *X)
+{
+    double *B=mat(n,n);
+    int info;
+    
+    matcpy(B,A,n,n);
+    if (!(info=ref_matinv(B,n))) {
+        ref_matmul(tr[0]=='N'?"NN":"TN",n,m,n,1.0,B,Y,0.0,X);
+    }
+    free(B);
+    return info;
+}
+static const kern_t kern_ref={ref_matmul,ref_matinv,ref_solve};
+static const kern_t kern_lib={matmul,matinv,solve};
+
+/* kalman filter update with kernels (same as filter_() in rtkcmn.c) ---------*/
+static int kfilter(data_t *d)
+{
+    const kern_t *k=d->kern;
+    int i,n=d->n,m=d->m,info;
+    
+    matcpy(d->Q,d->R,m,m);
+    matcpy(d->xp,d->x,n,1);
+    for (i=0;i<n*n;i++) d->I[i]=i%(n+1)?0.0:1.0;
+    k->matmul("NN",n,m,n,1.0,d->P,d->H,0.0,d->F);
+    k->matmul("TN",m,m,n,1.0,d->H,d->F,1.0,d->Q);
+    if (!(info=k->matinv(d->Q,m))) {
+        k->matmul("NN",n,m,m,1.0,d->F,d->Q,0.0,d->K);
+        k->matmul("NN",n,1,m,1.0,d->K,d->v,1.0,d->xp);
+        k->matmul("NT",n,n,m,-1.0,d->K,d->H,1.0,d->I);
+        k->matmul("NN",n,n,n,1.0,d->I,d->P,0.0,d->Pp);
+    }
+    return info;
+}
+/* benchmark functions -------------------------------------------------------*/
+static double bench_filter(data_t *d)
+{
+    kfilter(d);
+    return 1.0;
+}
+static double bench_matmul(data_t *d)
+{
+    d->kern->matmul("NN",d->n,d->n,d->n,1.0,d->A,d->B,0.0,d->C);
+    return 1.0;
+}
+static double bench_matinv(data_t *d)
+{
+    matcpy(d->C,d->A,d->m,d->m);
+    d->kern->matinv(d->C,d->m);
+    return 1.0;
+}
+static double bench_solve(data_t *d)
+{
+    d->kern->solve("T",d->A,d->Y,d->m,1,d->X);
+    return 1.0;
+}
+/* run benchmark (ns/op) -----------------------------------------------------*/
+static double runbench(benchfunc_t func, data_t *d)
+{
+    unsigned int tick,t;
+    double nop,ns,nsmin=0.0;
+    int i;
+    
+    for (i=0;i<NREP;i++) {
+        tick=tickget();
+        nop=0.0;
+        do {
+            nop+=func(d);
+        } while ((t=tickget()-tick)<mintime);
+        
+        ns=t*1E6/nop;
+        if (i==0||ns<nsmin) nsmin=ns;
+    }
+    return nsmin;
+}
+/* max relative difference of matrices ---------------------------------------*/
+static double maxdiff(const double *A, const double *B, int n)
+{
+    double d,dmax=0.0,amax=0.0;
+    int i;
+    
+    for (i=0;i<n;i++) {
+        if ((d=fabs(A[i]-B[i]))>dmax) dmax=d;
+        if (fabs(A[i])>amax) amax=fabs(A[i]);
+    }
+    return amax>0.0?dmax/amax:dmax;
+}
+/* generate benchmark data ---------------------------------------------------
+* P: symmetric positive definite, H: design matrix with geometry rows and an
+* ambiguity row per measurement, A: dense m x m matrix
+*---------------------------------------------------------------------------*/
+static void gendata(data_t *d, int n, int m)
+{
+    int i,j,nn=n>m?n:m;
+    
+    d->n=n; d->m=m;
+    d->x=mat(n,1); d->P=mat(n,n); d->H=zeros(n,m); d->v=mat(m,1);
+    d->R=zeros(m,m); d->xp=mat(n,1); d->Pp=mat(n,n);
+    d->F=mat(n,m); d->Q=mat(m,m); d->K=mat(n,m); d->I=mat(n,n);
+    d->A=mat(nn,nn); d->B=mat(nn,nn); d->C=mat(nn,nn);
+    d->Y=mat(m,1); d->X=mat(m,1);
+    
+    for (i=0;i<n;i++) d->x[i]=urand()*100.0;
+    for (i=0;i<nn*nn;i++) {d->A[i]=urand(); d->B[i]=urand();}
+    matmul("NT",n,n,n,1.0,d->A,d->A,0.0,d->P);
+    for (i=0;i<n;i++) d->P[i+i*n]+=n;
+    for (j=0;j<m;j++) {
+        for (i=0;i<n&&i<3;i++) d->H[i+j*n]=urand();
+        if (n>4) d->H[4+j%(n-4)+j*n]=1.0;
+        else if (n>3) d->H[3+j*n]=1.0;
+        d->v[j]=urand();
+        d->R[j+j*m]=0.01+urand()*urand();
+        d->Y[j]=urand();
+    }
+    for (i=0;i<m;i++) d->A[i+i*m]+=m;
+}
+static void freedata(data_t *d)
+{
+    free(d->x); free(d->P); free(d->H); free(d->v); free(d->R); free(d->xp);
+    free(d->Pp); free(d->F); free(d->Q); free(d->K); free(d->I);
+    free(d->A); free(d->B); free(d->C); free(d->Y); free(d->X);
+}
+/* check results of library kernels with reference kernels -------------------*/
+static double checkdata(data_t *d)
+{
+    double *x=mat(d->n,1),*P=mat(d->n*d->n,1),*C=mat(d->m,d->m),*X=mat(d->m,1);
+    double e,emax;
+    int n=d->n,m=d->m;
+    
+    d->kern=&kern_ref; kfilter(d);
+    matcpy(x,d->xp,n,1); matcpy(P,d->Pp,n,n);
+    d->kern=&kern_lib; kfilter(d);
+    emax=maxdiff(x,d->xp,n);
+    if ((e=maxdiff(P,d->Pp,n*n))>emax) emax=e;
+    
+    ref_matmul("NT",m,m,m,1.0,d->A,d->B,0.0,C);
+    matmul("NT",m,m,m,1.0,d->A,d->B,0.0,d->C);
+    if ((e=maxdiff(C,d->C,m*m))>emax) emax=e;
+    
+    matcpy(C,d->A,m,m); ref_matinv(C,m);
+    matcpy(d->C,d->A,m,m); matinv(d->C,m);
+    if ((e=maxdiff(C,d->C,m*m))>emax) emax=e;
+    
+    ref_solve("T",d->A,d->Y,m,1,X);
+    solve("T",d->A,d->Y,m,1,d->X);
+    if ((e=maxdiff(X,d->X,m))>emax) emax=e;
+    
+    free(x); free(P); free(C); free(X);
+    return emax;
+}
+/* bench_matrix main ---------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    static const struct {
+        const char *name; benchfunc_t func;
+    } funcs[]={
+        {"filter",bench_filter},{"matmul",bench_matmul},
+        {"matinv",bench_matinv},{"solve" ,bench_solve }
+    };
+    data_t data={0};
+    double tref,tlib,tblas,emax;
+    int i,j,nf=(int)(sizeof(funcs)/sizeof(*funcs)),blas=0;
+    char *lib=NULL,name[64];
+    
+    for (i=1;i<argc;i++) {
+        if      (!strcmp(argv[i],"-t")&&i+1<argc) mintime=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-blas")&&i+1<argc) {lib=argv[++i]; blas=1;}
+        else printhelp();
+    }
+    if (blas&&!matsetblas(strcmp(lib,"auto")?lib:NULL)) {
+        fprintf(stderr,"blas library load error: %s\n",lib);
+        return -1;
+    }
+    printf("%-26s %5s %5s %12s %12s %8s",PROGNAME,"n","m","ref(ns)","lib(ns)",
+           "speedup");
+    if (blas) printf(" %12s %8s","blas(ns)","speedup");
+    printf(" %9s\n","maxdiff");
+    
+    for (i=0;cases[i].name;i++) {
+        gendata(&data,cases[i].n,cases[i].m);
+        
+        matsetblas("");
+        emax=checkdata(&data);
+        
+        for (j=0;j<nf;j++) {
+            matsetblas("");
+            data.kern=&kern_ref; tref=runbench(funcs[j].func,&data);
+            data.kern=&kern_lib; tlib=runbench(funcs[j].func,&data);
+            
+            sprintf(name,"%s_%s",cases[i].name,funcs[j].name);
+            printf("%-26s %5d %5d %12.0f %12.0f %8.2f",name,
+                   j==2||j==3?cases[i].m:cases[i].n,cases[i].m,tref,tlib,
+                   tref/tlib);
+            if (blas) {
+                matsetblas(strcmp(lib,"auto")?lib:NULL);
+                tblas=runbench(funcs[j].func,&data);
+                printf(" %12.0f %8.2f",tblas,tref/tblas);
+            }
+            if (j==0) printf(" %9.1E\n",emax); else printf("\n");
+        }
+        freedata(&data);
+    }
+    return 0;
+}
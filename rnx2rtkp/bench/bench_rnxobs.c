@@ -0,0 +1,160 @@
+/*------------------------------------------------------------------------------
+* bench_rnxobs.c : rinex observation parser benchmark
+*
+* history : 2026/10/18  1.0 new
+*-----------------------------------------------------------------------------*/
+#include <stdarg.h>
+#include "rtklib.h"
+
+#define PROGNAME    "bench_rnxobs"      /* program name */
+
+/* help text -----------------------------------------------------------------*/
+static const char *help[]={
+"",
+" usage: bench_rnxobs [option]... file [...]",
+"",
+" Read RINEX OBS files repeatedly with readrnxt() and print parsing time and",
+" throughput. With -o option, the decoded observation data are dumped to the",
+" file field by field in the read order, so that the outputs of two builds of",
+" the parser (e.g. with and without -DRNXSCANF) or of different number of",
+" threads can be compared byte by byte.",
+"",
+" -?        print help",
+" -n loop   number of loops [5]",
+" -ti tint  time interval (sec) [all]",
+" -mt n     number of threads to read obs data [1]",
+" -ts y/m/d h:m:s  start time [all]",
+" -te y/m/d h:m:s  end time [all]",
+" -ix       skip epochs by epoch index files [off]",
+" -o file   dump decoded observation data to file [off]",
+};
+/* print help ----------------------------------------------------------------*/
+static void printhelp(void)
+{
+    int i;
+    for (i=0;i<(int)(sizeof(help)/sizeof(*help));i++) fprintf(stderr,"%s\n",help[i]);
+    exit(0);
+}
+/* dump observation data -----------------------------------------------------*/
+static int dumpobs(const char *file, const obs_t *obs)
+{
+    FILE *fp;
+    const obsd_t *p;
+    int i;
+    
+    if (!(fp=fopen(file,"wb"))) {
+        fprintf(stderr,"file open error: %s\n",file);
+        return 0;
+    }
+    for (i=0;i<obs->n;i++) {
+        p=obs->data+i;
+        fwrite(&p->time.time,sizeof(p->time.time),1,fp);
+        fwrite(&p->time.sec ,sizeof(p->time.sec ),1,fp);
+        fwrite(&p->sat ,sizeof(p->sat ),1,fp);
+        fwrite(&p->rcv ,sizeof(p->rcv ),1,fp);
+        fwrite(p->SNR ,sizeof(p->SNR ),1,fp);
+        fwrite(p->LLI ,sizeof(p->LLI ),1,fp);
+        fwrite(p->code,sizeof(p->code),1,fp);
+        fwrite(p->L   ,sizeof(p->L   ),1,fp);
+        fwrite(p->P   ,sizeof(p->P   ),1,fp);
+        fwrite(p->D   ,sizeof(p->D   ),1,fp);
+    }
+    fclose(fp);
+    return 1;
+}
+/* file size -----------------------------------------------------------------*/
+static double filesize(const char *file)
+{
+    FILE *fp;
+    double size;
+    
+    if (!(fp=fopen(file,"rb"))) return 0.0;
+    fseek(fp,0,SEEK_END);
+    size=(double)ftell(fp);
+    fclose(fp);
+    return size;
+}
+/* bench_rnxobs main ---------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    obs_t obs={0};
+    gtime_t ts={0},te={0};
+    double size=0.0,tint=0.0,t,tmin=0.0,tsum=0.0,es[]={2000,1,1,0,0,0};
+    double ee[]={2000,12,31,0,0,0};
+    unsigned int tick;
+    int i,j,n=0,nloop=5,nthread=1,nepoch,index=0;
+    char *files[16],*outfile="";
+    
+    for (i=1;i<argc;i++) {
+        if      (!strcmp(argv[i],"-n")&&i+1<argc) nloop=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-o")&&i+1<argc) outfile=argv[++i];
+        else if (!strcmp(argv[i],"-ti")&&i+1<argc) tint=atof(argv[++i]);
+        else if (!strcmp(argv[i],"-mt")&&i+1<argc) nthread=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-ts")&&i+2<argc) {
+            sscanf(argv[++i],"%lf/%lf/%lf",es,es+1,es+2);
+            sscanf(argv[++i],"%lf:%lf:%lf",es+3,es+4,es+5);
+            ts=epoch2time(es);
+        }
+        else if (!strcmp(argv[i],"-te")&&i+2<argc) {
+            sscanf(argv[++i],"%lf/%lf/%lf",ee,ee+1,ee+2);
+            sscanf(argv[++i],"%lf:%lf:%lf",ee+3,ee+4,ee+5);
+            te=epoch2time(ee);
+        }
+        else if (!strcmp(argv[i],"-ix")) index=1;
+        else if (*argv[i]=='-') printhelp();
+        else if (n<16) files[n++]=argv[i];
+    }
+    if (n<=0||nloop<=0) printhelp();
+    
+    rnxsetthread(nthread);
+    rnxsetindex(index);
+    
+    for (i=0;i<n;i++) {
+        if ((t=filesize(files[i]))<=0.0) {
+            fprintf(stderr,"file open error: %s\n",files[i]);
+            return -1;
+        }
+        size+=t;
+    }
+    
+    for (i=0;i<nloop;i++) {
+        free(obs.data); obs.data=NULL; obs.n=obs.nmax=0;
+        
+        tick=tickget();
+        for (j=0;j<n;j++) {
+            readrnxt(files[j],1,ts,te,tint,"",&obs,NULL,NULL);
+        }
+        t=(tickget()-tick)*1E-3;
+        if (i==0||t<tmin) tmin=t;
+        tsum+=t;
+    }
+    if (obs.n<=0) {
+        fprintf(stderr,"no obs data\n");
+        free(obs.data);
+        return -1;
+    }
+    if (*outfile&&!dumpobs(outfile,&obs)) return -1;
+    
+    sortobs(&obs);
+    for (i=nepoch=0;i<obs.n;i++) {
+        if (i==0||timediff(obs.data[i].time,obs.data[i-1].time)!=0.0) nepoch++;
+    }
+    printf("%-12s: %s, %d thread(s)%s\n",PROGNAME,
+#ifdef RNXSCANF
+           "sscanf parser",
+#else
+           "in-place parser",
+#endif
+           nthread,index?", epoch index":"");
+    printf("file size   : %.0f bytes\n",size);
+    printf("epochs      : %d\n",nepoch);
+    printf("obs records : %d\n",obs.n);
+    printf("time (min)  : %.3f s\n",tmin);
+    printf("time (avg)  : %.3f s\n",tsum/nloop);
+    if (tmin>0.0) {
+        printf("throughput  : %.1f MB/s %.0f epochs/s\n",size/tmin/1E6,
+               nepoch/tmin);
+    }
+    free(obs.data);
+    return 0;
+}
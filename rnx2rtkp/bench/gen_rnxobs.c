@@ -0,0 +1,293 @@
+/*------------------------------------------------------------------------------
+* gen_rnxobs.c : synthetic rinex observation generator
+*
+* history : 2026/10/18  1.0 new
+*-----------------------------------------------------------------------------*/
+#include <stdarg.h>
+#include "rtklib.h"
+
+#define PROGNAME    "gen_rnxobs"        /* program name */
+#define MAXSTA      1024                /* max number of stations */
+#define MAXFILE     16                  /* max number of input files */
+
+/* help text -----------------------------------------------------------------*/
+static const char *help[]={
+"",
+" usage: gen_rnxobs [option]... file [...]",
+"",
+" Generate synthetic RINEX 3.02 OBS files of static stations from RINEX NAV,",
+" SP3 or RINEX CLK files. Pseudorange, carrier-phase, doppler and SNR are",
+" computed with satposs(), geodist(), tropmodel() and ionmodel() and noise,",
+" cycle slips and outages are added by simobs(). Stations are given by -p or",
+" by a station list file of lines \"name x y z\" (ecef m) or \"name lat lon hgt\"",
+" (deg,m). With -mem option, observation data are generated in memory only",
+" and the generation time and throughput are printed.",
+"",
+" -?        print help",
+" -ts y/m/d h:m:s  start time [first day of ephemeris]",
+" -te y/m/d h:m:s  end time [start time + 1 day - tint]",
+" -ti tint  time interval (sec) [30]",
+" -p x y z  station position (ecef m) [-]",
+" -sta file station list file [-]",
+" -sys s[,s...] nav system(s) (s=G:GPS,R:GLO,E:GAL,J:QZS,C:BDS) [G]",
+" -f freq   number of frequencies [2]",
+" -m mask   elevation mask angle (deg) [15]",
+" -np std   pseudorange noise std at zenith (m) [0.3]",
+" -nl std   carrier-phase noise std at zenith (m) [0.003]",
+" -nd std   doppler noise std at zenith (Hz) [0.05]",
+" -slip r   cycle slip rate per satellite (/hour) [0]",
+" -out r    outage rate per satellite (/hour) [0]",
+" -outlen t outage length (sec) [60]",
+" -seed n   random seed [1]",
+" -o path   output file path (%r:station,%n:doy,%y:year) [%r%n0.%yo]",
+" -mem      generate observation data in memory only [off]",
+};
+/* print help ----------------------------------------------------------------*/
+static void printhelp(void)
+{
+    int i;
+    for (i=0;i<(int)(sizeof(help)/sizeof(*help));i++) fprintf(stderr,"%s\n",help[i]);
+    exit(0);
+}
+/* read station list ---------------------------------------------------------*/
+static int readsta(const char *file, char name[][8], double rr[][3])
+{
+    FILE *fp;
+    double x[3];
+    char buff[256],id[32];
+    int n=0;
+    
+    if (!(fp=fopen(file,"r"))) {
+        fprintf(stderr,"station list open error: %s\n",file);
+        return 0;
+    }
+    while (fgets(buff,sizeof(buff),fp)&&n<MAXSTA) {
+        if (buff[0]=='#'||buff[0]=='%') continue;
+        if (sscanf(buff,"%31s %lf %lf %lf",id,x,x+1,x+2)<4) continue;
+        
+        if (fabs(x[0])<=90.0&&fabs(x[1])<=360.0) { /* lat/lon/hgt */
+            x[0]*=D2R; x[1]*=D2R;
+            pos2ecef(x,rr[n]);
+        }
+        else {
+            matcpy(rr[n],x,3,1);
+        }
+        sprintf(name[n++],"%.4s",id);
+    }
+    fclose(fp);
+    return n;
+}
+/* read navigation data ------------------------------------------------------*/
+static int readnavs(char **files, int n, nav_t *nav)
+{
+    char *ext;
+    int i,prn,prec=0;
+    
+    for (i=0;i<n;i++) {
+        if (!(ext=strrchr(files[i],'.'))) ext="";
+        
+        if (!strcmp(ext,".sp3")||!strcmp(ext,".SP3")||!strcmp(ext,".eph")||
+            !strcmp(ext,".EPH")) {
+            readsp3(files[i],nav,0);
+            prec=1;
+        }
+        else if (!strcmp(ext,".clk")||!strcmp(ext,".CLK")) {
+            readrnxc(files[i],nav);
+        }
+        else {
+            readrnx(files[i],0,"",NULL,nav,NULL);
+        }
+    }
+    uniqnav(nav);
+    
+    /* glonass frequency channel numbers for header */
+    for (i=0;i<nav->ng;i++) {
+        if (satsys(nav->geph[i].sat,&prn)!=SYS_GLO) continue;
+        nav->glo_fcn[prn-1]=nav->geph[i].frq+8;
+    }
+    return prec;
+}
+/* first time of ephemeris ---------------------------------------------------*/
+static gtime_t ephtime(const nav_t *nav)
+{
+    gtime_t t={0};
+    
+    if      (nav->n >0) t=nav->eph[0].toe;
+    else if (nav->ng>0) t=nav->geph[0].toe;
+    else if (nav->ne>0) t=nav->peph[0].time;
+    
+    t.time-=t.time%86400; t.sec=0.0;
+    return t;
+}
+/* set rinex options by observation types in data ----------------------------*/
+static void setrnxopt(rnxopt_t *opt, const obs_t *obs, int navsys)
+{
+    const char type[]="CLDS";
+    char *id;
+    int i,j,k,m,s,sys,code[6][MAXCODE+1]={{0}};
+    
+    for (i=0;i<obs->n;i++) {
+        sys=satsys(obs->data[i].sat,NULL);
+        switch (sys) {
+            case SYS_GPS: s=0; break;
+            case SYS_GLO: s=1; break;
+            case SYS_GAL: s=2; break;
+            case SYS_QZS: s=3; break;
+            case SYS_CMP: s=5; break;
+            default: continue;
+        }
+        for (j=0;j<NFREQ;j++) code[s][obs->data[i].code[j]]=1;
+    }
+    opt->rnxver=3.02;
+    opt->navsys=navsys;
+    strcpy(opt->prog,PROGNAME);
+    
+    for (s=0;s<6;s++) {
+        memset(opt->mask[s],'1',sizeof(opt->mask[s]));
+        for (k=1,m=0;k<=MAXCODE;k++) {
+            if (!code[s][k]||!*(id=code2obs((unsigned char)k,NULL))) continue;
+            for (j=0;j<4&&m<MAXOBSTYPE;j++) {
+                sprintf(opt->tobs[s][m++],"%c%s",type[j],id);
+            }
+        }
+        opt->nobs[s]=m;
+    }
+    if (obs->n>0) {
+        opt->tstart=obs->data[0].time;
+        opt->tend=obs->data[obs->n-1].time;
+    }
+}
+/* write rinex obs file ------------------------------------------------------*/
+static int writeobs(const char *file, rnxopt_t *opt, const obs_t *obs,
+                    const nav_t *nav)
+{
+    FILE *fp;
+    int i,j;
+    
+    if (!(fp=fopen(file,"w"))) {
+        fprintf(stderr,"file open error: %s\n",file);
+        return 0;
+    }
+    outrnxobsh(fp,opt,nav);
+    
+    for (i=0;i<obs->n;i=j) {
+        for (j=i+1;j<obs->n;j++) {
+            if (timediff(obs->data[j].time,obs->data[i].time)!=0.0) break;
+        }
+        outrnxobsb(fp,opt,obs->data+i,j-i,0);
+    }
+    fclose(fp);
+    return 1;
+}
+/* gen_rnxobs main -----------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    static char name[MAXSTA][8];
+    static double rr[MAXSTA][3];
+    static rnxopt_t rnxopt;
+    simopt_t opt=simopt_default;
+    obs_t obs={0};
+    nav_t nav={0};
+    gtime_t ts={0},te={0};
+    double tint=30.0,es[]={2000,1,1,0,0,0},ee[]={2000,12,31,0,0,0},t;
+    unsigned int tick;
+    int i,n=0,nsta=0,nep,nobs=0,mem=0;
+    char *files[MAXFILE],*outpath="%r%n0.%yo",*p,file[1024];
+    
+    opt.navsys=0;
+    
+    for (i=1;i<argc;i++) {
+        if      (!strcmp(argv[i],"-ti")&&i+1<argc) tint=atof(argv[++i]);
+        else if (!strcmp(argv[i],"-ts")&&i+2<argc) {
+            sscanf(argv[++i],"%lf/%lf/%lf",es,es+1,es+2);
+            sscanf(argv[++i],"%lf:%lf:%lf",es+3,es+4,es+5);
+            ts=epoch2time(es);
+        }
+        else if (!strcmp(argv[i],"-te")&&i+2<argc) {
+            sscanf(argv[++i],"%lf/%lf/%lf",ee,ee+1,ee+2);
+            sscanf(argv[++i],"%lf:%lf:%lf",ee+3,ee+4,ee+5);
+            te=epoch2time(ee);
+        }
+        else if (!strcmp(argv[i],"-p")&&i+3<argc&&nsta<MAXSTA) {
+            rr[nsta][0]=atof(argv[++i]);
+            rr[nsta][1]=atof(argv[++i]);
+            rr[nsta][2]=atof(argv[++i]);
+            sprintf(name[nsta],"S%03d",nsta+1);
+            nsta++;
+        }
+        else if (!strcmp(argv[i],"-sta")&&i+1<argc) {
+            nsta+=readsta(argv[++i],name+nsta,rr+nsta);
+        }
+        else if (!strcmp(argv[i],"-sys")&&i+1<argc) {
+            for (p=argv[++i];*p;p++) {
+                if      (*p=='G') opt.navsys|=SYS_GPS;
+                else if (*p=='R') opt.navsys|=SYS_GLO;
+                else if (*p=='E') opt.navsys|=SYS_GAL;
+                else if (*p=='J') opt.navsys|=SYS_QZS;
+                else if (*p=='C') opt.navsys|=SYS_CMP;
+            }
+        }
+        else if (!strcmp(argv[i],"-f")&&i+1<argc) opt.nfreq=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-m")&&i+1<argc) opt.elmask=atof(argv[++i])*D2R;
+        else if (!strcmp(argv[i],"-np")&&i+1<argc) opt.errp=atof(argv[++i]);
+        else if (!strcmp(argv[i],"-nl")&&i+1<argc) opt.errl=atof(argv[++i]);
+        else if (!strcmp(argv[i],"-nd")&&i+1<argc) opt.errd=atof(argv[++i]);
+        else if (!strcmp(argv[i],"-slip")&&i+1<argc) opt.sliprate=atof(argv[++i])/3600.0;
+        else if (!strcmp(argv[i],"-out")&&i+1<argc) opt.outrate=atof(argv[++i])/3600.0;
+        else if (!strcmp(argv[i],"-outlen")&&i+1<argc) opt.outlen=atof(argv[++i]);
+        else if (!strcmp(argv[i],"-seed")&&i+1<argc) opt.seed=(unsigned int)atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-o")&&i+1<argc) outpath=argv[++i];
+        else if (!strcmp(argv[i],"-mem")) mem=1;
+        else if (*argv[i]=='-') printhelp();
+        else if (n<MAXFILE) files[n++]=argv[i];
+    }
+    if (n<=0||nsta<=0||tint<=0.0) printhelp();
+    if (!opt.navsys) opt.navsys=SYS_GPS;
+    
+    if (readnavs(files,n,&nav)) opt.ephopt=EPHOPT_PREC;
+    
+    if (nav.n<=0&&nav.ng<=0&&nav.ne<=0) {
+        fprintf(stderr,"no ephemeris data\n");
+        return -1;
+    }
+    if (ts.time==0) ts=ephtime(&nav);
+    if (te.time==0) te=timeadd(ts,86400.0-tint);
+    
+    tick=tickget();
+    
+    for (i=0;i<nsta;i++) {
+        if (!mem) {
+            free(obs.data); obs.data=NULL; obs.n=obs.nmax=0;
+        }
+        if ((nep=simobs(ts,te,tint,rr[i],i+1,&opt,&nav,&obs))<0) {
+            fprintf(stderr,"memory allocation error\n");
+            return -1;
+        }
+        nobs+=nep;
+        if (mem) continue;
+        
+        setrnxopt(&rnxopt,&obs,opt.navsys);
+        strcpy(rnxopt.marker,name[i]);
+        matcpy(rnxopt.apppos,rr[i],3,1);
+        rnxopt.tint=tint;
+        reppath(outpath,file,ts,name[i],"");
+        
+        if (!writeobs(file,&rnxopt,&obs,&nav)) return -1;
+        
+        fprintf(stderr,"%s: %d epochs %d obs\n",file,nep,obs.n);
+    }
+    t=(tickget()-tick)*1E-3;
+    
+    if (mem) {
+        printf("%-12s: %d station(s) in memory\n",PROGNAME,nsta);
+        printf("epochs      : %d\n",nobs);
+        printf("obs records : %d\n",obs.n);
+        printf("time        : %.3f s\n",t);
+        if (t>0.0) {
+            printf("throughput  : %.0f epochs/s %.0f obs/s\n",nobs/t,obs.n/t);
+        }
+    }
+    free(obs.data);
+    freenav(&nav,0xFF);
+    return 0;
+}
@@ -0,0 +1,11 @@
+/*------------------------------------------------------------------------------
+* stubs.c : dummy application functions of benchmarks
+*
+* history : 2026/10/19  1.0 new
+*-----------------------------------------------------------------------------*/
+#include "rtklib.h"
+
+/* dummy application functions -----------------------------------------------*/
+extern int showmsg(char *format, ...) {(void)format; return 0;}
+extern void settspan(gtime_t ts, gtime_t te) {(void)ts; (void)te;}
+extern void settime(gtime_t time) {(void)time;}
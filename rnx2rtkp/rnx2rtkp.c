@@ -46,6 +46,8 @@ static const char *help[]={
 " -ts ds ts start day/time (ds=y/m/d ts=h:m:s) [obs start time]",
 " -te de te end day/time   (de=y/m/d te=h:m:s) [obs end time]",
 " -ti tint  time interval (sec) [all]",
+" -tu tunit processing unit time (hr) (requires -ts and -te) [all]",
+" -tw twarm warm-up overlap of processing units (min) [0]",
 " -p mode   mode (0:single,1:dgps,2:kinematic,3:static,4:moving-base,",
 "                 5:fixed,6:ppp-kinematic,7:ppp-static) [2]",
 " -m mask   elevation mask angle (deg) [15]",
@@ -66,7 +68,19 @@ static const char *help[]={
 " -r x y z  reference (base) receiver ecef pos (m) [average of single pos]",
 " -l lat lon hgt reference (base) receiver latitude/longitude/height (deg/m)",
 " -y level  output soltion status (0:off,1:states,2:residuals) [0]",
-" -x level  debug trace level (0:off) [0]"
+" -x level  debug trace level (0:off) [0]",
+" -xa       write debug trace asynchronously by a background thread [off]",
+" -pf       output profile report of positioning stages (-DPROFILE) [off]",
+" -rov ids  rover ids replacing keyword %r in paths (separated by ' ') [\"\"]",
+" -base ids base station ids replacing keyword %b in paths (separated by ' ') [\"\"]",
+" -mt n     number of threads to process sessions or units in parallel [1]",
+" -blas lib BLAS/LAPACK library for large matrices (auto: default libraries) [off]",
+" -ix       skip rinex obs epochs out of -ts/-te/-ti by epoch index files [off]",
+" -sh       sparse design matrix for measurement update of ppp [off]",
+" -as       cache antex files as binary snapshots <file>.bin [off]",
+" -sta file extract pseudorange corrections of stations in station list file",
+"           (line: name x y z obsfile...) with input nav files. -o sets the",
+"           path prefix of log files <name>_log<doy>.csv [off]"
 };
 /* show message --------------------------------------------------------------*/
 extern int showmsg(char *format, ...)
@@ -93,9 +107,10 @@ int main(int argc, char **argv)
     solopt_t solopt=solopt_default;
     filopt_t filopt={""};
     gtime_t ts={0},te={0};
-    double tint=0.0,es[]={2000,1,1,0,0,0},ee[]={2000,12,31,23,59,59},pos[3];
+    double tint=0.0,tunit=0.0,pos[3];
+    double es[]={2000,1,1,0,0,0},ee[]={2000,12,31,23,59,59};
     int i,j,n,ret;
-    char *infile[MAXFILE],*outfile="";
+    char *infile[MAXFILE],*outfile="",*rov="",*base="",*stafile="";
     
     prcopt.mode  =PMODE_KINEMA;
     prcopt.navsys=SYS_GPS|SYS_GLO|SYS_GAL;
@@ -126,6 +141,8 @@ int main(int argc, char **argv)
             te=epoch2time(ee);
         }
         else if (!strcmp(argv[i],"-ti")&&i+1<argc) tint=atof(argv[++i]);
+        else if (!strcmp(argv[i],"-tu")&&i+1<argc) tunit=atof(argv[++i])*3600.0;
+        else if (!strcmp(argv[i],"-tw")&&i+1<argc) prcopt.tuwarm=atof(argv[++i])*60.0;
         else if (!strcmp(argv[i],"-k")&&i+1<argc) {++i; continue;}
         else if (!strcmp(argv[i],"-p")&&i+1<argc) prcopt.mode=atoi(argv[++i]);
         else if (!strcmp(argv[i],"-f")&&i+1<argc) prcopt.nf=atoi(argv[++i]);
@@ -156,6 +173,20 @@ int main(int argc, char **argv)
         }
         else if (!strcmp(argv[i],"-y")&&i+1<argc) solopt.sstat=atoi(argv[++i]);
         else if (!strcmp(argv[i],"-x")&&i+1<argc) solopt.trace=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-xa")) traceasync(1);
+        else if (!strcmp(argv[i],"-pf")) profenable(1);
+        else if (!strcmp(argv[i],"-rov")&&i+1<argc) rov=argv[++i];
+        else if (!strcmp(argv[i],"-base")&&i+1<argc) base=argv[++i];
+        else if (!strcmp(argv[i],"-mt")&&i+1<argc) prcopt.nthread=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-blas")&&i+1<argc) {
+            if (!matsetblas(strcmp(argv[++i],"auto")?argv[i]:NULL)) {
+                fprintf(stderr,"blas library load error: %s\n",argv[i]);
+            }
+        }
+        else if (!strcmp(argv[i],"-ix")) prcopt.rnxidx=1;
+        else if (!strcmp(argv[i],"-sh")) prcopt.sparseh=1;
+        else if (!strcmp(argv[i],"-as")) pcvsetsnap(1);
+        else if (!strcmp(argv[i],"-sta")&&i+1<argc) stafile=argv[++i];
         else if (*argv[i]=='-') printhelp();
         else if (n<MAXFILE) infile[n++]=argv[i];
     }
@@ -163,7 +194,14 @@ int main(int argc, char **argv)
         showmsg("error : no input file");
         return -2;
     }
-    ret=postpos(ts,te,tint,0.0,&prcopt,&solopt,&filopt,infile,n,outfile,"","");
+    if (*stafile) {
+        ret=postpcor(ts,te,tint,&prcopt,&solopt,&filopt,infile,n,stafile,
+                     outfile);
+    }
+    else {
+        ret=postpos(ts,te,tint,tunit,&prcopt,&solopt,&filopt,infile,n,outfile,
+                    rov,base);
+    }
     
     if (!ret) fprintf(stderr,"%40s\r","");
     return ret;
@@ -0,0 +1,346 @@
+/*------------------------------------------------------------------------------
+* chebeph.c : chebyshev compressed satellite orbit and clock
+*
+* fit chebyshev polynomials to satellite positions and clocks of broadcast or
+* precise ephemerides (sp3 and rinex clock) in fixed time segments, and serve
+* the positions, velocities and clocks by polynomial evaluation instead of
+* kepler propagation (ephpos()) or lagrange interpolation (peph2pos()). the
+* max fit error is evaluated for each segment and added to the error variance.
+* the segment table is saved to and read from a binary file to skip the fit for
+* repeated processing.
+*
+* references :
+*     [1] W.H.Press et al., Numerical Recipes in C 2nd ed., 5.8 Chebyshev
+*         Approximation, Cambridge University Press, 1992
+*
+* version : $Revision:$ $Date:$
+* history : 2026/10/18 1.0  new
+*-----------------------------------------------------------------------------*/
+#include "rtklib.h"
+
+#define SQR(x)      ((x)*(x))
+#define NCHECK      4                   /* check points per node interval */
+#define MAXFITERR   10.0                /* max fit error of segment (m) */
+#define CHEBID      "CHEBYSHEV EPH"     /* id of segment table file */
+#define CHEBVER     1                   /* version of segment table file */
+
+typedef struct {                        /* segment table file header type */
+    char id[16];                        /* id (CHEBID) */
+    int ver;                            /* version (CHEBVER) */
+    int maxsat;                         /* max satellite number (MAXSAT) */
+    gtime_t ts;                         /* start time of segments (gpst) */
+    double span;                        /* time span of a segment (s) */
+    int deg;                            /* degree of polynomials */
+    int nseg;                           /* number of segments per satellite */
+    int ephopt;                         /* source ephemeris option */
+    int n;                              /* number of fitted segments */
+} chebh_t;
+
+/* satellite position and clock of source ephemeris --------------------------*/
+static int srcpos(gtime_t time, gtime_t teph, int sat, const nav_t *nav,
+                  int ephopt, double *f, double *var)
+{
+    double rs[6],dts[2];
+    int i,svh;
+    
+    if (!satpos(time,teph,sat,ephopt,nav,rs,dts,var,&svh)||svh) return 0;
+    
+    /* no precise clock */
+    if (ephopt==EPHOPT_PREC&&dts[0]==0.0) return 0;
+    
+    for (i=0;i<3;i++) f[i]=rs[i];
+    f[3]=CLIGHT*dts[0];
+    return 1;
+}
+/* chebyshev polynomials and derivatives -------------------------------------*/
+static void chebpoly(double x, int n, double *T, double *D)
+{
+    int i;
+    
+    T[0]=1.0; D[0]=0.0;
+    if (n<=1) return;
+    T[1]=x; D[1]=1.0;
+    for (i=2;i<n;i++) {
+        T[i]=2.0*x*T[i-1]-T[i-2];
+        D[i]=2.0*T[i-1]+2.0*x*D[i-1]-D[i-2];
+    }
+}
+/* fit chebyshev polynomials to a segment --------------------------------------
+* coefficients c[i+j*n] (i=0..n-1: degree, j=0..3: x,y,z,clock) by chebyshev
+* interpolation at n chebyshev nodes [1] and max fit errors of position and
+* clock at NCHECK*(n-1)+1 check points including both ends of the segment
+*-----------------------------------------------------------------------------*/
+static int fitseg(const cheph_t *ceph, int sat, int iseg, const nav_t *nav,
+                  double *c, float *err, float *var)
+{
+    double f[4*(MAXCHEBDEG+1)],g[4],T[MAXCHEBDEG+1],D[MAXCHEBDEG+1],p,x;
+    double vars,errp=0.0,errc=0.0,vmax=0.0;
+    gtime_t tm,time;
+    int i,j,k,n=ceph->deg+1;
+    
+    tm=timeadd(ceph->ts,ceph->span*(iseg+0.5));
+    
+    /* positions and clocks at chebyshev nodes */
+    for (k=0;k<n;k++) {
+        x=cos(PI*(k+0.5)/n);
+        time=timeadd(tm,x*ceph->span/2.0);
+        if (!srcpos(time,tm,sat,nav,ceph->ephopt,g,&vars)) return 0;
+        for (j=0;j<4;j++) f[k+j*n]=g[j];
+        if (vars>vmax) vmax=vars;
+    }
+    for (j=0;j<4;j++) for (i=0;i<n;i++) {
+        for (k=0,p=0.0;k<n;k++) p+=f[k+j*n]*cos(PI*i*(k+0.5)/n);
+        c[i+j*n]=(i==0?1.0:2.0)*p/n;
+    }
+    /* max fit errors at check points */
+    for (k=0;k<=NCHECK*(n-1);k++) {
+        x=-1.0+2.0*k/(NCHECK*(n-1));
+        time=timeadd(tm,x*ceph->span/2.0);
+        if (!srcpos(time,tm,sat,nav,ceph->ephopt,g,&vars)) return 0;
+        chebpoly(x,n,T,D);
+        for (j=0;j<4;j++) g[j]-=dot(c+j*n,T,n);
+        if ((p=norm(g,3))>errp) errp=p;
+        if (fabs(g[3])>errc) errc=fabs(g[3]);
+    }
+    if (errp>MAXFITERR||errc>MAXFITERR) {
+        trace(2,"chebyshev fit error: sat=%2d seg=%d errp=%.3f errc=%.3f\n",
+              sat,iseg,errp,errc);
+        return 0;
+    }
+    err[0]=(float)errp;
+    err[1]=(float)errc;
+    *var=(float)vmax;
+    return 1;
+}
+/* add segment to table ------------------------------------------------------*/
+static int addseg(cheph_t *ceph, const double *c, const float *err, float var)
+{
+    double *coef;
+    float *err_,*var_;
+    int nc=4*(ceph->deg+1);
+    
+    if (ceph->n>=ceph->nmax) {
+        ceph->nmax=ceph->nmax<=0?1024:ceph->nmax*2;
+        coef=(double *)realloc(ceph->coef,sizeof(double)*nc*ceph->nmax);
+        if (!coef) return 0;
+        ceph->coef=coef;
+        err_=(float *)realloc(ceph->err,sizeof(float)*2*ceph->nmax);
+        if (!err_) return 0;
+        ceph->err=err_;
+        var_=(float *)realloc(ceph->var,sizeof(float)*ceph->nmax);
+        if (!var_) return 0;
+        ceph->var=var_;
+    }
+    matcpy(ceph->coef+nc*ceph->n,c,nc,1);
+    ceph->err[ceph->n*2  ]=err[0];
+    ceph->err[ceph->n*2+1]=err[1];
+    ceph->var[ceph->n]=var;
+    return ++ceph->n;
+}
+/* fit chebyshev compressed ephemeris ------------------------------------------
+* fit chebyshev polynomials to satellite positions and clocks of ephemerides
+* args   : gtime_t ts,te    I   start and end time (gpst)
+*          double span      I   time span of a segment (s)
+*          int    deg       I   degree of polynomials (1-MAXCHEBDEG)
+*          nav_t  *nav      I   navigation data
+*          int    ephopt    I   ephemeris option (EPHOPT_BRDC,EPHOPT_PREC)
+*          cheph_t *ceph    O   chebyshev compressed ephemeris
+* return : number of fitted segments (-1:error)
+* notes  : the start time of segments is ts truncated to a multiple of span in
+*          gps week. the segments are fitted to the positions and clocks by
+*          satpos() with ephopt. a segment is not fitted if the ephemeris is
+*          not available or unhealthy at any node or the max fit error exceeds
+*          MAXFITERR. the broadcast ephemeris is selected by the center time
+*          of the segment (teph) to avoid the discontinuity by the switch of
+*          ephemerides in the segment. the precise clocks are needed with
+*          EPHOPT_PREC.
+*          call freecheb() to free the table
+*-----------------------------------------------------------------------------*/
+extern int chebfit(gtime_t ts, gtime_t te, double span, int deg,
+                   const nav_t *nav, int ephopt, cheph_t *ceph)
+{
+    double c[4*(MAXCHEBDEG+1)];
+    float err[2],var;
+    int i,sat;
+    
+    trace(3,"chebfit : ts=%s span=%.0f deg=%d ephopt=%d\n",time_str(ts,0),
+          span,deg,ephopt);
+    
+    memset(ceph,0,sizeof(cheph_t));
+    
+    if (span<=0.0||deg<1||deg>MAXCHEBDEG||timediff(te,ts)<=0.0) return -1;
+    
+    ceph->ts=timeadd(ts,-fmod(time2gpst(ts,NULL),span));
+    ceph->span=span;
+    ceph->deg=deg;
+    ceph->ephopt=ephopt;
+    ceph->nseg=(int)ceil(timediff(te,ceph->ts)/span-1E-9);
+    
+    if (!(ceph->index=(int *)malloc(sizeof(int)*MAXSAT*ceph->nseg))) return -1;
+    
+    for (sat=1;sat<=MAXSAT;sat++) for (i=0;i<ceph->nseg;i++) {
+        ceph->index[i+(sat-1)*ceph->nseg]=-1;
+        
+        if (!fitseg(ceph,sat,i,nav,c,err,&var)) continue;
+        
+        if (!addseg(ceph,c,err,var)) {
+            freecheb(ceph);
+            return -1;
+        }
+        ceph->index[i+(sat-1)*ceph->nseg]=ceph->n-1;
+    }
+    trace(3,"chebfit : nseg=%d n=%d\n",ceph->nseg,ceph->n);
+    return ceph->n;
+}
+/* satellite position and clock by chebyshev compressed ephemeris -------------
+* compute satellite position, velocity and clock by chebyshev polynomials
+* args   : gtime_t time     I   time (gpst)
+*          int    sat       I   satellite number
+*          cheph_t *ceph    I   chebyshev compressed ephemeris
+*          double *rs       O   sat position and velocity (ecef)
+*                               {x,y,z,vx,vy,vz} (m|m/s)
+*          double *dts      O   sat clock {bias,drift} (s|s/s)
+*          double *var      O   sat position and clock error variance (m^2)
+*                               (NULL: no output)
+* return : status (1:ok,0:error or no segment)
+* notes  : the position and clock are the same as satpos() with the ephemeris
+*          option of chebfit() and teph of the segment center within the max
+*          fit errors. the variance is the
+*          variance of the source ephemeris plus the squared max fit errors
+*-----------------------------------------------------------------------------*/
+extern int cheb2pos(gtime_t time, int sat, const cheph_t *ceph, double *rs,
+                    double *dts, double *var)
+{
+    double T[MAXCHEBDEG+1],D[MAXCHEBDEG+1],tt,x,s;
+    const double *c;
+    int i,j,n=ceph->deg+1;
+    
+    trace(4,"cheb2pos: time=%s sat=%2d\n",time_str(time,3),sat);
+    
+    if (sat<=0||MAXSAT<sat||ceph->nseg<=0) return 0;
+    
+    tt=timediff(time,ceph->ts);
+    i=(int)floor(tt/ceph->span);
+    if (i==ceph->nseg&&tt<=ceph->span*i+1E-9) i--; /* end of table */
+    
+    if (i<0||i>=ceph->nseg||(j=ceph->index[i+(sat-1)*ceph->nseg])<0) {
+        return 0;
+    }
+    c=ceph->coef+4*n*j;
+    x=2.0*(tt-ceph->span*(i+0.5))/ceph->span;
+    s=2.0/ceph->span;
+    chebpoly(x,n,T,D);
+    
+    for (i=0;i<3;i++) {
+        rs[i  ]=dot(c+i*n,T,n);
+        rs[i+3]=dot(c+i*n,D,n)*s;
+    }
+    dts[0]=dot(c+3*n,T,n)/CLIGHT;
+    dts[1]=dot(c+3*n,D,n)*s/CLIGHT;
+    
+    if (var) {
+        *var=ceph->var[j]+SQR(ceph->err[j*2])+SQR(ceph->err[j*2+1]);
+    }
+    return 1;
+}
+/* free chebyshev compressed ephemeris ---------------------------------------*/
+extern void freecheb(cheph_t *ceph)
+{
+    free(ceph->index); free(ceph->coef); free(ceph->err); free(ceph->var);
+    memset(ceph,0,sizeof(cheph_t));
+}
+/* save chebyshev compressed ephemeris -----------------------------------------
+* save segment table of chebyshev compressed ephemeris to binary file
+* args   : char   *file     I   file path
+*          cheph_t *ceph    I   chebyshev compressed ephemeris
+* return : status (1:ok,0:error)
+* notes  : the file is native binary format and read by the same platform
+*-----------------------------------------------------------------------------*/
+extern int savecheb(const char *file, const cheph_t *ceph)
+{
+    FILE *fp;
+    chebh_t h;
+    int nc=4*(ceph->deg+1);
+    
+    trace(3,"savecheb: file=%s n=%d\n",file,ceph->n);
+    
+    memset(&h,0,sizeof(chebh_t));
+    strcpy(h.id,CHEBID);
+    h.ver=CHEBVER; h.maxsat=MAXSAT;
+    h.ts=ceph->ts; h.span=ceph->span; h.deg=ceph->deg; h.nseg=ceph->nseg;
+    h.ephopt=ceph->ephopt; h.n=ceph->n;
+    
+    if (!(fp=fopen(file,"wb"))) {
+        trace(2,"chebyshev eph file open error: %s\n",file);
+        return 0;
+    }
+    if (fwrite(&h,sizeof(h),1,fp)!=1||
+        fwrite(ceph->index,sizeof(int),MAXSAT*h.nseg,fp)!=
+               (size_t)(MAXSAT*h.nseg)||
+        fwrite(ceph->coef,sizeof(double)*nc,h.n,fp)!=(size_t)h.n||
+        fwrite(ceph->err,sizeof(float)*2,h.n,fp)!=(size_t)h.n||
+        fwrite(ceph->var,sizeof(float),h.n,fp)!=(size_t)h.n) {
+        trace(2,"chebyshev eph file write error: %s\n",file);
+        fclose(fp);
+        remove(file);
+        return 0;
+    }
+    fclose(fp);
+    return 1;
+}
+/* read chebyshev compressed ephemeris -----------------------------------------
+* read segment table of chebyshev compressed ephemeris from binary file
+* args   : char   *file     I   file path
+*          cheph_t *ceph    O   chebyshev compressed ephemeris
+* return : number of segments (-1:error)
+* notes  : call freecheb() to free the table
+*-----------------------------------------------------------------------------*/
+extern int readcheb(const char *file, cheph_t *ceph)
+{
+    FILE *fp;
+    chebh_t h;
+    int i,nc;
+    
+    trace(3,"readcheb: file=%s\n",file);
+    
+    memset(ceph,0,sizeof(cheph_t));
+    
+    if (!(fp=fopen(file,"rb"))) {
+        trace(2,"chebyshev eph file open error: %s\n",file);
+        return -1;
+    }
+    if (fread(&h,sizeof(h),1,fp)!=1||strcmp(h.id,CHEBID)||h.ver!=CHEBVER||
+        h.maxsat!=MAXSAT||h.deg<1||h.deg>MAXCHEBDEG||h.nseg<=0||h.n<0||
+        !(h.span>0.0)) {
+        trace(2,"chebyshev eph file not match: %s\n",file);
+        fclose(fp);
+        return -1;
+    }
+    ceph->ts=h.ts; ceph->span=h.span; ceph->deg=h.deg; ceph->nseg=h.nseg;
+    ceph->ephopt=h.ephopt; ceph->n=ceph->nmax=h.n;
+    nc=4*(h.deg+1);
+    
+    if (!(ceph->index=(int *)malloc(sizeof(int)*MAXSAT*h.nseg))||
+        !(ceph->coef=(double *)malloc(sizeof(double)*nc*(h.n+1)))||
+        !(ceph->err=(float *)malloc(sizeof(float)*2*(h.n+1)))||
+        !(ceph->var=(float *)malloc(sizeof(float)*(h.n+1)))||
+        fread(ceph->index,sizeof(int),MAXSAT*h.nseg,fp)!=
+              (size_t)(MAXSAT*h.nseg)||
+        fread(ceph->coef,sizeof(double)*nc,h.n,fp)!=(size_t)h.n||
+        fread(ceph->err,sizeof(float)*2,h.n,fp)!=(size_t)h.n||
+        fread(ceph->var,sizeof(float),h.n,fp)!=(size_t)h.n) {
+        trace(2,"chebyshev eph file read error: %s\n",file);
+        freecheb(ceph);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+    
+    for (i=0;i<MAXSAT*h.nseg;i++) {
+        if (ceph->index[i]>=-1&&ceph->index[i]<h.n) continue;
+        trace(2,"chebyshev eph file index error: %s\n",file);
+        freecheb(ceph);
+        return -1;
+    }
+    return h.n;
+}
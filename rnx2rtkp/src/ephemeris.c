@@ -724,6 +724,8 @@ extern void satposs(gtime_t teph, const obsd_t *obs, int n, const nav_t *nav,
     
     trace(3,"satposs : teph=%s n=%d ephopt=%d\n",time_str(teph,3),n,ephopt);
     
+    PROFBEG(PROF_SATPOSS);
+    
     for (i=0;i<n&&i<MAXOBS;i++) {
         for (j=0;j<6;j++) rs [j+i*6]=0.0;
         for (j=0;j<2;j++) dts[j+i*2]=0.0;
@@ -764,4 +766,5 @@ extern void satposs(gtime_t teph, const obsd_t *obs, int n, const nav_t *nav,
               time_str(time[i],6),obs[i].sat,rs[i*6],rs[1+i*6],rs[2+i*6],
               dts[i*2]*1E9,var[i],svh[i]);
     }
+    PROFEND(PROF_SATPOSS);
 }
@@ -21,6 +21,7 @@ static const double range[4];       /* embedded geoid area range {W,E,S,N} (deg)
 static const float geoid[361][181]; /* embedded geoid heights (m) (lon x lat) */
 static FILE *fp_geoid=NULL;         /* geoid file pointer */
 static int model_geoid=GEOID_EMBEDDED; /* geoid model */
+static lock_t lock_geoid;           /* lock for geoid model file */
 
 /* bilinear interpolation ----------------------------------------------------*/
 static double interpb(const double *y, double a, double b)
@@ -213,6 +214,7 @@ extern int opengeoid(int model, const char *file)
         trace(2,"geoid model file open error: model=%d file=%s\n",model,file);
         return 0;
     }
+    initlock(&lock_geoid);
     model_geoid=model;
     return 1;
 }
@@ -247,13 +249,20 @@ extern double geoidh(const double *pos)
         trace(2,"out of range for geoid model: lat=%.3f lon=%.3f\n",posd[0],posd[1]);
         return 0.0;
     }
-    switch (model_geoid) {
-        case GEOID_EMBEDDED   : h=geoidh_emb  (posd); break;
-        case GEOID_EGM96_M150 : h=geoidh_egm96(posd); break;
-        case GEOID_EGM2008_M25: h=geoidh_egm08(posd,model_geoid); break;
-        case GEOID_EGM2008_M10: h=geoidh_egm08(posd,model_geoid); break;
-        case GEOID_GSI2000_M15: h=geoidh_gsi  (posd); break;
-        default: return 0.0;
+    if (model_geoid==GEOID_EMBEDDED) {
+        h=geoidh_emb(posd);
+    }
+    else { /* model file shared by processing threads */
+        lock(&lock_geoid);
+        switch (model_geoid) {
+            case GEOID_EGM96_M150 : h=geoidh_egm96(posd); break;
+            case GEOID_EGM2008_M25: h=geoidh_egm08(posd,model_geoid); break;
+            case GEOID_EGM2008_M10: h=geoidh_egm08(posd,model_geoid); break;
+            case GEOID_GSI2000_M15: h=geoidh_gsi  (posd); break;
+            default: h=0.0; break;
+        }
+        unlock(&lock_geoid);
+        if (h==0.0) return 0.0;
     }
     if (fabs(h)>200.0) {
         trace(2,"invalid geoid model: lat=%.3f lon=%.3f h=%.3f\n",posd[0],posd[1],h);
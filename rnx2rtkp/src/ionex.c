@@ -301,7 +301,7 @@ extern void readtec(const char *file, nav_t *nav, int opt)
     n=expath(file,efiles,MAXEXFILE);
     
     for (i=0;i<n;i++) {
-        if (!(fp=fopen(efiles[i],"r"))) {
+        if (!(fp=uncfopen(efiles[i],NULL))) {
             trace(2,"ionex file open error %s\n",efiles[i]);
             continue;
         }
@@ -168,6 +168,9 @@ extern int lambda(int n, int m, const double *a, const double *Q, double *F,
     double *L,*D,*Z,*z,*E;
     
     if (n<=0||m<=0) return -1;
+    
+    PROFBEG(PROF_LAMBDA);
+    
     L=zeros(n,n); D=mat(n,1); Z=eye(n); z=mat(n,1),E=mat(n,m);
     
     /* LD factorization */
@@ -184,5 +187,7 @@ extern int lambda(int n, int m, const double *a, const double *Q, double *F,
         }
     }
     free(L); free(D); free(Z); free(z); free(E);
+    
+    PROFEND(PROF_LAMBDA);
     return info;
 }
@@ -147,6 +147,10 @@ opt_t sysopts[]={
     {"misc-sbasatsel",  0,  (void *)&prcopt_.sbassatsel, "0:all"},
     {"misc-rnxopt1",    2,  (void *)prcopt_.rnxopt[0],   ""     },
     {"misc-rnxopt2",    2,  (void *)prcopt_.rnxopt[1],   ""     },
+    {"misc-nthread",    0,  (void *)&prcopt_.nthread,    ""     },
+    {"misc-tuwarm",     1,  (void *)&prcopt_.tuwarm,     "s"    },
+    {"misc-rnxindex",   3,  (void *)&prcopt_.rnxidx,     SWTOPT },
+    {"misc-sparseh",    3,  (void *)&prcopt_.sparseh,    SWTOPT },
     
     {"file-satantfile", 2,  (void *)&filopt_.satantp,    ""     },
     {"file-rcvantfile", 2,  (void *)&filopt_.rcvantp,    ""     },
@@ -35,6 +35,16 @@ static const char rcsid[]="$Id:$";
 #define ERR_CBIAS   0.3         /* code bias error std (m) */
 #define REL_HUMI    0.7         /* relative humidity for saastamoinen model */
 
+#define MAXLOGLINE  512         /* max length of log line */
+
+static const char pcorhead[]="unix_time,unix_sec,sat_id,sat_x,sat_y,sat_z,azi,"
+                             "ele,raw_pseudo,cor_pseudo,range,sigma\n";
+static const char pcorfmt []="%lf,%f,%d,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf\n";
+static const double rr_chti[]={ /* default true receiver position (CHTI) */
+    // -4607855.993,-272375.743,-4386954.429 // CHTI location retreived from Rinex file
+    -4607855.52,-272377.50,-4386954.39 // CHTI GT location solved by online SPP
+};
+
 /* pseudorange measurement error variance ------------------------------------*/
 static double varerr(const prcopt_t *opt, double el, int sys)
 {
@@ -322,11 +332,13 @@ static int valsol(const double *azel, const int *vsat, int n,
  *          svh[i]        = obs[i] sat health flag
  *          double *Praw     O   raw pseduorange
  *          double *Pcor     O   corrected pseduorange (sat clock bias, trop delay, iono delay)
+ *          double *rr       I   true receiver position {x,y,z} (ecef) (m)
  */
 static int pseudocor(const obsd_t *obs, int n, const double *rs, const double *dts,
                   const double *vare, const int *svh, const nav_t *nav,
                   const prcopt_t *opt, sol_t *sol, double *AziEle, int *vsat,
-                  double *resp, char *msg, double *Praw, double *Pcor,double *Rtrue, double *measVar)
+                  double *resp, char *msg, double *Praw, double *Pcor,double *Rtrue, double *measVar,
+                  const double *rr)
 {
 
     
@@ -338,15 +350,13 @@ static int pseudocor(const obsd_t *obs, int n, const double *rs, const double *d
     v=mat(n+4,1); H=mat(NX,n+4); var=mat(n+4,1);
     
     int iter = 0;
-    double r,dion,dtrp,vmeas,vion,vtrp,rr[3],pos[3],dtr,e[3],P,lam_L1;
+    double r,dion,dtrp,vmeas,vion,vtrp,pos[3],dtr,e[3],P,lam_L1;
     int i,j,nv=0,sys,mask[4]={0};
     
     trace(3,"resprng : n=%d\n",n);
     
     
-    // rr is receiver position (xyz) 
-    // rr[0]=-4607855.993;rr[1]=-272375.743;rr[2]=-4386954.429; // CHTI location retreived from Rinex file
-    rr[0]=-4607855.52; rr[1]=-272377.50; rr[2]=-4386954.39; // CHTI GT location solved by online SPP
+    // rr is true receiver position (xyz) 
     ecef2pos(rr,pos); //xyz to lla
     
     for (i=0;i<n&&i<MAXOBS;i++) {
@@ -641,7 +651,7 @@ static void output_pseudocor(const char* output_filename, const obsd_t *obs, int
     
     // Write the header if the file is empty
     if (is_empty) {
-        fprintf(log_file, "unix_time,unix_sec,sat_id,sat_x,sat_y,sat_z,azi,ele,raw_pseudo,cor_pseudo,range,sigma\n");
+        fputs(pcorhead, log_file);
     }
     // Iterate through the satellite observations and write the desired information to the log file
     for (int i = 0; i < n; i++) {
@@ -659,12 +669,207 @@ static void output_pseudocor(const char* output_filename, const obsd_t *obs, int
         double sigma = sqrt(measVar[i]);
         
         // Write the information to the log file
-        fprintf(log_file, "%lf,%f,%d,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf\n", unix_time,unix_sec, sat_id, sat_x,sat_y,sat_z,azi,ele,raw_pseudo, cor_pseudo,range,sigma);
+        fprintf(log_file, pcorfmt, unix_time,unix_sec, sat_id, sat_x,sat_y,sat_z,azi,ele,raw_pseudo, cor_pseudo,range,sigma);
     }
     
     // Close the log file
     fclose(log_file);
 }
+/* flush pseudorange correction log (called with lock) -----------------------*/
+static void flushpcorlog(pcorlog_t *log)
+{
+    if (log->fp&&log->nb>0) {
+        
+        /* write by a call at line boundary to the unbuffered file */
+        if (fwrite(log->buff,1,log->nb,log->fp)<(size_t)log->nb) {
+            trace(2,"pcorlog write error: doy=%d\n",log->doy);
+        }
+    }
+    log->nb=0;
+}
+/* open pseudorange correction log file of the day (called with lock) --------*/
+static int openpcorday(pcorlog_t *log, int doy)
+{
+    char path[1100];
+    
+    flushpcorlog(log);
+    if (log->fp) fclose(log->fp);
+    log->fp=NULL;
+    log->doy=doy;
+    
+    sprintf(path,"%.1024s%d.csv",log->prefix,doy);
+    
+    trace(3,"openpcorday: path=%s\n",path);
+    
+    if (!(log->fp=fopen(path,"a"))) {
+        trace(2,"pcorlog open error: %s\n",path);
+        return 0;
+    }
+    setvbuf(log->fp,NULL,_IONBF,0);
+    
+    /* write header if the file is empty */
+    fseek(log->fp,0,SEEK_END);
+    if (ftell(log->fp)==0) fputs(pcorhead,log->fp);
+    return 1;
+}
+/* output pseudorange corrections to log ---------------------------------------
+* output the same lines as output_pseudocor() to the log file of the day of
+* the observation time through the write buffer. epochs before the output
+* start time (log->ts) are not output.
+*-----------------------------------------------------------------------------*/
+static void outpcorlog(pcorlog_t *log, const obsd_t *obs, int n,
+                       const double *rs, const double *Praw,
+                       const double *Pcor, const double *Rtrue,
+                       const double *AziEle, const double *measVar)
+{
+    int i,doy=(int)time2doy(obs[0].time);
+    
+    if (log->ts.time&&timediff(obs[0].time,log->ts)<-DTTOL) return;
+    
+    lock(&log->lock);
+    
+    if (doy!=log->doy) openpcorday(log,doy);
+    
+    for (i=0;i<n&&log->fp;i++) {
+        if (log->nb+MAXLOGLINE>log->nbuff) flushpcorlog(log);
+        log->nb+=sprintf(log->buff+log->nb,pcorfmt,(double)obs[i].time.time,
+                         obs[i].time.sec,obs[i].sat,rs[i*6],rs[1+i*6],
+                         rs[2+i*6],AziEle[i*2],AziEle[1+i*2],Praw[i],Pcor[i],
+                         Rtrue[i],sqrt(measVar[i]));
+    }
+    unlock(&log->lock);
+}
+/* pseudorange correction log flush thread -----------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI pcorlogthread(void *arg)
+#else
+static void *pcorlogthread(void *arg)
+#endif
+{
+    pcorlog_t *log=(pcorlog_t *)arg;
+    int t;
+    
+    while (log->state) {
+        for (t=0;log->state&&t<log->tflush;t+=10) sleepms(10);
+        
+        lock(&log->lock);
+        flushpcorlog(log);
+        unlock(&log->lock);
+    }
+    return 0;
+}
+/* open pseudorange correction log ---------------------------------------------
+* open pseudorange correction log written by pntpos() through processing
+* options (opt->pcorlog). the lines are buffered and written to the file of
+* the day of observation time <prefix><doy>.csv opened for appending.
+* args   : pcorlog_t *log   IO  pseudorange correction log
+*          char   *prefix   I   file path prefix
+*          int    nbuff     I   buffer size (bytes)
+*          int    tflush    I   flush interval by thread (ms) (0:no thread)
+* return : status (1:ok,0:error)
+* notes  : the output start time log->ts (0:all) can be set after opening
+*-----------------------------------------------------------------------------*/
+extern int pcorlogopen(pcorlog_t *log, const char *prefix, int nbuff,
+                       int tflush)
+{
+    gtime_t t0={0};
+    
+    trace(3,"pcorlogopen: prefix=%s nbuff=%d tflush=%d\n",prefix,nbuff,
+          tflush);
+    
+    log->fp=NULL;
+    log->doy=log->nb=log->state=0;
+    log->ts=t0;
+    log->nbuff=nbuff>MAXLOGLINE*2?nbuff:MAXLOGLINE*2;
+    log->tflush=tflush;
+    strncpy(log->prefix,prefix,sizeof(log->prefix)-1);
+    log->prefix[sizeof(log->prefix)-1]='\0';
+    
+    if (!(log->buff=(char *)malloc(log->nbuff))) {
+        trace(1,"pcorlogopen: malloc error\n");
+        return 0;
+    }
+    initlock(&log->lock);
+    
+    if (tflush>0) {
+        log->state=1;
+#ifdef WIN32
+        if (!(log->thread=CreateThread(NULL,0,pcorlogthread,log,0,NULL))) {
+#else
+        if (pthread_create(&log->thread,NULL,pcorlogthread,log)) {
+#endif
+            trace(2,"pcorlogopen: thread create error\n");
+            log->state=0;
+        }
+    }
+    return 1;
+}
+/* close pseudorange correction log ------------------------------------------*/
+extern void pcorlogclose(pcorlog_t *log)
+{
+    trace(3,"pcorlogclose:\n");
+    
+    if (!log->buff) return;
+    
+    if (log->state) {
+        log->state=0;
+#ifdef WIN32
+        WaitForSingleObject(log->thread,INFINITE);
+        CloseHandle(log->thread);
+#else
+        pthread_join(log->thread,NULL);
+#endif
+    }
+    flushpcorlog(log);
+    if (log->fp) fclose(log->fp);
+    free(log->buff);
+    log->fp=NULL;
+    log->buff=NULL;
+    log->doy=log->nb=0;
+}
+/* pseudorange corrections with true receiver position -------------------------
+* compute pseudorange corrections of observation data with satellite positions
+* and clocks given and output them to pseudorange correction log
+* args   : obsd_t *obs      I   observation data
+*          int    n         I   number of observation data
+*          double *rs       I   sat positions/velocities (see satposs())
+*          double *dts      I   sat clocks (see satposs())
+*          double *var      I   sat position and clock error variances (m^2)
+*          int    *svh      I   sat health flags
+*          nav_t  *nav      I   navigation data
+*          prcopt_t *opt    I   processing options
+*          double *rr       I   true receiver position {x,y,z} (ecef) (m)
+*          pcorlog_t *log   IO  pseudorange correction log
+* return : number of observation data output
+* notes  : the lines output are the same as ones by pntpos() with opt->pcorlog
+*          except for zeros for satellites without pseudorange corrections
+*-----------------------------------------------------------------------------*/
+extern int pntpcor(const obsd_t *obs, int n, const double *rs,
+                   const double *dts, const double *var, const int *svh,
+                   const nav_t *nav, const prcopt_t *opt, const double *rr,
+                   pcorlog_t *log)
+{
+    sol_t sol={0};
+    double *resp,*Praw,*Pcor,*AziEle,*measVar,*Rtrue;
+    int vsat[MAXOBS];
+    char msg[128]="";
+    
+    trace(3,"pntpcor : tobs=%s n=%d\n",time_str(obs[0].time,3),n);
+    
+    if (n<=0) return 0;
+    if (n>MAXOBS) n=MAXOBS;
+    
+    resp=zeros(1,n); Praw=zeros(1,n); Pcor=zeros(1,n); AziEle=zeros(2,n);
+    measVar=zeros(1,n); Rtrue=zeros(1,n);
+    
+    pseudocor(obs,n,rs,dts,var,svh,nav,opt,&sol,AziEle,vsat,resp,msg,Praw,
+              Pcor,Rtrue,measVar,rr);
+    outpcorlog(log,obs,n,rs,Praw,Pcor,Rtrue,AziEle,measVar);
+    
+    free(resp); free(Praw); free(Pcor); free(AziEle); free(measVar);
+    free(Rtrue);
+    return n;
+}
 
 /* single-point positioning ----------------------------------------------------
 * compute receiver position, velocity, clock bias by single-point positioning
@@ -696,6 +901,8 @@ extern int pntpos(const obsd_t *obs, int n, const nav_t *nav,
     
     trace(3,"pntpos  : tobs=%s n=%d\n",time_str(obs[0].time,3),n);
     
+    PROFBEG(PROF_PNTPOS);
+    
     sol->time=obs[0].time; msg[0]='\0';
     
     rs=mat(6,n); dts=mat(2,n); var=mat(1,n); azel_=zeros(2,n); resp=mat(1,n); 
@@ -712,15 +919,20 @@ extern int pntpos(const obsd_t *obs, int n, const nav_t *nav,
     satposs(sol->time,obs,n,nav,opt_.sateph,rs,dts,var,svh);
     
     /* pseduorange correction */
-    pseudocor(obs,n,rs,dts,var,svh,nav,&opt_,sol,AziEle,vsat,resp,msg,Praw,Pcor,Rtrue,measVar);
+    pseudocor(obs,n,rs,dts,var,svh,nav,&opt_,sol,AziEle,vsat,resp,msg,Praw,Pcor,Rtrue,measVar,rr_chti);
     // output time (obs[i].time.time,obs[i].time.sec), sat_id(obs[i].sat), sat_pos(rs), 
     // elevation(AziEle), azimuth(AziEle), raw_pseduo(Praw), corrected pseduo(Pcor), true range (Rtrue), sigma (measVar)
-    double doy = time2doy(obs[0].time);
-    int doy_i = (int)doy;
-    char output_filename[20];
-    sprintf(output_filename, "log%d.csv", doy_i);
-    output_pseudocor(output_filename,obs, n, rs, Praw, Pcor,Rtrue,AziEle,measVar);
-
+    if (opt->pcorlog) {
+        outpcorlog(opt->pcorlog,obs,n,rs,Praw,Pcor,Rtrue,AziEle,measVar);
+    }
+    else {
+        double doy = time2doy(obs[0].time);
+        int doy_i = (int)doy;
+        char output_filename[20];
+        sprintf(output_filename, "log%d.csv", doy_i);
+        output_pseudocor(output_filename,obs, n, rs, Praw, Pcor,Rtrue,AziEle,measVar);
+    }
+    
     /* estimate receiver position with pseudorange */
     stat=estpos(obs,n,rs,dts,var,svh,nav,&opt_,sol,azel_,vsat,resp,msg);
 
@@ -751,6 +963,8 @@ extern int pntpos(const obsd_t *obs, int n, const nav_t *nav,
         }
     }
     free(rs); free(dts); free(var); free(azel_); free(resp);
+    
+    PROFEND(PROF_PNTPOS);
     return stat;
 }
 
@@ -38,38 +38,148 @@ static const char rcsid[]="$Id: postpos.c,v 1.1 2008/07/17 21:48:06 ttaka Exp $"
 
 #define MAXPRCDAYS  100          /* max days of continuous processing */
 #define MAXINFILE   1000         /* max number of input files */
+#define MAXSESTHREAD 64          /* max number of session threads */
+#define PCORLOGBUFF 1048576      /* buffer size of pseudorange correction log */
+#define PCORLOGPFX  "log"        /* file prefix of pseudorange correction log */
+#define MAXPCORSTA  256          /* max number of batch stations */
+#define MAXSTAFILE  64           /* max number of obs files of batch station */
+#define NPCOREPOCH  120          /* number of epochs of a batch block */
+#define MAXDTPCOR   0.1          /* max time diff to reuse sat position (s) */
 
 /* constants/global variables ------------------------------------------------*/
 
 static pcvs_t pcvss={0};        /* receiver antenna parameters */
 static pcvs_t pcvsr={0};        /* satellite antenna parameters */
-static obs_t obss={0};          /* observation data */
-static nav_t navs={0};          /* navigation data */
-static sbs_t sbss={0};          /* sbas messages */
-static lex_t lexs={0};          /* lex messages */
-static sta_t stas[MAXRCV];      /* station infomation */
-static int nepoch=0;            /* number of observation epochs */
-static int iobsu =0;            /* current rover observation data index */
-static int iobsr =0;            /* current reference observation data index */
-static int isbs  =0;            /* current sbas message index */
-static int ilex  =0;            /* current lex message index */
-static int revs  =0;            /* analysis direction (0:forward,1:backward) */
-static int aborts=0;            /* abort status */
-static sol_t *solf;             /* forward solutions */
-static sol_t *solb;             /* backward solutions */
-static double *rbf;             /* forward base positions */
-static double *rbb;             /* backward base positions */
-static int isolf=0;             /* current forward solutions index */
-static int isolb=0;             /* current backward solutions index */
-static char proc_rov [64]="";   /* rover for current processing */
-static char proc_base[64]="";   /* base station for current processing */
-static char rtcm_file[1024]=""; /* rtcm data file */
-static char rtcm_path[1024]=""; /* rtcm data path */
-static rtcm_t rtcm;             /* rtcm control struct */
-static FILE *fp_rtcm=NULL;      /* rtcm data file pointer */
+static nav_t navs={0};          /* navigation data (dcb, tec and erp) */
+
+typedef struct {                /* processing session type */
+    obs_t obs;                  /* observation data */
+    rnxobs_t rnx[2];            /* rinex obs streams {rover,base} */
+    int stream;                 /* input obs from streams (forward only) */
+    gtime_t tspan[2];           /* rover obs time span {start,end} */
+    int span;                   /* rover obs time span (0:unset,1:set,-1:none) */
+    nav_t nav;                  /* navigation data */
+    sta_t sta[MAXRCV];          /* station infomation */
+    const sbs_t *sbs;           /* sbas messages */
+    const lex_t *lex;           /* lex messages */
+    const char *rtcm_file;      /* rtcm data file */
+    gtime_t tout;               /* solution output start time (0:all) */
+    int nepoch;                 /* number of observation epochs */
+    int iobsu;                  /* current rover observation data index */
+    int iobsr;                  /* current reference observation data index */
+    int isbs;                   /* current sbas message index */
+    int ilex;                   /* current lex message index */
+    int revs;                   /* analysis direction (0:forward,1:backward) */
+    int aborts;                 /* abort status */
+    sol_t *solf;                /* forward solutions */
+    sol_t *solb;                /* backward solutions */
+    double *rbf;                /* forward base positions */
+    double *rbb;                /* backward base positions */
+    int isolf;                  /* current forward solutions index */
+    int isolb;                  /* current backward solutions index */
+    char proc_rov [64];         /* rover for current processing */
+    char proc_base[64];         /* base station for current processing */
+    char rtcm_path[1024];       /* rtcm data path */
+    rtcm_t rtcm;                /* rtcm control struct */
+    FILE *fp_rtcm;              /* rtcm data file pointer */
+    pcorlog_t pcorlog;          /* pseudorange correction log */
+    const char *pcorpfx;        /* pseudorange correction log prefix */
+} ses_t;
+
+typedef struct {                /* processing session job type */
+    char **ifile;               /* input files (keywords replaced) */
+    char ofile[1024];           /* output file (keywords replaced) */
+    char rov [64];              /* rover id */
+    char base[64];              /* base station id */
+    char pfile[96];             /* temporary pcorlog prefix ("":pcorpfx) */
+} sesjob_t;
+
+typedef struct {                /* processing session pool type */
+    gtime_t ts,te;              /* processing start/end time */
+    gtime_t tout;               /* solution output start time (0:all) */
+    double ti;                  /* processing interval (s) */
+    const prcopt_t *popt;       /* processing options */
+    const solopt_t *sopt;       /* solution options */
+    const filopt_t *fopt;       /* file options */
+    int flag;                   /* output header/trace flag */
+    const int *index;           /* input file index */
+    int n;                      /* number of input files */
+    const nav_t *nav;           /* navigation data shared by sessions */
+    const sbs_t *sbs;           /* sbas messages */
+    const lex_t *lex;           /* lex messages */
+    const char *rtcm_file;      /* rtcm data file */
+    const char *pcorpfx;        /* pseudorange correction log prefix */
+    sesjob_t *job;              /* session jobs */
+    int njob,njobmax;           /* number of session jobs */
+    int next;                   /* next session job index */
+    int stat;                   /* status (1:aborted) */
+    lock_t lock;                /* lock flag */
+} sespool_t;
+
+typedef struct {                /* processing unit type */
+    gtime_t ts,te;              /* processing start/end time */
+    gtime_t tout;               /* solution output start time (0:all) */
+    int flag;                   /* output header/trace flag */
+    char **ifile;               /* input files */
+    int *index;                 /* input file index */
+    int n;                      /* number of input files */
+    char ofile[1024];           /* output file */
+    char tfile[1024];           /* temporary output file ("":ofile) */
+    char pfile[64];             /* temporary pcorlog prefix ("":PCORLOGPFX) */
+    int stat;                   /* status (0:ok,1:aborted) */
+} unit_t;
+
+typedef struct {                /* processing unit pool type */
+    gtime_t ts,te;              /* processing start/end time */
+    double ti;                  /* processing interval (s) */
+    prcopt_t popt;              /* processing options */
+    const solopt_t *sopt;       /* solution options */
+    const filopt_t *fopt;       /* file options */
+    const char *rov,*base;      /* rover and base station id lists */
+    unit_t *unit;               /* processing units */
+    int nunit,nunitmax;         /* number of processing units */
+    int next;                   /* next processing unit index */
+    int stat;                   /* status (1:aborted) */
+    lock_t lock;                /* lock flag */
+} unitpool_t;
+
+typedef struct {                /* pseudorange correction station type */
+    char name[64];              /* station name */
+    double rr[3];               /* true receiver position (ecef) (m) */
+    char *files[MAXSTAFILE];    /* rinex obs files */
+    int nfile;                  /* number of rinex obs files */
+    rnxobs_t rnx;               /* rinex obs stream */
+    pcorlog_t log;              /* pseudorange correction log */
+    obsd_t *data;               /* obs data of block */
+    int nobs,nmax;              /* number of obs data of block */
+    int index[NPCOREPOCH];      /* obs data index of block epochs */
+    int nsat[NPCOREPOCH];       /* number of obs data of block epochs */
+} pcorsta_t;
+
+typedef struct {                /* shared satellite position type */
+    double rs[6];               /* sat position and velocity (ecef) (m|m/s) */
+    double dts[2];              /* sat clock bias and drift (s|s/s) */
+    double var;                 /* sat position/clock error variance (m^2) */
+    double tr;                  /* transmission time w/o sat clock (s) */
+    int svh;                    /* sat health flag */
+    int stat;                   /* status (0:unset,1:set) */
+} pcorsat_t;
+
+typedef struct {                /* pseudorange correction batch pool type */
+    prcopt_t opt;               /* processing options */
+    const nav_t *nav;           /* navigation data shared by stations */
+    pcorsta_t *sta;             /* batch stations */
+    int nsta;                   /* number of batch stations */
+    gtime_t time[NPCOREPOCH];   /* block epoch times */
+    int nep;                    /* number of block epochs */
+    pcorsat_t *sat;             /* shared sat positions {epoch*MAXSAT+sat-1} */
+    int phase;                  /* pool phase (0:sat positions,1:stations) */
+    int next;                   /* next job index */
+    lock_t lock;                /* lock flag */
+} pcorpool_t;
 
 /* show message and check break ----------------------------------------------*/
-static int checkbrk(const char *format, ...)
+static int checkbrk(const ses_t *ses, const char *format, ...)
 {
     va_list arg;
     char buff[1024],*p=buff;
@@ -77,9 +187,12 @@ static int checkbrk(const char *format, ...)
     va_start(arg,format);
     p+=vsprintf(p,format,arg);
     va_end(arg);
-    if (*proc_rov&&*proc_base) sprintf(p," (%s-%s)",proc_rov,proc_base);
-    else if (*proc_rov ) sprintf(p," (%s)",proc_rov );
-    else if (*proc_base) sprintf(p," (%s)",proc_base);
+    if (!ses) ;
+    else if (*ses->proc_rov&&*ses->proc_base) {
+        sprintf(p," (%s-%s)",ses->proc_rov,ses->proc_base);
+    }
+    else if (*ses->proc_rov ) sprintf(p," (%s)",ses->proc_rov );
+    else if (*ses->proc_base) sprintf(p," (%s)",ses->proc_base);
     return showmsg(buff);
 }
 /* output reference position -------------------------------------------------*/
@@ -110,12 +223,11 @@ static void outrpos(FILE *fp, const double *r, const solopt_t *opt)
 }
 /* output header -------------------------------------------------------------*/
 static void outheader(FILE *fp, char **file, int n, const prcopt_t *popt,
-                      const solopt_t *sopt)
+                      const solopt_t *sopt, gtime_t ts, gtime_t te)
 {
     const char *s1[]={"GPST","UTC","JST"};
-    gtime_t ts,te;
     double t1,t2;
-    int i,j,w1,w2;
+    int i,w1,w2;
     char s2[32],s3[32];
     
     trace(3,"outheader: n=%d\n",n);
@@ -132,11 +244,7 @@ static void outheader(FILE *fp, char **file, int n, const prcopt_t *popt,
         for (i=0;i<n;i++) {
             fprintf(fp,"%s inp file  : %s\n",COMMENTH,file[i]);
         }
-        for (i=0;i<obss.n;i++)    if (obss.data[i].rcv==1) break;
-        for (j=obss.n-1;j>=0;j--) if (obss.data[j].rcv==1) break;
-        if (j<i) {fprintf(fp,"\n%s no rover obs data\n",COMMENTH); return;}
-        ts=obss.data[i].time;
-        te=obss.data[j].time;
+        if (!ts.time) {fprintf(fp,"\n%s no rover obs data\n",COMMENTH); return;}
         t1=time2gpst(ts,&w1);
         t2=time2gpst(te,&w2);
         if (sopt->times>=1) ts=gpst2utc(ts);
@@ -208,113 +316,168 @@ static void input_ssr(gtime_t time, rtcm_t *rtcm, nav_t *nav, FILE *fp)
     }
 }
 
+/* input forward obs data ----------------------------------------------------*/
+static int inputobsf(ses_t *ses, obsd_t *obs, const prcopt_t *popt)
+{
+    int i,nu,nr,n=0;
+    
+    if ((nu=nextobsf(&ses->obs,&ses->iobsu,1))<=0) return 0;
+    if (popt->intpref) {
+        for (;(nr=nextobsf(&ses->obs,&ses->iobsr,2))>0;ses->iobsr+=nr)
+            if (timediff(ses->obs.data[ses->iobsr].time,
+                         ses->obs.data[ses->iobsu].time)>-DTTOL) break;
+    }
+    else {
+        for (i=ses->iobsr;(nr=nextobsf(&ses->obs,&i,2))>0;ses->iobsr=i,i+=nr)
+            if (timediff(ses->obs.data[i].time,
+                         ses->obs.data[ses->iobsu].time)>DTTOL) break;
+    }
+    nr=nextobsf(&ses->obs,&ses->iobsr,2);
+    for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=ses->obs.data[ses->iobsu+i];
+    for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=ses->obs.data[ses->iobsr+i];
+    ses->iobsu+=nu;
+    
+    return n;
+}
+/* input forward obs data from rinex obs streams -----------------------------*/
+static int inputobss(ses_t *ses, obsd_t *obs, const prcopt_t *popt)
+{
+    rnxobs_t *rov=ses->rnx,*base=ses->rnx+1;
+    gtime_t time;
+    int i,n=0;
+    
+    if (rov->n[0]<=0) return 0;
+    
+    time=rov->data[0][0].time;
+    
+    /* select base station epoch as well as inputobs() with all obs data */
+    if (popt->intpref) {
+        while (base->n[0]>0&&timediff(base->data[0][0].time,time)<=-DTTOL) {
+            input_rnxobs(base);
+        }
+    }
+    else {
+        while (base->n[1]>0&&timediff(base->data[1][0].time,time)<=DTTOL) {
+            input_rnxobs(base);
+        }
+    }
+    for (i=0;i<rov ->n[0]&&n<MAXOBS*2;i++) obs[n++]=rov ->data[0][i];
+    for (i=0;i<base->n[0]&&n<MAXOBS*2;i++) obs[n++]=base->data[0][i];
+    
+    /* advance rover stream */
+    input_rnxobs(rov);
+    
+    return n;
+}
 /* input obs data, navigation messages and sbas correction -------------------*/
-static int inputobs(obsd_t *obs, int solq, const prcopt_t *popt)
+static int inputobs(ses_t *ses, obsd_t *obs, int solq, const prcopt_t *popt)
 {
     gtime_t time={0};
     char path[1024];
     int i,nu,nr,n=0;
     
-    trace(3,"infunc  : revs=%d iobsu=%d iobsr=%d isbs=%d\n",revs,iobsu,iobsr,isbs);
+    trace(3,"infunc  : ses->revs=%d ses->iobsu=%d ses->iobsr=%d ses->isbs=%d\n",ses->revs,ses->iobsu,ses->iobsr,ses->isbs);
     
-    if (0<=iobsu&&iobsu<obss.n) {
-        settime((time=obss.data[iobsu].time));
-        if (checkbrk("processing : %s Q=%d",time_str(time,0),solq)) {
-            aborts=1; showmsg("aborted"); return -1;
-        }
+    if (ses->stream) {
+        if (ses->rnx[0].n[0]>0) time=ses->rnx[0].data[0][0].time;
     }
-    if (!revs) { /* input forward data */
-        if ((nu=nextobsf(&obss,&iobsu,1))<=0) return -1;
-        if (popt->intpref) {
-            for (;(nr=nextobsf(&obss,&iobsr,2))>0;iobsr+=nr)
-                if (timediff(obss.data[iobsr].time,obss.data[iobsu].time)>-DTTOL) break;
-        }
-        else {
-            for (i=iobsr;(nr=nextobsf(&obss,&i,2))>0;iobsr=i,i+=nr)
-                if (timediff(obss.data[i].time,obss.data[iobsu].time)>DTTOL) break;
+    else if (0<=ses->iobsu&&ses->iobsu<ses->obs.n) {
+        time=ses->obs.data[ses->iobsu].time;
+    }
+    if (time.time) {
+        settime(time);
+        if (checkbrk(ses,"processing : %s Q=%d",time_str(time,0),solq)) {
+            ses->aborts=1; showmsg("aborted"); return -1;
         }
-        nr=nextobsf(&obss,&iobsr,2);
-        for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsu+i];
-        for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsr+i];
-        iobsu+=nu;
+    }
+    if (!ses->revs) { /* input forward data */
+        n=ses->stream?inputobss(ses,obs,popt):inputobsf(ses,obs,popt);
+        if (n<=0) return -1;
         
         /* update sbas corrections */
-        while (isbs<sbss.n) {
-            time=gpst2time(sbss.msgs[isbs].week,sbss.msgs[isbs].tow);
+        while (ses->isbs<ses->sbs->n) {
+            time=gpst2time(ses->sbs->msgs[ses->isbs].week,ses->sbs->msgs[ses->isbs].tow);
             
-            if (getbitu(sbss.msgs[isbs].msg,8,6)!=9) { /* except for geo nav */
-                sbsupdatecorr(sbss.msgs+isbs,&navs);
+            if (getbitu(ses->sbs->msgs[ses->isbs].msg,8,6)!=9) { /* except for geo nav */
+                sbsupdatecorr(ses->sbs->msgs+ses->isbs,&ses->nav);
             }
             if (timediff(time,obs[0].time)>-1.0-DTTOL) break;
-            isbs++;
+            ses->isbs++;
         }
         /* update lex corrections */
-        while (ilex<lexs.n) {
-            if (lexupdatecorr(lexs.msgs+ilex,&navs,&time)) {
+        while (ses->ilex<ses->lex->n) {
+            if (lexupdatecorr(ses->lex->msgs+ses->ilex,&ses->nav,&time)) {
                 if (timediff(time,obs[0].time)>-1.0-DTTOL) break;
             }
-            ilex++;
+            ses->ilex++;
         }
         /* update rtcm corrections */
-        if (*rtcm_file) {
+        if (*ses->rtcm_file) {
             
             /* open or swap rtcm file */
-            reppath(rtcm_file,path,obs[0].time,"","");
+            reppath(ses->rtcm_file,path,obs[0].time,"","");
             
-            if (strcmp(path,rtcm_path)) {
-                strcpy(rtcm_path,path);
+            if (strcmp(path,ses->rtcm_path)) {
+                strcpy(ses->rtcm_path,path);
                 
-                if (fp_rtcm) fclose(fp_rtcm);
-                fp_rtcm=fopen(path,"rb");
-                if (fp_rtcm) {
-                    rtcm.time=obs[0].time;
-                    input_rtcm3f(&rtcm,fp_rtcm);
+                if (ses->fp_rtcm) fclose(ses->fp_rtcm);
+                ses->fp_rtcm=fopen(path,"rb");
+                if (ses->fp_rtcm) {
+                    ses->rtcm.time=obs[0].time;
+                    input_rtcm3f(&ses->rtcm,ses->fp_rtcm);
                     trace(2,"rtcm file open: %s\n",path);
                 }
             }
-            if (fp_rtcm) {
-                input_ssr(obs[0].time, &rtcm, &navs, fp_rtcm);
+            if (ses->fp_rtcm) {
+                input_ssr(obs[0].time, &ses->rtcm, &ses->nav, ses->fp_rtcm);
             }
         }
     }
     else { /* input backward data */
-        if ((nu=nextobsb(&obss,&iobsu,1))<=0) return -1;
+        if ((nu=nextobsb(&ses->obs,&ses->iobsu,1))<=0) return -1;
         if (popt->intpref) {
-            for (;(nr=nextobsb(&obss,&iobsr,2))>0;iobsr-=nr)
-                if (timediff(obss.data[iobsr].time,obss.data[iobsu].time)<DTTOL) break;
+            for (;(nr=nextobsb(&ses->obs,&ses->iobsr,2))>0;ses->iobsr-=nr)
+                if (timediff(ses->obs.data[ses->iobsr].time,
+                             ses->obs.data[ses->iobsu].time)<DTTOL) break;
         }
         else {
-            for (i=iobsr;(nr=nextobsb(&obss,&i,2))>0;iobsr=i,i-=nr)
-                if (timediff(obss.data[i].time,obss.data[iobsu].time)<-DTTOL) break;
+            for (i=ses->iobsr;(nr=nextobsb(&ses->obs,&i,2))>0;ses->iobsr=i,i-=nr)
+                if (timediff(ses->obs.data[i].time,
+                             ses->obs.data[ses->iobsu].time)<-DTTOL) break;
         }
-        nr=nextobsb(&obss,&iobsr,2);
-        for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsu-nu+1+i];
-        for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsr-nr+1+i];
-        iobsu-=nu;
+        nr=nextobsb(&ses->obs,&ses->iobsr,2);
+        for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=ses->obs.data[ses->iobsu-nu+1+i];
+        for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=ses->obs.data[ses->iobsr-nr+1+i];
+        ses->iobsu-=nu;
         
         /* update sbas corrections */
-        while (isbs>=0) {
-            time=gpst2time(sbss.msgs[isbs].week,sbss.msgs[isbs].tow);
+        while (ses->isbs>=0) {
+            time=gpst2time(ses->sbs->msgs[ses->isbs].week,ses->sbs->msgs[ses->isbs].tow);
             
-            if (getbitu(sbss.msgs[isbs].msg,8,6)!=9) { /* except for geo nav */
-                sbsupdatecorr(sbss.msgs+isbs,&navs);
+            if (getbitu(ses->sbs->msgs[ses->isbs].msg,8,6)!=9) { /* except for geo nav */
+                sbsupdatecorr(ses->sbs->msgs+ses->isbs,&ses->nav);
             }
             if (timediff(time,obs[0].time)<1.0+DTTOL) break;
-            isbs--;
+            ses->isbs--;
         }
         /* update lex corrections */
-        while (ilex>=0) {
-            if (lexupdatecorr(lexs.msgs+ilex,&navs,&time)) {
+        while (ses->ilex>=0) {
+            if (lexupdatecorr(ses->lex->msgs+ses->ilex,&ses->nav,&time)) {
                 if (timediff(time,obs[0].time)<1.0+DTTOL) break;
             }
-            ilex--;
+            ses->ilex--;
         }
     }
     return n;
 }
+/* test solution output time (exclude warm-up period) ------------------------*/
+static int outtime(const ses_t *ses, gtime_t time)
+{
+    return ses->tout.time==0||timediff(time,ses->tout)>-DTTOL;
+}
 /* process positioning -------------------------------------------------------*/
-static void procpos(FILE *fp, const prcopt_t *popt, const solopt_t *sopt,
-                    int mode)
+static void procpos(ses_t *ses, FILE *fp, const prcopt_t *popt,
+                    const solopt_t *sopt, int mode)
 {
     gtime_t time={0};
     sol_t sol={{0}};
@@ -329,9 +492,9 @@ static void procpos(FILE *fp, const prcopt_t *popt, const solopt_t *sopt,
               (popt->mode==PMODE_STATIC||popt->mode==PMODE_PPP_STATIC);
     
     rtkinit(&rtk,popt);
-    rtcm_path[0]='\0';
+    ses->rtcm_path[0]='\0';
     
-    while ((nobs=inputobs(obs,rtk.sol.stat,popt))>=0) {
+    while ((nobs=inputobs(ses,obs,rtk.sol.stat,popt))>=0) {
         
         /* exclude satellites */
         for (i=n=0;i<nobs;i++) {
@@ -340,9 +503,10 @@ static void procpos(FILE *fp, const prcopt_t *popt, const solopt_t *sopt,
         }
         if (n<=0) continue;
         
-        if (!rtkpos(&rtk,obs,n,&navs)) continue;
+        if (!rtkpos(&rtk,obs,n,&ses->nav)) continue;
         
         if (mode==0) { /* forward/backward */
+            if (!outtime(ses,rtk.sol.time)) continue;
             if (!solstatic) {
                 outsol(fp,&rtk.sol,rtk.rb,sopt);
             }
@@ -354,17 +518,17 @@ static void procpos(FILE *fp, const prcopt_t *popt, const solopt_t *sopt,
                 }
             }
         }
-        else if (!revs) { /* combined-forward */
-            if (isolf>=nepoch) return;
-            solf[isolf]=rtk.sol;
-            for (i=0;i<3;i++) rbf[i+isolf*3]=rtk.rb[i];
-            isolf++;
+        else if (!ses->revs) { /* combined-forward */
+            if (ses->isolf>=ses->nepoch) return;
+            ses->solf[ses->isolf]=rtk.sol;
+            for (i=0;i<3;i++) ses->rbf[i+ses->isolf*3]=rtk.rb[i];
+            ses->isolf++;
         }
         else { /* combined-backward */
-            if (isolb>=nepoch) return;
-            solb[isolb]=rtk.sol;
-            for (i=0;i<3;i++) rbb[i+isolb*3]=rtk.rb[i];
-            isolb++;
+            if (ses->isolb>=ses->nepoch) return;
+            ses->solb[ses->isolb]=rtk.sol;
+            for (i=0;i<3;i++) ses->rbb[i+ses->isolb*3]=rtk.rb[i];
+            ses->isolb++;
         }
     }
     if (mode==0&&solstatic&&time.time!=0.0) {
@@ -398,12 +562,16 @@ static int valcomb(const sol_t *solf, const sol_t *solb)
     return 1;
 }
 /* combine forward/backward solutions and output results ---------------------*/
-static void combres(FILE *fp, const prcopt_t *popt, const solopt_t *sopt)
+static void combres(const ses_t *ses, FILE *fp, const prcopt_t *popt,
+                    const solopt_t *sopt)
 {
     gtime_t time={0};
     sol_t sols={{0}},sol={{0}};
     double tt,Qf[9],Qb[9],Qs[9],rbs[3]={0},rb[3]={0},rr_f[3],rr_b[3],rr_s[3];
-    int i,j,k,solstatic,pri[]={0,1,2,3,4,5,1,6};
+    const sol_t *solf=ses->solf,*solb=ses->solb;
+    const double *rbf=ses->rbf,*rbb=ses->rbb;
+    int i,j,k,solstatic,isolf=ses->isolf,isolb=ses->isolb;
+    int pri[]={0,1,2,3,4,5,1,6};
     
     trace(3,"combres : isolf=%d isolb=%d\n",isolf,isolb);
     
@@ -467,6 +635,7 @@ static void combres(FILE *fp, const prcopt_t *popt, const solopt_t *sopt)
             sols.qr[4]=(float)Qs[5];
             sols.qr[5]=(float)Qs[2];
         }
+        if (!outtime(ses,sols.time)) continue;
         if (!solstatic) {
             outsol(fp,&sols,rbs,sopt);
         }
@@ -485,7 +654,7 @@ static void combres(FILE *fp, const prcopt_t *popt, const solopt_t *sopt)
 }
 /* read prec ephemeris, sbas data, lex data, tec grid and open rtcm ----------*/
 static void readpreceph(char **infile, int n, const prcopt_t *prcopt,
-                        nav_t *nav, sbs_t *sbs, lex_t *lex)
+                        nav_t *nav, sbs_t *sbs, lex_t *lex, char *rtcm_file)
 {
     seph_t seph0={0};
     int i;
@@ -527,14 +696,13 @@ static void readpreceph(char **infile, int n, const prcopt_t *prcopt,
     }
     for (i=0;i<nav->ns;i++) nav->seph[i]=seph0;
     
-    /* set rtcm file and initialize rtcm struct */
-    rtcm_file[0]=rtcm_path[0]='\0'; fp_rtcm=NULL;
+    /* set rtcm file (rtcm struct is initialized for each session) */
+    rtcm_file[0]='\0';
     
     for (i=0;i<n;i++) {
         if ((ext=strrchr(infile[i],'.'))&&
             (!strcmp(ext,".rtcm3")||!strcmp(ext,".RTCM3"))) {
             strcpy(rtcm_file,infile[i]);
-            init_rtcm(&rtcm);
             break;
         }
     }
@@ -542,8 +710,6 @@ static void readpreceph(char **infile, int n, const prcopt_t *prcopt,
 /* free prec ephemeris and sbas data -----------------------------------------*/
 static void freepreceph(nav_t *nav, sbs_t *sbs, lex_t *lex)
 {
-    int i;
-    
     trace(3,"freepreceph:\n");
     
     free(nav->peph); nav->peph=NULL; nav->ne=nav->nemax=0;
@@ -551,86 +717,131 @@ static void freepreceph(nav_t *nav, sbs_t *sbs, lex_t *lex)
     free(nav->seph); nav->seph=NULL; nav->ns=nav->nsmax=0;
     free(sbs->msgs); sbs->msgs=NULL; sbs->n =sbs->nmax =0;
     free(lex->msgs); lex->msgs=NULL; lex->n =lex->nmax =0;
-    for (i=0;i<nav->nt;i++) {
-        free(nav->tec[i].data);
-        free(nav->tec[i].rms );
+}
+/* rover obs time span -------------------------------------------------------*/
+static int obsspan(ses_t *ses, gtime_t *ts, gtime_t *te)
+{
+    const obs_t *obs=&ses->obs;
+    int i,j;
+    
+    if (!ses->span) {
+        ses->span=-1;
+        
+        if (ses->stream) { /* scan rinex obs files of rover */
+            if (scan_rnxobs(ses->rnx,ses->tspan,ses->tspan+1)>0) ses->span=1;
+        }
+        else {
+            for (i=0;i<obs->n;i++)    if (obs->data[i].rcv==1) break;
+            for (j=obs->n-1;j>=0;j--) if (obs->data[j].rcv==1) break;
+            if (i<=j) {
+                ses->tspan[0]=obs->data[i].time;
+                ses->tspan[1]=obs->data[j].time;
+                ses->span=1;
+            }
+        }
     }
-    free(nav->tec ); nav->tec =NULL; nav->nt=nav->ntmax=0;
+    if (ses->span<=0) return 0;
+    *ts=ses->tspan[0];
+    *te=ses->tspan[1];
+    return 1;
+}
+/* first observation time ----------------------------------------------------*/
+static gtime_t firstobs(const ses_t *ses)
+{
+    gtime_t time;
     
-#ifdef EXTSTEC
-    stec_free(nav);
-#endif
+    if (!ses->stream) return ses->obs.n>0?ses->obs.data[0].time:timeget();
     
-    if (fp_rtcm) fclose(fp_rtcm);
-    free_rtcm(&rtcm);
+    time=ses->rnx[0].data[0][0].time;
+    if (ses->rnx[1].n[0]>0&&timediff(ses->rnx[1].data[0][0].time,time)<0.0) {
+        time=ses->rnx[1].data[0][0].time;
+    }
+    return time;
 }
 /* read obs and nav data -----------------------------------------------------*/
-static int readobsnav(gtime_t ts, gtime_t te, double ti, char **infile,
-                      const int *index, int n, const prcopt_t *prcopt,
-                      obs_t *obs, nav_t *nav, sta_t *sta)
+static int readobsnav(ses_t *ses, gtime_t ts, gtime_t te, double ti,
+                      char **infile, const int *index, int n,
+                      const prcopt_t *prcopt, obs_t *obs, nav_t *nav, sta_t *sta)
 {
-    int i,j,ind=0,nobs=0,rcv=1;
+    gtime_t t1,t2;
+    int i,j,ind=0,nobs=0,nrnx=0,rcv=1;
     
-    trace(3,"readobsnav: ts=%s n=%d\n",time_str(ts,0),n);
+    trace(3,"readobsnav: ts=%s n=%d stream=%d\n",time_str(ts,0),n,ses->stream);
     
     obs->data=NULL; obs->n =obs->nmax =0;
     nav->eph =NULL; nav->n =nav->nmax =0;
     nav->geph=NULL; nav->ng=nav->ngmax=0;
     nav->seph=NULL; nav->ns=nav->nsmax=0;
-    nepoch=0;
+    ses->nepoch=0;
+    ses->span=0;
     
     for (i=0;i<n;i++) {
-        if (checkbrk("")) return 0;
+        if (checkbrk(ses,"")) return 0;
         
         if (index[i]!=ind) {
-            if (obs->n>nobs) rcv++;
-            ind=index[i]; nobs=obs->n; 
+            if (obs->n>nobs||nrnx>0) rcv++;
+            ind=index[i]; nobs=obs->n; nrnx=0;
         }
-        /* read rinex obs and nav file */
-        if (readrnxt(infile[i],rcv,ts,te,ti,prcopt->rnxopt[rcv<=1?0:1],obs,nav,
-                     rcv<=2?sta+rcv-1:NULL)<0) {
-            checkbrk("error : insufficient memory");
+        /* read rinex obs and nav file (obs data are input by streams) */
+        if (readrnxt(infile[i],rcv,ts,te,ti,prcopt->rnxopt[rcv<=1?0:1],
+                     ses->stream?NULL:obs,nav,rcv<=2?sta+rcv-1:NULL)<0) {
+            checkbrk(ses,"error : insufficient memory");
             trace(1,"insufficient memory\n");
             return 0;
         }
+        /* open rinex obs stream of the files with the same index */
+        if (ses->stream&&rcv<=2&&(i+1>=n||index[i+1]!=ind)) {
+            for (j=i;j>0&&index[j-1]==ind;j--) ;
+            
+            if ((nrnx=open_rnxobs(ses->rnx+rcv-1,infile+j,i-j+1,rcv,ts,te,ti,
+                                  prcopt->rnxopt[rcv<=1?0:1]))<0) {
+                checkbrk(ses,"error : insufficient memory");
+                trace(1,"insufficient memory\n");
+                return 0;
+            }
+            if (nrnx==0) close_rnxobs(ses->rnx+rcv-1);
+        }
     }
-    if (obs->n<=0) {
-        checkbrk("error : no obs data");
+    if (ses->stream?ses->rnx[0].n[0]<=0:obs->n<=0) {
+        checkbrk(ses,"error : no obs data");
         trace(1,"no obs data\n");
         return 0;
     }
     if (nav->n<=0&&nav->ng<=0&&nav->ns<=0) {
-        checkbrk("error : no nav data");
+        checkbrk(ses,"error : no nav data");
         trace(1,"no nav data\n");
         return 0;
     }
     /* sort observation data */
-    nepoch=sortobs(obs);
+    if (!ses->stream) ses->nepoch=sortobs(obs);
     
     /* delete duplicated ephemeris */
     uniqnav(nav);
     
     /* set time span for progress display */
-    if (ts.time==0||te.time==0) {
-        for (i=0;   i<obs->n;i++) if (obs->data[i].rcv==1) break;
-        for (j=obs->n-1;j>=0;j--) if (obs->data[j].rcv==1) break;
-        if (i<j) {
-            if (ts.time==0) ts=obs->data[i].time;
-            if (te.time==0) te=obs->data[j].time;
-            settspan(ts,te);
-        }
+    if ((ts.time==0||te.time==0)&&obsspan(ses,&t1,&t2)) {
+        if (ts.time==0) ts=t1;
+        if (te.time==0) te=t2;
+        settspan(ts,te);
     }
     return 1;
 }
 /* free obs and nav data -----------------------------------------------------*/
-static void freeobsnav(obs_t *obs, nav_t *nav)
+static void freeobsnav(ses_t *ses)
 {
+    obs_t *obs=&ses->obs;
+    nav_t *nav=&ses->nav;
+    
     trace(3,"freeobsnav:\n");
     
     free(obs->data); obs->data=NULL; obs->n =obs->nmax =0;
     free(nav->eph ); nav->eph =NULL; nav->n =nav->nmax =0;
     free(nav->geph); nav->geph=NULL; nav->ng=nav->ngmax=0;
     free(nav->seph); nav->seph=NULL; nav->ns=nav->nsmax=0;
+    
+    /* close rinex obs streams */
+    close_rnxobs(ses->rnx  );
+    close_rnxobs(ses->rnx+1);
 }
 /* average of single position ------------------------------------------------*/
 static int avepos(double *ra, int rcv, const obs_t *obs, const nav_t *nav,
@@ -668,10 +879,11 @@ static int avepos(double *ra, int rcv, const obs_t *obs, const nav_t *nav,
     return 1;
 }
 /* station position from file ------------------------------------------------*/
-static int getstapos(const char *file, char *name, double *r)
+static int getstapos(const char *file, const char *name, double *r)
 {
     FILE *fp;
-    char buff[256],sname[256],*p,*q;
+    char buff[256],sname[256],*p;
+    const char *q;
     double pos[3];
     
     trace(3,"getstapos: file=%s name=%s\n",file,name);
@@ -706,7 +918,7 @@ static int antpos(prcopt_t *opt, int rcvno, const obs_t *obs, const nav_t *nav,
 {
     double *rr=rcvno==1?opt->ru:opt->rb,del[3],pos[3],dr[3]={0};
     int i,postype=rcvno==1?opt->rovpos:opt->refpos;
-    char *name;
+    const char *name;
     
     trace(3,"antpos  : rcvno=%d\n",rcvno);
     
@@ -717,29 +929,29 @@ static int antpos(prcopt_t *opt, int rcvno, const obs_t *obs, const nav_t *nav,
         }
     }
     else if (postype==2) { /* read from position file */
-        name=stas[rcvno==1?0:1].name;
+        name=sta[rcvno==1?0:1].name;
         if (!getstapos(posfile,name,rr)) {
             showmsg("error : no position of %s in %s",name,posfile);
             return 0;
         }
     }
     else if (postype==3) { /* get from rinex header */
-        if (norm(stas[rcvno==1?0:1].pos,3)<=0.0) {
+        if (norm(sta[rcvno==1?0:1].pos,3)<=0.0) {
             showmsg("error : no position in rinex header");
             trace(1,"no position position in rinex header\n");
             return 0;
         }
         /* antenna delta */
-        if (stas[rcvno==1?0:1].deltype==0) { /* enu */
-            for (i=0;i<3;i++) del[i]=stas[rcvno==1?0:1].del[i];
-            del[2]+=stas[rcvno==1?0:1].hgt;
-            ecef2pos(stas[rcvno==1?0:1].pos,pos);
+        if (sta[rcvno==1?0:1].deltype==0) { /* enu */
+            for (i=0;i<3;i++) del[i]=sta[rcvno==1?0:1].del[i];
+            del[2]+=sta[rcvno==1?0:1].hgt;
+            ecef2pos(sta[rcvno==1?0:1].pos,pos);
             enu2ecef(pos,del,dr);
         }
         else { /* xyz */
-            for (i=0;i<3;i++) dr[i]=stas[rcvno==1?0:1].del[i];
+            for (i=0;i<3;i++) dr[i]=sta[rcvno==1?0:1].del[i];
         }
-        for (i=0;i<3;i++) rr[i]=stas[rcvno==1?0:1].pos[i]+dr[i];
+        for (i=0;i<3;i++) rr[i]=sta[rcvno==1?0:1].pos[i]+dr[i];
     }
     return 1;
 }
@@ -797,11 +1009,13 @@ static int openses(const prcopt_t *popt, const solopt_t *sopt,
 /* close procssing session ---------------------------------------------------*/
 static void closeses(nav_t *nav, pcvs_t *pcvs, pcvs_t *pcvr)
 {
+    int i;
+    
     trace(3,"closeses:\n");
     
     /* free antenna parameters */
-    free(pcvs->pcv); pcvs->pcv=NULL; pcvs->n=pcvs->nmax=0;
-    free(pcvr->pcv); pcvr->pcv=NULL; pcvr->n=pcvr->nmax=0;
+    freepcv(pcvs);
+    freepcv(pcvr);
     
     /* close geoid data */
     closegeoid();
@@ -809,6 +1023,16 @@ static void closeses(nav_t *nav, pcvs_t *pcvs, pcvs_t *pcvr)
     /* free erp data */
     free(nav->erp.data); nav->erp.data=NULL; nav->erp.n=nav->erp.nmax=0;
     
+    /* free tec grid data */
+    for (i=0;i<nav->nt;i++) {
+        free(nav->tec[i].data);
+        free(nav->tec[i].rms );
+    }
+    free(nav->tec ); nav->tec =NULL; nav->nt=nav->ntmax=0;
+
+#ifdef EXTSTEC
+    stec_free(nav);
+#endif
     /* close solution statistics and debug trace */
     rtkclosestat();
     traceclose();
@@ -843,7 +1067,7 @@ static void setpcv(gtime_t time, prcopt_t *popt, nav_t *nav, const pcvs_t *pcvs,
                 }
             }
             else { /* enu */
-                for (j=0;j<3;j++) popt->antdel[i][j]=stas[i].del[j];
+                for (j=0;j<3;j++) popt->antdel[i][j]=sta[i].del[j];
             }
         }
         if (!(pcv=searchpcv(0,popt->anttype[i],time,pcvr))) {
@@ -865,10 +1089,11 @@ static void readotl(prcopt_t *popt, const char *file, const sta_t *sta)
     }
 }
 /* write header to output file -----------------------------------------------*/
-static int outhead(const char *outfile, char **infile, int n,
+static int outhead(ses_t *ses, const char *outfile, char **infile, int n,
                    const prcopt_t *popt, const solopt_t *sopt)
 {
     FILE *fp=stdout;
+    gtime_t ts={0},te={0};
     
     trace(3,"outhead: outfile=%s n=%d\n",outfile,n);
     
@@ -881,7 +1106,8 @@ static int outhead(const char *outfile, char **infile, int n,
         }
     }
     /* output header */
-    outheader(fp,infile,n,popt,sopt);
+    if (sopt->outhead&&sopt->posf!=SOLF_NMEA) obsspan(ses,&ts,&te);
+    outheader(fp,infile,n,popt,sopt,ts,te);
     
     if (*outfile) fclose(fp);
     
@@ -894,10 +1120,29 @@ static FILE *openfile(const char *outfile)
     
     return !*outfile?stdout:fopen(outfile,"a");
 }
+/* test obs data input by streams --------------------------------------------*/
+static int streamobs(const prcopt_t *popt, char **infile, int n)
+{
+    int i;
+    
+    /* backward or combined solutions need all obs data */
+    if (popt->mode!=PMODE_SINGLE&&popt->soltype!=0) return 0;
+    
+    /* average of single position needs all obs data */
+    if (popt->mode==PMODE_FIXED&&popt->rovpos==1) return 0;
+    if (PMODE_DGPS<=popt->mode&&popt->mode<=PMODE_STATIC&&popt->refpos==1) {
+        return 0;
+    }
+    /* stdin can not be read twice for nav data and obs stream */
+    for (i=0;i<n;i++) if (!*infile[i]) return 0;
+    
+    return 1;
+}
 /* execute processing session ------------------------------------------------*/
-static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
-                   const solopt_t *sopt, const filopt_t *fopt, int flag,
-                   char **infile, const int *index, int n, char *outfile)
+static int execses(ses_t *ses, gtime_t ts, gtime_t te, double ti,
+                   const prcopt_t *popt, const solopt_t *sopt,
+                   const filopt_t *fopt, int flag, char **infile,
+                   const int *index, int n, char *outfile)
 {
     FILE *fp;
     prcopt_t popt_=*popt;
@@ -918,28 +1163,33 @@ static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
         traceopen(tracefile);
         tracelevel(sopt->trace);
     }
-    /* read obs and nav data */
-    if (!readobsnav(ts,te,ti,infile,index,n,&popt_,&obss,&navs,stas)) return 0;
+    /* input obs data by streams for forward-only processing */
+    ses->stream=streamobs(&popt_,infile,n);
     
+    /* read obs and nav data */
+    if (!readobsnav(ses,ts,te,ti,infile,index,n,&popt_,&ses->obs,&ses->nav,
+                    ses->sta)) {
+        freeobsnav(ses);
+        return 0;
+    }
     /* set antenna paramters */
     if (popt_.mode!=PMODE_SINGLE) {
-        setpcv(obss.n>0?obss.data[0].time:timeget(),&popt_,&navs,&pcvss,&pcvsr,
-               stas);
+        setpcv(firstobs(ses),&popt_,&ses->nav,&pcvss,&pcvsr,ses->sta);
     }
     /* read ocean tide loading parameters */
     if (popt_.mode>PMODE_SINGLE&&fopt->blq) {
-        readotl(&popt_,fopt->blq,stas);
+        readotl(&popt_,fopt->blq,ses->sta);
     }
     /* rover/reference fixed position */
     if (popt_.mode==PMODE_FIXED) {
-        if (!antpos(&popt_,1,&obss,&navs,stas,fopt->stapos)) {
-            freeobsnav(&obss,&navs);
+        if (!antpos(&popt_,1,&ses->obs,&ses->nav,ses->sta,fopt->stapos)) {
+            freeobsnav(ses);
             return 0;
         }
     }
     else if (PMODE_DGPS<=popt_.mode&&popt_.mode<=PMODE_STATIC) {
-        if (!antpos(&popt_,2,&obss,&navs,stas,fopt->stapos)) {
-            freeobsnav(&obss,&navs);
+        if (!antpos(&popt_,2,&ses->obs,&ses->nav,ses->sta,fopt->stapos)) {
+            freeobsnav(ses);
             return 0;
         }
     }
@@ -951,160 +1201,612 @@ static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
         rtkopenstat(statfile,sopt->sstat);
     }
     /* write header to output file */
-    if (flag&&!outhead(outfile,infile,n,&popt_,sopt)) {
-        freeobsnav(&obss,&navs);
+    if (flag&&!outhead(ses,outfile,infile,n,&popt_,sopt)) {
+        freeobsnav(ses);
         return 0;
     }
-    iobsu=iobsr=isbs=ilex=revs=aborts=0;
+    ses->iobsu=ses->iobsr=ses->isbs=ses->ilex=ses->revs=ses->aborts=0;
     
+    /* open pseudorange correction log of the session without warm-up */
+    if (pcorlogopen(&ses->pcorlog,ses->pcorpfx,PCORLOGBUFF,0)) {
+        ses->pcorlog.ts=ses->tout;
+        popt_.pcorlog=&ses->pcorlog;
+    }
     if (popt_.mode==PMODE_SINGLE||popt_.soltype==0) {
         if ((fp=openfile(outfile))) {
-            procpos(fp,&popt_,sopt,0); /* forward */
+            procpos(ses,fp,&popt_,sopt,0); /* forward */
             fclose(fp);
         }
     }
     else if (popt_.soltype==1) {
         if ((fp=openfile(outfile))) {
-            revs=1; iobsu=iobsr=obss.n-1; isbs=sbss.n-1; ilex=lexs.n-1;
-            procpos(fp,&popt_,sopt,0); /* backward */
+            ses->revs=1; ses->iobsu=ses->iobsr=ses->obs.n-1;
+            ses->isbs=ses->sbs->n-1; ses->ilex=ses->lex->n-1;
+            procpos(ses,fp,&popt_,sopt,0); /* backward */
             fclose(fp);
         }
     }
     else { /* combined */
-        solf=(sol_t *)malloc(sizeof(sol_t)*nepoch);
-        solb=(sol_t *)malloc(sizeof(sol_t)*nepoch);
-        rbf=(double *)malloc(sizeof(double)*nepoch*3);
-        rbb=(double *)malloc(sizeof(double)*nepoch*3);
+        ses->solf=(sol_t *)malloc(sizeof(sol_t)*ses->nepoch);
+        ses->solb=(sol_t *)malloc(sizeof(sol_t)*ses->nepoch);
+        ses->rbf=(double *)malloc(sizeof(double)*ses->nepoch*3);
+        ses->rbb=(double *)malloc(sizeof(double)*ses->nepoch*3);
         
-        if (solf&&solb) {
-            isolf=isolb=0;
-            procpos(NULL,&popt_,sopt,1); /* forward */
-            revs=1; iobsu=iobsr=obss.n-1; isbs=sbss.n-1; ilex=lexs.n-1;
-            procpos(NULL,&popt_,sopt,1); /* backward */
+        if (ses->solf&&ses->solb) {
+            ses->isolf=ses->isolb=0;
+            procpos(ses,NULL,&popt_,sopt,1); /* forward */
+            ses->revs=1; ses->iobsu=ses->iobsr=ses->obs.n-1;
+            ses->isbs=ses->sbs->n-1; ses->ilex=ses->lex->n-1;
+            procpos(ses,NULL,&popt_,sopt,1); /* backward */
             
             /* combine forward/backward solutions */
-            if (!aborts&&(fp=openfile(outfile))) {
-                combres(fp,&popt_,sopt);
+            if (!ses->aborts&&(fp=openfile(outfile))) {
+                combres(ses,fp,&popt_,sopt);
                 fclose(fp);
             }
         }
         else showmsg("error : memory allocation");
-        free(solf);
-        free(solb);
-        free(rbf);
-        free(rbb);
+        free(ses->solf);
+        free(ses->solb);
+        free(ses->rbf);
+        free(ses->rbb);
     }
+    pcorlogclose(&ses->pcorlog);
+    
     /* free obs and nav data */
-    freeobsnav(&obss,&navs);
+    freeobsnav(ses);
     
-    return aborts?1:0;
+    return ses->aborts?1:0;
 }
-/* execute processing session for each rover ---------------------------------*/
-static int execses_r(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
-                     const solopt_t *sopt, const filopt_t *fopt, int flag,
-                     char **infile, const int *index, int n, char *outfile,
-                     const char *rov)
+/* run processing session job ------------------------------------------------*/
+static int runses(const sespool_t *pool, sesjob_t *job)
 {
-    gtime_t t0={0};
-    int i,stat=0;
-    char *ifile[MAXINFILE],ofile[1024],*rov_,*p,*q,s[64]="";
+    ses_t *ses;
+    char s[64]="";
+    int stat;
+    
+    trace(3,"runses  : rov=%s base=%s ofile=%s\n",job->rov,job->base,job->ofile);
+    
+    if (!(ses=(ses_t *)calloc(1,sizeof(ses_t)))) {
+        showmsg("error : memory allocation");
+        return 0;
+    }
+    strcpy(ses->proc_rov ,job->rov );
+    strcpy(ses->proc_base,job->base);
+    
+    if (*job->rov||*job->base) {
+        if (pool->ts.time) time2str(pool->ts,s,0);
+        if (checkbrk(ses,"reading    : %s",s)) {
+            free(ses);
+            return 1;
+        }
+    }
+    /* share precise ephemeris/clock, sbas ephemeris, tec, erp and dcb */
+    ses->nav=*pool->nav;
+    ses->sbs=pool->sbs;
+    ses->lex=pool->lex;
+    ses->rtcm_file=pool->rtcm_file;
+    ses->tout=pool->tout;
+    ses->pcorpfx=*job->pfile?job->pfile:pool->pcorpfx;
     
-    trace(3,"execses_r: n=%d outfile=%s\n",n,outfile);
+    if (*ses->rtcm_file) init_rtcm(&ses->rtcm);
     
-    for (i=0;i<n;i++) if (strstr(infile[i],"%r")) break;
+    /* execute processing session */
+    stat=execses(ses,pool->ts,pool->te,pool->ti,pool->popt,pool->sopt,
+                 pool->fopt,pool->flag,job->ifile,pool->index,pool->n,
+                 job->ofile);
     
-    if (i<n) { /* include rover keywords */
-        if (!(rov_=(char *)malloc(strlen(rov)+1))) return 0;
-        strcpy(rov_,rov);
+    if (ses->fp_rtcm) fclose(ses->fp_rtcm);
+    if (*ses->rtcm_file) free_rtcm(&ses->rtcm);
+    free(ses);
+    
+    return stat;
+}
+/* processing session thread -------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI sesthread(void *arg)
+#else
+static void *sesthread(void *arg)
+#endif
+{
+    sespool_t *pool=(sespool_t *)arg;
+    int i;
+    
+    for (;;) {
+        lock(&pool->lock);
+        i=pool->stat==1?pool->njob:pool->next++;
+        unlock(&pool->lock);
         
-        for (i=0;i<n;i++) {
-            if (!(ifile[i]=(char *)malloc(1024))) {
-                free(rov_); for (;i>=0;i--) free(ifile[i]);
-                return 0;
-            }
+        if (i>=pool->njob) break;
+        
+        if (runses(pool,pool->job+i)==1) {
+            lock(&pool->lock);
+            pool->stat=1;
+            unlock(&pool->lock);
         }
-        for (p=rov_;;p=q+1) { /* for each rover */
-            if ((q=strchr(p,' '))) *q='\0';
-            
-            if (*p) {
-                strcpy(proc_rov,p);
-                if (ts.time) time2str(ts,s,0); else *s='\0';
-                if (checkbrk("reading    : %s",s)) {
-                    stat=1;
-                    break;
-                }
-                for (i=0;i<n;i++) reppath(infile[i],ifile[i],t0,p,"");
-                reppath(outfile,ofile,t0,p,"");
-                
-                /* execute processing session */
-                stat=execses(ts,te,ti,popt,sopt,fopt,flag,ifile,index,n,ofile);
-            }
-            if (stat==1||!q) break;
+    }
+    return 0;
+}
+/* add processing session job ------------------------------------------------*/
+static int addjob(sespool_t *pool, char **infile, const char *outfile,
+                  const char *rov, const char *base)
+{
+    gtime_t t0={0};
+    sesjob_t *job;
+    char *buff;
+    int i;
+    
+    if (pool->njob>=pool->njobmax) {
+        pool->njobmax=pool->njobmax<=0?16:pool->njobmax*2;
+        if (!(job=(sesjob_t *)realloc(pool->job,sizeof(sesjob_t)*pool->njobmax))) {
+            return 0;
         }
-        free(rov_); for (i=0;i<n;i++) free(ifile[i]);
+        pool->job=job;
     }
-    else {
-        /* execute processing session */
-        stat=execses(ts,te,ti,popt,sopt,fopt,flag,infile,index,n,outfile);
+    job=pool->job+pool->njob;
+    
+    if (!(job->ifile=(char **)malloc(sizeof(char *)*(pool->n>0?pool->n:1)))) {
+        return 0;
+    }
+    if (!(buff=(char *)malloc(1024*(pool->n>0?pool->n:1)))) {
+        free(job->ifile);
+        return 0;
+    }
+    for (i=0;i<pool->n;i++) {
+        job->ifile[i]=buff+i*1024;
+        reppath(infile[i],job->ifile[i],t0,rov,base);
+    }
+    if (pool->n<=0) job->ifile[0]=buff;
+    reppath(outfile,job->ofile,t0,rov,base);
+    strcpy(job->rov ,rov );
+    strcpy(job->base,base);
+    job->pfile[0]='\0';
+    pool->njob++;
+    return 1;
+}
+/* add processing session jobs for each rover --------------------------------*/
+static int addjobs_r(sespool_t *pool, char **infile, const char *outfile,
+                     const char *rov, const char *base)
+{
+    int i,stat=1;
+    char *rov_,*p,*q;
+    
+    for (i=0;i<pool->n;i++) if (strstr(infile[i],"%r")) break;
+    
+    if (i>=pool->n) { /* no rover keywords */
+        return addjob(pool,infile,outfile,"",base);
     }
+    if (!(rov_=(char *)malloc(strlen(rov)+1))) return 0;
+    strcpy(rov_,rov);
+    
+    for (p=rov_;;p=q+1) { /* for each rover */
+        if ((q=strchr(p,' '))) *q='\0';
+        
+        if (*p&&!(stat=addjob(pool,infile,outfile,p,base))) break;
+        if (!q) break;
+    }
+    free(rov_);
     return stat;
 }
-/* execute processing session for each base station --------------------------*/
-static int execses_b(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
-                     const solopt_t *sopt, const filopt_t *fopt, int flag,
-                     char **infile, const int *index, int n, char *outfile,
+/* add processing session jobs for each base station -------------------------*/
+static int addjobs_b(sespool_t *pool, char **infile, const char *outfile,
                      const char *rov, const char *base)
 {
-    gtime_t t0={0};
-    int i,stat=0;
-    char *ifile[MAXINFILE],ofile[1024],*base_,*p,*q,s[64];
+    int i,stat=1;
+    char *base_,*p,*q;
+    
+    for (i=0;i<pool->n;i++) if (strstr(infile[i],"%b")) break;
+    
+    if (i>=pool->n) { /* no base station keywords */
+        return addjobs_r(pool,infile,outfile,rov,"");
+    }
+    if (!(base_=(char *)malloc(strlen(base)+1))) return 0;
+    strcpy(base_,base);
+    
+    for (p=base_;;p=q+1) { /* for each base station */
+        if ((q=strchr(p,' '))) *q='\0';
+        
+        if (*p&&!(stat=addjobs_r(pool,infile,outfile,rov,p))) break;
+        if (!q) break;
+    }
+    free(base_);
+    return stat;
+}
+/* free processing session jobs ----------------------------------------------*/
+static void freejobs(sespool_t *pool)
+{
+    int i;
+    
+    for (i=0;i<pool->njob;i++) {
+        free(pool->job[i].ifile[0]);
+        free(pool->job[i].ifile);
+    }
+    free(pool->job); pool->job=NULL; pool->njob=pool->njobmax=0;
+}
+/* append file to output file ------------------------------------------------*/
+static int catfile(const char *file, const char *outfile, const char *mode,
+                   int head)
+{
+    FILE *ifp,*ofp;
+    char buff[4096];
+    size_t n;
+    int c,stat=1;
+    
+    trace(3,"catfile : file=%s outfile=%s head=%d\n",file,outfile,head);
+    
+    if (!(ifp=fopen(file,"rb"))) return 0;
+    
+    if (!(ofp=fopen(outfile,mode))) {
+        showmsg("error : open output file %s",outfile);
+        fclose(ifp);
+        return 0;
+    }
+    /* skip header line if output file is not empty */
+    fseek(ofp,0,SEEK_END);
+    if (head&&ftell(ofp)>0) {
+        while ((c=fgetc(ifp))!=EOF&&c!='\n') ;
+    }
+    while ((n=fread(buff,1,sizeof(buff),ifp))>0) {
+        if (fwrite(buff,1,n,ofp)<n) {
+            stat=0;
+            break;
+        }
+    }
+    fclose(ifp);
+    fclose(ofp);
+    return stat;
+}
+/* test sessions jobs executable in parallel ---------------------------------*/
+static int paraljobs(const sespool_t *pool)
+{
+    int i,j;
+    
+    /* debug trace and solution statistics are process-wide */
+    if (pool->sopt->trace>0||pool->sopt->sstat>0) {
+        trace(2,"sessions run serially with trace or solution status\n");
+        return 0;
+    }
+    /* each session should be output to a separate file */
+    for (i=0;i<pool->njob;i++) {
+        if (!*pool->job[i].ofile) break;
+        for (j=0;j<i;j++) {
+            if (!strcmp(pool->job[i].ofile,pool->job[j].ofile)) break;
+        }
+        if (j<i) break;
+    }
+    if (i<pool->njob) {
+        trace(2,"sessions run serially without separate output files\n");
+        return 0;
+    }
+    return 1;
+}
+/* stitch temporary pseudorange correction logs of sessions ------------------
+* append the logs of parallel sessions to the log of each day in job order.
+* the days are not known before processing if no time limits, so all days
+* of year are tried.
+*-----------------------------------------------------------------------------*/
+static void stitchjobs(const sespool_t *pool)
+{
+    char file[1024],ofile[1024];
+    int i,doy;
+    
+    trace(3,"stitchjobs: njob=%d\n",pool->njob);
+    
+    for (doy=1;doy<=366;doy++) {
+        sprintf(ofile,"%s%d.csv",pool->pcorpfx,doy);
+        for (i=0;i<pool->njob;i++) {
+            sprintf(file,"%s%d.csv",pool->job[i].pfile,doy);
+            if (catfile(file,ofile,"ab",1)) remove(file);
+        }
+    }
+}
+/* execute processing session jobs -------------------------------------------*/
+static int execjobs(sespool_t *pool)
+{
+    thread_t thread[MAXSESTHREAD];
+    int i,nthread=pool->popt->nthread;
+    
+    trace(3,"execjobs: njob=%d nthread=%d\n",pool->njob,nthread);
+    
+    if (nthread>pool->njob) nthread=pool->njob;
+    if (nthread>MAXSESTHREAD) nthread=MAXSESTHREAD;
+    if (nthread>1&&!paraljobs(pool)) nthread=1;
+    
+    pool->next=pool->stat=0;
+    
+    /* output pseudorange correction log of each session to temporary files */
+    for (i=0;nthread>1&&i<pool->njob;i++) {
+        if (snprintf(pool->job[i].pfile,sizeof(pool->job[i].pfile),"%s.ses%d.",
+                     pool->pcorpfx,i)>=(int)sizeof(pool->job[i].pfile)) {
+            trace(2,"sessions run serially with too long pcorlog prefix\n");
+            nthread=1;
+        }
+    }
+    if (nthread<=1) {
+        for (i=0;i<pool->njob;i++) pool->job[i].pfile[0]='\0';
+        for (i=0;i<pool->njob;i++) {
+            if ((pool->stat=runses(pool,pool->job+i))==1) break;
+        }
+        return pool->stat;
+    }
+    initlock(&pool->lock);
+    
+    /* at most nthread sessions are loaded at a time */
+    for (i=0;i<nthread;i++) {
+#ifdef WIN32
+        if (!(thread[i]=CreateThread(NULL,0,sesthread,pool,0,NULL))) break;
+#else
+        if (pthread_create(thread+i,NULL,sesthread,pool)) break;
+#endif
+    }
+    if ((nthread=i)<=0) sesthread(pool);
+    
+    for (i=0;i<nthread;i++) {
+#ifdef WIN32
+        WaitForSingleObject(thread[i],INFINITE);
+        CloseHandle(thread[i]);
+#else
+        pthread_join(thread[i],NULL);
+#endif
+    }
+    stitchjobs(pool);
+    return pool->stat;
+}
+/* execute processing session for each base station and rover ----------------*/
+static int execses_b(gtime_t ts, gtime_t te, double ti, gtime_t tout,
+                     const prcopt_t *popt, const solopt_t *sopt,
+                     const filopt_t *fopt, int flag, char **infile,
+                     const int *index, int n, char *outfile, const char *rov,
+                     const char *base, const char *pcorpfx)
+{
+    sespool_t pool={0};
+    nav_t *nav;
+    sbs_t sbs={0};
+    lex_t lex={0};
+    char rtcm_file[1024]="";
+    int stat=0;
     
     trace(3,"execses_b: n=%d outfile=%s\n",n,outfile);
     
+    if (!(nav=(nav_t *)malloc(sizeof(nav_t)))) {
+        showmsg("error : memory allocation");
+        return -1;
+    }
+    /* dcb, tec and erp are shared by processing units */
+    *nav=navs;
+    
     /* read prec ephemeris and sbas data */
-    readpreceph(infile,n,popt,&navs,&sbss,&lexs);
+    readpreceph(infile,n,popt,nav,&sbs,&lex,rtcm_file);
+    
+    pool.ts=ts; pool.te=te; pool.tout=tout; pool.ti=ti;
+    pool.popt=popt; pool.sopt=sopt; pool.fopt=fopt;
+    pool.flag=flag; pool.index=index; pool.n=n;
+    pool.nav=nav; pool.sbs=&sbs; pool.lex=&lex; pool.rtcm_file=rtcm_file;
+    pool.pcorpfx=pcorpfx;
+    
+    /* expand base station and rover keywords to sessions */
+    if (addjobs_b(&pool,infile,outfile,rov,base)) {
+        stat=execjobs(&pool);
+    }
+    freejobs(&pool);
+    
+    /* free prec ephemeris and sbas data */
+    freepreceph(nav,&sbs,&lex);
+    free(nav);
     
-    for (i=0;i<n;i++) if (strstr(infile[i],"%b")) break;
+    return stat;
+}
+/* add processing unit -------------------------------------------------------*/
+static int addunit(unitpool_t *pool, gtime_t ts, gtime_t te, gtime_t tout,
+                   int flag, char **infile, const int *index, int n,
+                   const char *outfile)
+{
+    unit_t *unit;
+    char *buff;
+    int i;
     
-    if (i<n) { /* include base station keywords */
-        if (!(base_=(char *)malloc(strlen(base)+1))) {
-            freepreceph(&navs,&sbss,&lexs);
+    if (pool->nunit>=pool->nunitmax) {
+        pool->nunitmax=pool->nunitmax<=0?16:pool->nunitmax*2;
+        if (!(unit=(unit_t *)realloc(pool->unit,sizeof(unit_t)*pool->nunitmax))) {
             return 0;
         }
-        strcpy(base_,base);
+        pool->unit=unit;
+    }
+    unit=pool->unit+pool->nunit;
+    
+    if (!(unit->ifile=(char **)malloc(sizeof(char *)*(n>0?n:1)))) {
+        return 0;
+    }
+    if (!(unit->index=(int *)malloc(sizeof(int)*(n>0?n:1)))) {
+        free(unit->ifile);
+        return 0;
+    }
+    if (!(buff=(char *)malloc(1024*(n>0?n:1)))) {
+        free(unit->ifile);
+        free(unit->index);
+        return 0;
+    }
+    for (i=0;i<n;i++) {
+        unit->ifile[i]=buff+i*1024;
+        strcpy(unit->ifile[i],infile[i]);
+        unit->index[i]=index[i];
+    }
+    if (n<=0) unit->ifile[0]=buff;
+    unit->ts=ts; unit->te=te; unit->tout=tout;
+    unit->flag=flag; unit->n=n; unit->stat=-1;
+    strcpy(unit->ofile,outfile);
+    unit->tfile[0]=unit->pfile[0]='\0';
+    pool->nunit++;
+    return 1;
+}
+/* free processing units -----------------------------------------------------*/
+static void freeunits(unitpool_t *pool)
+{
+    int i;
+    
+    for (i=0;i<pool->nunit;i++) {
+        free(pool->unit[i].ifile[0]);
+        free(pool->unit[i].ifile);
+        free(pool->unit[i].index);
+    }
+    free(pool->unit); pool->unit=NULL; pool->nunit=pool->nunitmax=0;
+}
+/* run processing unit -------------------------------------------------------*/
+static int rununit(const unitpool_t *pool, unit_t *unit)
+{
+    gtime_t ts=unit->tout.time?unit->tout:unit->ts;
+    
+    trace(3,"rununit : ts=%s ofile=%s\n",time_str(unit->ts,0),unit->ofile);
+    
+    if (checkbrk(NULL,"reading    : %s",time_str(ts,0))) return 1;
+    
+    /* execute processing session */
+    return execses_b(unit->ts,unit->te,pool->ti,unit->tout,&pool->popt,
+                     pool->sopt,pool->fopt,unit->flag,unit->ifile,unit->index,
+                     unit->n,*unit->tfile?unit->tfile:unit->ofile,pool->rov,
+                     pool->base,*unit->pfile?unit->pfile:PCORLOGPFX);
+}
+/* processing unit thread ----------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI unitthread(void *arg)
+#else
+static void *unitthread(void *arg)
+#endif
+{
+    unitpool_t *pool=(unitpool_t *)arg;
+    int i;
+    
+    for (;;) {
+        lock(&pool->lock);
+        i=pool->stat==1?pool->nunit:pool->next++;
+        unlock(&pool->lock);
         
-        for (i=0;i<n;i++) {
-            if (!(ifile[i]=(char *)malloc(1024))) {
-                free(base_); for (;i>=0;i--) free(ifile[i]);
-                freepreceph(&navs,&sbss,&lexs);
-                return 0;
-            }
+        if (i>=pool->nunit) break;
+        
+        if ((pool->unit[i].stat=rununit(pool,pool->unit+i))==1) {
+            lock(&pool->lock);
+            pool->stat=1;
+            unlock(&pool->lock);
         }
-        for (p=base_;;p=q+1) { /* for each base station */
-            if ((q=strchr(p,' '))) *q='\0';
-            
-            if (*p) {
-                strcpy(proc_base,p);
-                if (ts.time) time2str(ts,s,0); else *s='\0';
-                if (checkbrk("reading    : %s",s)) {
-                    stat=1;
-                    break;
-                }
-                for (i=0;i<n;i++) reppath(infile[i],ifile[i],t0,"",p);
-                reppath(outfile,ofile,t0,"",p);
-                
-                stat=execses_r(ts,te,ti,popt,sopt,fopt,flag,ifile,index,n,ofile,rov);
+    }
+    return 0;
+}
+/* stitch temporary output files of processing unit --------------------------*/
+static void stitchunit(const unitpool_t *pool, const unit_t *unit, int out)
+{
+    sespool_t tpool={0},opool={0};
+    gtime_t time;
+    char file[1024],ofile[1024];
+    int i,doy,prev=0;
+    
+    trace(3,"stitchunit: ofile=%s out=%d\n",unit->ofile,out);
+    
+    tpool.n=opool.n=unit->n;
+    
+    /* expand base station and rover keywords as the sessions of unit */
+    if (addjobs_b(&tpool,unit->ifile,unit->tfile,pool->rov,pool->base)&&
+        addjobs_b(&opool,unit->ifile,unit->ofile,pool->rov,pool->base)) {
+        
+        for (i=0;i<tpool.njob&&i<opool.njob;i++) {
+            if (out) {
+                catfile(tpool.job[i].ofile,opool.job[i].ofile,
+                        unit->flag?"wb":"ab",0);
             }
-            if (stat==1||!q) break;
+            remove(tpool.job[i].ofile);
         }
-        free(base_); for (i=0;i<n;i++) free(ifile[i]);
     }
-    else {
-        stat=execses_r(ts,te,ti,popt,sopt,fopt,flag,infile,index,n,outfile,rov);
+    freejobs(&tpool);
+    freejobs(&opool);
+    
+    /* pseudorange correction logs of the days of unit */
+    for (time=unit->ts;timediff(time,unit->te)<86400.0;
+         time=timeadd(time,86400.0)) {
+        doy=(int)time2doy(timediff(time,unit->te)>0.0?unit->te:time);
+        if (doy==prev) continue;
+        prev=doy;
+        sprintf(file ,"%s%d.csv",unit->pfile,doy);
+        sprintf(ofile,"%s%d.csv",PCORLOGPFX,doy);
+        if (out) catfile(file,ofile,"ab",1);
+        remove(file);
     }
-    /* free prec ephemeris and sbas data */
-    freepreceph(&navs,&sbss,&lexs);
+}
+/* test processing units executable in parallel ------------------------------*/
+static int paralunits(const unitpool_t *pool)
+{
+    /* debug trace and solution statistics are process-wide */
+    if (pool->sopt->trace>0||pool->sopt->sstat>0) {
+        trace(2,"units run serially with trace or solution status\n");
+        return 0;
+    }
+    /* stdout can not be stitched */
+    if (!*pool->unit[0].ofile) {
+        trace(2,"units run serially without output file\n");
+        return 0;
+    }
+    return 1;
+}
+/* execute processing units --------------------------------------------------*/
+static int execunits(unitpool_t *pool)
+{
+    thread_t thread[MAXSESTHREAD];
+    unit_t *unit;
+    int i,j,stat=0,nthread=pool->popt.nthread;
+    
+    trace(3,"execunits: nunit=%d nthread=%d\n",pool->nunit,nthread);
+    
+    if (nthread>pool->nunit) nthread=pool->nunit;
+    if (nthread>MAXSESTHREAD) nthread=MAXSESTHREAD;
+    if (nthread>1&&!paralunits(pool)) nthread=1;
+    
+    pool->next=pool->stat=0;
+    
+    /* output each unit to temporary files to be stitched */
+    for (i=0;nthread>1&&i<pool->nunit;i++) {
+        unit=pool->unit+i;
+        if (snprintf(unit->tfile,sizeof(unit->tfile),"%s.tu%d",unit->ofile,
+                     i)>=(int)sizeof(unit->tfile)) {
+            trace(2,"units run serially with too long output file path\n");
+            for (j=0;j<=i;j++) pool->unit[j].tfile[0]='\0';
+            nthread=1;
+            break;
+        }
+        sprintf(unit->pfile,"%s.tu%d.",PCORLOGPFX,i);
+    }
+    if (nthread<=1) {
+        for (i=0;i<pool->nunit;i++) pool->unit[i].pfile[0]='\0';
+        for (i=0;i<pool->nunit;i++) {
+            if ((stat=pool->unit[i].stat=rununit(pool,pool->unit+i))==1) break;
+        }
+        return stat;
+    }
+    /* sessions in each unit run serially and share reader threads */
+    rnxsetthread(pool->popt.nthread/nthread);
+    pool->popt.nthread=1;
+    
+    initlock(&pool->lock);
     
+    for (i=0;i<nthread;i++) {
+#ifdef WIN32
+        if (!(thread[i]=CreateThread(NULL,0,unitthread,pool,0,NULL))) break;
+#else
+        if (pthread_create(thread+i,NULL,unitthread,pool)) break;
+#endif
+    }
+    if ((nthread=i)<=0) unitthread(pool);
+    
+    for (i=0;i<nthread;i++) {
+#ifdef WIN32
+        WaitForSingleObject(thread[i],INFINITE);
+        CloseHandle(thread[i]);
+#else
+        pthread_join(thread[i],NULL);
+#endif
+    }
+    /* stitch outputs of units in time order until aborted */
+    for (i=0;i<pool->nunit;i++) {
+        if (pool->unit[i].stat==1) stat=1;
+        stitchunit(pool,pool->unit+i,!stat&&pool->unit[i].stat==0);
+    }
     return stat;
 }
 /* post-processing positioning -------------------------------------------------
@@ -1150,19 +1852,56 @@ static int execses_b(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
 *          are output to a single output file.
 *
 *          ssr corrections are valid only for forward estimation.
+*
+*          for forward-only processing (single or popt->soltype=0), the rover
+*          and base station obs data are input epoch by epoch from rinex obs
+*          streams (see open_rnxobs()) instead of loading all obs data, except
+*          for the station position by average of single position. the obs
+*          files of each receiver should be in time order.
+*
+*          if popt->nthread>1, the sessions expanded by rover and base station
+*          keywords are executed by a pool of popt->nthread threads sharing
+*          the precise ephemeris/clock, sbas and lex data. the observation data
+*          are loaded at most for popt->nthread sessions at a time. parallel
+*          execution requires a separate output file for each session (include
+*          %r or %b in the output file) and no debug trace or solution status.
+*          otherwise the sessions are executed serially.
+*
+*          if tu>0 and popt->nthread>1, the processing units are executed by
+*          a pool of popt->nthread threads instead. each unit is output to
+*          temporary files which are concatenated to the output files in time
+*          order after all units finished. if popt->tuwarm>0, the processing
+*          of each unit except for the first starts popt->tuwarm (s) earlier
+*          than the unit start time to converge the filter and the solutions
+*          and the pseudorange corrections in the warm-up period are not
+*          output. the pseudorange correction logs of units are also output to
+*          temporary files and concatenated to log<doy>.csv in time order.
+*
+*          if popt->nthread>1, the rinex obs data loaded by readrnxt() are also
+*          read by popt->nthread threads (see rnxsetthread()), which are
+*          divided among the units processed in parallel. if
+*          popt->rnxidx=1, epochs out of ts, te and ti are skipped by epoch
+*          index files of rinex obs files (see rnxsetindex()).
+*          if the profiler is enabled by profenable(), the profile report of
+*          positioning stages is output to stderr at the end of processing.
 *-----------------------------------------------------------------------------*/
 extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
                    const prcopt_t *popt, const solopt_t *sopt,
                    const filopt_t *fopt, char **infile, int n, char *outfile,
                    const char *rov, const char *base)
 {
-    gtime_t tts,tte,ttte;
+    gtime_t tts,tte,ttte,tout,t0={0};
+    unitpool_t upool={0};
     double tunit,tss;
     int i,j,k,nf,stat=0,week,flag=1,index[MAXINFILE]={0};
     char *ifile[MAXINFILE],ofile[1024],*ext;
     
     trace(3,"postpos : ti=%.0f tu=%.0f n=%d outfile=%s\n",ti,tu,n,outfile);
     
+    /* read rinex obs data by popt->nthread threads */
+    rnxsetthread(popt->nthread);
+    rnxsetindex(popt->rnxidx);
+    
     /* open processing session */
     if (!openses(popt,sopt,fopt,&navs,&pcvss,&pcvsr)) return -1;
     
@@ -1191,11 +1930,12 @@ extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
             if (timediff(tts,ts)<0.0) tts=ts;
             if (timediff(tte,te)>0.0) tte=te;
             
-            strcpy(proc_rov ,"");
-            strcpy(proc_base,"");
-            if (checkbrk("reading    : %s",time_str(tts,0))) {
-                stat=1;
-                break;
+            /* start earlier by warm-up overlap except for the first unit */
+            tout=t0;
+            if (i>0&&popt->tuwarm>0.0) {
+                tout=tts;
+                tts=timeadd(tts,-popt->tuwarm);
+                if (timediff(tts,ts)<0.0) tts=ts;
             }
             for (j=k=nf=0;j<n;j++) {
                 
@@ -1223,15 +1963,23 @@ extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
                     break;
                 }
             }
-            if (!reppath(outfile,ofile,tts,"","")&&i>0) flag=0;
+            if (!reppath(outfile,ofile,tout.time?tout:tts,"","")&&i>0) flag=0;
             
-            /* execute processing session */
-            stat=execses_b(tts,tte,ti,popt,sopt,fopt,flag,ifile,index,nf,ofile,
-                           rov,base);
-            
-            if (stat==1) break;
+            if (!addunit(&upool,tts,tte,tout,flag,ifile,index,nf,ofile)) {
+                showmsg("error : memory allocation");
+                stat=-1;
+                break;
+            }
         }
         for (i=0;i<MAXINFILE;i++) free(ifile[i]);
+        
+        /* execute processing units */
+        if (!stat) {
+            upool.ts=ts; upool.te=te; upool.ti=ti; upool.popt=*popt;
+            upool.sopt=sopt; upool.fopt=fopt; upool.rov=rov; upool.base=base;
+            stat=execunits(&upool);
+        }
+        freeunits(&upool);
     }
     else if (ts.time!=0) {
         for (i=0;i<n&&i<MAXINFILE;i++) {
@@ -1245,8 +1993,8 @@ extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
         reppath(outfile,ofile,ts,"","");
         
         /* execute processing session */
-        stat=execses_b(ts,te,ti,popt,sopt,fopt,1,ifile,index,n,ofile,rov,
-                       base);
+        stat=execses_b(ts,te,ti,t0,popt,sopt,fopt,1,ifile,index,n,ofile,rov,
+                       base,PCORLOGPFX);
         
         for (i=0;i<n&&i<MAXINFILE;i++) free(ifile[i]);
     }
@@ -1254,11 +2002,383 @@ extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
         for (i=0;i<n;i++) index[i]=i;
         
         /* execute processing session */
-        stat=execses_b(ts,te,ti,popt,sopt,fopt,1,infile,index,n,outfile,rov,
-                       base);
+        stat=execses_b(ts,te,ti,t0,popt,sopt,fopt,1,infile,index,n,outfile,
+                       rov,base,PCORLOGPFX);
     }
+    /* output profile report of positioning stages */
+    profreport(stderr);
+    
     /* close processing session */
     closeses(&navs,&pcvss,&pcvsr);
     
     return stat;
 }
+/* first pseudorange of obs data -------------------------------------------*/
+static double firstpr(const obsd_t *obs)
+{
+    int i;
+    
+    for (i=0;i<NFREQ;i++) if (obs->P[i]!=0.0) return obs->P[i];
+    return 0.0;
+}
+/* read batch station list ---------------------------------------------------*/
+static int readpcorsta(const char *file, pcorsta_t *sta, int nmax)
+{
+    FILE *fp;
+    char buff[4096],*p;
+    int n=0;
+    
+    trace(3,"readpcorsta: file=%s\n",file);
+    
+    if (!(fp=fopen(file,"r"))) {
+        showmsg("error : station list open %s",file);
+        trace(1,"station list open error: %s\n",file);
+        return 0;
+    }
+    while (n<nmax&&fgets(buff,sizeof(buff),fp)) {
+        if ((p=strchr(buff,'#'))) *p='\0';
+        
+        /* name x y z obsfile [obsfile ...] */
+        if (!(p=strtok(buff," \t\r\n"))) continue;
+        memset(sta+n,0,sizeof(pcorsta_t));
+        strncpy(sta[n].name,p,sizeof(sta[n].name)-1);
+        
+        if (!(p=strtok(NULL," \t\r\n"))||sscanf(p,"%lf",sta[n].rr  )<1||
+            !(p=strtok(NULL," \t\r\n"))||sscanf(p,"%lf",sta[n].rr+1)<1||
+            !(p=strtok(NULL," \t\r\n"))||sscanf(p,"%lf",sta[n].rr+2)<1) {
+            trace(2,"invalid station position: %s\n",sta[n].name);
+            continue;
+        }
+        while (sta[n].nfile<MAXSTAFILE&&(p=strtok(NULL," \t\r\n"))) {
+            if (!(sta[n].files[sta[n].nfile]=(char *)malloc(strlen(p)+1))) {
+                break;
+            }
+            strcpy(sta[n].files[sta[n].nfile++],p);
+        }
+        if (sta[n].nfile<=0) {
+            trace(2,"no obs file of station: %s\n",sta[n].name);
+            continue;
+        }
+        n++;
+    }
+    fclose(fp);
+    return n;
+}
+/* free batch stations -------------------------------------------------------*/
+static void freepcorsta(pcorsta_t *sta, int n)
+{
+    int i,j;
+    
+    for (i=0;i<n;i++) {
+        close_rnxobs(&sta[i].rnx);
+        pcorlogclose(&sta[i].log);
+        for (j=0;j<sta[i].nfile;j++) free(sta[i].files[j]);
+        free(sta[i].data);
+    }
+}
+/* add obs data of station epoch to block ------------------------------------*/
+static int addpcorobs(pcorsta_t *sta, int iep, const prcopt_t *popt)
+{
+    const obsd_t *obs=sta->rnx.data[0];
+    obsd_t *data;
+    int i,n=sta->rnx.n[0];
+    
+    if (sta->nobs+n>sta->nmax) {
+        sta->nmax=sta->nmax<=0?MAXOBS*NPCOREPOCH/4:sta->nmax*2;
+        if (sta->nmax<sta->nobs+n) sta->nmax=sta->nobs+n;
+        if (!(data=(obsd_t *)realloc(sta->data,sizeof(obsd_t)*sta->nmax))) {
+            return 0;
+        }
+        sta->data=data;
+    }
+    /* exclude satellites */
+    for (i=n=0;i<sta->rnx.n[0];i++) {
+        if ((satsys(obs[i].sat,NULL)&popt->navsys)&&
+            popt->exsats[obs[i].sat-1]!=1) sta->data[sta->nobs+n++]=obs[i];
+    }
+    sta->index[iep]=sta->nobs;
+    sta->nsat[iep]=n;
+    sta->nobs+=n;
+    return 1;
+}
+/* input block of obs data merged by epoch -----------------------------------*/
+static int inputpcorblk(pcorpool_t *pool)
+{
+    pcorsta_t *sta;
+    gtime_t time;
+    int i,nep,mem=1;
+    
+    for (i=0;i<pool->nsta;i++) pool->sta[i].nobs=0;
+    
+    for (nep=0;nep<NPCOREPOCH&&mem;nep++) {
+        
+        /* earliest epoch of stations */
+        for (i=0,time.time=0;i<pool->nsta;i++) {
+            sta=pool->sta+i;
+            if (sta->rnx.n[0]<=0) continue;
+            if (!time.time||timediff(sta->rnx.data[0][0].time,time)<0.0) {
+                time=sta->rnx.data[0][0].time;
+            }
+        }
+        if (!time.time) break;
+        pool->time[nep]=time;
+        
+        for (i=0;i<pool->nsta;i++) {
+            sta=pool->sta+i;
+            sta->nsat[nep]=0;
+            if (sta->rnx.n[0]<=0||
+                fabs(timediff(sta->rnx.data[0][0].time,time))>DTTOL) continue;
+            
+            if (!(mem=addpcorobs(sta,nep,&pool->opt))) break;
+            input_rnxobs(&sta->rnx);
+        }
+    }
+    if (!mem) {
+        showmsg("error : memory allocation");
+        trace(1,"inputpcorblk: memory allocation error\n");
+        return -1;
+    }
+    return pool->nep=nep;
+}
+/* shared satellite positions of block epoch ---------------------------------*/
+static void pcorsats(pcorpool_t *pool, int iep)
+{
+    const pcorsta_t *sta;
+    const obsd_t *obs;
+    pcorsat_t *sat=pool->sat+iep*MAXSAT;
+    double pr;
+    int i,j;
+    
+    for (i=0;i<MAXSAT;i++) sat[i].stat=0;
+    
+    /* satellite position at transmission time of the first station */
+    for (i=0;i<pool->nsta;i++) {
+        sta=pool->sta+i;
+        for (j=0;j<sta->nsat[iep];j++) {
+            obs=sta->data+sta->index[iep]+j;
+            if (sat[obs->sat-1].stat||(pr=firstpr(obs))==0.0) continue;
+            
+            satposs(pool->time[iep],obs,1,pool->nav,pool->opt.sateph,
+                    sat[obs->sat-1].rs,sat[obs->sat-1].dts,
+                    &sat[obs->sat-1].var,&sat[obs->sat-1].svh);
+            sat[obs->sat-1].tr=timediff(obs->time,pool->time[iep])-pr/CLIGHT;
+            sat[obs->sat-1].stat=1;
+        }
+    }
+}
+/* pseudorange corrections of station block ----------------------------------*/
+static void pcorstas(pcorpool_t *pool, int ista)
+{
+    pcorsta_t *sta=pool->sta+ista;
+    const pcorsat_t *sat;
+    const obsd_t *obs;
+    double rs[6*MAXOBS],dts[2*MAXOBS],var[MAXOBS],pr,dt;
+    int i,j,k,n,svh[MAXOBS];
+    
+    for (i=0;i<pool->nep;i++) {
+        if ((n=sta->nsat[i])<=0) continue;
+        obs=sta->data+sta->index[i];
+        
+        for (j=0;j<n;j++) {
+            sat=pool->sat+i*MAXSAT+obs[j].sat-1;
+            
+            if ((pr=firstpr(obs+j))==0.0||!sat->stat) {
+                for (k=0;k<6;k++) rs [k+j*6]=0.0;
+                for (k=0;k<2;k++) dts[k+j*2]=0.0;
+                var[j]=0.0; svh[j]=0;
+                continue;
+            }
+            dt=timediff(obs[j].time,pool->time[i])-pr/CLIGHT-sat->tr;
+            
+            /* compute satellite position if far from shared one */
+            if (fabs(dt)>MAXDTPCOR) {
+                satposs(pool->time[i],obs+j,1,pool->nav,pool->opt.sateph,
+                        rs+j*6,dts+j*2,var+j,svh+j);
+                continue;
+            }
+            /* shift shared satellite position by velocity and clock drift */
+            for (k=0;k<3;k++) {
+                rs[k+j*6]=sat->rs[k]+sat->rs[k+3]*dt;
+                rs[k+3+j*6]=sat->rs[k+3];
+            }
+            dts[j*2]=sat->dts[0]+sat->dts[1]*dt;
+            dts[1+j*2]=sat->dts[1];
+            var[j]=sat->var;
+            svh[j]=sat->svh;
+        }
+        pntpcor(obs,n,rs,dts,var,svh,pool->nav,&pool->opt,sta->rr,&sta->log);
+    }
+}
+/* pseudorange correction batch thread ---------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI pcorthread(void *arg)
+#else
+static void *pcorthread(void *arg)
+#endif
+{
+    pcorpool_t *pool=(pcorpool_t *)arg;
+    int i,n=pool->phase?pool->nsta:pool->nep;
+    
+    for (;;) {
+        lock(&pool->lock);
+        i=pool->next++;
+        unlock(&pool->lock);
+        
+        if (i>=n) break;
+        
+        if (pool->phase) pcorstas(pool,i); else pcorsats(pool,i);
+    }
+    return 0;
+}
+/* execute phase of pseudorange correction batch by threads ------------------*/
+static void execpcor(pcorpool_t *pool, int phase, int nthread)
+{
+    thread_t thread[MAXSESTHREAD];
+    int i;
+    
+    pool->phase=phase;
+    pool->next=0;
+    
+    for (i=0;i<nthread-1;i++) {
+#ifdef WIN32
+        if (!(thread[i]=CreateThread(NULL,0,pcorthread,pool,0,NULL))) break;
+#else
+        if (pthread_create(thread+i,NULL,pcorthread,pool)) break;
+#endif
+    }
+    nthread=i;
+    pcorthread(pool);
+    
+    for (i=0;i<nthread;i++) {
+#ifdef WIN32
+        WaitForSingleObject(thread[i],INFINITE);
+        CloseHandle(thread[i]);
+#else
+        pthread_join(thread[i],NULL);
+#endif
+    }
+}
+/* batch pseudorange correction extraction -------------------------------------
+* extract pseudorange corrections of multiple stations with true receiver
+* positions against navigation data loaded once
+* args   : gtime_t ts       I   processing start time (ts.time==0: no limit)
+*        : gtime_t te       I   processing end time   (te.time==0: no limit)
+*          double ti        I   processing interval  (s) (0:all)
+*          prcopt_t *popt   I   processing options
+*          solopt_t *sopt   I   solution options
+*          filopt_t *fopt   I   file options
+*          char   **infile  I   input files (nav, precise ephemeris and clock)
+*          int    n         I   number of input files
+*          char   *stafile  I   station list file
+*          char   *outdir   I   output path prefix of logs ("":current dir)
+* return : status (0:ok,0>:error)
+* notes  : a line of the station list is as follows ('#': comment):
+*              name x y z obsfile [obsfile ...]
+*          where x y z are the true receiver position (ecef) (m). the obs files
+*          of a station are input by rinex obs streams in time order and can
+*          include wild-cards (*).
+*
+*          the pseudorange corrections of a station are output to the log
+*          files <outdir><name>_log<doy>.csv with the same format as pntpos().
+*
+*          the obs data of stations are merged by epochs in blocks of
+*          NPCOREPOCH epochs. the position of a satellite is computed once
+*          per epoch at the transmission time of the first station observing
+*          it and shifted to the transmission times of the others by the
+*          velocity and clock drift. the shared satellite positions and the
+*          stations are processed by popt->nthread threads.
+*-----------------------------------------------------------------------------*/
+extern int postpcor(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
+                    const solopt_t *sopt, const filopt_t *fopt, char **infile,
+                    int n, const char *stafile, const char *outdir)
+{
+    pcorpool_t pool={0};
+    nav_t nav={0};
+    sbs_t sbs={0};
+    lex_t lex={0};
+    char rtcm_file[1024]="",prefix[1024];
+    int i,nep=0,nthread,stat=0;
+    
+    trace(3,"postpcor: n=%d stafile=%s\n",n,stafile);
+    
+    if (!openses(popt,sopt,fopt,&navs,&pcvss,&pcvsr)) return -1;
+    
+    if (sopt->trace>0) {
+        traceopen(fopt->trace);
+        tracelevel(sopt->trace);
+    }
+    if (!(pool.sta=(pcorsta_t *)malloc(sizeof(pcorsta_t)*MAXPCORSTA))||
+        !(pool.sat=(pcorsat_t *)malloc(sizeof(pcorsat_t)*MAXSAT*NPCOREPOCH))) {
+        showmsg("error : memory allocation");
+        free(pool.sta);
+        closeses(&navs,&pcvss,&pcvsr);
+        return -1;
+    }
+    /* dcb, tec and erp are shared by stations */
+    nav=navs;
+    nav.eph =NULL; nav.n =nav.nmax =0;
+    nav.geph=NULL; nav.ng=nav.ngmax=0;
+    
+    /* read precise ephemeris and nav data once for all stations */
+    readpreceph(infile,n,popt,&nav,&sbs,&lex,rtcm_file);
+    free(nav.seph); nav.seph=NULL; nav.ns=nav.nsmax=0;
+    
+    for (i=0;i<n;i++) {
+        if (readrnxt(infile[i],0,ts,te,ti,"",NULL,&nav,NULL)<0) {
+            showmsg("error : insufficient memory");
+            stat=-1;
+        }
+    }
+    if (!stat&&nav.n<=0&&nav.ng<=0&&nav.ne<=0) {
+        showmsg("error : no nav data");
+        stat=-1;
+    }
+    uniqnav(&nav);
+    
+    /* open obs streams and logs of stations */
+    if (!stat&&(pool.nsta=readpcorsta(stafile,pool.sta,MAXPCORSTA))<=0) {
+        showmsg("error : no station in %s",stafile);
+        stat=-1;
+    }
+    for (i=0;i<pool.nsta&&!stat;i++) {
+        if (open_rnxobs(&pool.sta[i].rnx,pool.sta[i].files,pool.sta[i].nfile,
+                        1,ts,te,ti,popt->rnxopt[0])<0) {
+            showmsg("error : insufficient memory");
+            stat=-1;
+            break;
+        }
+        sprintf(prefix,"%.900s%.64s_log",outdir,pool.sta[i].name);
+        
+        if (!pcorlogopen(&pool.sta[i].log,prefix,PCORLOGBUFF,0)) stat=-1;
+    }
+    pool.opt=*popt;
+    pool.nav=&nav;
+    if (pool.opt.mode!=PMODE_SINGLE) {
+        pool.opt.ionoopt=IONOOPT_BRDC;
+        pool.opt.tropopt=TROPOPT_SAAS;
+    }
+    nthread=popt->nthread<MAXSESTHREAD?popt->nthread:MAXSESTHREAD;
+    initlock(&pool.lock);
+    
+    while (!stat&&(nep=inputpcorblk(&pool))>0) {
+        
+        if (showmsg("processing : %s",time_str(pool.time[0],0))) {
+            stat=1;
+            break;
+        }
+        execpcor(&pool,0,nthread<nep?nthread:nep); /* shared sat positions */
+        execpcor(&pool,1,nthread<pool.nsta?nthread:pool.nsta); /* stations */
+    }
+    if (nep<0) stat=-1;
+    
+    freepcorsta(pool.sta,pool.nsta);
+    free(pool.sta);
+    free(pool.sat);
+    free(nav.eph);
+    free(nav.geph);
+    freepreceph(&nav,&sbs,&lex);
+    
+    closeses(&navs,&pcvss,&pcvsr);
+    
+    return stat;
+}
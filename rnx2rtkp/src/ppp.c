@@ -63,6 +63,7 @@ static const char rcsid[]="$Id:$";
 #define ERR_BRDCI   0.5             /* broadcast iono model error factor */
 #define ERR_CBIAS   0.3             /* code bias error std (m) */
 #define REL_HUMI    0.7             /* relative humidity for saastamoinen model */
+#define MAXHNZ      8               /* max non-zero elements of h row */
 
 #define NP(opt)     ((opt)->dynamics?9:3) /* number of pos solution */
 #define IC(s,opt)   (NP(opt)+(s))      /* state index of clocks (s=0:gps,1:glo) */
@@ -879,15 +880,18 @@ static double prectrop(gtime_t time, const double *pos, const double *azel,
 static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
                    const double *dts, const double *vare, const int *svh,
                    const nav_t *nav, const double *x, rtk_t *rtk, double *v,
-                   double *H, double *R, double *azel)
+                   double *H, int *Hi, double *Hv, double *R, double *azel)
 {
     prcopt_t *opt=&rtk->opt;
     double r,rr[3],disp[3],pos[3],e[3],meas[2],dtdx[3],dantr[NFREQ]={0};
     double dants[NFREQ]={0},var[MAXOBS*2],dtrp=0.0,vart=0.0,varm[2]={0};
-    int i,j,k,sat,sys,nv=0,nx=rtk->nx,brk,tideopt;
+    double val[MAXHNZ];
+    int i,j,k,sat,sys,nv=0,nx=rtk->nx,brk,tideopt,idx[MAXHNZ],nh;
     
     trace(3,"res_ppp : n=%d nx=%d\n",n,nx);
     
+    PROFBEG(PROF_RESPPP);
+    
     for (i=0;i<MAXSAT;i++) rtk->ssat[i].vsat[0]=0;
     
     for (i=0;i<3;i++) rr[i]=x[i];
@@ -954,28 +958,38 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
             
             if (meas[j]==0.0) continue;
             
-            for (k=0;k<nx;k++) H[k+nx*nv]=0.0;
-            
             v[nv]=meas[j]-r;
             
-            for (k=0;k<3;k++) H[k+nx*nv]=-e[k];
+            for (k=0;k<3;k++) {idx[k]=k; val[k]=-e[k];}
+            nh=3;
             
             if (sys!=SYS_GLO) {
                 v[nv]-=x[IC(0,opt)];
-                H[IC(0,opt)+nx*nv]=1.0;
+                idx[nh]=IC(0,opt); val[nh++]=1.0;
             }
             else {
                 v[nv]-=x[IC(1,opt)];
-                H[IC(1,opt)+nx*nv]=1.0;
+                idx[nh]=IC(1,opt); val[nh++]=1.0;
             }
             if (opt->tropopt>=TROPOPT_EST) {
                 for (k=0;k<(opt->tropopt>=TROPOPT_ESTG?3:1);k++) {
-                    H[IT(opt)+k+nx*nv]=dtdx[k];
+                    idx[nh]=IT(opt)+k; val[nh++]=dtdx[k];
                 }
             }
             if (j==0) {
                 v[nv]-=x[IB(obs[i].sat,opt)];
-                H[IB(obs[i].sat,opt)+nx*nv]=1.0;
+                idx[nh]=IB(obs[i].sat,opt); val[nh++]=1.0;
+            }
+            /* design matrix row (sparse: state indices and values) */
+            if (Hi) {
+                for (k=0;k<MAXHNZ;k++) {
+                    Hi[k+MAXHNZ*nv]=k<nh?idx[k]:-1;
+                    Hv[k+MAXHNZ*nv]=k<nh?val[k]:0.0;
+                }
+            }
+            else {
+                for (k=0;k<nx;k++) H[k+nx*nv]=0.0;
+                for (k=0;k<nh;k++) H[idx[k]+nx*nv]=val[k];
             }
             var[nv]=varerr(obs[i].sat,sys,azel[1+i*2],j,opt)+varm[j]+vare[i]+vart;
             
@@ -1002,8 +1016,12 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
     }
     trace(5,"x=\n"); tracemat(5,x, 1,nx,8,3);
     trace(5,"v=\n"); tracemat(5,v, 1,nv,8,3);
-    trace(5,"H=\n"); tracemat(5,H,nx,nv,8,3);
+    if (H) {
+        trace(5,"H=\n"); tracemat(5,H,nx,nv,8,3);
+    }
     trace(5,"R=\n"); tracemat(5,R,nv,nv,8,5);
+    
+    PROFEND(PROF_RESPPP);
     return nv;
 }
 /* number of estimated states ------------------------------------------------*/
@@ -1015,11 +1033,13 @@ extern int pppnx(const prcopt_t *opt)
 extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
 {
     const prcopt_t *opt=&rtk->opt;
-    double *rs,*dts,*var,*v,*H,*R,*azel,*xp,*Pp;
-    int i,nv,info,svh[MAXOBS],stat=SOLQ_SINGLE;
+    double *rs,*dts,*var,*v,*H=NULL,*Hv=NULL,*R,*azel,*xp,*Pp;
+    int i,nv,info,svh[MAXOBS],stat=SOLQ_SINGLE,*Hi=NULL;
     
     trace(3,"pppos   : nx=%d n=%d\n",rtk->nx,n);
     
+    PROFBEG(PROF_PPPOS);
+    
     rs=mat(6,n); dts=mat(2,n); var=mat(1,n); azel=zeros(2,n);
     
     for (i=0;i<MAXSAT;i++) rtk->ssat[i].fix[0]=0;
@@ -1038,17 +1058,26 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     }
     xp=mat(rtk->nx,1); Pp=zeros(rtk->nx,rtk->nx);
     matcpy(xp,rtk->x,rtk->nx,1);
-    nv=n*rtk->opt.nf*2; v=mat(nv,1); H=mat(rtk->nx,nv); R=mat(nv,nv);
+    nv=n*rtk->opt.nf*2; v=mat(nv,1); R=mat(nv,nv);
+    
+    if (opt->sparseh) { /* sparse design matrix */
+        Hi=imat(MAXHNZ,nv); Hv=mat(MAXHNZ,nv);
+    }
+    else H=mat(rtk->nx,nv);
     
     for (i=0;i<rtk->opt.niter;i++) {
         
         /* phase and code residuals */
-        if ((nv=res_ppp(i,obs,n,rs,dts,var,svh,nav,xp,rtk,v,H,R,azel))<=0) break;
+        if ((nv=res_ppp(i,obs,n,rs,dts,var,svh,nav,xp,rtk,v,H,Hi,Hv,R,
+                        azel))<=0) break;
         
         /* measurement update */
         matcpy(Pp,rtk->P,rtk->nx,rtk->nx);
         
-        if ((info=filter(xp,Pp,H,v,R,rtk->nx,nv))) {
+        if (Hi) info=filtersp(xp,Pp,Hi,Hv,MAXHNZ,v,R,rtk->nx,nv);
+        else    info=filter(xp,Pp,H,v,R,rtk->nx,nv);
+        
+        if (info) {
             trace(2,"ppp filter error %s info=%d\n",time_str(rtk->sol.time,0),
                   info);
             break;
@@ -1059,7 +1088,7 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     }
     if (stat==SOLQ_PPP) {
         /* postfit residuals */
-        res_ppp(1,obs,n,rs,dts,var,svh,nav,xp,rtk,v,H,R,azel);
+        res_ppp(1,obs,n,rs,dts,var,svh,nav,xp,rtk,v,H,Hi,Hv,R,azel);
         
         /* update state and covariance matrix */
         matcpy(rtk->x,xp,rtk->nx,1);
@@ -1097,5 +1126,7 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
         }
     }
     free(rs); free(dts); free(var); free(azel);
-    free(xp); free(Pp); free(v); free(H); free(R);
+    free(xp); free(Pp); free(v); free(H); free(Hi); free(Hv); free(R);
+    
+    PROFEND(PROF_PPPOS);
 }
@@ -82,6 +82,7 @@
 *           2014/10/20 1.23 recognize "C2" in 2.12 as "C2W" instead of "C2D"
 *           2014/12/07 1.24 add read rinex option -SYS=...
 *-----------------------------------------------------------------------------*/
+#include <sys/stat.h>
 #include "rtklib.h"
 
 static const char rcsid[]="$Id:$";
@@ -96,6 +97,12 @@ static const char rcsid[]="$Id:$";
 #define MINFREQ_GLO -7                  /* min frequency number glonass */
 #define MAXFREQ_GLO 13                  /* max frequency number glonass */
 #define NINCOBS     262144              /* inclimental number of obs data */
+#define RNXBUFSIZ   1048576             /* rinex file stream buffer size */
+#define RNXCHUNK    262144              /* min size of obs body chunk (bytes) */
+#define MAXRNXTHREAD 32                 /* max number of threads to read obs */
+#define RNXIDXEXT   ".idx"              /* extension of obs epoch index file */
+#define RNXIDXVER   1                   /* version of obs epoch index file */
+#define RNXIDX_SLIP 0x100               /* epoch index flag: lli cycle-slip */
 
 static const int navsys[]={             /* satellite systems */
     SYS_GPS,SYS_GLO,SYS_GAL,SYS_QZS,SYS_SBS,SYS_CMP,0
@@ -121,6 +128,58 @@ typedef struct {                        /* signal index type */
     double shift[MAXOBSTYPE];           /* phase shift (cycle) */
 } sigind_t;
 
+typedef struct {                        /* rinex obs epoch index type */
+    gtime_t time;                       /* epoch time (time system of file) */
+    long pos;                           /* file position of epoch record */
+    int flag;                           /* epoch flag (|RNXIDX_SLIP:slip) */
+} rnxidx_t;
+
+typedef struct {                        /* rinex obs epoch index file header */
+    char id[16];                        /* id ("RINEX OBS INDEX") */
+    int ver;                            /* version (RNXIDXVER) */
+    int size;                           /* size of an index record (bytes) */
+    long fsize;                         /* size of indexed rinex file (bytes) */
+    long mtime;                         /* modified time of rinex file */
+    long pos;                           /* file position of obs body */
+    int n;                              /* number of index records */
+} rnxidxh_t;
+
+typedef struct {                        /* rinex obs body type */
+    char path[1024];                    /* file path */
+    long pos;                           /* file position of body (-1:none) */
+    long *bound;                        /* chunk boundaries (epoch positions) */
+    int nbound;                         /* number of chunk boundaries */
+    gtime_t ts,te;                      /* observation time start/end */
+    double tint;                        /* observation time interval (s) */
+    const char *opt;                    /* rinex options */
+    int rcv;                            /* receiver number */
+    double ver;                         /* rinex version */
+    int tsys;                           /* time system */
+    char tobs[NUMSYS][MAXOBSTYPE][4];   /* rinex obs types */
+    rnxidx_t *idx;                      /* epoch index (NULL:none) */
+    int nidx;                           /* number of epoch index */
+    int stat;                           /* status */
+} obsbody_t;
+
+typedef struct {                        /* rinex obs body chunk type */
+    const obsbody_t *body;              /* obs body */
+    long pos,end;                       /* file position start/end (-1:eof) */
+    obs_t obs;                          /* obs data of chunk */
+    unsigned char slips[MAXSAT][NFREQ]; /* cycle-slips pending at chunk end */
+    int stat;                           /* status */
+} obschunk_t;
+
+typedef struct {                        /* rinex read job pool type */
+    void (*func)(void *);               /* job function */
+    char *job;                          /* jobs */
+    size_t size;                        /* size of a job (bytes) */
+    int n,next;                         /* number of jobs and next job */
+    lock_t lock;                        /* lock flag */
+} rnxpool_t;
+
+static int rnxnthread=1;                /* number of threads to read obs */
+static int rnxidxena=0;                 /* obs epoch index (0:off,1:on) */
+
 /* set string without tail space ---------------------------------------------*/
 static void setstr(char *dst, const char *src, int n)
 {
@@ -628,24 +687,116 @@ static int readrnxh(FILE *fp, double *ver, char *type, int *sys, int *tsys,
     }
     return 0;
 }
+#ifndef RNXSCANF
+/* decode number in field without copy ---------------------------------------*/
+static const char *decval(const char *p, const char *e, double *val)
+{
+    static const double pow10[]={
+        1E0,1E1,1E2,1E3,1E4,1E5,1E6,1E7,1E8,1E9,1E10,1E11,1E12,1E13,1E14,1E15
+    };
+    double v=0.0;
+    int sign=0,nd=0,nf=0;
+    
+    if (p<e&&(*p=='-'||*p=='+')) sign=*p++=='-';
+    for (;p<e&&'0'<=*p&&*p<='9';p++,nd++) v=v*10.0+(*p-'0');
+    if (p<e&&*p=='.') {
+        for (p++;p<e&&'0'<=*p&&*p<='9';p++,nd++,nf++) v=v*10.0+(*p-'0');
+    }
+    /* exponent, hex or too many digits to be exact: leave to sscanf */
+    if (nd<=0||nd>15) return NULL;
+    if (p<e&&strchr("eEdDxX",*p)) return NULL;
+    
+    /* v and 10^nf are exact, so the division is rounded as strtod */
+    *val=sign?-(v/pow10[nf]):v/pow10[nf];
+    return p;
+}
+/* skip white spaces ---------------------------------------------------------*/
+static const char *skipspc(const char *p, const char *e)
+{
+    while (p<e&&(*p==' '||('\t'<=*p&&*p<='\r'))) p++;
+    return p;
+}
+#endif /* RNXSCANF */
+/* fast string to number -------------------------------------------------------
+* same as str2num() with known string length but without substring copy and
+* sscanf() for plain decimal fields, which are the most of rinex obs records
+*-----------------------------------------------------------------------------*/
+static double decnum(const char *s, int len, int i, int n)
+{
+#ifndef RNXSCANF
+    const char *p,*e;
+    double value;
+    
+    if (i<0||len<i) return 0.0;
+    e=s+(i+n<len?i+n:len);
+    if ((p=skipspc(s+i,e))>=e) return 0.0;
+    if (decval(p,e,&value)) return value;
+#endif
+    return str2num(s,i,n);
+}
+/* fast string to time -------------------------------------------------------*/
+static int dectime(const char *s, int len, int i, int n, gtime_t *t)
+{
+#ifndef RNXSCANF
+    const char *p,*e;
+    double ep[6];
+    int k;
+    
+    if (i<0||len<i) return -1;
+    e=s+(i+n<len?i+n:len);
+    for (k=0,p=s+i;k<6;k++) {
+        if (!(p=decval(skipspc(p,e),e,ep+k))) break;
+    }
+    if (k>=6) {
+        if (ep[0]<100.0) ep[0]+=ep[0]<80.0?2000.0:1900.0;
+        *t=epoch2time(ep);
+        return 0;
+    }
+#endif
+    return str2time(s,i,n,t);
+}
+/* fast satellite id to satellite number -------------------------------------*/
+static int decsat(const char *id)
+{
+    char satid[8]="";
+#ifndef RNXSCANF
+    int sys,prn;
+    
+    if ('0'<=id[1]&&id[1]<='9'&&'0'<=id[2]&&id[2]<='9') {
+        prn=(id[1]-'0')*10+(id[2]-'0');
+        switch (id[0]) {
+            case 'G': sys=SYS_GPS; prn+=MINPRNGPS-1; break;
+            case 'R': sys=SYS_GLO; prn+=MINPRNGLO-1; break;
+            case 'E': sys=SYS_GAL; prn+=MINPRNGAL-1; break;
+            case 'J': sys=SYS_QZS; prn+=MINPRNQZS-1; break;
+            case 'C': sys=SYS_CMP; prn+=MINPRNCMP-1; break;
+            case 'L': sys=SYS_LEO; prn+=MINPRNLEO-1; break;
+            case 'S': sys=SYS_SBS; prn+=100; break;
+            default : sys=SYS_NONE; break;
+        }
+        if (sys!=SYS_NONE) return satno(sys,prn);
+    }
+#endif
+    strncpy(satid,id,3);
+    return satid2no(satid);
+}
 /* decode obs epoch ----------------------------------------------------------*/
 static int decode_obsepoch(FILE *fp, char *buff, double ver, gtime_t *time,
                            int *flag, int *sats)
 {
-    int i,j,n;
-    char satid[8]="";
+    int i,j,n,len=(int)strlen(buff);
     
     trace(4,"decode_obsepoch: ver=%.2f\n",ver);
     
     if (ver<=2.99) { /* ver.2 */
-        if ((n=(int)str2num(buff,29,3))<=0) return 0;
+        if ((n=(int)decnum(buff,len,29,3))<=0) return 0;
         
         /* epoch flag: 3:new site,4:header info,5:external event */
-        *flag=(int)str2num(buff,28,1);
+        *flag=(int)decnum(buff,len,28,1);
         
         if (3<=*flag&&*flag<=5) return n;
         
-        if (str2time(buff,0,26,time)) {
+        if (dectime(buff,len,0,26,time)) {
             trace(2,"rinex obs invalid epoch: epoch=%26.26s\n",buff);
             return 0;
         }
@@ -654,20 +805,17 @@ static int decode_obsepoch(FILE *fp, char *buff, double ver, gtime_t *time,
                 if (!fgets(buff,MAXRNXLEN,fp)) break;
                 j=32;
             }
-            if (i<MAXOBS) {
-                strncpy(satid,buff+j,3);
-                sats[i]=satid2no(satid);
-            }
+            if (i<MAXOBS) sats[i]=decsat(buff+j);
         }
     }
     else { /* ver.3 */
-        if ((n=(int)str2num(buff,32,3))<=0) return 0;
+        if ((n=(int)decnum(buff,len,32,3))<=0) return 0;
         
-        *flag=(int)str2num(buff,31,1);
+        *flag=(int)decnum(buff,len,31,1);
         
         if (3<=*flag&&*flag<=5) return n;
         
-        if (buff[0]!='>'||str2time(buff,1,28,time)) {
+        if (buff[0]!='>'||dectime(buff,len,1,28,time)) {
             trace(2,"rinex obs invalid epoch: epoch=%29.29s\n",buff);
             return 0;
         }
@@ -683,13 +831,13 @@ static int decode_obsdata(FILE *fp, char *buff, double ver, int mask,
     double val[MAXOBSTYPE]={0};
     unsigned char lli[MAXOBSTYPE]={0};
     char satid[8]="";
-    int i,j,n,m,stat=1,p[MAXOBSTYPE],k[16],l[16];
+    int i,j,n,m,len=(int)strlen(buff),stat=1,p[MAXOBSTYPE],k[16],l[16];
     
     trace(4,"decode_obsdata: ver=%.2f\n",ver);
     
     if (ver>2.99) { /* ver.3 */
         strncpy(satid,buff,3);
-        obs->sat=(unsigned char)satid2no(satid);
+        obs->sat=(unsigned char)decsat(satid);
     }
     if (!obs->sat) {
         trace(4,"decode_obsdata: unsupported sat sat=%s\n",satid);
@@ -711,11 +859,12 @@ static int decode_obsdata(FILE *fp, char *buff, double ver, int mask,
         
         if (ver<=2.99&&j>=80) { /* ver.2 */
             if (!fgets(buff,MAXRNXLEN,fp)) break;
+            len=(int)strlen(buff);
             j=0;
         }
         if (stat) {
-            val[i]=str2num(buff,j,14)+ind->shift[i];
-            lli[i]=(unsigned char)str2num(buff,j+14,1)&3;
+            val[i]=decnum(buff,len,j,14)+ind->shift[i];
+            lli[i]=(unsigned char)decnum(buff,len,j+14,1)&3;
         }
     }
     if (!stat) return 0;
@@ -770,9 +919,9 @@ static int decode_obsdata(FILE *fp, char *buff, double ver, int mask,
             }
         }
     }
-    /* save obs data */
+    /* save obs data (signals out of NFREQ+NEXOBS of ver.2.11 are excluded) */
     for (i=0;i<ind->n;i++) {
-        if (p[i]<0||val[i]==0.0) continue;
+        if (p[i]<0||p[i]>=NFREQ+NEXOBS||val[i]==0.0) continue;
         switch (ind->type[i]) {
             case 0: obs->P[p[i]]=val[i]; obs->code[p[i]]=ind->code[i]; break;
             case 1: obs->L[p[i]]=val[i]; obs->LLI [p[i]]=lli[i];       break;
@@ -914,17 +1063,11 @@ static void set_index(double ver, int sys, const char *opt,
     }
 #endif
 }
-/* read rinex obs data body --------------------------------------------------*/
-static int readrnxobsb(FILE *fp, const char *opt, double ver,
-                       char tobs[][MAXOBSTYPE][4], int *flag, obsd_t *data)
+/* set system mask and signal index of all systems ---------------------------*/
+static int set_indexs(double ver, const char *opt, char tobs[][MAXOBSTYPE][4],
+                      sigind_t *index)
 {
-    gtime_t time={0};
-    sigind_t index[6]={{0}};
-    char buff[MAXRNXLEN];
-    int i=0,n=0,nsat=0,sats[MAXOBS]={0},mask;
-    
-    /* set system mask */
-    mask=set_sysmask(opt);
+    memset(index,0,sizeof(sigind_t)*6);
     
     /* set signal index */
     set_index(ver,SYS_GPS,opt,tobs[0],index  );
@@ -934,6 +1077,17 @@ static int readrnxobsb(FILE *fp, const char *opt, double ver,
     set_index(ver,SYS_SBS,opt,tobs[4],index+4);
     set_index(ver,SYS_CMP,opt,tobs[5],index+5);
     
+    /* set system mask */
+    return set_sysmask(opt);
+}
+/* read rinex obs data record with signal index ------------------------------*/
+static int readrnxobsr(FILE *fp, double ver, int mask, sigind_t *index,
+                       int *flag, obsd_t *data)
+{
+    gtime_t time={0};
+    char buff[MAXRNXLEN];
+    int i=0,n=0,nsat=0,sats[MAXOBS]={0};
+    
     /* read record */
     while (fgets(buff,MAXRNXLEN,fp)) {
         
@@ -955,23 +1109,268 @@ static int readrnxobsb(FILE *fp, const char *opt, double ver,
     }
     return -1;
 }
-/* read rinex obs ------------------------------------------------------------*/
-static int readrnxobs(FILE *fp, gtime_t ts, gtime_t te, double tint,
+/* read rinex obs data body --------------------------------------------------*/
+static int readrnxobsb(FILE *fp, const char *opt, double ver,
+                       char tobs[][MAXOBSTYPE][4], int *flag, obsd_t *data)
+{
+    sigind_t index[6];
+    int mask;
+    
+    mask=set_indexs(ver,opt,tobs,index);
+    
+    return readrnxobsr(fp,ver,mask,index,flag,data);
+}
+/* test cycle-slip in lli of obs data record ---------------------------------*/
+static int testslip(const char *buff, int i)
+{
+    int len=(int)strlen(buff);
+    
+    for (i+=14;i<len;i+=16) {
+        if ('0'<=buff[i]&&buff[i]<='9'&&((buff[i]-'0')&1)) return 1;
+    }
+    return 0;
+}
+/* skip rinex obs data record with signal index ------------------------------*/
+static int skiprnxobsr(FILE *fp, double ver, int mask, const sigind_t *index,
+                       int *flag, gtime_t *time, int *slip)
+{
+    const sigind_t *ind;
+    char buff[MAXRNXLEN],satid[8]="";
+    int i=0,j,n=0,nsat=0,sat,sats[MAXOBS]={0};
+    
+    /* read record without decoding obs data fields */
+    while (fgets(buff,MAXRNXLEN,fp)) {
+        
+        /* decode obs epoch */
+        if (i==0) {
+            if ((nsat=decode_obsepoch(fp,buff,ver,time,flag,sats))<=0) {
+                continue;
+            }
+        }
+        else if (*flag<=2||*flag==6) {
+            if (ver>2.99) {
+                sprintf(satid,"%.3s",buff);
+                sat=decsat(satid);
+            }
+            else sat=sats[i-1];
+            
+            if (slip&&testslip(buff,ver>2.99?3:0)) *slip=1;
+            
+            switch (satsys(sat,NULL)) {
+                case SYS_GLO: ind=index+1; break;
+                case SYS_GAL: ind=index+2; break;
+                case SYS_QZS: ind=index+3; break;
+                case SYS_SBS: ind=index+4; break;
+                case SYS_CMP: ind=index+5; break;
+                default:      ind=index  ; break;
+            }
+            /* skip continuation lines of ver.2 */
+            for (j=5;ver<=2.99&&j<ind->n;j+=5) {
+                if (!fgets(buff,MAXRNXLEN,fp)) break;
+                if (slip&&testslip(buff,0)) *slip=1;
+            }
+            if (sat&&(satsys(sat,NULL)&mask)&&n<MAXOBS) n++;
+        }
+        if (++i>nsat) return n;
+    }
+    return -1;
+}
+/* skip rinex obs data body --------------------------------------------------*/
+static int skiprnxobsb(FILE *fp, const char *opt, double ver,
+                       char tobs[][MAXOBSTYPE][4], int *flag, gtime_t *time)
+{
+    sigind_t index[6];
+    int mask;
+    
+    /* signal index to count ver.2 lines */
+    mask=set_indexs(ver,opt,tobs,index);
+    
+    return skiprnxobsr(fp,ver,mask,index,flag,time,NULL);
+}
+/* scan rinex obs body for epoch index ---------------------------------------*/
+static int scanrnxidx(FILE *fp, double ver, char tobs[][MAXOBSTYPE][4],
+                      rnxidx_t **idx)
+{
+    sigind_t index[6];
+    rnxidx_t *p;
+    gtime_t time={0};
+    long pos;
+    int n=0,nmax=0,mask,flag=0,slip;
+    
+    mask=set_indexs(ver,"",tobs,index);
+    
+    for (*idx=NULL;;n++) {
+        pos=ftell(fp);
+        slip=0;
+        if (skiprnxobsr(fp,ver,mask,index,&flag,&time,&slip)<0) break;
+        
+        if (n>=nmax) {
+            nmax=nmax<=0?4096:nmax*2;
+            if (!(p=(rnxidx_t *)realloc(*idx,sizeof(rnxidx_t)*nmax))) {
+                free(*idx); *idx=NULL;
+                return 0;
+            }
+            *idx=p;
+        }
+        (*idx)[n].time=time;
+        (*idx)[n].pos=pos;
+        (*idx)[n].flag=flag|(slip?RNXIDX_SLIP:0);
+    }
+    return n;
+}
+/* read rinex obs epoch index file -------------------------------------------*/
+static int readrnxidx(const char *file, const rnxidxh_t *head, rnxidx_t **idx)
+{
+    FILE *fp;
+    rnxidxh_t h;
+    char path[1040];
+    
+    sprintf(path,"%s%s",file,RNXIDXEXT);
+    
+    if (!(fp=fopen(path,"rb"))) return 0;
+    
+    if (fread(&h,sizeof(h),1,fp)!=1||strcmp(h.id,head->id)||
+        h.ver!=head->ver||h.size!=head->size||h.fsize!=head->fsize||
+        h.mtime!=head->mtime||h.pos!=head->pos||h.n<=0) {
+        trace(2,"rinex obs index not match: %s\n",path);
+        fclose(fp);
+        return 0;
+    }
+    if (!(*idx=(rnxidx_t *)malloc(sizeof(rnxidx_t)*h.n))||
+        fread(*idx,sizeof(rnxidx_t),h.n,fp)!=(size_t)h.n) {
+        trace(2,"rinex obs index read error: %s\n",path);
+        free(*idx); *idx=NULL;
+        fclose(fp);
+        return 0;
+    }
+    fclose(fp);
+    return h.n;
+}
+/* write rinex obs epoch index file ------------------------------------------*/
+static void writernxidx(const char *file, const rnxidxh_t *head,
+                        const rnxidx_t *idx)
+{
+    FILE *fp;
+    char path[1040];
+    
+    sprintf(path,"%s%s",file,RNXIDXEXT);
+    
+    if (!(fp=fopen(path,"wb"))) {
+        trace(2,"rinex obs index open error: %s\n",path);
+        return;
+    }
+    if (fwrite(head,sizeof(rnxidxh_t),1,fp)!=1||
+        fwrite(idx,sizeof(rnxidx_t),head->n,fp)!=(size_t)head->n) {
+        trace(2,"rinex obs index write error: %s\n",path);
+        fclose(fp);
+        remove(path);
+        return;
+    }
+    fclose(fp);
+}
+/* open rinex obs epoch index --------------------------------------------------
+* read epoch index of rinex obs body at the current file position from the
+* index file (file+RNXIDXEXT). if the index file does not exist or is not
+* matched with the rinex file, scan the obs body and write the index file
+*-----------------------------------------------------------------------------*/
+static int openrnxidx(const char *file, FILE *fp, double ver,
+                      char tobs[][MAXOBSTYPE][4], rnxidx_t **idx)
+{
+    struct stat st;
+    rnxidxh_t head;
+    
+    trace(3,"openrnxidx: file=%s\n",file);
+    
+    *idx=NULL;
+    
+    memset(&head,0,sizeof(rnxidxh_t));
+    strcpy(head.id,"RINEX OBS INDEX");
+    head.ver=RNXIDXVER;
+    head.size=sizeof(rnxidx_t);
+    
+    if ((head.pos=ftell(fp))<0||stat(file,&st)) return 0;
+    
+    head.fsize=(long)st.st_size;
+    head.mtime=(long)st.st_mtime;
+    
+    if ((head.n=readrnxidx(file,&head,idx))>0) return head.n;
+    
+    /* scan obs body and cache index */
+    if ((head.n=scanrnxidx(fp,ver,tobs,idx))>0) {
+        writernxidx(file,&head,*idx);
+    }
+    fseek(fp,head.pos,SEEK_SET);
+    
+    trace(3,"openrnxidx: nidx=%d\n",head.n);
+    return head.n;
+}
+/* test epoch to be read by rinex obs epoch index ----------------------------*/
+static int testidx(const rnxidx_t *idx, gtime_t ts, gtime_t te, double tint,
+                   int tsys)
+{
+    gtime_t time;
+    int flag=idx->flag&0xFF;
+    
+    /* no obs data in special event records */
+    if (3<=flag&&flag<=5) return 0;
+    
+    /* epochs with cycle-slip are read to save the slip */
+    if (idx->flag&RNXIDX_SLIP) return 1;
+    
+    time=tsys==TSYS_UTC?utc2gpst(idx->time):idx->time;
+    
+    return screent(time,ts,te,tint);
+}
+/* read rinex obs --------------------------------------------------------------
+* read rinex obs data body up to the file position end (-1: end of file).
+* with epoch index, screened epochs without cycle-slip are skipped by seeking
+* the file without decoding the records
+*-----------------------------------------------------------------------------*/
+static int readrnxobs(FILE *fp, long end, gtime_t ts, gtime_t te, double tint,
                       const char *opt, int rcv, double ver, int tsys,
-                      char tobs[][MAXOBSTYPE][4], obs_t *obs)
+                      char tobs[][MAXOBSTYPE][4], const rnxidx_t *idx,
+                      int nidx, unsigned char slips[][NFREQ], obs_t *obs)
 {
     obsd_t *data;
-    unsigned char slips[MAXSAT][NFREQ]={{0}};
-    int i,n,flag=0,stat=0;
+    sigind_t index[6];
+    long pos=0;
+    int i,j=0,k,n,mask,flag=0,stat=0;
     
-    trace(4,"readrnxobs: rcv=%d ver=%.2f tsys=%d\n",rcv,ver,tsys);
+    trace(4,"readrnxobs: rcv=%d ver=%.2f tsys=%d nidx=%d\n",rcv,ver,tsys,
+          nidx);
     
     if (!obs||rcv>MAXRCV) return 0;
     
     if (!(data=(obsd_t *)malloc(sizeof(obsd_t)*MAXOBS))) return 0;
     
-    /* read rinex obs data body */
-    while ((n=readrnxobsb(fp,opt,ver,tobs,&flag,data))>=0&&stat>=0) {
+    /* signal index common to all records */
+    mask=set_indexs(ver,opt,tobs,index);
+    
+    /* first epoch index at the current file position */
+    if (idx) {
+        pos=ftell(fp);
+        for (i=0,j=nidx;i<j;) {
+            k=(i+j)/2;
+            if (idx[k].pos<pos) i=k+1; else j=k;
+        }
+    }
+    /* read rinex obs data body (up to the file position end) */
+    while (stat>=0) {
+        if (idx) {
+            
+            /* skip epochs by epoch index */
+            for (;j<nidx&&(end<0||idx[j].pos<end);j++) {
+                if (testidx(idx+j,ts,te,tint,tsys)) break;
+            }
+            if (j>=nidx||(end>=0&&idx[j].pos>=end)) break;
+            
+            if (idx[j].pos!=pos&&fseek(fp,idx[j].pos,SEEK_SET)) break;
+            j++;
+            pos=j<nidx?idx[j].pos:-1;
+        }
+        else if (end>=0&&ftell(fp)>=end) break;
+        
+        if ((n=readrnxobsr(fp,ver,mask,index,&flag,data))<0) break;
         
         for (i=0;i<n;i++) {
             
@@ -1388,14 +1787,22 @@ static int readrnxclk(FILE *fp, const char *opt, int index, nav_t *nav)
     }
     return nav->nc>0;
 }
+/* use rinex obs epoch index -------------------------------------------------*/
+static int useidx(gtime_t ts, gtime_t te, double tint)
+{
+    return rnxidxena&&(ts.time!=0||te.time!=0||tint>0.0);
+}
 /* read rinex file -----------------------------------------------------------*/
-static int readrnxfp(FILE *fp, gtime_t ts, gtime_t te, double tint,
-                     const char *opt, int flag, int index, char *type,
-                     obs_t *obs, nav_t *nav, sta_t *sta)
+static int readrnxfp(FILE *fp, const char *file, gtime_t ts, gtime_t te,
+                     double tint, const char *opt, int flag, int index,
+                     char *type, obs_t *obs, nav_t *nav, sta_t *sta,
+                     obsbody_t *body)
 {
+    rnxidx_t *idx=NULL;
     double ver;
-    int sys,tsys;
+    int sys,tsys,nidx=0,stat;
     char tobs[NUMSYS][MAXOBSTYPE][4]={{""}};
+    unsigned char slips[MAXSAT][NFREQ]={{0}};
     
     trace(3,"readrnxfp: flag=%d index=%d\n",flag,index);
     
@@ -1407,7 +1814,22 @@ static int readrnxfp(FILE *fp, gtime_t ts, gtime_t te, double tint,
     
     /* read rinex body */
     switch (*type) {
-        case 'O': return readrnxobs(fp,ts,te,tint,opt,index,ver,tsys,tobs,obs);
+        case 'O':
+            /* defer reading obs body of plain file */
+            if (body&&obs&&file&&index<=MAXRCV&&(body->pos=ftell(fp))>=0) {
+                body->ver=ver;
+                body->tsys=tsys;
+                memcpy(body->tobs,tobs,sizeof(tobs));
+                return 1;
+            }
+            /* epoch index of plain file */
+            if (file&&obs&&useidx(ts,te,tint)) {
+                nidx=openrnxidx(file,fp,ver,tobs,&idx);
+            }
+            stat=readrnxobs(fp,-1,ts,te,tint,opt,index,ver,tsys,tobs,idx,nidx,
+                            slips,obs);
+            free(idx);
+            return stat;
         case 'N': return readrnxnav(fp,opt,ver,sys    ,nav);
         case 'G': return readrnxnav(fp,opt,ver,SYS_GLO,nav);
         case 'H': return readrnxnav(fp,opt,ver,SYS_SBS,nav);
@@ -1421,33 +1843,279 @@ static int readrnxfp(FILE *fp, gtime_t ts, gtime_t te, double tint,
 /* uncompress and read rinex file --------------------------------------------*/
 static int readrnxfile(const char *file, gtime_t ts, gtime_t te, double tint,
                        const char *opt, int flag, int index, char *type,
-                       obs_t *obs, nav_t *nav, sta_t *sta)
+                       obs_t *obs, nav_t *nav, sta_t *sta, obsbody_t *body)
 {
     FILE *fp;
-    int cstat,stat;
-    char tmpfile[1024];
+    int stat,plain;
+    char *buff;
     
     trace(3,"readrnxfile: file=%s flag=%d index=%d\n",file,flag,index);
     
     if (sta) init_sta(sta);
     
-    /* uncompress file */
-    if ((cstat=uncompress(file,tmpfile))<0) {
-        trace(2,"rinex file uncompact error: %s\n",file);
+    /* open file with uncompression */
+    if (!(fp=uncfopen(file,&plain))) {
+        trace(2,"rinex file open error: %s\n",file);
         return 0;
     }
-    if (!(fp=fopen(cstat?tmpfile:file,"r"))) {
-        trace(2,"rinex file open error: %s\n",cstat?tmpfile:file);
-        return 0;
+    /* read rinex file through large stream buffer */
+    if ((buff=(char *)malloc(RNXBUFSIZ))) setvbuf(fp,buff,_IOFBF,RNXBUFSIZ);
+    
+    /* only plain file can be reopened for deferred obs body and index */
+    stat=readrnxfp(fp,plain?file:NULL,ts,te,tint,opt,flag,index,type,obs,nav,
+                   sta,body);
+    
+    fclose(fp);
+    free(buff);
+    
+    /* keep file path of deferred obs body */
+    if (body&&body->pos>=0) strcpy(body->path,file);
+    
+    return stat;
+}
+/* rinex read worker thread --------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI rnxthread(void *arg)
+#else
+static void *rnxthread(void *arg)
+#endif
+{
+    rnxpool_t *pool=(rnxpool_t *)arg;
+    int i;
+    
+    for (;;) {
+        lock(&pool->lock);
+        i=pool->next++;
+        unlock(&pool->lock);
+        
+        if (i>=pool->n) break;
+        
+        pool->func(pool->job+pool->size*i);
     }
-    /* read rinex file */
-    stat=readrnxfp(fp,ts,te,tint,opt,flag,index,type,obs,nav,sta);
+    return 0;
+}
+/* execute rinex read jobs in parallel ---------------------------------------*/
+static void execrnxjobs(void (*func)(void *), void *job, size_t size, int n)
+{
+    rnxpool_t pool={0};
+    thread_t thread[MAXRNXTHREAD];
+    int i,nthread=rnxnthread;
     
+    trace(3,"execrnxjobs: n=%d nthread=%d\n",n,nthread);
+    
+    if (nthread>n) nthread=n;
+    if (nthread>MAXRNXTHREAD) nthread=MAXRNXTHREAD;
+    
+    if (nthread<=1) {
+        for (i=0;i<n;i++) func((char *)job+size*i);
+        return;
+    }
+    pool.func=func;
+    pool.job=(char *)job;
+    pool.size=size;
+    pool.n=n;
+    initlock(&pool.lock);
+    
+    for (i=0;i<nthread;i++) {
+#ifdef WIN32
+        if (!(thread[i]=CreateThread(NULL,0,rnxthread,&pool,0,NULL))) break;
+#else
+        if (pthread_create(thread+i,NULL,rnxthread,&pool)) break;
+#endif
+    }
+    if ((nthread=i)<=0) rnxthread(&pool);
+    
+    for (i=0;i<nthread;i++) {
+#ifdef WIN32
+        WaitForSingleObject(thread[i],INFINITE);
+        CloseHandle(thread[i]);
+#else
+        pthread_join(thread[i],NULL);
+#endif
+    }
+}
+/* open rinex obs body -------------------------------------------------------*/
+static FILE *openobsbody(const obsbody_t *body, long pos, char **buff)
+{
+    FILE *fp;
+    
+    if (!(fp=fopen(body->path,"r"))) {
+        trace(2,"rinex file open error: %s\n",body->path);
+        return NULL;
+    }
+    if ((*buff=(char *)malloc(RNXBUFSIZ))) setvbuf(fp,*buff,_IOFBF,RNXBUFSIZ);
+    
+    if (fseek(fp,pos,SEEK_SET)) {
+        fclose(fp); free(*buff);
+        return NULL;
+    }
+    return fp;
+}
+/* scan rinex obs body for chunk boundaries ------------------------------------
+* chunk boundaries are put on the epochs where readrnxobsb() starts to read a
+* record in the sequential reading, so that each chunk is read as well as in
+* the sequential reading
+*-----------------------------------------------------------------------------*/
+static void scanobsbody(void *arg)
+{
+    obsbody_t *body=(obsbody_t *)arg;
+    FILE *fp;
+    sigind_t index[6];
+    gtime_t time;
+    long pos,end,size,next,*p;
+    int i,mask,flag=0,nmax=0;
+    char *buff=NULL;
+    
+    if (body->pos<0||!(fp=openobsbody(body,body->pos,&buff))) return;
+    
+    mask=set_indexs(body->ver,body->opt,body->tobs,index);
+    
+    /* epoch index */
+    if (useidx(body->ts,body->te,body->tint)) {
+        body->nidx=openrnxidx(body->path,fp,body->ver,body->tobs,&body->idx);
+    }
+    fseek(fp,0,SEEK_END);
+    end=ftell(fp);
+    fseek(fp,body->pos,SEEK_SET);
+    
+    trace(3,"scanobsbody: path=%s size=%ld\n",body->path,end-body->pos);
+    
+    /* target chunk size */
+    if ((size=(end-body->pos)/(rnxnthread*2))<RNXCHUNK) size=RNXCHUNK;
+    
+    /* the last chunk is not shorter than half the target size */
+    for (i=0,next=body->pos+size;next+size/2<end;) {
+        if (body->idx) { /* epoch positions by index */
+            if (i>=body->nidx) break;
+            pos=body->idx[i++].pos;
+        }
+        else pos=ftell(fp);
+        
+        if (pos>=next) {
+            if (pos+size/2>=end) break;
+            if (body->nbound>=nmax) {
+                nmax=nmax<=0?16:nmax*2;
+                if (!(p=(long *)realloc(body->bound,sizeof(long)*nmax))) break;
+                body->bound=p;
+            }
+            body->bound[body->nbound++]=pos;
+            next=pos+size;
+        }
+        if (body->idx) continue;
+        
+        if (skiprnxobsr(fp,body->ver,mask,index,&flag,&time,NULL)<0) break;
+    }
     fclose(fp);
+    free(buff);
+}
+/* read rinex obs body chunk -------------------------------------------------*/
+static void readobschunk(void *arg)
+{
+    obschunk_t *chunk=(obschunk_t *)arg;
+    const obsbody_t *body=chunk->body;
+    FILE *fp;
+    char *buff=NULL;
+    
+    trace(3,"readobschunk: path=%s pos=%ld end=%ld\n",body->path,chunk->pos,
+          chunk->end);
     
-    /* delete temporary file */
-    if (cstat) remove(tmpfile);
+    if (!(fp=openobsbody(body,chunk->pos,&buff))) return;
+    
+    chunk->stat=readrnxobs(fp,chunk->end,body->ts,body->te,body->tint,
+                           body->opt,body->rcv,body->ver,body->tsys,
+                           (char (*)[MAXOBSTYPE][4])body->tobs,body->idx,
+                           body->nidx,chunk->slips,&chunk->obs);
+    fclose(fp);
+    free(buff);
+}
+/* merge obs data of rinex obs body chunks -------------------------------------
+* cycle-slips saved in the screened epochs at the end of a chunk are restored
+* to the first obs data of the satellite in the following chunks
+*-----------------------------------------------------------------------------*/
+static int mergechunk(obschunk_t *chunk, int n, obs_t *obs)
+{
+    unsigned char slips[MAXSAT][NFREQ]={{0}};
+    obsd_t *data;
+    int i,j,k,stat=0;
     
+    for (i=0;i<n;i++) {
+        for (j=0;j<chunk[i].obs.n;j++) {
+            data=chunk[i].obs.data+j;
+            for (k=0;k<NFREQ;k++) {
+                if (slips[data->sat-1][k]&1) data->LLI[k]|=1;
+                slips[data->sat-1][k]=0;
+            }
+        }
+        for (j=0;j<MAXSAT;j++) for (k=0;k<NFREQ;k++) {
+            slips[j][k]|=chunk[i].slips[j][k];
+        }
+        if (chunk[i].stat<0) stat=-1;
+        else if (chunk[i].stat>0&&stat==0) stat=1;
+        
+        for (j=0;j<chunk[i].obs.n&&stat>=0;j++) {
+            if (addobsdata(obs,chunk[i].obs.data+j)<0) stat=-1;
+        }
+    }
+    return stat;
+}
+/* read rinex files with parallel reading of obs bodies ----------------------*/
+static int readrnxpar(char **files, int n, gtime_t ts, gtime_t te, double tint,
+                      const char *opt, int rcv, char *type, obs_t *obs,
+                      nav_t *nav, sta_t *sta)
+{
+    obsbody_t *body;
+    obschunk_t *chunk=NULL;
+    int i,j,k,m,nchunk=0,stat=0;
+    
+    trace(3,"readrnxpar: n=%d rcv=%d nthread=%d\n",n,rcv,rnxnthread);
+    
+    if (!(body=(obsbody_t *)calloc(n,sizeof(obsbody_t)))) return -1;
+    
+    /* read headers and nav/clock data in order and defer obs bodies */
+    for (m=0;m<n&&stat>=0;m++) {
+        body[m].pos=-1;
+        body[m].ts=ts; body[m].te=te; body[m].tint=tint;
+        body[m].opt=opt; body[m].rcv=rcv;
+        body[m].stat=stat=readrnxfile(files[m],ts,te,tint,opt,0,rcv,type,obs,
+                                      nav,sta,body+m);
+    }
+    /* find chunk boundaries of obs bodies */
+    execrnxjobs(scanobsbody,body,sizeof(obsbody_t),m);
+    
+    for (i=0;i<m;i++) {
+        if (body[i].pos>=0) nchunk+=body[i].nbound+1;
+    }
+    if (nchunk>0&&!(chunk=(obschunk_t *)calloc(nchunk,sizeof(obschunk_t)))) {
+        nchunk=0;
+        stat=-1;
+    }
+    for (i=k=0;i<m&&k<nchunk;i++) {
+        if (body[i].pos<0) continue;
+        for (j=0;j<=body[i].nbound;j++,k++) {
+            chunk[k].body=body+i;
+            chunk[k].pos=j==0?body[i].pos:body[i].bound[j-1];
+            chunk[k].end=j<body[i].nbound?body[i].bound[j]:-1;
+        }
+    }
+    /* read obs body chunks */
+    execrnxjobs(readobschunk,chunk,sizeof(obschunk_t),nchunk);
+    
+    for (i=k=0;i<m&&k<nchunk;i++) {
+        if (body[i].pos<0) continue;
+        body[i].stat=mergechunk(chunk+k,body[i].nbound+1,obs);
+        k+=body[i].nbound+1;
+    }
+    /* status of the last file read as sequential reading */
+    if (stat>=0) {
+        for (i=0;i<m&&(stat=body[i].stat)>=0;i++) ;
+    }
+    for (i=0;i<nchunk;i++) free(chunk[i].obs.data);
+    for (i=0;i<m;i++) {
+        free(body[i].bound);
+        free(body[i].idx);
+    }
+    free(chunk);
+    free(body);
     return stat;
 }
 /* read rinex obs and nav files ------------------------------------------------
@@ -1494,7 +2162,8 @@ extern int readrnxt(const char *file, int rcv, gtime_t ts, gtime_t te,
     trace(3,"readrnxt: file=%s rcv=%d\n",file,rcv);
     
     if (!*file) {
-        return readrnxfp(stdin,ts,te,tint,opt,0,1,&type,obs,nav,sta);
+        return readrnxfp(stdin,NULL,ts,te,tint,opt,0,1,&type,obs,nav,sta,
+                         NULL);
     }
     for (i=0;i<MAXEXFILE;i++) {
         if (!(files[i]=(char *)malloc(1024))) {
@@ -1507,10 +2176,20 @@ extern int readrnxt(const char *file, int rcv, gtime_t ts, gtime_t te,
         for (i=0;i<MAXEXFILE;i++) free(files[i]);
         return 0;
     }
+    PROFBEG(PROF_READRNX);
+    
     /* read rinex files */
-    for (i=0;i<n&&stat>=0;i++) {
-        stat=readrnxfile(files[i],ts,te,tint,opt,0,rcv,&type,obs,nav,sta);
+    if (obs&&rnxnthread>1) {
+        stat=readrnxpar(files,n,ts,te,tint,opt,rcv,&type,obs,nav,sta);
     }
+    else {
+        for (i=0;i<n&&stat>=0;i++) {
+            stat=readrnxfile(files[i],ts,te,tint,opt,0,rcv,&type,obs,nav,sta,
+                             NULL);
+        }
+    }
+    PROFEND(PROF_READRNX);
+    
     /* if station name empty, set 4-char name from file head */
     if (type=='O'&&sta) {
         if (!(p=strrchr(file,FILEPATHSEP))) p=file-1;
@@ -1529,6 +2208,39 @@ extern int readrnx(const char *file, int rcv, const char *opt, obs_t *obs,
     
     return readrnxt(file,rcv,t,t,0.0,opt,obs,nav,sta);
 }
+/* set number of threads to read rinex obs -------------------------------------
+* set number of threads to read rinex obs data in readrnxt() and readrnx()
+* args   : int    nthread   I   number of threads (<=1: sequential reading)
+* return : none
+* notes  : obs data bodies are split into chunks at epochs found by a scan of
+*          the bodies. the chunks of all input files are read in parallel and
+*          merged in the order of the sequential reading with cycle-slips
+*          carried over the chunk boundaries. the read obs data are the same
+*          as ones of the sequential reading.
+*-----------------------------------------------------------------------------*/
+extern void rnxsetthread(int nthread)
+{
+    trace(3,"rnxsetthread: nthread=%d\n",nthread);
+    
+    rnxnthread=nthread<1?1:(nthread>MAXRNXTHREAD?MAXRNXTHREAD:nthread);
+}
+/* set rinex obs epoch index ---------------------------------------------------
+* enable or disable epoch index of rinex obs files in readrnxt()
+* args   : int    ena       I   epoch index (0:off,1:on)
+* return : none
+* notes  : if enabled and the time span or interval is specified, the file
+*          positions of epochs of rinex obs files are indexed and cached to
+*          index files (file+".idx") at the first reading. with the index,
+*          epochs out of the time span or interval are skipped without
+*          decoding. epochs with lli cycle-slips are always decoded to keep
+*          the slips. compressed files are not indexed.
+*-----------------------------------------------------------------------------*/
+extern void rnxsetindex(int ena)
+{
+    trace(3,"rnxsetindex: ena=%d\n",ena);
+    
+    rnxidxena=ena;
+}
 /* compare precise clock -----------------------------------------------------*/
 static int cmppclk(const void *p1, const void *p2)
 {
@@ -1594,7 +2306,8 @@ extern int readrnxc(const char *file, nav_t *nav)
     
     /* read rinex clock files */
     for (i=0;i<n;i++) {
-        if (readrnxfile(files[i],t,t,0.0,"",1,index++,&type,NULL,nav,NULL)) {
+        if (readrnxfile(files[i],t,t,0.0,"",1,index++,&type,NULL,nav,NULL,
+                        NULL)) {
             continue;
         }
         stat=0;
@@ -1762,6 +2475,262 @@ extern int input_rnxctr(rnxctr_t *rnx, FILE *fp)
     }
     return 2;
 }
+/* close current file of rinex obs stream ------------------------------------*/
+static void closefile_rnxobs(rnxobs_t *rnx)
+{
+    if (!rnx->fp) return;
+    
+    fclose(rnx->fp);
+    rnx->fp=NULL;
+}
+/* open next file of rinex obs stream ----------------------------------------*/
+static int nextfile_rnxobs(rnxobs_t *rnx)
+{
+    char type,*file;
+    int sys;
+    
+    closefile_rnxobs(rnx);
+    
+    while (rnx->ifile<rnx->nfile) {
+        file=rnx->files[rnx->ifile++];
+        
+        trace(3,"nextfile_rnxobs: file=%s rcv=%d\n",file,rnx->rcv);
+        
+        /* open file with uncompression */
+        if (!(rnx->fp=uncfopen(file,NULL))) {
+            trace(2,"rinex file open error: %s\n",file);
+            continue;
+        }
+        memset(rnx->tobs ,0,sizeof(rnx->tobs ));
+        memset(rnx->slips,0,sizeof(rnx->slips));
+        
+        /* read rinex header (obs files only) */
+        if (readrnxh(rnx->fp,&rnx->ver,&type,&sys,&rnx->tsys,rnx->tobs,NULL,
+                     NULL)&&type=='O') {
+            return 1;
+        }
+        closefile_rnxobs(rnx);
+    }
+    return 0;
+}
+/* compare obs data by satellite ---------------------------------------------*/
+static int cmpobssat(const void *p1, const void *p2)
+{
+    const obsd_t *q1=(const obsd_t *)p1,*q2=(const obsd_t *)p2;
+    return (int)q1->sat-(int)q2->sat;
+}
+/* read next epoch of rinex obs stream ---------------------------------------*/
+static int readepoch_rnxobs(rnxobs_t *rnx, obsd_t *data, gtime_t tlast)
+{
+    int i,j,n,flag=0;
+    
+    while (rnx->fp||nextfile_rnxobs(rnx)) {
+        
+        /* read rinex obs data body */
+        if ((n=readrnxobsb(rnx->fp,rnx->opt,rnx->ver,rnx->tobs,&flag,
+                           data))<0) {
+            closefile_rnxobs(rnx);
+            continue;
+        }
+        if (n<=0) continue;
+        
+        for (i=0;i<n;i++) {
+            
+            /* utc -> gpst */
+            if (rnx->tsys==TSYS_UTC) data[i].time=utc2gpst(data[i].time);
+            
+            /* save cycle-slip */
+            saveslips(rnx->slips,data+i);
+        }
+        /* skip rest of file after end time */
+        if (rnx->te.time&&timediff(data[0].time,rnx->te)>DTTOL) {
+            closefile_rnxobs(rnx);
+            continue;
+        }
+        /* screen data by time */
+        if (!screent(data[0].time,rnx->ts,rnx->te,rnx->tint)) continue;
+        
+        /* skip duplicated or disordered epoch */
+        if (tlast.time&&timediff(data[0].time,tlast)<=DTTOL) {
+            trace(2,"rinex obs epoch skipped: time=%s rcv=%d\n",
+                  time_str(data[0].time,3),rnx->rcv);
+            continue;
+        }
+        for (i=0;i<n;i++) {
+            
+            /* restore cycle-slip */
+            restslips(rnx->slips,data+i);
+            
+            data[i].rcv=(unsigned char)rnx->rcv;
+        }
+        /* sort and unique obs data by satellite */
+        qsort(data,n,sizeof(obsd_t),cmpobssat);
+        
+        for (i=j=0;i<n;i++) {
+            if (data[i].sat!=data[j].sat) data[++j]=data[i];
+        }
+        return j+1;
+    }
+    return 0;
+}
+/* open rinex obs stream -------------------------------------------------------
+* open rinex obs files as a stream of observation epochs for forward-only
+* processing. only the current and the next epoch are kept in memory.
+* args   : rnxobs_t *rnx IO  rinex obs stream
+*          char   **file I   rinex obs files (wild-card * expanded)
+*          int    n      I   number of rinex obs files
+*          int    rcv    I   receiver number for obs data
+*          gtime_t ts    I   observation time start (ts.time==0: no limit)
+*          gtime_t te    I   observation time end   (te.time==0: no limit)
+*          double tint   I   observation time interval (s) (0:all)
+*          char   *opt   I   rinex options (see readrnxt())
+* return : number of obs data of the first epoch (0:no data,-1:error)
+* notes  : rnx should be zero-cleared or closed by close_rnxobs() before
+*          calling the function. the files other than rinex obs are skipped.
+*          the files should be input in time order. the epochs of the same or
+*          earlier time than the last input epoch are skipped.
+*          the obs data of the current epoch are rnx->data[0][0..rnx->n[0]-1]
+*          and ones of the next epoch are rnx->data[1][0..rnx->n[1]-1] sorted
+*          by satellite number.
+*-----------------------------------------------------------------------------*/
+extern int open_rnxobs(rnxobs_t *rnx, char **file, int n, int rcv, gtime_t ts,
+                       gtime_t te, double tint, const char *opt)
+{
+    gtime_t t0={0};
+    char *files[MAXEXFILE]={0},**p;
+    int i,j,m;
+    
+    trace(3,"open_rnxobs: n=%d rcv=%d\n",n,rcv);
+    
+    memset(rnx,0,sizeof(rnxobs_t));
+    rnx->ts=ts; rnx->te=te; rnx->tint=tint; rnx->rcv=rcv;
+    strncpy(rnx->opt,opt,255);
+    
+    for (i=0;i<MAXEXFILE;i++) {
+        if (!(files[i]=(char *)malloc(1024))) {
+            for (i--;i>=0;i--) free(files[i]);
+            return -1;
+        }
+    }
+    /* expand wild-card */
+    for (i=0;i<n;i++) {
+        if ((m=expath(file[i],files,MAXEXFILE))<=0) continue;
+        
+        if (!(p=(char **)realloc(rnx->files,sizeof(char *)*(rnx->nfile+m)))) {
+            break;
+        }
+        rnx->files=p;
+        for (j=0;j<m;j++) {
+            if (!(rnx->files[rnx->nfile]=(char *)malloc(strlen(files[j])+1))) {
+                break;
+            }
+            strcpy(rnx->files[rnx->nfile++],files[j]);
+        }
+        if (j<m) break;
+    }
+    for (j=0;j<MAXEXFILE;j++) free(files[j]);
+    
+    if (i<n||!(rnx->data[0]=(obsd_t *)malloc(sizeof(obsd_t)*MAXOBS*2))) {
+        close_rnxobs(rnx);
+        return -1;
+    }
+    rnx->data[1]=rnx->data[0]+MAXOBS;
+    
+    /* read the first and the next epoch */
+    if ((rnx->n[0]=readepoch_rnxobs(rnx,rnx->data[0],t0))>0) {
+        rnx->n[1]=readepoch_rnxobs(rnx,rnx->data[1],rnx->data[0][0].time);
+    }
+    return rnx->n[0];
+}
+/* input rinex obs stream ------------------------------------------------------
+* advance rinex obs stream to the next epoch
+* args   : rnxobs_t *rnx IO  rinex obs stream
+* return : number of obs data of the new current epoch (0:end of stream)
+*-----------------------------------------------------------------------------*/
+extern int input_rnxobs(rnxobs_t *rnx)
+{
+    obsd_t *data=rnx->data[0];
+    
+    trace(4,"input_rnxobs: rcv=%d\n",rnx->rcv);
+    
+    if (rnx->n[0]<=0) return 0;
+    
+    rnx->data[0]=rnx->data[1]; rnx->n[0]=rnx->n[1];
+    rnx->data[1]=data;         rnx->n[1]=0;
+    
+    if (rnx->n[0]>0) {
+        rnx->n[1]=readepoch_rnxobs(rnx,rnx->data[1],rnx->data[0][0].time);
+    }
+    return rnx->n[0];
+}
+/* close rinex obs stream ------------------------------------------------------
+* close rinex obs stream and free buffers
+* args   : rnxobs_t *rnx IO  rinex obs stream
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void close_rnxobs(rnxobs_t *rnx)
+{
+    int i;
+    
+    trace(3,"close_rnxobs: rcv=%d\n",rnx->rcv);
+    
+    closefile_rnxobs(rnx);
+    
+    for (i=0;i<rnx->nfile;i++) free(rnx->files[i]);
+    free(rnx->files); rnx->files=NULL; rnx->nfile=rnx->ifile=0;
+    free(rnx->data[0]<rnx->data[1]?rnx->data[0]:rnx->data[1]);
+    rnx->data[0]=rnx->data[1]=NULL;
+    rnx->n[0]=rnx->n[1]=0;
+}
+/* scan time span of rinex obs stream ------------------------------------------
+* get the first and the last epoch time of rinex obs stream without decoding
+* obs data fields
+* args   : rnxobs_t *rnx I   rinex obs stream opened by open_rnxobs()
+*          gtime_t *ts   O   first epoch time
+*          gtime_t *te   O   last epoch time
+* return : number of epochs
+* notes  : the stream itself is not changed. the files are read again.
+*-----------------------------------------------------------------------------*/
+extern int scan_rnxobs(const rnxobs_t *rnx, gtime_t *ts, gtime_t *te)
+{
+    rnxobs_t *scan;
+    gtime_t time={0},tlast={0};
+    int n,nepoch=0,flag=0;
+    
+    trace(3,"scan_rnxobs: rcv=%d\n",rnx->rcv);
+    
+    ts->time=te->time=0; ts->sec=te->sec=0.0;
+    
+    if (!(scan=(rnxobs_t *)calloc(1,sizeof(rnxobs_t)))) return 0;
+    
+    scan->ts=rnx->ts; scan->te=rnx->te; scan->tint=rnx->tint;
+    scan->rcv=rnx->rcv; scan->files=rnx->files; scan->nfile=rnx->nfile;
+    strcpy(scan->opt,rnx->opt);
+    
+    while (scan->fp||nextfile_rnxobs(scan)) {
+        if ((n=skiprnxobsb(scan->fp,scan->opt,scan->ver,scan->tobs,&flag,
+                           &time))<0) {
+            closefile_rnxobs(scan);
+            continue;
+        }
+        if (n<=0) continue;
+        
+        /* utc -> gpst */
+        if (scan->tsys==TSYS_UTC) time=utc2gpst(time);
+        
+        if (scan->te.time&&timediff(time,scan->te)>DTTOL) {
+            closefile_rnxobs(scan);
+            continue;
+        }
+        if (!screent(time,scan->ts,scan->te,scan->tint)) continue;
+        if (tlast.time&&timediff(time,tlast)<=DTTOL) continue;
+        
+        if (nepoch++==0) *ts=time;
+        *te=tlast=time;
+    }
+    free(scan);
+    return nepoch;
+}
 /*------------------------------------------------------------------------------
 * output rinex functions
 *-----------------------------------------------------------------------------*/
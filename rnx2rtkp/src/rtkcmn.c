@@ -6,8 +6,11 @@
 * options : -DLAPACK   use LAPACK/BLAS
 *           -DMKL      use Intel MKL
 *           -DTRACE    enable debug trace
+*           -DTRACEMAX=n max level of debug trace compiled in (default: 5)
+*           -DPROFILE  enable profiler of positioning stages
 *           -DWIN32    use WIN32 API
 *           -DNOCALLOC no use calloc for zero matrix
+*           -DNODLOPEN no runtime loading of BLAS/LAPACK library
 *           -DIERS_MODEL use GMF instead of NMF
 *           -DDLL      built for shared library
 *
@@ -110,7 +113,7 @@
 *                           chanage api crc32() -> rtk_crc32()
 *                           chanage api crc24q() -> rtk_crc24q()
 *-----------------------------------------------------------------------------*/
-#define _POSIX_C_SOURCE 199309
+#define _POSIX_C_SOURCE 200112L
 #include <stdarg.h>
 #include <ctype.h>
 #ifndef WIN32
@@ -119,6 +122,9 @@
 #include <sys/time.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
 #endif
 #include "rtklib.h"
 
@@ -128,6 +134,14 @@ static const char rcsid[]="$Id: rtkcmn.c,v 1.1 2008/07/17 21:48:06 ttaka Exp tta
 
 #define POLYCRC32   0xEDB88320u /* CRC32 polynomial */
 #define POLYCRC24Q  0x1864CFBu  /* CRC24Q polynomial */
+#define PCVSNAPID   "RTKLIB PCV SNAP" /* id of antenna parameters snapshot */
+#define PCVSNAPVER  1           /* version of antenna parameters snapshot */
+
+static int pcvsnap=0;   /* snapshot of antenna parameters (0:off,1:on) */
+
+#ifdef PROFILE
+static THREADLOCAL unsigned int nalloc_prof=0; /* number of matrix allocations */
+#endif
 
 const static double gpst0[]={1980,1, 6,0,0,0}; /* gps time reference */
 const static double gst0 []={1999,8,22,0,0,0}; /* galileo system time reference */
@@ -743,6 +757,9 @@ extern double *mat(int n, int m)
     if (!(p=(double *)malloc(sizeof(double)*n*m))) {
         fatalerr("matrix memory allocation error: n=%d,m=%d\n",n,m);
     }
+#ifdef PROFILE
+    nalloc_prof++;
+#endif
     return p;
 }
 /* new integer matrix ----------------------------------------------------------
@@ -758,6 +775,9 @@ extern int *imat(int n, int m)
     if (!(p=(int *)malloc(sizeof(int)*n*m))) {
         fatalerr("integer matrix memory allocation error: n=%d,m=%d\n",n,m);
     }
+#ifdef PROFILE
+    nalloc_prof++;
+#endif
     return p;
 }
 /* zero matrix -----------------------------------------------------------------
@@ -776,6 +796,9 @@ extern double *zeros(int n, int m)
     if (!(p=(double *)calloc(sizeof(double),n*m))) {
         fatalerr("matrix memory allocation error: n=%d,m=%d\n",n,m);
     }
+#ifdef PROFILE
+    nalloc_prof++;
+#endif
 #endif
     return p;
 }
@@ -916,85 +939,354 @@ extern int solve(const char *tr, const double *A, const double *Y, int n,
     free(ipiv); free(B); 
     return info;
 }
+/* set BLAS/LAPACK library ---------------------------------------------------*/
+extern int matsetblas(const char *lib)
+{
+    (void)lib;
+    return 1;
+}
 
 #else /* without LAPACK/BLAS or MKL */
 
+#define MATBLK      64          /* block size of matrix multiplication */
+#define MAXSMALLMUL 48          /* max n*k*m to multiply by inner products */
+#define MINBLASMUL  32768       /* min n*k*m to multiply matrix by BLAS */
+#define MINBLASLU   64          /* min n to decompose matrix by LAPACK */
+
+#if defined(__GNUC__)&&!defined(__clang__)&&!defined(__OPTIMIZE_SIZE__)
+#pragma GCC push_options
+#pragma GCC optimize ("tree-vectorize") /* vectorize kernels also for -O2 */
+#define MATVECOPT
+#endif
+#if defined(_MSC_VER)
+#define RESTRICT    __restrict
+#elif defined(__GNUC__)
+#define RESTRICT    __restrict__
+#else
+#define RESTRICT
+#endif
+
+typedef void dgemm_t(char *, char *, int *, int *, int *, double *, double *,
+                     int *, double *, int *, double *, double *, int *);
+typedef void dgetrf_t(int *, int *, double *, int *, int *, int *);
+typedef void dgetri_t(int *, double *, int *, int *, double *, int *, int *);
+typedef void dgetrs_t(char *, int *, int *, double *, int *, int *, double *,
+                      int *, int *);
+
+static dgemm_t  *dgemm_blas =NULL;      /* BLAS dgemm (NULL: not loaded) */
+static dgetrf_t *dgetrf_blas=NULL;      /* LAPACK dgetrf */
+static dgetri_t *dgetri_blas=NULL;      /* LAPACK dgetri */
+static dgetrs_t *dgetrs_blas=NULL;      /* LAPACK dgetrs */
+
+#ifndef NODLOPEN
+#ifdef WIN32
+#define dlopen(file,mode)   ((void *)LoadLibrary(file))
+#define dlsym(lib,name)     ((void *)GetProcAddress((HMODULE)(lib),name))
+#define dlclose(lib)        FreeLibrary((HMODULE)(lib))
+#else
+#include <dlfcn.h>
+#endif
+static void *lib_blas=NULL;             /* BLAS/LAPACK library handle */
+
+/* default BLAS/LAPACK libraries ---------------------------------------------*/
+static const char *libs_blas[]={
+#ifdef WIN32
+    "libopenblas.dll","mkl_rt.dll",
+#elif defined(__APPLE__)
+    "/System/Library/Frameworks/Accelerate.framework/Accelerate",
+    "libopenblas.dylib",
+#else
+    "libopenblas.so.0","libopenblas.so","libmkl_rt.so","liblapack.so.3",
+#endif
+    ""
+};
+/* resolve BLAS/LAPACK function ----------------------------------------------*/
+static void *symblas(const char *name)
+{
+    char name_[16];
+    void *p;
+    
+    sprintf(name_,"%s_",name);
+    if ((p=dlsym(lib_blas,name_))) return p;
+    return dlsym(lib_blas,name);
+}
+#endif /* NODLOPEN */
+
+/* set BLAS/LAPACK library -----------------------------------------------------
+* load BLAS/LAPACK shared library at runtime and dispatch large matrix
+* multiplications, inversions and linear equations to it
+* args   : char   *lib      I   library path (NULL: search default libraries,
+*                               "": unload library)
+* return : status (1:dgemm loaded, 0:not loaded)
+* notes  : built-in routines are used for small matrices, for functions not
+*          found in the library or if compiled with -DNODLOPEN.
+*          not thread-safe. call it before starting processing threads.
+*-----------------------------------------------------------------------------*/
+extern int matsetblas(const char *lib)
+{
+#ifndef NODLOPEN
+    int i;
+    
+    trace(3,"matsetblas: lib=%s\n",lib?lib:"(default)");
+    
+    dgemm_blas=NULL; dgetrf_blas=NULL; dgetri_blas=NULL; dgetrs_blas=NULL;
+    if (lib_blas) dlclose(lib_blas);
+    lib_blas=NULL;
+    
+    if (lib&&!*lib) return 0;
+    
+    if (lib) {
+        lib_blas=dlopen(lib,RTLD_NOW);
+    }
+    else {
+        for (i=0;*libs_blas[i]&&!lib_blas;i++) {
+            lib_blas=dlopen(libs_blas[i],RTLD_NOW);
+        }
+    }
+    if (!lib_blas) {
+        trace(2,"blas library load error: %s\n",lib?lib:"(default)");
+        return 0;
+    }
+    dgemm_blas =(dgemm_t  *)symblas("dgemm");
+    dgetrf_blas=(dgetrf_t *)symblas("dgetrf");
+    dgetri_blas=(dgetri_t *)symblas("dgetri");
+    dgetrs_blas=(dgetrs_t *)symblas("dgetrs");
+    
+    trace(3,"matsetblas: dgemm=%d dgetrf=%d dgetri=%d dgetrs=%d\n",
+          dgemm_blas!=NULL,dgetrf_blas!=NULL,dgetri_blas!=NULL,
+          dgetrs_blas!=NULL);
+    return dgemm_blas!=NULL;
+#else
+    (void)lib;
+    return 0;
+#endif
+}
+/* multiply matrix C+=alpha*A*B or C+=alpha*A*B' -------------------------------
+* B(x,j) is B[x*sx+j*sj] (A*B: sx=1,sj=m, A*B': sx=k,sj=1). columns of A are
+* accumulated to columns of C by blocks of MATBLK rows and columns four at a
+* time, so that the inner loop is a vectorizable axpy on contiguous memory
+*-----------------------------------------------------------------------------*/
+static void matmulnx(int n, int k, int m, double alpha,
+                     const double *RESTRICT A, const double *RESTRICT B, int sx,
+                     int sj, double *RESTRICT C)
+{
+    const double *a0,*a1,*a2,*a3;
+    double b0,b1,b2,b3,*c;
+    int i,j,x,i0,i1,x0,x1;
+    
+    for (x0=0;x0<m;x0+=MATBLK) {
+        x1=x0+MATBLK<m?x0+MATBLK:m;
+        
+        for (i0=0;i0<n;i0+=MATBLK) {
+            i1=i0+MATBLK<n?i0+MATBLK:n;
+            
+            for (j=0;j<k;j++) {
+                c=C+j*n;
+                for (x=x0;x+3<x1;x+=4) {
+                    b0=alpha*B[ x   *sx+j*sj]; b1=alpha*B[(x+1)*sx+j*sj];
+                    b2=alpha*B[(x+2)*sx+j*sj]; b3=alpha*B[(x+3)*sx+j*sj];
+                    if (b0==0.0&&b1==0.0&&b2==0.0&&b3==0.0) continue;
+                    a0=A+x*n; a1=a0+n; a2=a1+n; a3=a2+n;
+                    for (i=i0;i<i1;i++) {
+                        c[i]+=b0*a0[i]+b1*a1[i]+b2*a2[i]+b3*a3[i];
+                    }
+                }
+                for (;x<x1;x++) {
+                    if ((b0=alpha*B[x*sx+j*sj])==0.0) continue;
+                    a0=A+x*n;
+                    for (i=i0;i<i1;i++) c[i]+=b0*a0[i];
+                }
+            }
+        }
+    }
+}
+/* inner product with four partial sums --------------------------------------*/
+static double matdot(const double *RESTRICT a, const double *RESTRICT b, int n)
+{
+    double d0=0.0,d1=0.0,d2=0.0,d3=0.0;
+    int i;
+    
+    for (i=0;i+3<n;i+=4) {
+        d0+=a[i  ]*b[i  ]; d1+=a[i+1]*b[i+1];
+        d2+=a[i+2]*b[i+2]; d3+=a[i+3]*b[i+3];
+    }
+    for (;i<n;i++) d0+=a[i]*b[i];
+    return (d0+d1)+(d2+d3);
+}
+/* multiply matrix C+=alpha*A'*B ---------------------------------------------*/
+static void matmultn(int n, int k, int m, double alpha, const double *A,
+                     const double *B, double *C)
+{
+    int i,j,x0,x1;
+    
+    for (x0=0;x0<m;x0+=MATBLK*4) {
+        x1=x0+MATBLK*4<m?x0+MATBLK*4:m;
+        
+        for (j=0;j<k;j++) for (i=0;i<n;i++) {
+            C[i+j*n]+=alpha*matdot(A+x0+i*m,B+x0+j*m,x1-x0);
+        }
+    }
+}
+/* multiply matrix C+=alpha*A'*B' --------------------------------------------*/
+static void matmultt(int n, int k, int m, double alpha, const double *A,
+                     const double *B, double *C)
+{
+    double d;
+    int i,j,x;
+    
+    for (j=0;j<k;j++) for (i=0;i<n;i++) {
+        for (x=0,d=0.0;x<m;x++) d+=A[x+i*m]*B[j+x*k];
+        C[i+j*n]+=alpha*d;
+    }
+}
+/* multiply small matrix by inner products ----------------------------------*/
+static void matmuls(const char *tr, int n, int k, int m, double alpha,
+                    const double *A, const double *B, double beta, double *C)
+{
+    double d;
+    int i,j,x,ai=1,ax=n,bx=1,bj=m;
+    
+    if (tr[0]=='T') {ai=m; ax=1;}
+    if (tr[1]=='T') {bx=k; bj=1;}
+    
+    for (j=0;j<k;j++) for (i=0;i<n;i++) {
+        for (x=0,d=0.0;x<m;x++) d+=A[i*ai+x*ax]*B[x*bx+j*bj];
+        if (beta==0.0) C[i+j*n]=alpha*d; else C[i+j*n]=alpha*d+beta*C[i+j*n];
+    }
+}
 /* multiply matrix -----------------------------------------------------------*/
 extern void matmul(const char *tr, int n, int k, int m, double alpha,
                    const double *A, const double *B, double beta, double *C)
 {
-    double d;
-    int i,j,x,f=tr[0]=='N'?(tr[1]=='N'?1:2):(tr[1]=='N'?3:4);
-    
-    for (i=0;i<n;i++) for (j=0;j<k;j++) {
-        d=0.0;
-        switch (f) {
-            case 1: for (x=0;x<m;x++) d+=A[i+x*n]*B[x+j*m]; break;
-            case 2: for (x=0;x<m;x++) d+=A[i+x*n]*B[j+x*k]; break;
-            case 3: for (x=0;x<m;x++) d+=A[x+i*m]*B[x+j*m]; break;
-            case 4: for (x=0;x<m;x++) d+=A[x+i*m]*B[j+x*k]; break;
-        }
-        if (beta==0.0) C[i+j*n]=alpha*d; else C[i+j*n]=alpha*d+beta*C[i+j*n];
+    int i,lda,ldb;
+    
+    if (n<=0||k<=0) return;
+    
+    if (n*k*m<=MAXSMALLMUL) {
+        matmuls(tr,n,k,m,alpha,A,B,beta,C);
+        return;
+    }
+    
+    if (dgemm_blas&&(double)n*k*m>=MINBLASMUL) {
+        lda=tr[0]=='T'?m:n; ldb=tr[1]=='T'?k:m;
+        dgemm_blas((char *)tr,(char *)tr+1,&n,&k,&m,&alpha,(double *)A,&lda,
+                   (double *)B,&ldb,&beta,C,&n);
+        return;
+    }
+    if (beta==0.0) {
+        for (i=0;i<n*k;i++) C[i]=0.0;
+    }
+    else if (beta!=1.0) {
+        for (i=0;i<n*k;i++) C[i]*=beta;
+    }
+    if (m<=0||alpha==0.0) return;
+    
+    if (tr[0]=='N') {
+        if (tr[1]=='N') matmulnx(n,k,m,alpha,A,B,1,m,C);
+        else            matmulnx(n,k,m,alpha,A,B,k,1,C);
+    }
+    else {
+        if (tr[1]=='N') matmultn(n,k,m,alpha,A,B,C);
+        else            matmultt(n,k,m,alpha,A,B,C);
     }
 }
-/* LU decomposition ----------------------------------------------------------*/
-static int ludcmp(double *A, int n, int *indx, double *d)
+/* LU decomposition ------------------------------------------------------------
+* right-looking LU decomposition with implicit pivoting (PA=LU). the trailing
+* matrix is updated column by column with contiguous inner loops
+*-----------------------------------------------------------------------------*/
+static int ludcmp(double *A, int n, int *indx)
 {
-    double big,s,tmp,*vv=mat(n,1);
-    int i,imax=0,j,k;
+    double big,tmp,*vv,*RESTRICT a,*RESTRICT c;
+    int i,imax,j,k;
     
-    *d=1.0;
+    vv=zeros(n,1);
+    for (j=0;j<n;j++) for (i=0;i<n;i++) {
+        if ((tmp=fabs(A[i+j*n]))>vv[i]) vv[i]=tmp;
+    }
     for (i=0;i<n;i++) {
-        big=0.0; for (j=0;j<n;j++) if ((tmp=fabs(A[i+j*n]))>big) big=tmp;
-        if (big>0.0) vv[i]=1.0/big; else {free(vv); return -1;}
+        if (vv[i]>0.0) vv[i]=1.0/vv[i]; else {free(vv); return -1;}
     }
     for (j=0;j<n;j++) {
-        for (i=0;i<j;i++) {
-            s=A[i+j*n]; for (k=0;k<i;k++) s-=A[i+k*n]*A[k+j*n]; A[i+j*n]=s;
-        }
-        big=0.0;
+        a=A+j*n;
+        big=0.0; imax=j;
         for (i=j;i<n;i++) {
-            s=A[i+j*n]; for (k=0;k<j;k++) s-=A[i+k*n]*A[k+j*n]; A[i+j*n]=s;
-            if ((tmp=vv[i]*fabs(s))>=big) {big=tmp; imax=i;}
+            if ((tmp=vv[i]*fabs(a[i]))>=big) {big=tmp; imax=i;}
         }
         if (j!=imax) {
             for (k=0;k<n;k++) {
                 tmp=A[imax+k*n]; A[imax+k*n]=A[j+k*n]; A[j+k*n]=tmp;
             }
-            *d=-(*d); vv[imax]=vv[j];
+            vv[imax]=vv[j];
         }
         indx[j]=imax;
-        if (A[j+j*n]==0.0) {free(vv); return -1;}
-        if (j!=n-1) {
-            tmp=1.0/A[j+j*n]; for (i=j+1;i<n;i++) A[i+j*n]*=tmp;
+        if (a[j]==0.0) {free(vv); return -1;}
+        
+        tmp=1.0/a[j]; for (i=j+1;i<n;i++) a[i]*=tmp;
+        
+        for (k=j+1;k<n;k++) {
+            c=A+k*n;
+            if ((tmp=c[j])==0.0) continue;
+            for (i=j+1;i<n;i++) c[i]-=a[i]*tmp;
         }
     }
     free(vv);
     return 0;
 }
-/* LU back-substitution ------------------------------------------------------*/
-static void lubksb(const double *A, int n, const int *indx, double *b)
+/* LU back-substitution (b=A\b) ----------------------------------------------*/
+static void lubksb(const double *A, int n, const int *indx, double *RESTRICT b)
 {
-    double s;
-    int i,ii=-1,ip,j;
+    const double *RESTRICT a;
+    double tmp;
+    int i,j;
     
     for (i=0;i<n;i++) {
-        ip=indx[i]; s=b[ip]; b[ip]=b[i];
-        if (ii>=0) for (j=ii;j<i;j++) s-=A[i+j*n]*b[j]; else if (s) ii=i;
-        b[i]=s;
+        if (indx[i]!=i) {tmp=b[indx[i]]; b[indx[i]]=b[i]; b[i]=tmp;}
+    }
+    for (j=0;j<n;j++) {
+        if ((tmp=b[j])==0.0) continue;
+        for (a=A+j*n,i=j+1;i<n;i++) b[i]-=a[i]*tmp;
+    }
+    for (j=n-1;j>=0;j--) {
+        if (b[j]==0.0) continue;
+        tmp=b[j]/=A[j+j*n];
+        for (a=A+j*n,i=0;i<j;i++) b[i]-=a[i]*tmp;
+    }
+}
+/* LU back-substitution of transposed matrix (b=A'\b) ------------------------*/
+static void lubksbt(const double *A, int n, const int *indx, double *b)
+{
+    double tmp;
+    int i,j;
+    
+    for (j=0;j<n;j++) { /* U'*z=b */
+        b[j]=(b[j]-matdot(A+j*n,b,j))/A[j+j*n];
+    }
+    for (j=n-1;j>=0;j--) { /* L'*w=z */
+        b[j]-=matdot(A+j+1+j*n,b+j+1,n-j-1);
     }
     for (i=n-1;i>=0;i--) {
-        s=b[i]; for (j=i+1;j<n;j++) s-=A[i+j*n]*b[j]; b[i]=s/A[i+i*n];
+        if (indx[i]!=i) {tmp=b[indx[i]]; b[indx[i]]=b[i]; b[i]=tmp;}
     }
 }
 /* inverse of matrix ---------------------------------------------------------*/
 extern int matinv(double *A, int n)
 {
-    double d,*B;
-    int i,j,*indx;
+    double *B,*work;
+    int i,j,info,lwork,*indx;
+    
+    if (n<=0) return 0;
     
-    indx=imat(n,1); B=mat(n,n); matcpy(B,A,n,n);
-    if (ludcmp(B,n,indx,&d)) {free(indx); free(B); return -1;}
+    indx=imat(n,1);
+    
+    if (dgetrf_blas&&dgetri_blas&&n>=MINBLASLU) {
+        lwork=n*16; work=mat(lwork,1);
+        dgetrf_blas(&n,&n,A,&n,indx,&info);
+        if (!info) dgetri_blas(&n,A,&n,indx,work,&lwork,&info);
+        free(indx); free(work);
+        return info;
+    }
+    B=mat(n,n); matcpy(B,A,n,n);
+    if (ludcmp(B,n,indx)) {free(indx); free(B); return -1;}
     for (j=0;j<n;j++) {
         for (i=0;i<n;i++) A[i+j*n]=0.0; A[j+j*n]=1.0;
         lubksb(B,n,indx,A+j*n);
@@ -1006,14 +1298,31 @@ extern int matinv(double *A, int n)
 extern int solve(const char *tr, const double *A, const double *Y, int n,
                  int m, double *X)
 {
-    double *B=mat(n,n);
-    int info;
+    double *B;
+    int j,info,*indx;
     
+    if (n<=0) return 0;
+    
+    B=mat(n,n); indx=imat(n,1);
     matcpy(B,A,n,n);
-    if (!(info=matinv(B,n))) matmul(tr[0]=='N'?"NN":"TN",n,m,n,1.0,B,Y,0.0,X);
-    free(B);
+    if (X!=Y) matcpy(X,Y,n,m);
+    
+    if (dgetrf_blas&&dgetrs_blas&&n>=MINBLASLU) {
+        dgetrf_blas(&n,&n,B,&n,indx,&info);
+        if (!info) dgetrs_blas((char *)tr,&n,&m,B,&n,indx,X,&n,&info);
+    }
+    else if (!(info=ludcmp(B,n,indx))) {
+        for (j=0;j<m;j++) {
+            if (tr[0]=='N') lubksb (B,n,indx,X+j*n);
+            else            lubksbt(B,n,indx,X+j*n);
+        }
+    }
+    free(indx); free(B);
     return info;
 }
+#ifdef MATVECOPT
+#pragma GCC pop_options
+#endif
 #endif
 /* end of matrix routines ----------------------------------------------------*/
 
@@ -1085,6 +1394,8 @@ extern int filter(double *x, double *P, const double *H, const double *v,
     double *x_,*xp_,*P_,*Pp_,*H_;
     int i,j,k,info,*ix;
     
+    PROFBEG(PROF_FILTER);
+    
     ix=imat(n,1); for (i=k=0;i<n;i++) if (x[i]!=0.0&&P[i+i*n]>0.0) ix[k++]=i;
     x_=mat(k,1); xp_=mat(k,1); P_=mat(k,k); Pp_=mat(k,k); H_=mat(k,m);
     for (i=0;i<k;i++) {
@@ -1098,6 +1409,70 @@ extern int filter(double *x, double *P, const double *H, const double *v,
         for (j=0;j<k;j++) P[ix[i]+ix[j]*n]=Pp_[i+j*k];
     }
     free(ix); free(x_); free(xp_); free(P_); free(Pp_); free(H_);
+    
+    PROFEND(PROF_FILTER);
+    return info;
+}
+/* kalman filter with sparse design matrix ------------------------------------
+* kalman filter state update with sparse design matrix as follows:
+*
+*   F=P*H, K=F*(H'*F+R)^-1, xp=x+K*v, Pp=P-K*F'
+*
+* args   : double *x        IO  states vector (n x 1)
+*          double *P        IO  covariance matrix of states (n x n)
+*          int    *Hi       I   state indices of non-zero elements of design
+*                               matrix (nh x m) (-1: no element)
+*          double *Hv       I   non-zero elements of design matrix (nh x m)
+*          int    nh        I   max number of non-zero elements of a column
+*          double *v        I   innovation (measurement - model) (m x 1)
+*          double *R        I   covariance matrix of measurement error (m x m)
+*          int    n,m       I   number of states and measurements
+* return : status (0:ok,<0:error)
+* notes  : equivalent to filter() with H[Hi[k+j*nh]+j*n]=Hv[k+j*nh] for
+*          symmetric P. the results agree with filter() within round-off
+*          errors. P*H and H'*P*H are formed from the non-zero elements in
+*          O(n*m*nh) and O(m*m*nh) without the dense H. the update of P is
+*          still O(n*n*m) as filter()
+*          if state x[i]==0.0, not updates state x[i]/P[i+i*n]
+*-----------------------------------------------------------------------------*/
+extern int filtersp(double *x, double *P, const int *Hi, const double *Hv,
+                    int nh, const double *v, const double *R, int n, int m)
+{
+    double *x_,*P_,*F,*Q,*K;
+    int i,j,k,l,a,info,*ix,*iy;
+    
+    PROFBEG(PROF_FILTER);
+    
+    ix=imat(n,1); iy=imat(n,1);
+    for (i=k=0;i<n;i++) {
+        if (x[i]!=0.0&&P[i+i*n]>0.0) {iy[i]=k; ix[k++]=i;} else iy[i]=-1;
+    }
+    x_=mat(k,1); P_=mat(k,k); F=zeros(k,m); Q=mat(m,m); K=mat(k,m);
+    for (i=0;i<k;i++) {
+        x_[i]=x[ix[i]];
+        for (j=0;j<k;j++) P_[i+j*k]=P[ix[i]+ix[j]*n];
+    }
+    for (j=0;j<m;j++) for (l=0;l<nh;l++) { /* F=P*H */
+        if (Hi[l+j*nh]<0||(a=iy[Hi[l+j*nh]])<0) continue;
+        for (i=0;i<k;i++) F[i+j*k]+=P_[i+a*k]*Hv[l+j*nh];
+    }
+    matcpy(Q,R,m,m);
+    for (i=0;i<m;i++) for (l=0;l<nh;l++) { /* Q=H'*F+R */
+        if (Hi[l+i*nh]<0||(a=iy[Hi[l+i*nh]])<0) continue;
+        for (j=0;j<m;j++) Q[i+j*m]+=Hv[l+i*nh]*F[a+j*k];
+    }
+    if (!(info=matinv(Q,m))) {
+        matmul("NN",k,m,m,1.0,F,Q,0.0,K);   /* K=F*Q^-1 */
+        matmul("NN",k,1,m,1.0,K,v,1.0,x_);  /* xp=x+K*v */
+        matmul("NT",k,k,m,-1.0,K,F,1.0,P_); /* Pp=P-K*F' */
+        for (i=0;i<k;i++) {
+            x[ix[i]]=x_[i];
+            for (j=0;j<k;j++) P[ix[i]+ix[j]*n]=P_[i+j*k];
+        }
+    }
+    free(ix); free(iy); free(x_); free(P_); free(F); free(Q); free(K);
+    
+    PROFEND(PROF_FILTER);
     return info;
 }
 /* smoother --------------------------------------------------------------------
@@ -1527,7 +1902,7 @@ extern void time2str(gtime_t t, char *s, int n)
 *-----------------------------------------------------------------------------*/
 extern char *time_str(gtime_t t, int n)
 {
-    static char buff[64];
+    static THREADLOCAL char buff[64];
     time2str(t,buff,n);
     return buff;
 }
@@ -1601,6 +1976,263 @@ extern void sleepms(int ms)
     nanosleep(&ts,NULL);
 #endif
 }
+/* wait condition ------------------------------------------------------------
+* wait condition signaled by signalcond() with timeout
+* args   : cond_t *cond     IO  condition
+*          lock_t *lock     IO  lock flag (locked by caller)
+*          int    ms        I   timeout (ms)
+* return : none
+* notes  : the lock is released while waiting and locked again on return.
+*          spurious wakeups are possible and should be checked by caller.
+*-----------------------------------------------------------------------------*/
+extern void waitcond(cond_t *cond, lock_t *lock, int ms)
+{
+#ifdef WIN32
+    SleepConditionVariableCS(cond,lock,ms>0?(DWORD)ms:0);
+#else
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_REALTIME,&ts);
+    ts.tv_sec+=ms/1000;
+    ts.tv_nsec+=(long)(ms%1000)*1000000;
+    if (ts.tv_nsec>=1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec-=1000000000;
+    }
+    pthread_cond_timedwait(cond,lock,&ts);
+#endif
+}
+/* load/store queue count with acquire/release ordering ----------------------*/
+static unsigned int loadacq(volatile unsigned int *p)
+{
+#ifdef WIN32
+    unsigned int n=*p;
+    MemoryBarrier();
+    return n;
+#else
+    return __atomic_load_n(p,__ATOMIC_ACQUIRE);
+#endif
+}
+static void storerel(volatile unsigned int *p, unsigned int n)
+{
+#ifdef WIN32
+    MemoryBarrier();
+    *p=n;
+#else
+    __atomic_store_n(p,n,__ATOMIC_RELEASE);
+#endif
+}
+/* initialize single-producer single-consumer queue ----------------------------
+* initialize lock-free queue of fixed size elements between a producer thread
+* and a consumer thread
+* args   : spscq_t *q       IO  queue
+*          int    size      I   element size (bytes)
+*          int    n         I   number of elements (rounded up to power of 2)
+* return : status (1:ok,0:memory allocation error)
+* notes  : the producer gets a free element by spscwbuf(), fills it and
+*          publishes it by spscpush(). the consumer gets the oldest element by
+*          spscrbuf() and releases it by spscpop(). the elements are accessed
+*          in place without copy.
+*-----------------------------------------------------------------------------*/
+extern int spscinit(spscq_t *q, int size, int n)
+{
+    unsigned int m=1;
+    
+    while (m<(unsigned int)n) m<<=1;
+    
+    q->size=size;
+    q->wp=q->rp=0;
+    if (!(q->buff=(unsigned char *)malloc((size_t)size*m))) {
+        q->n=0;
+        return 0;
+    }
+    q->n=m;
+    return 1;
+}
+/* free single-producer single-consumer queue --------------------------------*/
+extern void spscfree(spscq_t *q)
+{
+    free(q->buff);
+    q->buff=NULL;
+    q->n=q->wp=q->rp=0;
+}
+/* get free element of queue (producer) ----------------------------------------
+* args   : spscq_t *q       IO  queue
+* return : free element (NULL: queue full)
+*-----------------------------------------------------------------------------*/
+extern void *spscwbuf(spscq_t *q)
+{
+    unsigned int wp=q->wp;
+    
+    if (q->n==0||wp-loadacq(&q->rp)>=q->n) return NULL;
+    return q->buff+(size_t)(wp&(q->n-1))*q->size;
+}
+/* publish element got by spscwbuf() (producer) ------------------------------*/
+extern void spscpush(spscq_t *q)
+{
+    storerel(&q->wp,q->wp+1);
+}
+/* get oldest element of queue (consumer) --------------------------------------
+* args   : spscq_t *q       IO  queue
+* return : oldest element (NULL: queue empty)
+*-----------------------------------------------------------------------------*/
+extern void *spscrbuf(spscq_t *q)
+{
+    unsigned int rp=q->rp;
+    
+    if (q->n==0||loadacq(&q->wp)==rp) return NULL;
+    return q->buff+(size_t)(rp&(q->n-1))*q->size;
+}
+/* release element got by spscrbuf() (consumer) ------------------------------*/
+extern void spscpop(spscq_t *q)
+{
+    storerel(&q->rp,q->rp+1);
+}
+/* number of elements in queue -----------------------------------------------*/
+extern int spscnum(spscq_t *q)
+{
+    return (int)(loadacq(&q->wp)-loadacq(&q->rp));
+}
+/* memory fence for ring buffer ----------------------------------------------*/
+static void fencerel(void)
+{
+#ifdef WIN32
+    MemoryBarrier();
+#else
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+#endif
+}
+static void fenceacq(void)
+{
+#ifdef WIN32
+    MemoryBarrier();
+#else
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+#endif
+}
+/* initialize single-producer byte ring buffer ---------------------------------
+* initialize lock-free byte ring buffer written by a producer thread and read
+* by any number of consumers with own reader cursors
+* args   : ringbuf_t *ring  IO  ring buffer
+*          int    n         I   buffer size (bytes) (rounded up to power of 2)
+* return : status (1:ok,0:memory allocation error)
+* notes  : the producer writes data in place to the space got by ringwbuf()
+*          and publishes it by ringpush(), or copies data by ringwrite().
+*          the producer never waits for the consumers. a consumer reads data
+*          by ringread() after its cursor. if the consumer is late more than
+*          the buffer size, the overwritten data are skipped.
+*-----------------------------------------------------------------------------*/
+extern int ringinit(ringbuf_t *ring, int n)
+{
+    unsigned int m=1;
+    
+    while (m<(unsigned int)n) m<<=1;
+    
+    ring->wp=ring->ws=0;
+    if (!(ring->buff=(unsigned char *)malloc(m))) {
+        ring->n=0;
+        return 0;
+    }
+    ring->n=m;
+    return 1;
+}
+/* free single-producer byte ring buffer -------------------------------------*/
+extern void ringfree(ringbuf_t *ring)
+{
+    free(ring->buff);
+    ring->buff=NULL;
+    ring->n=ring->wp=ring->ws=0;
+}
+/* get write space of ring buffer (producer) -----------------------------------
+* args   : ringbuf_t *ring  IO  ring buffer
+*          int    *n        IO  max size (bytes) (I) and contiguous size got (O)
+* return : write space (NULL: no buffer)
+* notes  : the space is reserved until ringpush()
+*-----------------------------------------------------------------------------*/
+extern unsigned char *ringwbuf(ringbuf_t *ring, int *n)
+{
+    unsigned int i=ring->wp&(ring->n-1);
+    
+    if (ring->n==0) {
+        *n=0;
+        return NULL;
+    }
+    if (*n>(int)(ring->n-i)) *n=(int)(ring->n-i);
+    if (*n>(int)(ring->n/2)) *n=(int)(ring->n/2);
+    
+    /* reserved count never decreases as reserved space may be dirty */
+    if ((int)(ring->wp+*n-ring->ws)>0) ring->ws=ring->wp+*n;
+    fencerel(); /* reserve space before write data */
+    return ring->buff+i;
+}
+/* publish data written to space got by ringwbuf() (producer) ----------------*/
+extern void ringpush(ringbuf_t *ring, int n)
+{
+    storerel(&ring->wp,ring->wp+n);
+}
+/* write data to ring buffer (producer) --------------------------------------*/
+extern void ringwrite(ringbuf_t *ring, const unsigned char *buff, int n)
+{
+    unsigned int wp=ring->wp,i;
+    int m;
+    
+    if (ring->n==0||n<=0) return;
+    
+    if ((int)(wp+n-ring->ws)>0) ring->ws=wp+n;
+    fencerel(); /* reserve space before write data */
+    
+    if (n>(int)ring->n) { /* only last data */
+        buff+=n-(int)ring->n;
+        wp+=n-(int)ring->n;
+        n=(int)ring->n;
+    }
+    i=wp&(ring->n-1);
+    m=n<(int)(ring->n-i)?n:(int)(ring->n-i);
+    memcpy(ring->buff+i,buff,m);
+    memcpy(ring->buff,buff+m,n-m);
+    
+    storerel(&ring->wp,wp+n);
+}
+/* read data from ring buffer (consumer) ---------------------------------------
+* args   : ringbuf_t *ring  I   ring buffer
+*          unsigned int *rp IO  reader cursor (write count read)
+*          unsigned char *buff O data buffer
+*          int    nmax      I   max data length (bytes)
+* return : read data length (bytes)
+* notes  : the data overwritten by the producer during read are discarded
+*-----------------------------------------------------------------------------*/
+extern int ringread(const ringbuf_t *ring, unsigned int *rp,
+                    unsigned char *buff, int nmax)
+{
+    unsigned int wp,ws,i,k;
+    int n,m;
+    
+    if (ring->n==0||nmax<=0) return 0;
+    
+    wp=loadacq((volatile unsigned int *)&ring->wp);
+    if (wp-*rp>ring->n) { /* overrun or new cursor */
+        *rp=wp<ring->n?0:wp-ring->n;
+    }
+    n=(int)(wp-*rp)<nmax?(int)(wp-*rp):nmax;
+    i=*rp&(ring->n-1);
+    m=n<(int)(ring->n-i)?n:(int)(ring->n-i);
+    memcpy(buff,ring->buff+i,m);
+    memcpy(buff+m,ring->buff,n-m);
+    
+    fenceacq(); /* read data before reserved count */
+    ws=ring->ws;
+    
+    /* discard data overwritten during read */
+    if ((k=ws-*rp)>ring->n) {
+        k-=ring->n;
+        if (k>(unsigned int)n) k=(unsigned int)n;
+        memmove(buff,buff+k,n-k);
+        *rp+=n;
+        return n-(int)k;
+    }
+    *rp+=n;
+    return n;
+}
 /* convert degree to deg-min-sec -----------------------------------------------
 * convert degree to degree-minute-second
 * args   : double deg       I   degree
@@ -1904,13 +2536,13 @@ static void nut_iau1980(double t, const double *f, double *dpsi, double *deps)
 *                               (NULL: no output)
 * return : none
 * note   : see ref [3] chap 5
-*          not thread-safe
+*          the cache is thread-local
 *-----------------------------------------------------------------------------*/
 extern void eci2ecef(gtime_t tutc, const double *erpv, double *U, double *gmst)
 {
     const double ep2000[]={2000,1,1,12,0,0};
-    static gtime_t tutc_;
-    static double U_[9],gmst_;
+    static THREADLOCAL gtime_t tutc_;
+    static THREADLOCAL double U_[9],gmst_;
     gtime_t tgps;
     double eps,ze,th,z,t,t2,t3,dpsi,deps,gast,f[5];
     double R1[9],R2[9],R3[9],R[9],W[9],N[9],P[9],NP[9];
@@ -2006,7 +2638,7 @@ static int readngspcv(const char *file, pcvs_t *pcvs)
     int n=0;
     char buff[256];
     
-    if (!(fp=fopen(file,"r"))) {
+    if (!(fp=uncfopen(file,NULL))) {
         trace(2,"ngs pcv file open error: %s\n",file);
         return 0;
     }
@@ -2055,7 +2687,7 @@ static int readantex(const char *file, pcvs_t *pcvs)
     
     trace(3,"readantex: file=%s\n",file);
     
-    if (!(fp=fopen(file,"r"))) {
+    if (!(fp=uncfopen(file,NULL))) {
         trace(2,"antex pcv file open error: %s\n",file);
         return 0;
     }
@@ -2111,6 +2743,183 @@ static int readantex(const char *file, pcvs_t *pcvs)
     
     return 1;
 }
+/* enable snapshot of antenna parameters --------------------------------------
+* enable cache of antex file as binary snapshot <file>.bin by readpcv()
+* args   : int    ena       I   snapshot (0:off,1:on)
+* return : none
+* notes  : the snapshot is written to the directory of the antex file
+*-----------------------------------------------------------------------------*/
+extern void pcvsetsnap(int ena)
+{
+    pcvsnap=ena;
+}
+/* size and modified time of file -------------------------------------------*/
+static int filestat(const char *file, double *info)
+{
+    struct stat st;
+    
+    if (stat(file,&st)) return 0;
+    info[0]=(double)st.st_size;
+    info[1]=(double)st.st_mtime;
+    return 1;
+}
+/* save snapshot of antenna parameters -----------------------------------------
+* save antenna parameters pcvs->pcv[n0...] read from source file with the size
+* and modified time of the source file (src) in binary format. frequencies
+* without offsets and variations are omitted.
+*-----------------------------------------------------------------------------*/
+static int savepcvsnap(const char *file, const double *src, const pcvs_t *pcvs,
+                       int n0)
+{
+    FILE *fp;
+    const pcv_t *pcv;
+    double t[4];
+    char tmp[1024];
+    int i,j,k,hdr[3],mask,stat;
+    
+    trace(3,"savepcvsnap: file=%s n=%d\n",file,pcvs->n-n0);
+    
+    sprintf(tmp,"%.1019s.tmp",file);
+    if (!(fp=fopen(tmp,"wb"))) {
+        trace(2,"pcv snapshot open error: %s\n",tmp);
+        return 0;
+    }
+    hdr[0]=PCVSNAPVER; hdr[1]=NFREQ; hdr[2]=pcvs->n-n0;
+    fwrite(PCVSNAPID,1,16,fp);
+    fwrite(hdr,sizeof(int),3,fp);
+    fwrite(src,sizeof(double),2,fp);
+    
+    for (i=n0;i<pcvs->n;i++) {
+        pcv=pcvs->pcv+i;
+        for (j=mask=0;j<NFREQ;j++) {
+            for (k=0;k<3;k++) if (pcv->off[j][k]!=0.0) break;
+            if (k<3) {mask|=1<<j; continue;}
+            for (k=0;k<19;k++) if (pcv->var[j][k]!=0.0) break;
+            if (k<19) mask|=1<<j;
+        }
+        t[0]=(double)pcv->ts.time; t[1]=pcv->ts.sec;
+        t[2]=(double)pcv->te.time; t[3]=pcv->te.sec;
+        fwrite(&pcv->sat,sizeof(int),1,fp);
+        fwrite(&mask,sizeof(int),1,fp);
+        fwrite(pcv->type,1,MAXANT,fp);
+        fwrite(pcv->code,1,MAXANT,fp);
+        fwrite(t,sizeof(double),4,fp);
+        for (j=0;j<NFREQ;j++) {
+            if (!(mask&(1<<j))) continue;
+            fwrite(pcv->off[j],sizeof(double),3,fp);
+            fwrite(pcv->var[j],sizeof(double),19,fp);
+        }
+    }
+    fwrite(PCVSNAPID,1,16,fp);
+    stat=!ferror(fp);
+    fclose(fp);
+    
+    remove(file);
+    if (!stat||rename(tmp,file)) {
+        trace(2,"pcv snapshot write error: %s\n",file);
+        remove(tmp);
+        return 0;
+    }
+    return 1;
+}
+/* read snapshot of antenna parameters -----------------------------------------
+* read snapshot of antenna parameters saved by savepcvsnap() and add them to
+* pcvs. the snapshot is rejected if the size or modified time of the source
+* file (src) is changed.
+*-----------------------------------------------------------------------------*/
+static int readpcvsnap(const char *file, const double *src, pcvs_t *pcvs)
+{
+    FILE *fp;
+    static const pcv_t pcv0={0};
+    pcv_t pcv;
+    double t[4],info[2];
+    char id[16];
+    int i,j,n0=pcvs->n,hdr[3],mask,stat=1;
+    
+    trace(3,"readpcvsnap: file=%s\n",file);
+    
+    if (!(fp=fopen(file,"rb"))) return 0;
+    
+    if (fread(id,1,16,fp)!=16||strncmp(id,PCVSNAPID,16)||
+        fread(hdr,sizeof(int),3,fp)!=3||hdr[0]!=PCVSNAPVER||hdr[1]!=NFREQ||
+        fread(info,sizeof(double),2,fp)!=2||info[0]!=src[0]||
+        info[1]!=src[1]) {
+        fclose(fp);
+        return 0;
+    }
+    for (i=0;i<hdr[2]&&stat;i++) {
+        pcv=pcv0;
+        if (fread(&pcv.sat,sizeof(int),1,fp)!=1||
+            fread(&mask,sizeof(int),1,fp)!=1||
+            fread(pcv.type,1,MAXANT,fp)!=MAXANT||
+            fread(pcv.code,1,MAXANT,fp)!=MAXANT||
+            fread(t,sizeof(double),4,fp)!=4) {
+            stat=0;
+            break;
+        }
+        pcv.type[MAXANT-1]=pcv.code[MAXANT-1]='\0';
+        pcv.ts.time=(time_t)t[0]; pcv.ts.sec=t[1];
+        pcv.te.time=(time_t)t[2]; pcv.te.sec=t[3];
+        for (j=0;j<NFREQ;j++) {
+            if (!(mask&(1<<j))) continue;
+            if (fread(pcv.off[j],sizeof(double),3,fp)!=3||
+                fread(pcv.var[j],sizeof(double),19,fp)!=19) {
+                stat=0;
+                break;
+            }
+        }
+        if (stat) addpcv(&pcv,pcvs);
+    }
+    if (stat&&(fread(id,1,16,fp)!=16||strncmp(id,PCVSNAPID,16))) stat=0;
+    fclose(fp);
+    
+    if (!stat) {
+        trace(2,"pcv snapshot read error: %s\n",file);
+        if (pcvs->n>n0) pcvs->n=n0;
+    }
+    return stat;
+}
+/* index antenna parameters ----------------------------------------------------
+* build index of antenna parameters: satellite antennas sorted by satellite
+* and start of valid time (stable in file order)
+*-----------------------------------------------------------------------------*/
+static void indexpcv(pcvs_t *pcvs)
+{
+    pcv_t *pcv;
+    int i,j,k,sat,cnt[MAXSAT+1]={0};
+    
+    trace(3,"indexpcv: n=%d\n",pcvs->n);
+    
+    free(pcvs->sidx);
+    pcvs->sidx=NULL; pcvs->nidx=0;
+    memset(pcvs->satp,0,sizeof(pcvs->satp));
+    
+    if (pcvs->n<=0) return;
+    
+    if (!(pcvs->sidx=(int *)malloc(sizeof(int)*pcvs->n))) {
+        trace(1,"indexpcv: memory allocation error\n");
+        return;
+    }
+    /* satellite antennas by counting sort and insertion sort */
+    for (i=0;i<pcvs->n;i++) {
+        sat=pcvs->pcv[i].sat;
+        if (sat>0&&sat<=MAXSAT) cnt[sat]++;
+    }
+    for (i=0;i<MAXSAT;i++) pcvs->satp[i+1]=pcvs->satp[i]+cnt[i+1];
+    for (i=0;i<MAXSAT;i++) cnt[i+1]=pcvs->satp[i];
+    for (i=0;i<pcvs->n;i++) {
+        sat=pcvs->pcv[i].sat;
+        if (sat<=0||sat>MAXSAT) continue;
+        pcv=pcvs->pcv+i;
+        for (j=cnt[sat]++;j>pcvs->satp[sat-1];j--) {
+            k=pcvs->sidx[j-1];
+            if (timediff(pcvs->pcv[k].ts,pcv->ts)<=0.0) break;
+            pcvs->sidx[j]=k;
+        }
+        pcvs->sidx[j]=i;
+    }
+    pcvs->nidx=pcvs->n;
+}
 /* read antenna parameters ------------------------------------------------------
 * read antenna parameters
 * args   : char   *file       I   antenna parameter file (antex)
@@ -2120,19 +2929,30 @@ static int readantex(const char *file, pcvs_t *pcvs)
 *          file except for antex is recognized ngs antenna parameters
 *          see reference [3]
 *          only support non-azimuth-depedent parameters
+*          if enabled by pcvsetsnap(), antex file is cached to the snapshot
+*          file <file>.bin, which is read instead of antex file if the size
+*          and modified time are not changed
 *-----------------------------------------------------------------------------*/
 extern int readpcv(const char *file, pcvs_t *pcvs)
 {
     pcv_t *pcv;
-    char *ext;
-    int i,stat;
+    double src[2];
+    char *ext,snap[1024];
+    int i,n0=pcvs->n,stat;
     
     trace(3,"readpcv: file=%s\n",file);
     
     if (!(ext=strrchr(file,'.'))) ext="";
     
     if (!strcmp(ext,".atx")||!strcmp(ext,".ATX")) {
-        stat=readantex(file,pcvs);
+        sprintf(snap,"%.1019s.bin",file);
+        if (!pcvsnap||!filestat(file,src)) {
+            stat=readantex(file,pcvs);
+        }
+        else if (!(stat=readpcvsnap(snap,src,pcvs))&&
+                 (stat=readantex(file,pcvs))) {
+            savepcvsnap(snap,src,pcvs,n0);
+        }
     }
     else {
         stat=readngspcv(file,pcvs);
@@ -2143,6 +2963,7 @@ extern int readpcv(const char *file, pcvs_t *pcvs)
               pcv->sat,pcv->type,pcv->code,pcv->off[0][0],pcv->off[0][1],
               pcv->off[0][2],pcv->off[1][0],pcv->off[1][1],pcv->off[1][2]);
     }
+    indexpcv(pcvs);
     return stat;
 }
 /* search antenna parameter ----------------------------------------------------
@@ -2152,16 +2973,35 @@ extern int readpcv(const char *file, pcvs_t *pcvs)
 *          gtime_t time       I   time to search parameters
 *          pcvs_t *pcvs       IO  antenna parameters
 * return : antenna parameter (NULL: no antenna)
+* notes  : index built by readpcv() is used to search satellite antenna if
+*          valid. the first valid one in file order is returned in any case.
 *-----------------------------------------------------------------------------*/
 extern pcv_t *searchpcv(int sat, const char *type, gtime_t time,
                         const pcvs_t *pcvs)
 {
-    pcv_t *pcv;
+    pcv_t *pcv,*pcv_s=NULL;
     char buff[MAXANT],*types[2],*p;
-    int i,j,n=0;
+    int i,j,k,n=0;
     
     trace(3,"searchpcv: sat=%2d type=%s\n",sat,type);
     
+    if (sat&&pcvs->nidx==pcvs->n&&pcvs->sidx) {
+        if (sat<=0||sat>MAXSAT) return NULL;
+        
+        /* binary search of antennas with start of valid time <= time */
+        for (i=pcvs->satp[sat-1],j=pcvs->satp[sat];i<j;) {
+            k=(i+j)/2;
+            pcv=pcvs->pcv+pcvs->sidx[k];
+            if (pcv->ts.time==0||timediff(pcv->ts,time)<=0.0) i=k+1; else j=k;
+        }
+        /* first one in file order valid at the time */
+        for (k=pcvs->satp[sat-1];k<i;k++) {
+            pcv=pcvs->pcv+pcvs->sidx[k];
+            if (pcv->te.time!=0&&timediff(pcv->te,time)<0.0) continue;
+            if (!pcv_s||pcv<pcv_s) pcv_s=pcv;
+        }
+        return pcv_s;
+    }
     if (sat) { /* search satellite antenna */
         for (i=0;i<pcvs->n;i++) {
             pcv=pcvs->pcv+i;
@@ -2193,6 +3033,15 @@ extern pcv_t *searchpcv(int sat, const char *type, gtime_t time,
     }
     return NULL;
 }
+/* free antenna parameters ---------------------------------------------------*/
+extern void freepcv(pcvs_t *pcvs)
+{
+    trace(3,"freepcv:\n");
+    
+    free(pcvs->pcv); pcvs->pcv=NULL; pcvs->n=pcvs->nmax=0;
+    free(pcvs->sidx); pcvs->sidx=NULL;
+    pcvs->nidx=0;
+}
 /* read station positions ------------------------------------------------------
 * read positions from station position file
 * args   : char  *file      I   station position file containing
@@ -2300,7 +3149,7 @@ extern int readerp(const char *file, erp_t *erp)
     
     trace(3,"readerp: file=%s\n",file);
     
-    if (!(fp=fopen(file,"r"))) {
+    if (!(fp=uncfopen(file,NULL))) {
         trace(2,"erp file open error: file=%s\n",file);
         return 0;
     }
@@ -2690,26 +3539,70 @@ extern void freenav(nav_t *nav, int opt)
 /* debug trace functions -----------------------------------------------------*/
 #ifdef TRACE
 
+#define TRACESLOT   256                 /* size of async trace slot (bytes) */
+#define TRACERING   8192                /* number of async trace slots (2^n) */
+
+#ifdef WIN32
+#define CASUINT(p,o,n) \
+    (InterlockedCompareExchange((volatile LONG *)(p),(LONG)(n),(LONG)(o))==(LONG)(o))
+#define MEMBARRIER() MemoryBarrier()
+#else
+#define CASUINT(p,o,n) __sync_bool_compare_and_swap(p,o,n)
+#define MEMBARRIER() __sync_synchronize()
+#endif
+
+typedef struct {                        /* async trace slot type */
+    volatile unsigned int seq;          /* sequence number */
+    int len;                            /* length of message */
+    char msg[TRACESLOT-8];              /* message */
+} traceslot_t;
+
+int tracelvl=1;                 /* max level of trace output */
 static FILE *fp_trace=NULL;     /* file pointer of trace */
 static char file_trace[1024];   /* trace file */
 static int level_trace=0;       /* level of trace */
 static unsigned int tick_trace=0; /* tick time at traceopen (ms) */
+static unsigned int tick_swap=0; /* tick time of next trace file swap (ms) */
 static gtime_t time_trace={0};  /* time at traceopen */
 static lock_t lock_trace;       /* lock for trace */
+static int async_trace=0;       /* async trace (0:off,1:on) */
+static traceslot_t *ring_trace=NULL; /* ring buffer of async trace */
+static volatile unsigned int head_trace=0; /* write sequence of ring buffer */
+static unsigned int tail_trace=0; /* read sequence of ring buffer */
+static volatile int state_trace=0; /* state of trace thread (0:stop,1:run) */
+static thread_t thread_trace;   /* trace thread */
 
+/* set tick time of next trace file swap -------------------------------------*/
+static void settickswap(gtime_t time)
+{
+    double tow=time2gpst(time,NULL);
+    
+    tick_swap=tickget()+(unsigned int)((INT_SWAP_TRAC-fmod(tow,INT_SWAP_TRAC))*1E3);
+}
+/* update max level of trace output ------------------------------------------*/
+static void setlevel(void)
+{
+    tracelvl=fp_trace&&level_trace>1?level_trace:1;
+}
 static void traceswap(void)
 {
-    gtime_t time=utc2gpst(timeget());
+    gtime_t time;
     char path[1024];
     
+    if ((int)(tickget()-tick_swap)<0) return;
+    
+    time=utc2gpst(timeget());
+    
     lock(&lock_trace);
     
     if ((int)(time2gpst(time      ,NULL)/INT_SWAP_TRAC)==
         (int)(time2gpst(time_trace,NULL)/INT_SWAP_TRAC)) {
+        settickswap(time);
         unlock(&lock_trace);
         return;
     }
     time_trace=time;
+    settickswap(time);
     
     if (!reppath(file_trace,path,time,"","")) {
         unlock(&lock_trace);
@@ -2722,6 +3615,123 @@ static void traceswap(void)
     }
     unlock(&lock_trace);
 }
+/* write ready slots of ring buffer to trace file ----------------------------*/
+static int tracedrain(void)
+{
+    traceslot_t *slot;
+    int n=0;
+    
+    for (;;n++) {
+        slot=ring_trace+(tail_trace&(TRACERING-1));
+        if (slot->seq!=tail_trace+1) break;
+        MEMBARRIER();
+        traceswap();
+        fwrite(slot->msg,1,slot->len,fp_trace);
+        MEMBARRIER();
+        slot->seq=tail_trace+TRACERING;
+        tail_trace++;
+    }
+    if (n>0) fflush(fp_trace);
+    return n;
+}
+/* async trace thread --------------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI tracethread(void *arg)
+#else
+static void *tracethread(void *arg)
+#endif
+{
+    (void)arg;
+    
+    while (state_trace) {
+        if (!tracedrain()) sleepms(10);
+    }
+    tracedrain();
+    return 0;
+}
+/* start/stop async trace thread ---------------------------------------------*/
+static void startasync(void)
+{
+    unsigned int i;
+    
+    if (!(ring_trace=(traceslot_t *)malloc(sizeof(traceslot_t)*TRACERING))) {
+        return;
+    }
+    for (i=0;i<TRACERING;i++) ring_trace[i].seq=i;
+    head_trace=tail_trace=0;
+    state_trace=1;
+#ifdef WIN32
+    if (!(thread_trace=CreateThread(NULL,0,tracethread,NULL,0,NULL))) {
+#else
+    if (pthread_create(&thread_trace,NULL,tracethread,NULL)) {
+#endif
+        free(ring_trace); ring_trace=NULL;
+        state_trace=0;
+    }
+}
+static void stopasync(void)
+{
+    if (!ring_trace) return;
+    state_trace=0;
+#ifdef WIN32
+    WaitForSingleObject(thread_trace,INFINITE);
+    CloseHandle(thread_trace);
+#else
+    pthread_join(thread_trace,NULL);
+#endif
+    free(ring_trace); ring_trace=NULL;
+}
+/* output trace message ------------------------------------------------------*/
+static void traceout(const char *msg, int len)
+{
+    traceslot_t *slot;
+    unsigned int pos;
+    int n;
+    
+    if (!ring_trace) {
+        traceswap();
+        fwrite(msg,1,len,fp_trace);
+        return;
+    }
+    /* put message to ring buffer with lock-free multi-producer queue */
+    for (;len>0;msg+=n,len-=n) {
+        n=len<(int)sizeof(slot->msg)?len:(int)sizeof(slot->msg);
+        for (;;) {
+            pos=head_trace;
+            slot=ring_trace+(pos&(TRACERING-1));
+            if (slot->seq==pos) {
+                if (CASUINT(&head_trace,pos,pos+1)) break;
+            }
+            else if ((int)(slot->seq-pos)<0) sleepms(1); /* ring full */
+        }
+        memcpy(slot->msg,msg,n);
+        slot->len=n;
+        MEMBARRIER();
+        slot->seq=pos+1;
+    }
+}
+static void traceprintf(const char *format, ...)
+{
+    va_list ap;
+    char buff[4096];
+    int n;
+    
+    va_start(ap,format); n=vsnprintf(buff,sizeof(buff),format,ap); va_end(ap);
+    if (n<0) return;
+    traceout(buff,n<(int)sizeof(buff)?n:(int)sizeof(buff)-1);
+}
+/* enable async debug trace ----------------------------------------------------
+* write debug trace by a background thread through a lock-free ring buffer
+* args   : int    ena       I   async trace (0:off,1:on)
+* return : none
+* notes  : call before traceopen(). with async trace, the trace functions only
+*          copy formatted messages to the ring buffer and the trace file is
+*          written and flushed by the background thread.
+*-----------------------------------------------------------------------------*/
+extern void traceasync(int ena)
+{
+    async_trace=ena;
+}
 extern void traceopen(const char *file)
 {
     gtime_t time=utc2gpst(timeget());
@@ -2732,46 +3742,69 @@ extern void traceopen(const char *file)
     strcpy(file_trace,file);
     tick_trace=tickget();
     time_trace=time;
+    settickswap(time);
     initlock(&lock_trace);
+    if (async_trace) startasync();
+    setlevel();
 }
 extern void traceclose(void)
 {
+    stopasync();
     if (fp_trace&&fp_trace!=stderr) fclose(fp_trace);
     fp_trace=NULL;
     file_trace[0]='\0';
+    setlevel();
 }
 extern void tracelevel(int level)
 {
     level_trace=level;
+    setlevel();
 }
-extern void trace(int level, const char *format, ...)
+extern void (trace)(int level, const char *format, ...)
 {
     va_list ap;
+    char buff[4096];
+    int n;
     
     /* print error message to stderr */
     if (level<=1) {
         va_start(ap,format); vfprintf(stderr,format,ap); va_end(ap);
     }
     if (!fp_trace||level>level_trace) return;
-    traceswap();
-    fprintf(fp_trace,"%d ",level);
-    va_start(ap,format); vfprintf(fp_trace,format,ap); va_end(ap);
-    fflush(fp_trace);
+    n=sprintf(buff,"%d ",level);
+    va_start(ap,format); n+=vsnprintf(buff+n,sizeof(buff)-n,format,ap); va_end(ap);
+    traceout(buff,n<(int)sizeof(buff)?n:(int)sizeof(buff)-1);
+    
+    /* flush errors and warnings at once in sync mode */
+    if (level<=2&&!ring_trace) fflush(fp_trace);
 }
-extern void tracet(int level, const char *format, ...)
+extern void (tracet)(int level, const char *format, ...)
 {
     va_list ap;
+    char buff[4096];
+    int n;
     
     if (!fp_trace||level>level_trace) return;
-    traceswap();
-    fprintf(fp_trace,"%d %9.3f: ",level,(tickget()-tick_trace)/1000.0);
-    va_start(ap,format); vfprintf(fp_trace,format,ap); va_end(ap);
-    fflush(fp_trace);
+    n=sprintf(buff,"%d %9.3f: ",level,(tickget()-tick_trace)/1000.0);
+    va_start(ap,format); n+=vsnprintf(buff+n,sizeof(buff)-n,format,ap); va_end(ap);
+    traceout(buff,n<(int)sizeof(buff)?n:(int)sizeof(buff)-1);
 }
 extern void tracemat(int level, const double *A, int n, int m, int p, int q)
 {
+    char buff[4096];
+    int i,j,len;
+    
     if (!fp_trace||level>level_trace) return;
-    matfprint(A,n,m,p,q,fp_trace); fflush(fp_trace);
+    for (i=0;i<n;i++) {
+        for (j=len=0;j<m;j++) {
+            if (len>(int)sizeof(buff)-64) {
+                traceout(buff,len); len=0;
+            }
+            len+=sprintf(buff+len," %*.*f",p,q,A[i+j*n]);
+        }
+        buff[len++]='\n';
+        traceout(buff,len);
+    }
 }
 extern void traceobs(int level, const obsd_t *obs, int n)
 {
@@ -2782,12 +3815,11 @@ extern void traceobs(int level, const obsd_t *obs, int n)
     for (i=0;i<n;i++) {
         time2str(obs[i].time,str,3);
         satno2id(obs[i].sat,id);
-        fprintf(fp_trace," (%2d) %s %-3s rcv%d %13.3f %13.3f %13.3f %13.3f %d %d %d %d %3.1f %3.1f\n",
+        traceprintf(" (%2d) %s %-3s rcv%d %13.3f %13.3f %13.3f %13.3f %d %d %d %d %3.1f %3.1f\n",
               i+1,str,id,obs[i].rcv,obs[i].L[0],obs[i].L[1],obs[i].P[0],
               obs[i].P[1],obs[i].LLI[0],obs[i].LLI[1],obs[i].code[0],
               obs[i].code[1],obs[i].SNR[0]*0.25,obs[i].SNR[1]*0.25);
     }
-    fflush(fp_trace);
 }
 extern void tracenav(int level, const nav_t *nav)
 {
@@ -2799,14 +3831,14 @@ extern void tracenav(int level, const nav_t *nav)
         time2str(nav->eph[i].toe,s1,0);
         time2str(nav->eph[i].ttr,s2,0);
         satno2id(nav->eph[i].sat,id);
-        fprintf(fp_trace,"(%3d) %-3s : %s %s %3d %3d %02x\n",i+1,
+        traceprintf("(%3d) %-3s : %s %s %3d %3d %02x\n",i+1,
                 id,s1,s2,nav->eph[i].iode,nav->eph[i].iodc,nav->eph[i].svh);
     }
-    fprintf(fp_trace,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gps[0],
+    traceprintf("(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gps[0],
             nav->ion_gps[1],nav->ion_gps[2],nav->ion_gps[3]);
-    fprintf(fp_trace,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gps[4],
+    traceprintf("(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gps[4],
             nav->ion_gps[5],nav->ion_gps[6],nav->ion_gps[7]);
-    fprintf(fp_trace,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gal[0],
+    traceprintf("(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gal[0],
             nav->ion_gal[1],nav->ion_gal[2],nav->ion_gal[3]);
 }
 extern void tracegnav(int level, const nav_t *nav)
@@ -2819,7 +3851,7 @@ extern void tracegnav(int level, const nav_t *nav)
         time2str(nav->geph[i].toe,s1,0);
         time2str(nav->geph[i].tof,s2,0);
         satno2id(nav->geph[i].sat,id);
-        fprintf(fp_trace,"(%3d) %-3s : %s %s %2d %2d %8.3f\n",i+1,
+        traceprintf("(%3d) %-3s : %s %s %2d %2d %8.3f\n",i+1,
                 id,s1,s2,nav->geph[i].frq,nav->geph[i].svh,nav->geph[i].taun*1E6);
     }
 }
@@ -2833,7 +3865,7 @@ extern void tracehnav(int level, const nav_t *nav)
         time2str(nav->seph[i].t0,s1,0);
         time2str(nav->seph[i].tof,s2,0);
         satno2id(nav->seph[i].sat,id);
-        fprintf(fp_trace,"(%3d) %-3s : %s %s %2d %2d\n",i+1,
+        traceprintf("(%3d) %-3s : %s %s %2d %2d\n",i+1,
                 id,s1,s2,nav->seph[i].svh,nav->seph[i].sva);
     }
 }
@@ -2848,7 +3880,7 @@ extern void tracepeph(int level, const nav_t *nav)
         time2str(nav->peph[i].time,s,0);
         for (j=0;j<MAXSAT;j++) {
             satno2id(j+1,id);
-            fprintf(fp_trace,"%-3s %d %-3s %13.3f %13.3f %13.3f %13.3f %6.3f %6.3f %6.3f %6.3f\n",
+            traceprintf("%-3s %d %-3s %13.3f %13.3f %13.3f %13.3f %6.3f %6.3f %6.3f %6.3f\n",
                     s,nav->peph[i].index,id,
                     nav->peph[i].pos[j][0],nav->peph[i].pos[j][1],
                     nav->peph[i].pos[j][2],nav->peph[i].pos[j][3]*1E9,
@@ -2868,7 +3900,7 @@ extern void tracepclk(int level, const nav_t *nav)
         time2str(nav->pclk[i].time,s,0);
         for (j=0;j<MAXSAT;j++) {
             satno2id(j+1,id);
-            fprintf(fp_trace,"%-3s %d %-3s %13.3f %6.3f\n",
+            traceprintf("%-3s %d %-3s %13.3f %6.3f\n",
                     s,nav->pclk[i].index,id,
                     nav->pclk[i].clk[j][0]*1E9,nav->pclk[i].std[j][0]*1E9);
         }
@@ -2876,17 +3908,26 @@ extern void tracepclk(int level, const nav_t *nav)
 }
 extern void traceb(int level, const unsigned char *p, int n)
 {
-    int i;
+    char buff[4096];
+    int i,len=0;
+    
     if (!fp_trace||level>level_trace) return;
-    for (i=0;i<n;i++) fprintf(fp_trace,"%02X%s",*p++,i%8==7?" ":"");
-    fprintf(fp_trace,"\n");
+    for (i=0;i<n;i++) {
+        if (len>(int)sizeof(buff)-8) {
+            traceout(buff,len); len=0;
+        }
+        len+=sprintf(buff+len,"%02X%s",*p++,i%8==7?" ":"");
+    }
+    buff[len++]='\n';
+    traceout(buff,len);
 }
 #else
+extern void traceasync(int ena) {(void)ena;}
 extern void traceopen(const char *file) {}
 extern void traceclose(void) {}
 extern void tracelevel(int level) {}
-extern void trace   (int level, const char *format, ...) {}
-extern void tracet  (int level, const char *format, ...) {}
+extern void (trace) (int level, const char *format, ...) {}
+extern void (tracet)(int level, const char *format, ...) {}
 extern void tracemat(int level, const double *A, int n, int m, int p, int q) {}
 extern void traceobs(int level, const obsd_t *obs, int n) {}
 extern void tracenav(int level, const nav_t *nav) {}
@@ -2898,6 +3939,197 @@ extern void traceb  (int level, const unsigned char *p, int n) {}
 
 #endif /* TRACE */
 
+/* profiler functions --------------------------------------------------------*/
+#ifdef PROFILE
+
+#define MAXPROFNODE 256                 /* max number of profile nodes */
+#define MAXPROFDEP  16                  /* max depth of profile scopes */
+#define NPROFBIN    160                 /* number of profile histogram bins */
+
+#ifdef WIN32
+#define ATOMADD(p,n) InterlockedExchangeAdd64((volatile LONG64 *)(p),(LONG64)(n))
+#else
+#define ATOMADD(p,n) __sync_fetch_and_add(p,n)
+#endif
+
+typedef struct {                        /* profile node type */
+    int id,parent,depth;                /* scope id, parent node and depth */
+    volatile int child[NPROF];          /* child nodes (0:none) */
+    unsigned long long n;               /* number of calls */
+    unsigned long long t;               /* total time (ns) */
+    unsigned long long nalloc;          /* number of matrix allocations */
+    unsigned long long hist[NPROFBIN];  /* histogram of time */
+} profnode_t;
+
+static const char *name_prof[NPROF]={   /* profile scope names */
+    "total","readrnx","readsp3","pntpos","rtkpos","pppos","satposs",
+    "udstate","zdres","ddres","res_ppp","filter","lambda"
+};
+int profena=0;                  /* profiler enabled flag */
+static profnode_t node_prof[MAXPROFNODE]; /* profile nodes (0:root) */
+static int nnode_prof=1;        /* number of profile nodes */
+static unsigned long long t_prof=0; /* time at profenable (ns) */
+static lock_t lock_prof;        /* lock for profile nodes */
+static THREADLOCAL int n_prof=0; /* number of open scopes */
+static THREADLOCAL int stk_prof[MAXPROFDEP]; /* nodes of open scopes */
+static THREADLOCAL unsigned long long t0_prof[MAXPROFDEP]; /* start time (ns) */
+static THREADLOCAL unsigned int a0_prof[MAXPROFDEP]; /* allocations at start */
+
+/* current time in ns --------------------------------------------------------*/
+static unsigned long long profns(void)
+{
+#ifdef WIN32
+    LARGE_INTEGER f,c;
+    
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (unsigned long long)(c.QuadPart*(1E9/f.QuadPart));
+#else
+    struct timespec tp={0};
+    
+    clock_gettime(CLOCK_MONOTONIC,&tp);
+    return (unsigned long long)tp.tv_sec*1000000000u+tp.tv_nsec;
+#endif
+}
+/* histogram bin of time (4 bins per octave) ---------------------------------*/
+static int profbin(unsigned long long t)
+{
+    double m;
+    int e,i;
+    
+    if (t<1) return 0;
+    m=frexp((double)t,&e);
+    i=(e-1)*4+(int)((m-0.5)*8.0);
+    return i<NPROFBIN?i:NPROFBIN-1;
+}
+/* upper bound of histogram bin (ns) -----------------------------------------*/
+static double profbinmax(int i)
+{
+    return ldexp(1.0+(i%4+1)/4.0,i/4);
+}
+/* get or add child node -----------------------------------------------------*/
+static int profchild(int node, int id)
+{
+    int c;
+    
+    if ((c=node_prof[node].child[id])) return c;
+    
+    lock(&lock_prof);
+    if (!(c=node_prof[node].child[id])&&nnode_prof<MAXPROFNODE) {
+        c=nnode_prof;
+        node_prof[c].id=id;
+        node_prof[c].parent=node;
+        node_prof[c].depth=node_prof[node].depth+1;
+        node_prof[node].child[id]=c;
+        nnode_prof++;
+    }
+    unlock(&lock_prof);
+    return c;
+}
+/* print profile node and children -------------------------------------------*/
+static void profprint(FILE *fp, int node)
+{
+    profnode_t *p=node_prof+node;
+    double p99=0.0;
+    unsigned long long n;
+    int i,d=p->depth*2-2;
+    
+    if (node>0) {
+        for (i=0,n=0;i<NPROFBIN;i++) {
+            if ((n+=p->hist[i])>=p->n*0.99) break;
+        }
+        p99=i<NPROFBIN?profbinmax(i):0.0;
+        fprintf(fp,"%% %*s%-*s %10.0f %11.3f %10.3f %10.3f %10.1f\n",
+                d,"",22-d,name_prof[p->id],(double)p->n,
+                p->t*1E-6,p->n?p->t*1E-3/p->n:0.0,p99*1E-3,
+                p->n?(double)p->nalloc/p->n:0.0);
+    }
+    for (i=0;i<NPROF;i++) {
+        if (p->child[i]) profprint(fp,p->child[i]);
+    }
+}
+/* enable profiler -------------------------------------------------------------
+* enable or disable the profiler of positioning stages
+* args   : int    ena       I   profiler (0:off,1:on)
+* return : none
+* notes  : enabling the profiler clears the profile records. scopes are marked
+*          by PROFBEG()/PROFEND() macros with PROF_??? ids. each scope is
+*          recorded in a call tree keyed by the enclosing scopes, so satposs()
+*          under pntpos() and under rtkpos() are reported separately.
+*          profiler functions are available only with -DPROFILE. without it,
+*          PROFBEG()/PROFEND() are compiled to nothing.
+*-----------------------------------------------------------------------------*/
+extern void profenable(int ena)
+{
+    if (ena&&!profena) {
+        initlock(&lock_prof);
+        memset(node_prof,0,sizeof(node_prof));
+        nnode_prof=1;
+        t_prof=profns();
+    }
+    profena=ena;
+}
+/* begin/end profile scope -----------------------------------------------------
+* begin or end the profile scope of a positioning stage
+* args   : int    id        I   scope id (PROF_???)
+* return : none
+* notes  : use PROFBEG()/PROFEND() macros instead of direct calls
+*-----------------------------------------------------------------------------*/
+extern void profbeg(int id)
+{
+    int n=n_prof++;
+    
+    if (n>=MAXPROFDEP) return;
+    stk_prof[n]=profchild(n>0?stk_prof[n-1]:0,id);
+    a0_prof[n]=nalloc_prof;
+    t0_prof[n]=profns();
+}
+extern void profend(int id)
+{
+    profnode_t *p;
+    unsigned long long t=profns();
+    int n=n_prof-1;
+    
+    if (n<0) return;
+    if (n<MAXPROFDEP&&stk_prof[n]&&node_prof[stk_prof[n]].id!=id) {
+        return; /* unbalanced scope */
+    }
+    n_prof=n;
+    if (n>=MAXPROFDEP||!stk_prof[n]) return;
+    p=node_prof+stk_prof[n];
+    t-=t0_prof[n];
+    ATOMADD(&p->n,1);
+    ATOMADD(&p->t,t);
+    ATOMADD(&p->nalloc,nalloc_prof-a0_prof[n]);
+    ATOMADD(p->hist+profbin(t),1);
+}
+/* output profile report -------------------------------------------------------
+* output profile report of positioning stages
+* args   : FILE   *fp       I   output file pointer
+* return : none
+* notes  : the report lists the scopes in a call tree with number of calls,
+*          total time (ms), mean and 99 percentile time (us) and mean number
+*          of matrix allocations by mat(), imat() and zeros() per call.
+*          the 99 percentile is the upper bound of a histogram bin with 4 bins
+*          per octave (resolution 25%). the lines start with '%'.
+*-----------------------------------------------------------------------------*/
+extern void profreport(FILE *fp)
+{
+    if (!profena) return;
+    
+    fprintf(fp,"%% profile report (elapsed %.3f s)\n",(profns()-t_prof)*1E-9);
+    fprintf(fp,"%% %-22s %10s %11s %10s %10s %10s\n","scope","count",
+            "total(ms)","mean(us)","p99(us)","allocs");
+    profprint(fp,0);
+}
+#else
+extern void profenable(int ena) {(void)ena;}
+extern void profbeg(int id) {(void)id;}
+extern void profend(int id) {(void)id;}
+extern void profreport(FILE *fp) {(void)fp;}
+
+#endif /* PROFILE */
+
 /* execute command -------------------------------------------------------------
 * execute command line by operating system shell
 * args   : char   *cmd      I   command line
@@ -3707,7 +4939,9 @@ extern void csmooth(obs_t *obs, int ns)
 *          char   *uncfile  O   uncompressed file
 * return : status (-1:error,0:not compressed file,1:uncompress completed)
 * note   : creates uncompressed file in tempolary directory
-*          gzip and crx2rnx commands have to be installed in commands path
+*          gzip, compress and hatanaka-compressed files are uncompressed in
+*          process by uncompfile(). tar command has to be installed in commands
+*          path to extract tar file
 *-----------------------------------------------------------------------------*/
 extern int uncompress(const char *file, char *uncfile)
 {
@@ -3725,10 +4959,8 @@ extern int uncompress(const char *file, char *uncfile)
         !strcmp(p,".zip")||!strcmp(p,".ZIP")) {
         
         strcpy(uncfile,tmpfile); uncfile[p-tmpfile]='\0';
-        sprintf(cmd,"gzip -f -d -c \"%s\" > \"%s\"",tmpfile,uncfile);
         
-        if (execcmd(cmd)) {
-            remove(uncfile);
+        if (!uncompfile(tmpfile,uncfile,1,0)) {
             return -1;
         }
         strcpy(tmpfile,uncfile);
@@ -3759,15 +4991,17 @@ extern int uncompress(const char *file, char *uncfile)
         if (stat) remove(tmpfile);
         stat=1;
     }
-    /* extract hatanaka-compressed file by cnx2rnx */
-    else if ((p=strrchr(tmpfile,'.'))&&strlen(p)>3&&(*(p+3)=='d'||*(p+3)=='D')) {
+    /* uncompact hatanaka-compressed file */
+    else if ((p=strrchr(tmpfile,'.'))&&
+             ((strlen(p)>3&&(*(p+3)=='d'||*(p+3)=='D'))||
+              !strcmp(p,".crx")||!strcmp(p,".CRX"))) {
         
         strcpy(uncfile,tmpfile);
-        uncfile[p-tmpfile+3]=*(p+3)=='D'?'O':'o';
-        sprintf(cmd,"crx2rnx < \"%s\" > \"%s\"",tmpfile,uncfile);
+        if      (!strcmp(p,".crx")) strcpy(uncfile+(p-tmpfile),".rnx");
+        else if (!strcmp(p,".CRX")) strcpy(uncfile+(p-tmpfile),".RNX");
+        else uncfile[p-tmpfile+3]=*(p+3)=='D'?'O':'o';
         
-        if (execcmd(cmd)) {
-            remove(uncfile);
+        if (!uncompfile(tmpfile,uncfile,0,1)) {
             if (stat) remove(tmpfile);
             return -1;
         }
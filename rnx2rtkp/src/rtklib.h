@@ -230,8 +230,10 @@ extern "C" {
 #define MAXANT      64                  /* max length of station name/antenna type */
 #define MAXSOLBUF   256                 /* max number of solution buffer */
 #define MAXOBSBUF   128                 /* max number of observation data buffer */
+#define NLATWIN     1024                /* max latency samples in RTK server */
 #define MAXNRPOS    16                  /* max number of reference positions */
 #define MAXLEAPS    64                  /* max number of leap seconds table */
+#define MAXCHEBDEG  24                  /* max degree of chebyshev polynomial */
 
 #define RNX2VER     2.10                /* RINEX ver.2 default output version */
 #define RNX3VER     3.00                /* RINEX ver.3 default output version */
@@ -411,6 +413,13 @@ extern "C" {
 #define STR_MODE_W  0x2                 /* stream mode: write */
 #define STR_MODE_RW 0x3                 /* stream mode: read/write */
 
+#define LATSTG_DEC  0                   /* latency stage: input to decoded */
+#define LATSTG_QUE  1                   /* latency stage: decoded to process */
+#define LATSTG_POS  2                   /* latency stage: processing */
+#define LATSTG_OUT  3                   /* latency stage: processed to output */
+#define LATSTG_ALL  4                   /* latency stage: input to output */
+#define NLATSTG     5                   /* number of latency stages */
+
 #define GEOID_EMBEDDED    0             /* geoid model: embedded geoid */
 #define GEOID_EGM96_M150  1             /* geoid model: EGM96 15x15" */
 #define GEOID_EGM2008_M25 2             /* geoid model: EGM2008 2.5x2.5" */
@@ -463,6 +472,16 @@ extern "C" {
 #define initlock(f) InitializeCriticalSection(f)
 #define lock(f)     EnterCriticalSection(f)
 #define unlock(f)   LeaveCriticalSection(f)
+#define cond_t      CONDITION_VARIABLE
+#define initcond(f) InitializeConditionVariable(f)
+#define signalcond(f) WakeConditionVariable(f)
+#define broadcastcond(f) WakeAllConditionVariable(f)
+#define rwlock_t    SRWLOCK
+#define initrwlock(f) InitializeSRWLock(f)
+#define rdlock(f)   AcquireSRWLockShared(f)
+#define rdunlock(f) ReleaseSRWLockShared(f)
+#define wrlock(f)   AcquireSRWLockExclusive(f)
+#define wrunlock(f) ReleaseSRWLockExclusive(f)
 #define FILEPATHSEP '\\'
 #else
 #define thread_t    pthread_t
@@ -470,8 +489,23 @@ extern "C" {
 #define initlock(f) pthread_mutex_init(f,NULL)
 #define lock(f)     pthread_mutex_lock(f)
 #define unlock(f)   pthread_mutex_unlock(f)
+#define cond_t      pthread_cond_t
+#define initcond(f) pthread_cond_init(f,NULL)
+#define signalcond(f) pthread_cond_signal(f)
+#define broadcastcond(f) pthread_cond_broadcast(f)
+#define rwlock_t    pthread_rwlock_t
+#define initrwlock(f) pthread_rwlock_init(f,NULL)
+#define rdlock(f)   pthread_rwlock_rdlock(f)
+#define rdunlock(f) pthread_rwlock_unlock(f)
+#define wrlock(f)   pthread_rwlock_wrlock(f)
+#define wrunlock(f) pthread_rwlock_unlock(f)
 #define FILEPATHSEP '/'
 #endif
+#ifdef _MSC_VER
+#define THREADLOCAL __declspec(thread) /* thread local storage */
+#else
+#define THREADLOCAL __thread
+#endif
 
 /* type definitions ----------------------------------------------------------*/
 
@@ -522,6 +556,9 @@ typedef struct {        /* antenna parameter type */
 typedef struct {        /* antenna parameters type */
     int n,nmax;         /* number of data/allocated */
     pcv_t *pcv;         /* antenna parameters data */
+    int nidx;           /* number of indexed data (index valid if nidx==n) */
+    int *sidx;          /* satellite antennas sorted by sat and valid start */
+    int satp[MAXSAT+1]; /* start of satellite antennas of sat in sidx */
 } pcvs_t;
 
 typedef struct {        /* almanac type */
@@ -940,6 +977,23 @@ typedef struct {        /* rinex control struct type */
     char   opt[256];    /* rinex dependent options */
 } rnxctr_t;
 
+typedef struct {        /* rinex obs stream type */
+    gtime_t ts,te;      /* observation time start/end (0:no limit) */
+    double tint;        /* observation time interval (s) (0:all) */
+    int    rcv;         /* receiver number */
+    char   opt[256];    /* rinex options */
+    char   **files;     /* rinex obs files */
+    int    nfile;       /* number of rinex obs files */
+    int    ifile;       /* index of next file */
+    FILE   *fp;         /* current file pointer (NULL:closed) */
+    double ver;         /* rinex version of current file */
+    int    tsys;        /* time system of current file */
+    char   tobs[6][MAXOBSTYPE][4]; /* rinex obs types of current file */
+    unsigned char slips[MAXSAT][NFREQ]; /* cycle-slips in screened epochs */
+    obsd_t *data[2];    /* obs data of current and next epoch */
+    int    n[2];        /* number of obs data of current and next epoch */
+} rnxobs_t;
+
 typedef struct {        /* download url type */
     char type[32];      /* data type */
     char path[1024];    /* url path */
@@ -967,6 +1021,19 @@ typedef struct {        /* SNR mask type */
     double mask[NFREQ][9]; /* mask (dBHz) at 5,10,...85 deg */
 } snrmask_t;
 
+typedef struct {        /* pseudorange correction log type */
+    FILE *fp;           /* file pointer of the day */
+    char prefix[1024];  /* file path prefix (<prefix><doy>.csv) */
+    int doy;            /* day of year of the file (0:not opened) */
+    gtime_t ts;         /* output start time (0:all) */
+    char *buff;         /* write buffer */
+    int nb,nbuff;       /* bytes in buffer/buffer size */
+    int tflush;         /* flush interval (ms) (0:no flush thread) */
+    int state;          /* state of flush thread (0:stop,1:running) */
+    thread_t thread;    /* flush thread */
+    lock_t lock;        /* lock flag */
+} pcorlog_t;
+
 typedef struct {        /* processing options type */
     int mode;           /* positioning mode (PMODE_???) */
     int soltype;        /* solution type (0:forward,1:backward,2:combined) */
@@ -1021,6 +1088,11 @@ typedef struct {        /* processing options type */
     int  syncsol;       /* solution sync mode (0:off,1:on) */
     double odisp[2][6*11]; /* ocean tide loading parameters {rov,base} */
     exterr_t exterr;    /* extended receiver error model */
+    int nthread;        /* number of processing threads (0,1:single thread) */
+    double tuwarm;      /* warm-up overlap of processing unit (s) (0:none) */
+    int rnxidx;         /* rinex obs epoch index (0:off,1:on) */
+    int sparseh;        /* sparse design matrix of ppp (0:off,1:on) */
+    pcorlog_t *pcorlog; /* pseudorange correction log (NULL:open per epoch) */
 } prcopt_t;
 
 typedef struct {        /* solution options type */
@@ -1093,6 +1165,45 @@ typedef struct {        /* RINEX options type */
     int nobs[6];        /* number of obs types {GPS,GLO,GAL,QZS,SBS,CMP} */
 } rnxopt_t;
 
+typedef struct {        /* observation simulator options type */
+    int navsys;         /* navigation system */
+    int nfreq;          /* number of frequencies */
+    int ephopt;         /* satellite ephemeris option (EPHOPT_???) */
+    double elmask;      /* elevation mask angle (rad) */
+    double errp;        /* pseudorange noise std at zenith (m) */
+    double errl;        /* carrier-phase noise std at zenith (m) */
+    double errd;        /* doppler noise std at zenith (Hz) */
+    double sliprate;    /* cycle slip rate per satellite (/s) */
+    double outrate;     /* outage rate per satellite (/s) */
+    double outlen;      /* outage length (s) */
+    unsigned int seed;  /* random seed */
+} simopt_t;
+
+typedef struct {        /* observation simulator type */
+    simopt_t opt;       /* simulator options */
+    double rr[3];       /* receiver position (ecef) (m) */
+    double pos[3];      /* receiver position {lat,lon,h} (rad,m) */
+    int rcv;            /* receiver number */
+    unsigned int seed;  /* random number state */
+    gtime_t time;       /* previous epoch time */
+    gtime_t tout[MAXSAT]; /* outage end time */
+    unsigned char lock[MAXSAT]; /* phase lock flag */
+    double amb[MAXSAT][NFREQ]; /* carrier-phase ambiguity (cycle) */
+} simobs_t;
+
+typedef struct {        /* chebyshev compressed ephemeris type */
+    gtime_t ts;         /* start time of segments (gpst) */
+    double span;        /* time span of a segment (s) */
+    int deg;            /* degree of polynomials */
+    int nseg;           /* number of segments per satellite */
+    int ephopt;         /* source ephemeris option (EPHOPT_???) */
+    int n,nmax;         /* number of fitted/allocated segments */
+    int *index;         /* segment index (MAXSAT x nseg) (-1:no segment) */
+    double *coef;       /* coefficients {x,y,z,clk} (m) (4*(deg+1) x n) */
+    float *err;         /* max fit error {pos,clk} (m) (2 x n) */
+    float *var;         /* error variance of source ephemeris (m^2) (n) */
+} cheph_t;
+
 typedef struct {        /* satellite status type */
     unsigned char sys;  /* navigation system */
     unsigned char vs;   /* valid satellite flag single */
@@ -1173,6 +1284,20 @@ typedef struct {        /* receiver raw data control type */
     unsigned char pbuff[255+4+2]; /* RT17: Packet buffer */
 } raw_t;
 
+typedef struct {        /* single-producer single-consumer queue type */
+    unsigned char *buff; /* element buffer */
+    int size;           /* element size (bytes) */
+    unsigned int n;     /* number of elements (power of 2) */
+    volatile unsigned int wp,rp; /* write/read count */
+} spscq_t;
+
+typedef struct {        /* single-producer byte ring buffer type */
+    unsigned char *buff; /* ring buffer */
+    unsigned int n;     /* buffer size (bytes) (power of 2) */
+    volatile unsigned int wp; /* write count (bytes) */
+    volatile unsigned int ws; /* write count reserved by producer (bytes) */
+} ringbuf_t;
+
 typedef struct {        /* stream type */
     int type;           /* type (STR_???) */
     int mode;           /* mode (STR_MODE_?) */
@@ -1185,6 +1310,8 @@ typedef struct {        /* stream type */
     void *port;         /* type dependent port control struct */
     char path[MAXSTRPATH]; /* stream path */
     char msg [MAXSTRMSG];  /* stream message */
+    int efd;            /* event poll descriptor for strwait() (-1:none) */
+    int nfd,fd[2];      /* descriptors registered to event poll */
 } stream_t;
 
 typedef struct {        /* stream converter type */
@@ -1217,6 +1344,33 @@ typedef struct {        /* stream server type */
     lock_t lock;        /* lock flag */
 } strsvr_t;
 
+typedef struct {        /* latency statistics type */
+    unsigned int n;     /* number of samples */
+    float lat[NLATWIN]; /* latency samples of recent epochs (ms) */
+} latstat_t;
+
+typedef struct {        /* RTK server input thread argument type */
+    void *svr;          /* RTK server */
+    int index;          /* input stream index (0:rov,1:base,2:corr) */
+} rtksvrarg_t;
+
+typedef struct {        /* rover of multi-rover RTK server type */
+    int strs[2];        /* stream types {input,solution} */
+    char paths[2][MAXSTRPATH]; /* stream paths {input,solution} */
+    char opt[256];      /* receiver option */
+    int format;         /* input format (STRFMT_???) */
+    rtk_t rtk;          /* RTK control/result struct */
+    raw_t raw;          /* receiver raw control */
+    rtcm_t rtcm;        /* RTCM control */
+    stream_t stream[2]; /* streams {input,solution} */
+    spscq_t obsq;       /* observation data queue to positioning workers */
+    int job;            /* queued to or processed by worker (0:no,1:yes) */
+    unsigned int nobs;  /* number of observation data input */
+    unsigned int nsol;  /* number of solutions output */
+    unsigned int nfcn;  /* update count of glonass fcn set to decoder */
+    int cputime;        /* CPU time (ms) for a processing epoch */
+} rtkrov_t;
+
 typedef struct {        /* RTK server type */
     int state;          /* server state (0:stop,1:running) */
     int cycle;          /* processing cycle (ms) */
@@ -1230,12 +1384,8 @@ typedef struct {        /* RTK server type */
     int nsbs;           /* number of sbas message */
     int nsol;           /* number of solution buffer */
     rtk_t rtk;          /* RTK control/result struct */
-    int nb [3];         /* bytes in input buffers {rov,base} */
-    int nsb[2];         /* bytes in soulution buffers */
-    int npb[3];         /* bytes in input peek buffers */
-    unsigned char *buff[3]; /* input buffers {rov,base,corr} */
-    unsigned char *sbuf[2]; /* output buffers {sol1,sol2} */
-    unsigned char *pbuf[3]; /* peek buffers {rov,base,corr} */
+    ringbuf_t buff[3];  /* input ring buffers {rov,base,corr} */
+    ringbuf_t sbuf[2];  /* output ring buffers {sol1,sol2} */
     sol_t solbuf[MAXSOLBUF]; /* solution buffer */
     unsigned int nmsg[3][10]; /* input message counts */
     raw_t  raw [3];     /* receiver raw control {rov,base,corr} */
@@ -1251,7 +1401,32 @@ typedef struct {        /* RTK server type */
     thread_t thread;    /* server thread */
     int cputime;        /* CPU time (ms) for a processing cycle */
     int prcout;         /* missing observation data count */
+    int solout;         /* dropped solution output count */
     lock_t lock;        /* lock flag */
+    pcorlog_t pcorlog;  /* pseudorange correction log */
+    rtksvrarg_t arg[3]; /* input thread arguments {rov,base,corr} */
+    thread_t ithread[3]; /* input threads {rov,base,corr} */
+    thread_t othread;   /* solution output thread */
+    volatile int ostate; /* solution output thread state (0:stop,1:running) */
+    spscq_t evq[3];     /* decoded input event queues {rov,base,corr} */
+    spscq_t solq;       /* solution output queue */
+    lock_t qlock;       /* lock flag for queue wakeup */
+    cond_t evcond;      /* input event wakeup */
+    cond_t solcond;     /* solution output wakeup */
+    int fcn[MAXPRNGLO]; /* glonass frequency channel numbers (-999:unknown) */
+    volatile unsigned int nfcn; /* update count of glonass fcn */
+    latstat_t lat[3][NLATSTG]; /* latency statistics {rov,base,corr} */
+    lock_t latlock;     /* lock flag of latency statistics */
+    int outlat;         /* output latency to solution status (0:off,1:on) */
+    int nrov;           /* number of rovers of multi-rover mode (0:off) */
+    int nwork;          /* number of positioning worker threads */
+    rtkrov_t *rov;      /* rovers of multi-rover mode */
+    thread_t rthread;   /* rover input thread */
+    thread_t *wthread;  /* positioning worker threads */
+    int *jobq;          /* positioning job queue (rover indexes) */
+    int njob,jobp;      /* number of jobs/read position of job queue */
+    cond_t jobcond;     /* positioning job wakeup */
+    rwlock_t navlock;   /* lock flag of navigation/base data for workers */
 } rtksvr_t;
 
 /* global variables ----------------------------------------------------------*/
@@ -1259,6 +1434,7 @@ extern const double chisqr[];           /* chi-sqr(n) table (alpha=0.001) */
 extern const double lam_carr[];         /* carrier wave length (m) {L1,L2,...} */
 extern const prcopt_t prcopt_default;   /* default positioning options */
 extern const solopt_t solopt_default;   /* default solution output options */
+extern const simopt_t simopt_default;   /* default simulator options */
 extern const sbsigpband_t igpband1[][8]; /* SBAS IGP band 0-8 */
 extern const sbsigpband_t igpband2[][5]; /* SBAS IGP band 9-10 */
 extern const char *formatstrs[];        /* stream format strings */
@@ -1292,10 +1468,13 @@ extern void matmul(const char *tr, int n, int k, int m, double alpha,
 extern int  matinv(double *A, int n);
 extern int  solve (const char *tr, const double *A, const double *Y, int n,
                    int m, double *X);
+extern int  matsetblas(const char *lib);
 extern int  lsq   (const double *A, const double *y, int n, int m, double *x,
                    double *Q);
 extern int  filter(double *x, double *P, const double *H, const double *v,
                    const double *R, int n, int m);
+extern int  filtersp(double *x, double *P, const int *Hi, const double *Hv,
+                     int nh, const double *v, const double *R, int n, int m);
 extern int  smoother(const double *xf, const double *Qf, const double *xb,
                      const double *Qb, int n, double *xs, double *Qs);
 extern void matprint (const double *A, int n, int m, int p, int q);
@@ -1330,6 +1509,21 @@ extern int read_leaps(const char *file);
 extern int adjgpsweek(int week);
 extern unsigned int tickget(void);
 extern void sleepms(int ms);
+extern void waitcond(cond_t *cond, lock_t *lock, int ms);
+extern int  spscinit(spscq_t *q, int size, int n);
+extern void spscfree(spscq_t *q);
+extern void *spscwbuf(spscq_t *q);
+extern void spscpush(spscq_t *q);
+extern void *spscrbuf(spscq_t *q);
+extern void spscpop (spscq_t *q);
+extern int  spscnum (spscq_t *q);
+extern int  ringinit(ringbuf_t *ring, int n);
+extern void ringfree(ringbuf_t *ring);
+extern unsigned char *ringwbuf(ringbuf_t *ring, int *n);
+extern void ringpush(ringbuf_t *ring, int n);
+extern void ringwrite(ringbuf_t *ring, const unsigned char *buff, int n);
+extern int  ringread(const ringbuf_t *ring, unsigned int *rp,
+                     unsigned char *buff, int nmax);
 
 extern int reppath(const char *path, char *rpath, gtime_t time, const char *rov,
                    const char *base);
@@ -1362,6 +1556,7 @@ extern int  readerp(const char *file, erp_t *erp);
 extern int  geterp (const erp_t *erp, gtime_t time, double *val);
 
 /* debug trace functions -----------------------------------------------------*/
+extern void traceasync(int ena);
 extern void traceopen(const char *file);
 extern void traceclose(void);
 extern void tracelevel(int level);
@@ -1376,6 +1571,53 @@ extern void tracepeph(int level, const nav_t *nav);
 extern void tracepclk(int level, const nav_t *nav);
 extern void traceb   (int level, const unsigned char *p, int n);
 
+/* gate trace() and tracet() by the level before evaluation of the arguments.
+   -DTRACEMAX=n limits the max level of debug trace compiled in */
+#ifdef TRACE
+#ifndef TRACEMAX
+#define TRACEMAX    5                   /* max level of debug trace */
+#endif
+extern int tracelvl;
+
+#define trace(level,...) \
+    do {if ((level)<=TRACEMAX&&(level)<=tracelvl) (trace)(level,__VA_ARGS__);} while (0)
+#define tracet(level,...) \
+    do {if ((level)<=TRACEMAX&&(level)<=tracelvl) (tracet)(level,__VA_ARGS__);} while (0)
+#else
+#define trace(level,...)  do {if (0) (trace)(level,__VA_ARGS__);} while (0)
+#define tracet(level,...) do {if (0) (tracet)(level,__VA_ARGS__);} while (0)
+#endif
+
+/* profiler functions --------------------------------------------------------*/
+#define PROF_READRNX 1                  /* profile scope: readrnxt() */
+#define PROF_READSP3 2                  /* profile scope: readsp3() */
+#define PROF_PNTPOS 3                   /* profile scope: pntpos() */
+#define PROF_RTKPOS 4                   /* profile scope: rtkpos() */
+#define PROF_PPPOS  5                   /* profile scope: pppos() */
+#define PROF_SATPOSS 6                  /* profile scope: satposs() */
+#define PROF_UDSTATE 7                  /* profile scope: udstate() */
+#define PROF_ZDRES  8                   /* profile scope: zdres() */
+#define PROF_DDRES  9                   /* profile scope: ddres() */
+#define PROF_RESPPP 10                  /* profile scope: res_ppp() */
+#define PROF_FILTER 11                  /* profile scope: filter() */
+#define PROF_LAMBDA 12                  /* profile scope: lambda() */
+#define NPROF       13                  /* number of profile scopes */
+
+extern void profenable(int ena);
+extern void profbeg(int id);
+extern void profend(int id);
+extern void profreport(FILE *fp);
+
+#ifdef PROFILE
+extern int profena;
+
+#define PROFBEG(id) do {if (profena) profbeg(id);} while (0)
+#define PROFEND(id) do {if (profena) profend(id);} while (0)
+#else
+#define PROFBEG(id) do {} while (0)
+#define PROFEND(id) do {} while (0)
+#endif
+
 /* platform dependent functions ----------------------------------------------*/
 extern int execcmd(const char *cmd);
 extern int expath (const char *path, char *paths[], int nmax);
@@ -1417,8 +1659,10 @@ extern void stec_free(nav_t *nav);
 
 /* antenna models ------------------------------------------------------------*/
 extern int  readpcv(const char *file, pcvs_t *pcvs);
+extern void pcvsetsnap(int ena);
 extern pcv_t *searchpcv(int sat, const char *type, gtime_t time,
                         const pcvs_t *pcvs);
+extern void freepcv(pcvs_t *pcvs);
 extern void antmodel(const pcv_t *pcv, const double *del, const double *azel,
                      int opt, double *dant);
 extern void antmodel_s(const pcv_t *pcv, double nadir, double *dant);
@@ -1446,6 +1690,8 @@ extern int readrnxt(const char *file, int rcv, gtime_t ts, gtime_t te,
                     double tint, const char *opt, obs_t *obs, nav_t *nav,
                     sta_t *sta);
 extern int readrnxc(const char *file, nav_t *nav);
+extern void rnxsetthread(int nthread);
+extern void rnxsetindex(int ena);
 extern int outrnxobsh(FILE *fp, const rnxopt_t *opt, const nav_t *nav);
 extern int outrnxobsb(FILE *fp, const rnxopt_t *opt, const obsd_t *obs, int n,
                       int epflag);
@@ -1459,11 +1705,27 @@ extern int outrnxnavb (FILE *fp, const rnxopt_t *opt, const eph_t *eph);
 extern int outrnxgnavb(FILE *fp, const rnxopt_t *opt, const geph_t *geph);
 extern int outrnxhnavb(FILE *fp, const rnxopt_t *opt, const seph_t *seph);
 extern int uncompress(const char *file, char *uncfile);
+extern FILE *uncfopen(const char *file, int *plain);
+extern int uncompfile(const char *file, const char *outfile, int zip,
+                      int crx);
 extern int convrnx(int format, rnxopt_t *opt, const char *file, char **ofile);
 extern int  init_rnxctr (rnxctr_t *rnx);
 extern void free_rnxctr (rnxctr_t *rnx);
 extern int  open_rnxctr (rnxctr_t *rnx, FILE *fp);
 extern int  input_rnxctr(rnxctr_t *rnx, FILE *fp);
+extern int  open_rnxobs (rnxobs_t *rnx, char **file, int n, int rcv,
+                         gtime_t ts, gtime_t te, double tint, const char *opt);
+extern int  input_rnxobs(rnxobs_t *rnx);
+extern void close_rnxobs(rnxobs_t *rnx);
+extern int  scan_rnxobs (const rnxobs_t *rnx, gtime_t *ts, gtime_t *te);
+
+/* observation simulator functions -------------------------------------------*/
+extern void initsimobs(simobs_t *sim, const double *rr, int rcv,
+                       const simopt_t *opt);
+extern int simobsepoch(simobs_t *sim, gtime_t time, const nav_t *nav,
+                       obsd_t *obs);
+extern int simobs(gtime_t ts, gtime_t te, double tint, const double *rr,
+                  int rcv, const simopt_t *opt, const nav_t *nav, obs_t *obs);
 
 /* ephemeris and clock functions ---------------------------------------------*/
 extern double eph2clk (gtime_t time, const eph_t  *eph);
@@ -1485,6 +1747,13 @@ extern int  satpos(gtime_t time, gtime_t teph, int sat, int ephopt,
 extern void satposs(gtime_t time, const obsd_t *obs, int n, const nav_t *nav,
                     int sateph, double *rs, double *dts, double *var, int *svh);
 extern void readsp3(const char *file, nav_t *nav, int opt);
+extern int  chebfit(gtime_t ts, gtime_t te, double span, int deg,
+                    const nav_t *nav, int ephopt, cheph_t *ceph);
+extern int  cheb2pos(gtime_t time, int sat, const cheph_t *ceph, double *rs,
+                     double *dts, double *var);
+extern void freecheb(cheph_t *ceph);
+extern int  savecheb(const char *file, const cheph_t *ceph);
+extern int  readcheb(const char *file, cheph_t *ceph);
 extern int  readsap(const char *file, gtime_t time, nav_t *nav);
 extern int  readdcb(const char *file, nav_t *nav);
 extern void alm2pos(gtime_t time, const alm_t *alm, double *rs, double *dts);
@@ -1632,6 +1901,8 @@ extern void strunlock(stream_t *stream);
 extern int  stropen  (stream_t *stream, int type, int mode, const char *path);
 extern void strclose (stream_t *stream);
 extern int  strread  (stream_t *stream, unsigned char *buff, int n);
+extern int  strwait  (stream_t *stream, int msec);
+extern int  strwaits (stream_t **streams, int n, int msec);
 extern int  strwrite (stream_t *stream, unsigned char *buff, int n);
 extern void strsync  (stream_t *stream1, stream_t *stream2);
 extern int  strstat  (stream_t *stream, char *msg);
@@ -1652,6 +1923,13 @@ extern int lambda(int n, int m, const double *a, const double *Q, double *F,
 extern int pntpos(const obsd_t *obs, int n, const nav_t *nav,
                   const prcopt_t *opt, sol_t *sol, double *azel,
                   ssat_t *ssat, char *msg);
+extern int  pcorlogopen(pcorlog_t *log, const char *prefix, int nbuff,
+                        int tflush);
+extern void pcorlogclose(pcorlog_t *log);
+extern int  pntpcor(const obsd_t *obs, int n, const double *rs,
+                    const double *dts, const double *var, const int *svh,
+                    const nav_t *nav, const prcopt_t *opt, const double *rr,
+                    pcorlog_t *log);
 
 /* precise positioning -------------------------------------------------------*/
 extern void rtkinit(rtk_t *rtk, const prcopt_t *opt);
@@ -1659,6 +1937,7 @@ extern void rtkfree(rtk_t *rtk);
 extern int  rtkpos (rtk_t *rtk, const obsd_t *obs, int nobs, const nav_t *nav);
 extern int  rtkopenstat(const char *file, int level);
 extern void rtkclosestat(void);
+extern void rtkoutlat(const rtk_t *rtk, const double *lat);
 
 /* precise point positioning -------------------------------------------------*/
 extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav);
@@ -1674,6 +1953,9 @@ extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
                    const prcopt_t *popt, const solopt_t *sopt,
                    const filopt_t *fopt, char **infile, int n, char *outfile,
                    const char *rov, const char *base);
+extern int postpcor(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
+                    const solopt_t *sopt, const filopt_t *fopt, char **infile,
+                    int n, const char *stafile, const char *outdir);
 
 /* stream server functions ---------------------------------------------------*/
 extern void strsvrinit (strsvr_t *svr, int nout);
@@ -1695,6 +1977,8 @@ extern int  rtksvrstart (rtksvr_t *svr, int cycle, int buffsize, int *strs,
                          const double *nmeapos, prcopt_t *prcopt,
                          solopt_t *solopt, stream_t *moni);
 extern void rtksvrstop  (rtksvr_t *svr, char **cmds);
+extern int  rtksvrsetrov(rtksvr_t *svr, int nrov, int nwork, const int *strs,
+                         char **paths, const int *formats, char **rcvopts);
 extern int  rtksvropenstr(rtksvr_t *svr, int index, int str, const char *path,
                           const solopt_t *solopt);
 extern void rtksvrclosestr(rtksvr_t *svr, int index);
@@ -1703,6 +1987,9 @@ extern void rtksvrunlock(rtksvr_t *svr);
 extern int  rtksvrostat (rtksvr_t *svr, int type, gtime_t *time, int *sat,
                          double *az, double *el, int **snr, int *vsat);
 extern void rtksvrsstat (rtksvr_t *svr, int *sstat, char *msg);
+extern int  rtksvrpeek  (rtksvr_t *svr, int index, unsigned int *rp,
+                         unsigned char *buff, int nmax);
+extern int  rtksvrlat   (rtksvr_t *svr, int index, int stage, double *lat);
 
 /* downloader functions ------------------------------------------------------*/
 extern int dl_readurls(const char *file, char **types, int ntype, url_t *urls,
@@ -329,6 +329,27 @@ static void outsolstat(rtk_t *rtk)
         }
     }
 }
+/* output latency to solution status ------------------------------------------
+* output processing latency of current epoch to solution status file
+* args   : rtk_t  *rtk      I   rtk control/result struct
+*          double *lat      I   latency of stages (ms)
+*                               {input to decoded,decoded to processing,
+*                                processing,input to processed}
+* return : none
+* notes  : output format: $LAT,week,tow,stat,dec,que,pos,total
+*-----------------------------------------------------------------------------*/
+extern void rtkoutlat(const rtk_t *rtk, const double *lat)
+{
+    double tow;
+    int week;
+    
+    if (statlevel<=0||!fp_stat||rtk->sol.stat==SOLQ_NONE) return;
+    
+    tow=time2gpst(rtk->sol.time,&week);
+    
+    fprintf(fp_stat,"$LAT,%d,%.3f,%d,%.3f,%.3f,%.3f,%.3f\n",week,tow,
+            rtk->sol.stat,lat[0],lat[1],lat[2],lat[3]);
+}
 /* save error message --------------------------------------------------------*/
 static void errmsg(rtk_t *rtk, const char *format, ...)
 {
@@ -780,6 +801,8 @@ static void udstate(rtk_t *rtk, const obsd_t *obs, const int *sat,
     
     trace(3,"udstate : ns=%d\n",ns);
     
+    PROFBEG(PROF_UDSTATE);
+    
     /* temporal update of position/velocity/acceleration */
     udpos(rtk,tt);
     
@@ -800,6 +823,7 @@ static void udstate(rtk_t *rtk, const obsd_t *obs, const int *sat,
     if (rtk->opt.mode>PMODE_DGPS) {
         udbias(rtk,tt,obs,sat,iu,ir,ns,nav);
     }
+    PROFEND(PROF_UDSTATE);
 }
 /* undifferenced phase/code residual for satellite ---------------------------*/
 static void zdres_sat(int base, double r, const obsd_t *obs, const nav_t *nav,
@@ -859,6 +883,8 @@ static int zdres(int base, const obsd_t *obs, int n, const double *rs,
     
     if (norm(rr,3)<=0.0) return 0; /* no receiver position */
     
+    PROFBEG(PROF_ZDRES);
+    
     for (i=0;i<3;i++) rr_[i]=rr[i];
     
     /* earth tide correction */
@@ -900,6 +926,7 @@ static int zdres(int base, const obsd_t *obs, int n, const double *rs,
     }
     trace(4,"y=\n"); tracemat(4,y,nf*2,n,13,3);
     
+    PROFEND(PROF_ZDRES);
     return 1;
 }
 /* test valid observation data -----------------------------------------------*/
@@ -1031,6 +1058,8 @@ static int ddres(rtk_t *rtk, const nav_t *nav, double dt, const double *x,
     
     trace(3,"ddres   : dt=%.1f nx=%d ns=%d\n",dt,rtk->nx,ns);
     
+    PROFBEG(PROF_DDRES);
+    
     bl=baseline(x,rtk->rb,dr);
     ecef2pos(x,posu); ecef2pos(rtk->rb,posr);
     
@@ -1200,16 +1229,17 @@ static int ddres(rtk_t *rtk, const nav_t *nav, double dt, const double *x,
     free(Ri); free(Rj); free(im);
     free(tropu); free(tropr); free(dtdxu); free(dtdxr);
     
+    PROFEND(PROF_DDRES);
     return nv;
 }
 /* time-interpolation of residuals (for post-mission) ------------------------*/
 static double intpres(gtime_t time, const obsd_t *obs, int n, const nav_t *nav,
                       rtk_t *rtk, double *y)
 {
-    static obsd_t obsb[MAXOBS];
-    static double yb[MAXOBS*NFREQ*2],rs[MAXOBS*6],dts[MAXOBS*2],var[MAXOBS];
-    static double e[MAXOBS*3],azel[MAXOBS*2];
-    static int nb=0,svh[MAXOBS*2];
+    static THREADLOCAL obsd_t obsb[MAXOBS];
+    static THREADLOCAL double yb[MAXOBS*NFREQ*2],rs[MAXOBS*6],dts[MAXOBS*2];
+    static THREADLOCAL double var[MAXOBS],e[MAXOBS*3],azel[MAXOBS*2];
+    static THREADLOCAL int nb=0,svh[MAXOBS*2];
     prcopt_t *opt=&rtk->opt;
     double tt=timediff(time,obs[0].time),ttb,*p,*q;
     int i,j,k,nf=NF(opt);
@@ -1715,65 +1745,8 @@ extern void rtkfree(rtk_t *rtk)
     free(rtk->xa); rtk->xa=NULL;
     free(rtk->Pa); rtk->Pa=NULL;
 }
-/* precise positioning ---------------------------------------------------------
-* input observation data and navigation message, compute rover position by 
-* precise positioning
-* args   : rtk_t *rtk       IO  rtk control/result struct
-*            rtk->sol       IO  solution
-*                .time      O   solution time
-*                .rr[]      IO  rover position/velocity
-*                               (I:fixed mode,O:single mode)
-*                .dtr[0]    O   receiver clock bias (s)
-*                .dtr[1]    O   receiver glonass-gps time offset (s)
-*                .Qr[]      O   rover position covarinace
-*                .stat      O   solution status (SOLQ_???)
-*                .ns        O   number of valid satellites
-*                .age       O   age of differential (s)
-*                .ratio     O   ratio factor for ambiguity validation
-*            rtk->rb[]      IO  base station position/velocity
-*                               (I:relative mode,O:moving-base mode)
-*            rtk->nx        I   number of all states
-*            rtk->na        I   number of integer states
-*            rtk->ns        O   number of valid satellite
-*            rtk->tt        O   time difference between current and previous (s)
-*            rtk->x[]       IO  float states pre-filter and post-filter
-*            rtk->P[]       IO  float covariance pre-filter and post-filter
-*            rtk->xa[]      O   fixed states after AR
-*            rtk->Pa[]      O   fixed covariance after AR
-*            rtk->ssat[s]   IO  sat(s+1) status
-*                .sys       O   system (SYS_???)
-*                .az   [r]  O   azimuth angle   (rad) (r=0:rover,1:base)
-*                .el   [r]  O   elevation angle (rad) (r=0:rover,1:base)
-*                .vs   [r]  O   data valid single     (r=0:rover,1:base)
-*                .resp [f]  O   freq(f+1) pseudorange residual (m)
-*                .resc [f]  O   freq(f+1) carrier-phase residual (m)
-*                .vsat [f]  O   freq(f+1) data vaild (0:invalid,1:valid)
-*                .fix  [f]  O   freq(f+1) ambiguity flag
-*                               (0:nodata,1:float,2:fix,3:hold)
-*                .slip [f]  O   freq(f+1) slip flag
-*                               (bit8-7:rcv1 LLI, bit6-5:rcv2 LLI,
-*                                bit2:parity unknown, bit1:slip)
-*                .lock [f]  IO  freq(f+1) carrier lock count
-*                .outc [f]  IO  freq(f+1) carrier outage count
-*                .slipc[f]  IO  freq(f+1) cycle slip count
-*                .rejc [f]  IO  freq(f+1) data reject count
-*                .gf        IO  geometry-free phase (L1-L2) (m)
-*                .gf2       IO  geometry-free phase (L1-L5) (m)
-*            rtk->nfix      IO  number of continuous fixes of ambiguity
-*            rtk->neb       IO  bytes of error message buffer
-*            rtk->errbuf    IO  error message buffer
-*            rtk->tstr      O   time string for debug
-*            rtk->opt       I   processing options
-*          obsd_t *obs      I   observation data for an epoch
-*                               obs[i].rcv=1:rover,2:reference
-*                               sorted by receiver and satellte
-*          int    n         I   number of observation data
-*          nav_t  *nav      I   navigation messages
-* return : status (0:no solution,1:valid solution)
-* notes  : before calling function, base station position rtk->sol.rb[] should
-*          be properly set for relative mode except for moving-baseline
-*-----------------------------------------------------------------------------*/
-extern int rtkpos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
+/* precise positioning for an epoch ------------------------------------------*/
+static int rtkpos_(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
 {
     prcopt_t *opt=&rtk->opt;
     sol_t solb={{0}};
@@ -1856,3 +1829,70 @@ extern int rtkpos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     
     return 1;
 }
+/* precise positioning ---------------------------------------------------------
+* input observation data and navigation message, compute rover position by 
+* precise positioning
+* args   : rtk_t *rtk       IO  rtk control/result struct
+*            rtk->sol       IO  solution
+*                .time      O   solution time
+*                .rr[]      IO  rover position/velocity
+*                               (I:fixed mode,O:single mode)
+*                .dtr[0]    O   receiver clock bias (s)
+*                .dtr[1]    O   receiver glonass-gps time offset (s)
+*                .Qr[]      O   rover position covarinace
+*                .stat      O   solution status (SOLQ_???)
+*                .ns        O   number of valid satellites
+*                .age       O   age of differential (s)
+*                .ratio     O   ratio factor for ambiguity validation
+*            rtk->rb[]      IO  base station position/velocity
+*                               (I:relative mode,O:moving-base mode)
+*            rtk->nx        I   number of all states
+*            rtk->na        I   number of integer states
+*            rtk->ns        O   number of valid satellite
+*            rtk->tt        O   time difference between current and previous (s)
+*            rtk->x[]       IO  float states pre-filter and post-filter
+*            rtk->P[]       IO  float covariance pre-filter and post-filter
+*            rtk->xa[]      O   fixed states after AR
+*            rtk->Pa[]      O   fixed covariance after AR
+*            rtk->ssat[s]   IO  sat(s+1) status
+*                .sys       O   system (SYS_???)
+*                .az   [r]  O   azimuth angle   (rad) (r=0:rover,1:base)
+*                .el   [r]  O   elevation angle (rad) (r=0:rover,1:base)
+*                .vs   [r]  O   data valid single     (r=0:rover,1:base)
+*                .resp [f]  O   freq(f+1) pseudorange residual (m)
+*                .resc [f]  O   freq(f+1) carrier-phase residual (m)
+*                .vsat [f]  O   freq(f+1) data vaild (0:invalid,1:valid)
+*                .fix  [f]  O   freq(f+1) ambiguity flag
+*                               (0:nodata,1:float,2:fix,3:hold)
+*                .slip [f]  O   freq(f+1) slip flag
+*                               (bit8-7:rcv1 LLI, bit6-5:rcv2 LLI,
+*                                bit2:parity unknown, bit1:slip)
+*                .lock [f]  IO  freq(f+1) carrier lock count
+*                .outc [f]  IO  freq(f+1) carrier outage count
+*                .slipc[f]  IO  freq(f+1) cycle slip count
+*                .rejc [f]  IO  freq(f+1) data reject count
+*                .gf        IO  geometry-free phase (L1-L2) (m)
+*                .gf2       IO  geometry-free phase (L1-L5) (m)
+*            rtk->nfix      IO  number of continuous fixes of ambiguity
+*            rtk->neb       IO  bytes of error message buffer
+*            rtk->errbuf    IO  error message buffer
+*            rtk->tstr      O   time string for debug
+*            rtk->opt       I   processing options
+*          obsd_t *obs      I   observation data for an epoch
+*                               obs[i].rcv=1:rover,2:reference
+*                               sorted by receiver and satellte
+*          int    n         I   number of observation data
+*          nav_t  *nav      I   navigation messages
+* return : status (0:no solution,1:valid solution)
+* notes  : before calling function, base station position rtk->sol.rb[] should
+*          be properly set for relative mode except for moving-baseline
+*-----------------------------------------------------------------------------*/
+extern int rtkpos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
+{
+    int stat;
+    
+    PROFBEG(PROF_RTKPOS);
+    stat=rtkpos_(rtk,obs,n,nav);
+    PROFEND(PROF_RTKPOS);
+    return stat;
+}
@@ -34,6 +34,86 @@
 
 static const char rcsid[]="$Id:$";
 
+#define PCORLOGBUFF 65536       /* buffer size of pseudorange correction log */
+#define PCORLOGFLUSH 1000       /* flush interval of the log (ms) */
+
+#define SVREV_PEPH  20          /* input event: precise ephemeris */
+#define SVREV_PCLK  21          /* input event: precise clock */
+#define NSOLQ       64          /* size of solution output queue */
+#define MAXSOLOUT   1024        /* max bytes of solution output */
+#define NROVQ       4           /* size of rover observation data queue */
+
+typedef struct {                /* decoded input event type */
+    int type;                   /* type (input_raw() status,SVREV_???) */
+    int sat;                    /* satellite number */
+    unsigned int tick;          /* tick of stream input (us) */
+    unsigned int tdec;          /* tick of decoded (us) */
+    int n;                      /* number of obs data */
+    obsd_t data[MAXOBS];        /* obs data */
+    eph_t eph;                  /* ephemeris */
+    geph_t geph;                /* glonass ephemeris */
+    sbsmsg_t sbsmsg;            /* sbas message */
+    ssr_t ssr;                  /* ssr corrections */
+    lexmsg_t lexmsg;            /* lex message */
+    double ion_gps[8];          /* gps iono model parameters */
+    double utc_gps[4];          /* gps delta-utc parameters */
+    double ion_gal[4];          /* galileo iono model parameters */
+    double utc_gal[4];          /* galileo utc parameters */
+    double ion_qzs[8];          /* qzss iono model parameters */
+    double utc_qzs[4];          /* qzss utc parameters */
+    int leaps;                  /* leap seconds (s) */
+    double rb[3];               /* base station position (ecef) (m) */
+    peph_t *peph;               /* precise ephemeris */
+    pclk_t *pclk;               /* precise clock */
+    int ne;                     /* number of precise ephemeris/clock */
+    char file[MAXSTRPATH];      /* download file path */
+} svrev_t;
+
+typedef struct {                /* solution output type */
+    sol_t sol;                  /* solution */
+    unsigned int tick[4];       /* ticks of stages (us) (0:no epoch) */
+    unsigned int pos[2];        /* ring buffer positions {sol1,sol2} */
+    int nb[3];                  /* output bytes {sol1,sol2,moni} */
+    unsigned char moni[MAXSOLOUT]; /* solution to monitor port */
+} svrsol_t;
+
+typedef struct {                /* rover observation data type */
+    int n;                      /* number of obs data */
+    obsd_t data[MAXOBS];        /* obs data */
+} rovobs_t;
+
+/* get current tick in us ----------------------------------------------------*/
+static unsigned int tickus(void)
+{
+#ifdef WIN32
+    LARGE_INTEGER f,t;
+    
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&t);
+    return (unsigned int)(t.QuadPart/f.QuadPart*1000000+
+                          t.QuadPart%f.QuadPart*1000000/f.QuadPart);
+#else
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (unsigned int)ts.tv_sec*1000000u+(unsigned int)(ts.tv_nsec/1000);
+#endif
+}
+/* compare latency samples --------------------------------------------------*/
+static int cmplat(const void *p1, const void *p2)
+{
+    double d=*(const double *)p1-*(const double *)p2;
+    return d<0.0?-1:(d>0.0?1:0);
+}
+/* add latency sample --------------------------------------------------------*/
+static void addlat(rtksvr_t *svr, latstat_t *lat, unsigned int tick1,
+                   unsigned int tick2)
+{
+    lock(&svr->latlock);
+    lat->lat[lat->n%NLATWIN]=(float)((int)(tick2-tick1)*1E-3);
+    lat->n++;
+    unlock(&svr->latlock);
+}
 /* write solution header to output stream ------------------------------------*/
 static void writesolhead(stream_t *stream, const solopt_t *solopt)
 {
@@ -43,53 +123,120 @@ static void writesolhead(stream_t *stream, const solopt_t *solopt)
     n=outsolheads(buff,solopt);
     strwrite(stream,buff,n);
 }
-/* save output buffer --------------------------------------------------------*/
-static void saveoutbuf(rtksvr_t *svr, unsigned char *buff, int n, int index)
+/* write data in ring buffer to stream ---------------------------------------*/
+static void writering(stream_t *stream, const ringbuf_t *ring, unsigned int pos,
+                      int n)
 {
-    rtksvrlock(svr);
+    unsigned int i=pos&(ring->n-1);
+    int m=n<(int)(ring->n-i)?n:(int)(ring->n-i);
     
-    n=n<svr->buffsize-svr->nsb[index]?n:svr->buffsize-svr->nsb[index];
-    memcpy(svr->sbuf[index]+svr->nsb[index],buff,n);
-    svr->nsb[index]+=n;
+    strwrite(stream,ring->buff+i,m);
+    if (m<n) strwrite(stream,ring->buff,n-m);
+}
+/* output solution and extended solution to ring buffer ----------------------*/
+static int outsolring(rtksvr_t *svr, ringbuf_t *ring, const solopt_t *opt)
+{
+    unsigned char buff[MAXSOLOUT*2],*p;
+    int n=MAXSOLOUT*2;
     
-    rtksvrunlock(svr);
+    /* format in place if contiguous space available */
+    if ((p=ringwbuf(ring,&n))&&n>=MAXSOLOUT*2) {
+        n =outsols (p  ,&svr->rtk.sol,svr->rtk.rb  ,opt);
+        n+=outsolexs(p+n,&svr->rtk.sol,svr->rtk.ssat,opt);
+        ringpush(ring,n);
+        return n;
+    }
+    ringpush(ring,0);
+    n =outsols (buff  ,&svr->rtk.sol,svr->rtk.rb  ,opt);
+    n+=outsolexs(buff+n,&svr->rtk.sol,svr->rtk.ssat,opt);
+    ringwrite(ring,buff,n);
+    return n;
 }
-/* write solution to output stream -------------------------------------------*/
-static void writesol(rtksvr_t *svr, int index)
+/* write solution to solution output queue -----------------------------------*/
+static void writesol(rtksvr_t *svr, const unsigned int *tick)
 {
     solopt_t solopt=solopt_default;
-    unsigned char buff[1024];
-    int i,n;
+    svrsol_t *sol;
+    int i;
     
-    tracet(4,"writesol: index=%d\n",index);
+    tracet(4,"writesol:\n");
     
+    if (!(sol=(svrsol_t *)spscwbuf(&svr->solq))) {
+        svr->solout++;
+        tracet(2,"solution output queue overflow: solout=%d\n",svr->solout);
+        return;
+    }
+    sol->sol=svr->rtk.sol;
+    for (i=0;i<4;i++) sol->tick[i]=tick?tick[i]:0;
+    
+    /* solution and extended solution to output ring buffers */
     for (i=0;i<2;i++) {
-        /* output solution */
-        n=outsols(buff,&svr->rtk.sol,svr->rtk.rb,svr->solopt+i);
-        strwrite(svr->stream+i+3,buff,n);
-        
-        /* save output buffer */
-        saveoutbuf(svr,buff,n,i);
-        
-        /* output extended solution */
-        n=outsolexs(buff,&svr->rtk.sol,svr->rtk.ssat,svr->solopt+i);
-        strwrite(svr->stream+i+3,buff,n);
-        
-        /* save output buffer */
-        saveoutbuf(svr,buff,n,i);
+        sol->pos[i]=svr->sbuf[i].wp;
+        sol->nb[i]=outsolring(svr,svr->sbuf+i,svr->solopt+i);
+    }
+    /* solution to monitor port */
+    sol->nb[2]=svr->moni?outsols(sol->moni,&svr->rtk.sol,svr->rtk.rb,
+                                 &solopt):0;
+    spscpush(&svr->solq);
+    
+    lock(&svr->qlock);
+    signalcond(&svr->solcond);
+    unlock(&svr->qlock);
+}
+/* output solution to streams (called by solution output thread) -------------*/
+static void outsolstr(rtksvr_t *svr, svrsol_t *sol)
+{
+    unsigned int tick;
+    int i;
+    
+    /* output solution from ring buffers without copy */
+    for (i=0;i<2;i++) {
+        writering(svr->stream+i+3,svr->sbuf+i,sol->pos[i],sol->nb[i]);
     }
     /* output solution to monitor port */
-    if (svr->moni) {
-        n=outsols(buff,&svr->rtk.sol,svr->rtk.rb,&solopt);
-        strwrite(svr->moni,buff,n);
+    if (svr->moni&&sol->nb[2]>0) {
+        strwrite(svr->moni,sol->moni,sol->nb[2]);
+    }
+    /* latency of output and total of rover epoch */
+    if (sol->tick[0]) {
+        tick=tickus();
+        addlat(svr,svr->lat[0]+LATSTG_OUT,sol->tick[3],tick);
+        addlat(svr,svr->lat[0]+LATSTG_ALL,sol->tick[0],tick);
     }
     /* save solution buffer */
     if (svr->nsol<MAXSOLBUF) {
         rtksvrlock(svr);
-        svr->solbuf[svr->nsol++]=svr->rtk.sol;
+        svr->solbuf[svr->nsol++]=sol->sol;
         rtksvrunlock(svr);
     }
 }
+/* solution output thread ----------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI outputthread(void *arg)
+#else
+static void *outputthread(void *arg)
+#endif
+{
+    rtksvr_t *svr=(rtksvr_t *)arg;
+    svrsol_t *sol;
+    
+    tracet(3,"outputthread:\n");
+    
+    for (;;) {
+        while ((sol=(svrsol_t *)spscrbuf(&svr->solq))) {
+            outsolstr(svr,sol);
+            spscpop(&svr->solq);
+        }
+        if (!svr->ostate) break;
+        
+        lock(&svr->qlock);
+        if (svr->ostate&&spscnum(&svr->solq)<=0) {
+            waitcond(&svr->solcond,&svr->qlock,1000);
+        }
+        unlock(&svr->qlock);
+    }
+    return 0;
+}
 /* update navigation data ----------------------------------------------------*/
 static void updatenav(nav_t *nav)
 {
@@ -98,130 +245,146 @@ static void updatenav(nav_t *nav)
         nav->lam[i][j]=satwavelen(i+1,j,nav);
     }
 }
-/* update glonass frequency channel number in raw data struct ----------------*/
-static void updatefcn(rtksvr_t *svr)
+/* update glonass frequency channel number in decoder navigation data ---------
+* set the frequency channel numbers of glonass ephemerides received by any
+* input stream to the navigation data of a raw or rtcm decoder (called by
+* input thread or rover input thread)
+*-----------------------------------------------------------------------------*/
+static void updatefcn(rtksvr_t *svr, nav_t *nav, unsigned int *nfcn)
 {
-    int i,j,sat,frq;
+    int i,sat,frq;
+    
+    if (*nfcn==svr->nfcn) return;
+    
+    rtksvrlock(svr);
     
     for (i=0;i<MAXPRNGLO;i++) {
         sat=satno(SYS_GLO,i+1);
-        
-        for (j=0,frq=-999;j<3;j++) {
-            if (svr->raw[j].nav.geph[i].sat!=sat) continue;
-            frq=svr->raw[j].nav.geph[i].frq;
-        }
+        frq=svr->fcn[i];
         if (frq<-7||frq>6) continue;
-        
-        for (j=0;j<3;j++) {
-            if (svr->raw[j].nav.geph[i].sat==sat) continue;
-            svr->raw[j].nav.geph[i].sat=sat;
-            svr->raw[j].nav.geph[i].frq=frq;
-        }
+        if (nav->geph[i].sat==sat) continue;
+        nav->geph[i].sat=sat;
+        nav->geph[i].frq=frq;
     }
+    *nfcn=svr->nfcn;
+    
+    rtksvrunlock(svr);
 }
-/* update rtk server struct --------------------------------------------------*/
-static void updatesvr(rtksvr_t *svr, int ret, obs_t *obs, nav_t *nav, int sat,
-                      sbsmsg_t *sbsmsg, int index, int iobs)
+/* get free input event (called by input thread) -------------------------------
+* wait for the positioning thread if the input event queue is full
+*-----------------------------------------------------------------------------*/
+static svrev_t *newev(rtksvr_t *svr, int index, int type, unsigned int tick)
 {
-    eph_t *eph1,*eph2,*eph3;
-    geph_t *geph1,*geph2,*geph3;
-    gtime_t tof;
+    svrev_t *ev;
+    
+    while (!(ev=(svrev_t *)spscwbuf(svr->evq+index))) {
+        if (!svr->state) return NULL;
+        sleepms(1);
+    }
+    ev->type=type;
+    ev->sat=0;
+    ev->tick=tick;
+    return ev;
+}
+/* publish input event and wake up positioning thread ------------------------*/
+static void pushev(rtksvr_t *svr, int index, svrev_t *ev)
+{
+    ev->tdec=tickus();
+    spscpush(svr->evq+index);
+    
+    lock(&svr->qlock);
+    signalcond(&svr->evcond);
+    unlock(&svr->qlock);
+}
+/* input decoded data as events (called by input thread) ---------------------*/
+static void inputev(rtksvr_t *svr, int ret, obs_t *obs, nav_t *nav, int sat,
+                    sbsmsg_t *sbsmsg, int index, unsigned int tick)
+{
+    svrev_t *ev;
+    obs_t evobs={0};
     double pos[3],del[3]={0},dr[3];
-    int i,n=0,prn,sbssat=svr->rtk.opt.sbassatsel,sys,iode;
+    int i,n=0,prn,sbssat=svr->rtk.opt.sbassatsel;
     
-    tracet(4,"updatesvr: ret=%d sat=%2d index=%d\n",ret,sat,index);
+    tracet(4,"inputev: ret=%d sat=%2d index=%d\n",ret,sat,index);
     
     if (ret==1) { /* observation data */
-        if (iobs<MAXOBSBUF) {
-            for (i=0;i<obs->n;i++) {
+        if ((ev=newev(svr,index,ret,tick))) {
+            for (i=0;i<obs->n&&n<MAXOBS;i++) {
                 if (svr->rtk.opt.exsats[obs->data[i].sat-1]==1||
                     !(satsys(obs->data[i].sat,NULL)&svr->rtk.opt.navsys)) continue;
-                svr->obs[index][iobs].data[n]=obs->data[i];
-                svr->obs[index][iobs].data[n++].rcv=index+1;
+                ev->data[n]=obs->data[i];
+                ev->data[n++].rcv=index+1;
             }
-            svr->obs[index][iobs].n=n;
-            sortobs(&svr->obs[index][iobs]);
+            evobs.data=ev->data; evobs.n=evobs.nmax=n;
+            ev->n=sortobs(&evobs)>0?evobs.n:0;
+            pushev(svr,index,ev);
         }
         svr->nmsg[index][0]++;
     }
     else if (ret==2) { /* ephemeris */
         if (satsys(sat,&prn)!=SYS_GLO) {
-            if (!svr->navsel||svr->navsel==index+1) {
-                eph1=nav->eph+sat-1;
-                eph2=svr->nav.eph+sat-1;
-                eph3=svr->nav.eph+sat-1+MAXSAT;
-                if (eph2->ttr.time==0||
-                    (eph1->iode!=eph3->iode&&eph1->iode!=eph2->iode)||
-                    (timediff(eph1->toe,eph3->toe)!=0.0&&
-                     timediff(eph1->toe,eph2->toe)!=0.0)) {
-                    *eph3=*eph2;
-                    *eph2=*eph1;
-                    updatenav(&svr->nav);
-                }
+            if ((!svr->navsel||svr->navsel==index+1)&&
+                (ev=newev(svr,index,ret,tick))) {
+                ev->sat=sat;
+                ev->eph=nav->eph[sat-1];
+                pushev(svr,index,ev);
             }
             svr->nmsg[index][1]++;
         }
         else {
-           if (!svr->navsel||svr->navsel==index+1) {
-               geph1=nav->geph+prn-1;
-               geph2=svr->nav.geph+prn-1;
-               geph3=svr->nav.geph+prn-1+MAXPRNGLO;
-               if (geph2->tof.time==0||
-                   (geph1->iode!=geph3->iode&&geph1->iode!=geph2->iode)) {
-                   *geph3=*geph2;
-                   *geph2=*geph1;
-                   updatenav(&svr->nav);
-                   updatefcn(svr);
-               }
-           }
-           svr->nmsg[index][6]++;
+            if ((!svr->navsel||svr->navsel==index+1)&&
+                (ev=newev(svr,index,ret,tick))) {
+                ev->sat=sat;
+                ev->geph=nav->geph[prn-1];
+                pushev(svr,index,ev);
+            }
+            svr->nmsg[index][6]++;
         }
     }
     else if (ret==3) { /* sbas message */
-        if (sbsmsg&&(sbssat==sbsmsg->prn||sbssat==0)) {
-            if (svr->nsbs<MAXSBSMSG) {
-                svr->sbsmsg[svr->nsbs++]=*sbsmsg;
-            }
-            else {
-                for (i=0;i<MAXSBSMSG-1;i++) svr->sbsmsg[i]=svr->sbsmsg[i+1];
-                svr->sbsmsg[i]=*sbsmsg;
-            }
-            sbsupdatecorr(sbsmsg,&svr->nav);
+        if (sbsmsg&&(sbssat==sbsmsg->prn||sbssat==0)&&
+            (ev=newev(svr,index,ret,tick))) {
+            ev->sbsmsg=*sbsmsg;
+            pushev(svr,index,ev);
         }
         svr->nmsg[index][3]++;
     }
     else if (ret==9) { /* ion/utc parameters */
-        if (svr->navsel==0||svr->navsel==index+1) {
-            for (i=0;i<8;i++) svr->nav.ion_gps[i]=nav->ion_gps[i];
-            for (i=0;i<4;i++) svr->nav.utc_gps[i]=nav->utc_gps[i];
-            for (i=0;i<4;i++) svr->nav.ion_gal[i]=nav->ion_gal[i];
-            for (i=0;i<4;i++) svr->nav.utc_gal[i]=nav->utc_gal[i];
-            for (i=0;i<8;i++) svr->nav.ion_qzs[i]=nav->ion_qzs[i];
-            for (i=0;i<4;i++) svr->nav.utc_qzs[i]=nav->utc_qzs[i];
-            svr->nav.leaps=nav->leaps;
+        if ((svr->navsel==0||svr->navsel==index+1)&&
+            (ev=newev(svr,index,ret,tick))) {
+            for (i=0;i<8;i++) ev->ion_gps[i]=nav->ion_gps[i];
+            for (i=0;i<4;i++) ev->utc_gps[i]=nav->utc_gps[i];
+            for (i=0;i<4;i++) ev->ion_gal[i]=nav->ion_gal[i];
+            for (i=0;i<4;i++) ev->utc_gal[i]=nav->utc_gal[i];
+            for (i=0;i<8;i++) ev->ion_qzs[i]=nav->ion_qzs[i];
+            for (i=0;i<4;i++) ev->utc_qzs[i]=nav->utc_qzs[i];
+            ev->leaps=nav->leaps;
+            pushev(svr,index,ev);
         }
         svr->nmsg[index][2]++;
     }
     else if (ret==5) { /* antenna postion parameters */
-        if (svr->rtk.opt.refpos==4&&index==1) {
+        if (svr->rtk.opt.refpos==4&&index==1&&
+            (ev=newev(svr,index,ret,tick))) {
             for (i=0;i<3;i++) {
-                svr->rtk.rb[i]=svr->rtcm[1].sta.pos[i];
+                ev->rb[i]=svr->rtcm[1].sta.pos[i];
             }
             /* antenna delta */
-            ecef2pos(svr->rtk.rb,pos);
+            ecef2pos(ev->rb,pos);
             if (svr->rtcm[1].sta.deltype) { /* xyz */
                 del[2]=svr->rtcm[1].sta.hgt;
                 enu2ecef(pos,del,dr);
                 for (i=0;i<3;i++) {
-                    svr->rtk.rb[i]+=svr->rtcm[1].sta.del[i]+dr[i];
+                    ev->rb[i]+=svr->rtcm[1].sta.del[i]+dr[i];
                 }
             }
             else { /* enu */
                 enu2ecef(pos,svr->rtcm[1].sta.del,dr);
                 for (i=0;i<3;i++) {
-                    svr->rtk.rb[i]+=dr[i];
+                    ev->rb[i]+=dr[i];
                 }
             }
+            pushev(svr,index,ev);
         }
         svr->nmsg[index][4]++;
     }
@@ -238,63 +401,156 @@ static void updatesvr(rtksvr_t *svr, int ret, obs_t *obs, nav_t *nav, int sat,
             
             svr->rtcm[index].ssr[i].update=0;
             
-            iode=svr->rtcm[index].ssr[i].iode;
-            sys=satsys(i+1,&prn);
-            
-            /* check corresponding ephemeris exists */
-            if (sys==SYS_GPS||sys==SYS_GAL||sys==SYS_QZS) {
-                if (svr->nav.eph[i       ].iode!=iode&&
-                    svr->nav.eph[i+MAXSAT].iode!=iode) {
-                    continue;
-                }
-            }
-            else if (sys==SYS_GLO) {
-                if (svr->nav.geph[prn-1          ].iode!=iode&&
-                    svr->nav.geph[prn-1+MAXPRNGLO].iode!=iode) {
-                    continue;
-                }
-            }
-            svr->nav.ssr[i]=svr->rtcm[index].ssr[i];
+            if (!(ev=newev(svr,index,ret,tick))) break;
+            ev->sat=i+1;
+            ev->ssr=svr->rtcm[index].ssr[i];
+            pushev(svr,index,ev);
         }
         svr->nmsg[index][7]++;
     }
     else if (ret==31) { /* lex message */
-        lexupdatecorr(&svr->raw[index].lexmsg,&svr->nav,&tof);
+        if ((ev=newev(svr,index,ret,tick))) {
+            ev->lexmsg=svr->raw[index].lexmsg;
+            pushev(svr,index,ev);
+        }
         svr->nmsg[index][8]++;
     }
     else if (ret==-1) { /* error */
         svr->nmsg[index][9]++;
     }
 }
-/* decode receiver raw/rtcm data ---------------------------------------------*/
-static int decoderaw(rtksvr_t *svr, int index)
+/* update rtk server struct by input event ------------------------------------
+* called with lock. navigation and base station data shared with positioning
+* workers of rovers are updated with write lock of navlock
+*-----------------------------------------------------------------------------*/
+static void updatesvr(rtksvr_t *svr, const svrev_t *ev, int index)
+{
+    eph_t *eph2,*eph3;
+    geph_t *geph2,*geph3;
+    gtime_t tof;
+    int i,prn,sys,iode;
+    
+    tracet(4,"updatesvr: type=%d sat=%2d index=%d\n",ev->type,ev->sat,index);
+    
+    if (ev->type==1) { /* observation data */
+        for (i=0;i<ev->n;i++) svr->obs[index][0].data[i]=ev->data[i];
+        svr->obs[index][0].n=ev->n;
+    }
+    else if (ev->type==2) { /* ephemeris */
+        if (satsys(ev->sat,&prn)!=SYS_GLO) {
+            eph2=svr->nav.eph+ev->sat-1;
+            eph3=svr->nav.eph+ev->sat-1+MAXSAT;
+            if (eph2->ttr.time==0||
+                (ev->eph.iode!=eph3->iode&&ev->eph.iode!=eph2->iode)||
+                (timediff(ev->eph.toe,eph3->toe)!=0.0&&
+                 timediff(ev->eph.toe,eph2->toe)!=0.0)) {
+                *eph3=*eph2;
+                *eph2=ev->eph;
+                updatenav(&svr->nav);
+            }
+        }
+        else {
+            geph2=svr->nav.geph+prn-1;
+            geph3=svr->nav.geph+prn-1+MAXPRNGLO;
+            if (geph2->tof.time==0||
+                (ev->geph.iode!=geph3->iode&&ev->geph.iode!=geph2->iode)) {
+                *geph3=*geph2;
+                *geph2=ev->geph;
+                updatenav(&svr->nav);
+                
+                /* glonass fcn for input threads */
+                svr->fcn[prn-1]=ev->geph.frq;
+                svr->nfcn++;
+            }
+        }
+    }
+    else if (ev->type==3) { /* sbas message */
+        if (svr->nsbs<MAXSBSMSG) {
+            svr->sbsmsg[svr->nsbs++]=ev->sbsmsg;
+        }
+        else {
+            for (i=0;i<MAXSBSMSG-1;i++) svr->sbsmsg[i]=svr->sbsmsg[i+1];
+            svr->sbsmsg[i]=ev->sbsmsg;
+        }
+        sbsupdatecorr(&ev->sbsmsg,&svr->nav);
+    }
+    else if (ev->type==9) { /* ion/utc parameters */
+        for (i=0;i<8;i++) svr->nav.ion_gps[i]=ev->ion_gps[i];
+        for (i=0;i<4;i++) svr->nav.utc_gps[i]=ev->utc_gps[i];
+        for (i=0;i<4;i++) svr->nav.ion_gal[i]=ev->ion_gal[i];
+        for (i=0;i<4;i++) svr->nav.utc_gal[i]=ev->utc_gal[i];
+        for (i=0;i<8;i++) svr->nav.ion_qzs[i]=ev->ion_qzs[i];
+        for (i=0;i<4;i++) svr->nav.utc_qzs[i]=ev->utc_qzs[i];
+        svr->nav.leaps=ev->leaps;
+    }
+    else if (ev->type==5) { /* antenna postion parameters */
+        for (i=0;i<3;i++) svr->rtk.rb[i]=ev->rb[i];
+    }
+    else if (ev->type==10) { /* ssr message */
+        iode=ev->ssr.iode;
+        sys=satsys(ev->sat,&prn);
+        
+        /* check corresponding ephemeris exists */
+        if (sys==SYS_GPS||sys==SYS_GAL||sys==SYS_QZS) {
+            if (svr->nav.eph[ev->sat-1       ].iode!=iode&&
+                svr->nav.eph[ev->sat-1+MAXSAT].iode!=iode) {
+                return;
+            }
+        }
+        else if (sys==SYS_GLO) {
+            if (svr->nav.geph[prn-1          ].iode!=iode&&
+                svr->nav.geph[prn-1+MAXPRNGLO].iode!=iode) {
+                return;
+            }
+        }
+        svr->nav.ssr[ev->sat-1]=ev->ssr;
+    }
+    else if (ev->type==31) { /* lex message */
+        lexupdatecorr(&ev->lexmsg,&svr->nav,&tof);
+    }
+    else if (ev->type==SVREV_PEPH) { /* precise ephemeris */
+        if (svr->nav.peph) free(svr->nav.peph);
+        svr->nav.ne=svr->nav.nemax=ev->ne;
+        svr->nav.peph=ev->peph;
+        svr->ftime[index]=utc2gpst(timeget());
+        strcpy(svr->files[index],ev->file);
+    }
+    else if (ev->type==SVREV_PCLK) { /* precise clock */
+        if (svr->nav.pclk) free(svr->nav.pclk);
+        svr->nav.nc=svr->nav.ncmax=ev->ne;
+        svr->nav.pclk=ev->pclk;
+        svr->ftime[index]=utc2gpst(timeget());
+        strcpy(svr->files[index],ev->file);
+    }
+}
+/* decode receiver raw/rtcm data (called by input thread) --------------------*/
+static void decoderaw(rtksvr_t *svr, int index, const unsigned char *buff,
+                      int n, unsigned int tick)
 {
     obs_t *obs;
     nav_t *nav;
     sbsmsg_t *sbsmsg=NULL;
-    int i,ret,sat,fobs=0;
+    int i,ret,sat;
     
     tracet(4,"decoderaw: index=%d\n",index);
     
-    rtksvrlock(svr);
-    
-    for (i=0;i<svr->nb[index];i++) {
+    for (i=0;i<n;i++) {
         
         /* input rtcm/receiver raw data from stream */
         if (svr->format[index]==STRFMT_RTCM2) {
-            ret=input_rtcm2(svr->rtcm+index,svr->buff[index][i]);
+            ret=input_rtcm2(svr->rtcm+index,buff[i]);
             obs=&svr->rtcm[index].obs;
             nav=&svr->rtcm[index].nav;
             sat=svr->rtcm[index].ephsat;
         }
         else if (svr->format[index]==STRFMT_RTCM3) {
-            ret=input_rtcm3(svr->rtcm+index,svr->buff[index][i]);
+            ret=input_rtcm3(svr->rtcm+index,buff[i]);
             obs=&svr->rtcm[index].obs;
             nav=&svr->rtcm[index].nav;
             sat=svr->rtcm[index].ephsat;
         }
         else {
-            ret=input_raw(svr->raw+index,svr->format[index],svr->buff[index][i]);
+            ret=input_raw(svr->raw+index,svr->format[index],buff[i]);
             obs=&svr->raw[index].obs;
             nav=&svr->raw[index].nav;
             sat=svr->raw[index].ephsat;
@@ -306,41 +562,34 @@ static int decoderaw(rtksvr_t *svr, int index)
                   time_str(obs->data[0].time,0),obs->n);
         }
 #endif
-        /* update rtk server */
-        if (ret>0) updatesvr(svr,ret,obs,nav,sat,sbsmsg,index,fobs);
-        
-        /* observation data received */
-        if (ret==1) {
-            if (fobs<MAXOBSBUF) fobs++; else svr->prcout++;
-        }
+        /* input decoded data to positioning thread */
+        if (ret>0) inputev(svr,ret,obs,nav,sat,sbsmsg,index,tick);
     }
-    svr->nb[index]=0;
-    
-    rtksvrunlock(svr);
-    
-    return fobs;
 }
-/* decode download file ------------------------------------------------------*/
-static void decodefile(rtksvr_t *svr, int index)
+/* decode download file (called by input thread) -----------------------------*/
+static void decodefile(rtksvr_t *svr, int index, unsigned int *rp,
+                       unsigned int tick)
 {
     nav_t nav={0};
+    svrev_t *ev;
+    ringbuf_t *ring=svr->buff+index;
     char file[1024];
+    unsigned int wp=ring->wp;
     int nb;
     
     tracet(4,"decodefile: index=%d\n",index);
     
-    rtksvrlock(svr);
-    
     /* check file path completed */
-    if ((nb=svr->nb[index])<=2||
-        svr->buff[index][nb-2]!='\r'||svr->buff[index][nb-1]!='\n') {
-        rtksvrunlock(svr);
+    if ((nb=(int)(wp-*rp))<=2||ring->buff[(wp-2)&(ring->n-1)]!='\r'||
+        ring->buff[(wp-1)&(ring->n-1)]!='\n') {
         return;
     }
-    strncpy(file,(char *)svr->buff[index],nb-2); file[nb-2]='\0';
-    svr->nb[index]=0;
-    
-    rtksvrunlock(svr);
+    if (nb>(int)sizeof(file)) { /* path too long */
+        *rp=wp;
+        return;
+    }
+    nb=ringread(ring,rp,(unsigned char *)file,nb);
+    file[nb>=2?nb-2:0]='\0';
     
     if (svr->format[index]==STRFMT_SP3) { /* precise ephemeris */
         
@@ -350,16 +599,13 @@ static void decodefile(rtksvr_t *svr, int index)
             tracet(1,"sp3 file read error: %s\n",file);
             return;
         }
-        /* update precise ephemeris */
-        rtksvrlock(svr);
-        
-        if (svr->nav.peph) free(svr->nav.peph);
-        svr->nav.ne=svr->nav.nemax=nav.ne;
-        svr->nav.peph=nav.peph;
-        svr->ftime[index]=utc2gpst(timeget());
-        strcpy(svr->files[index],file);
-        
-        rtksvrunlock(svr);
+        /* update precise ephemeris by positioning thread */
+        if (!(ev=newev(svr,index,SVREV_PEPH,tick))) {
+            free(nav.peph);
+            return;
+        }
+        ev->peph=nav.peph;
+        ev->ne=nav.ne;
     }
     else if (svr->format[index]==STRFMT_RNXCLK) { /* precise clock */
         
@@ -368,19 +614,428 @@ static void decodefile(rtksvr_t *svr, int index)
             tracet(1,"rinex clock file read error: %s\n",file);
             return;
         }
-        /* update precise clock */
-        rtksvrlock(svr);
+        /* update precise clock by positioning thread */
+        if (!(ev=newev(svr,index,SVREV_PCLK,tick))) {
+            free(nav.pclk);
+            return;
+        }
+        ev->pclk=nav.pclk;
+        ev->ne=nav.nc;
+    }
+    else return;
+    
+    strncpy(ev->file,file,MAXSTRPATH-1);
+    ev->file[MAXSTRPATH-1]='\0';
+    pushev(svr,index,ev);
+}
+/* input stream thread ---------------------------------------------------------
+* read input stream to the input ring buffer, write it to log stream and
+* decode it to events queued to positioning thread. the data are read, logged
+* and decoded in place of the ring buffer without copy and published to peek
+* by monitors. if no data, wait for the input stream by strwait() up to
+* server cycle
+*-----------------------------------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI inputthread(void *arg)
+#else
+static void *inputthread(void *arg)
+#endif
+{
+    rtksvr_t *svr=(rtksvr_t *)((rtksvrarg_t *)arg)->svr;
+    ringbuf_t *ring;
+    unsigned int tick,nfcn=0,rp;
+    unsigned char *p;
+    int n,m,i=((rtksvrarg_t *)arg)->index;
+    
+    tracet(3,"inputthread: index=%d\n",i);
+    
+    ring=svr->buff+i;
+    rp=ring->wp;
+    
+    while (svr->state) {
+        m=svr->buffsize;
+        p=ringwbuf(ring,&m);
         
-        if (svr->nav.pclk) free(svr->nav.pclk);
-        svr->nav.nc=svr->nav.ncmax=nav.nc;
-        svr->nav.pclk=nav.pclk;
-        svr->ftime[index]=utc2gpst(timeget());
-        strcpy(svr->files[index],file);
+        /* read receiver raw/rtcm data from input stream */
+        if ((n=strread(svr->stream+i,p,m))<=0) {
+            ringpush(ring,0);
+            strwait(svr->stream+i,svr->cycle);
+            continue;
+        }
+        tick=tickus();
         
-        rtksvrunlock(svr);
+        /* write receiver raw/rtcm data to log stream */
+        strwrite(svr->stream+i+5,p,n);
+        
+        /* publish data to monitors */
+        ringpush(ring,n);
+        
+        if (svr->format[i]==STRFMT_SP3||svr->format[i]==STRFMT_RNXCLK) {
+            /* decode download file */
+            decodefile(svr,i,&rp,tick);
+        }
+        else {
+            /* decode receiver raw/rtcm data */
+            updatefcn(svr,&svr->raw[i].nav,&nfcn);
+            decoderaw(svr,i,p,n,tick);
+        }
+    }
+    return 0;
+}
+/* rover observation data positioning ----------------------------------------*/
+static void procobs(rtksvr_t *svr, const svrev_t *ev, obs_t *obs)
+{
+    double tt,lat[4];
+    unsigned int tick=tickget(),ticks[4];
+    int i;
+    
+    ticks[0]=ev->tick;
+    ticks[1]=ev->tdec;
+    ticks[2]=tickus();
+    
+    obs->n=0;
+    for (i=0;i<ev->n&&obs->n<MAXOBS*2;i++) {
+        obs->data[obs->n++]=ev->data[i];
+    }
+    for (i=0;i<svr->obs[1][0].n&&obs->n<MAXOBS*2;i++) {
+        obs->data[obs->n++]=svr->obs[1][0].data[i];
+    }
+    /* rtk positioning */
+    rtksvrlock(svr);
+    updatesvr(svr,ev,0);
+    rtkpos(&svr->rtk,obs->data,obs->n,&svr->nav);
+    rtksvrunlock(svr);
+    
+    ticks[3]=tickus();
+    
+    if ((svr->cputime=(int)(tickget()-tick))<=0) svr->cputime=1;
+    
+    /* if cpu overload, increment obs outage counter by queued events */
+    if (svr->cputime>=svr->cycle) svr->prcout+=spscnum(svr->evq)-1;
+    
+    /* latency of rover epoch */
+    addlat(svr,svr->lat[0]+LATSTG_DEC,ticks[0],ticks[1]);
+    addlat(svr,svr->lat[0]+LATSTG_QUE,ticks[1],ticks[2]);
+    addlat(svr,svr->lat[0]+LATSTG_POS,ticks[2],ticks[3]);
+    
+    if (svr->rtk.sol.stat!=SOLQ_NONE) {
+        
+        /* adjust current time by latency from stream input */
+        tt=(int)(ticks[3]-ev->tick)*1E-6+DTTOL;
+        timeset(gpst2utc(timeadd(svr->rtk.sol.time,tt)));
+        
+        /* output latency to solution status */
+        if (svr->outlat) {
+            lat[0]=(int)(ticks[1]-ticks[0])*1E-3;
+            lat[1]=(int)(ticks[2]-ticks[1])*1E-3;
+            lat[2]=(int)(ticks[3]-ticks[2])*1E-3;
+            lat[3]=(int)(ticks[3]-ticks[0])*1E-3;
+            rtkoutlat(&svr->rtk,lat);
+        }
+        /* write solution */
+        writesol(svr,ticks);
+    }
+}
+/* wait for input events -----------------------------------------------------*/
+static void waitev(rtksvr_t *svr, int ms)
+{
+    int i;
+    
+    lock(&svr->qlock);
+    for (i=0;i<3;i++) if (spscnum(svr->evq+i)>0) break;
+    if (i>=3&&svr->state) waitcond(&svr->evcond,&svr->qlock,ms);
+    unlock(&svr->qlock);
+}
+/* queue rover to positioning job queue (called with qlock) ------------------*/
+static void pushjob(rtksvr_t *svr, int index)
+{
+    svr->jobq[(svr->jobp+svr->njob)%svr->nrov]=index;
+    svr->njob++;
+    svr->rov[index].job=1;
+    signalcond(&svr->jobcond);
+}
+/* input rover observation data (called by rover input thread) ---------------*/
+static void inputrov(rtksvr_t *svr, int index, const obs_t *obs)
+{
+    rtkrov_t *rov=svr->rov+index;
+    rovobs_t *ob;
+    obs_t evobs={0};
+    int i,n=0;
+    
+    rov->nobs++;
+    
+    if (!(ob=(rovobs_t *)spscwbuf(&rov->obsq))) {
+        tracet(2,"rover observation data queue overflow: rover=%d\n",index);
+        return;
+    }
+    for (i=0;i<obs->n&&n<MAXOBS;i++) {
+        if (rov->rtk.opt.exsats[obs->data[i].sat-1]==1||
+            !(satsys(obs->data[i].sat,NULL)&rov->rtk.opt.navsys)) continue;
+        ob->data[n]=obs->data[i];
+        ob->data[n++].rcv=1;
+    }
+    evobs.data=ob->data; evobs.n=evobs.nmax=n;
+    ob->n=sortobs(&evobs)>0?evobs.n:0;
+    spscpush(&rov->obsq);
+    
+    lock(&svr->qlock);
+    if (!rov->job) pushjob(svr,index);
+    unlock(&svr->qlock);
+}
+/* decode rover raw/rtcm data (called by rover input thread) -----------------*/
+static void decoderov(rtksvr_t *svr, int index, const unsigned char *buff,
+                      int n)
+{
+    rtkrov_t *rov=svr->rov+index;
+    obs_t *obs;
+    int i;
+    
+    tracet(4,"decoderov: index=%d\n",index);
+    
+    /* update glonass fcn of rover decoder by shared navigation data */
+    if (rov->format==STRFMT_RTCM2||rov->format==STRFMT_RTCM3) {
+        updatefcn(svr,&rov->rtcm.nav,&rov->nfcn);
+    }
+    else {
+        updatefcn(svr,&rov->raw.nav,&rov->nfcn);
+    }
+    for (i=0;i<n;i++) {
+        if (rov->format==STRFMT_RTCM2) {
+            if (input_rtcm2(&rov->rtcm,buff[i])!=1) continue;
+            obs=&rov->rtcm.obs;
+        }
+        else if (rov->format==STRFMT_RTCM3) {
+            if (input_rtcm3(&rov->rtcm,buff[i])!=1) continue;
+            obs=&rov->rtcm.obs;
+        }
+        else {
+            if (input_raw(&rov->raw,rov->format,buff[i])!=1) continue;
+            obs=&rov->raw.obs;
+        }
+        inputrov(svr,index,obs);
     }
 }
-/* rtk server thread ---------------------------------------------------------*/
+/* rover input thread ----------------------------------------------------------
+* read and decode input streams of all rovers of multi-rover mode and queue
+* the observation data to positioning workers. navigation data of rover
+* streams are not used but glonass fcn of the shared navigation data are set
+* to the rover decoders. if no data, wait for the input streams by strwaits()
+* up to server cycle
+*-----------------------------------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI rovinputthread(void *arg)
+#else
+static void *rovinputthread(void *arg)
+#endif
+{
+    rtksvr_t *svr=(rtksvr_t *)arg;
+    stream_t **streams;
+    unsigned char *buff;
+    int i,n,nb;
+    
+    tracet(3,"rovinputthread: nrov=%d\n",svr->nrov);
+    
+    if (!(buff=(unsigned char *)malloc(svr->buffsize))||
+        !(streams=(stream_t **)malloc(sizeof(stream_t *)*svr->nrov))) {
+        tracet(1,"rovinputthread: malloc error\n");
+        free(buff);
+        return 0;
+    }
+    for (i=0;i<svr->nrov;i++) streams[i]=svr->rov[i].stream;
+    
+    while (svr->state) {
+        for (i=nb=0;i<svr->nrov;i++) {
+            
+            /* read rover raw/rtcm data from input stream */
+            if ((n=strread(svr->rov[i].stream,buff,svr->buffsize))<=0) {
+                continue;
+            }
+            /* decode and queue rover observation data */
+            decoderov(svr,i,buff,n);
+            nb+=n;
+        }
+        if (!nb) strwaits(streams,svr->nrov,svr->cycle);
+    }
+    free(buff);
+    free(streams);
+    return 0;
+}
+/* rover observation data positioning (called by positioning worker) ---------*/
+static void procrov(rtksvr_t *svr, rtkrov_t *rov, const rovobs_t *ob,
+                    obsd_t *data)
+{
+    unsigned char buff[MAXSOLOUT*2];
+    unsigned int tick=tickget();
+    int i,n=0;
+    
+    for (i=0;i<ob->n;i++) data[n++]=ob->data[i];
+    
+    /* rtk positioning with shared navigation and base station data */
+    rdlock(&svr->navlock);
+    for (i=0;i<svr->obs[1][0].n&&n<MAXOBS*2;i++) {
+        data[n++]=svr->obs[1][0].data[i];
+    }
+    if (rov->rtk.opt.mode!=PMODE_MOVEB) {
+        for (i=0;i<6;i++) rov->rtk.rb[i]=svr->rtk.rb[i];
+    }
+    rtkpos(&rov->rtk,data,n,&svr->nav);
+    rdunlock(&svr->navlock);
+    
+    if ((rov->cputime=(int)(tickget()-tick))<=0) rov->cputime=1;
+    
+    if (rov->rtk.sol.stat==SOLQ_NONE) return;
+    
+    /* write solution to rover solution stream */
+    n =outsols (buff  ,&rov->rtk.sol,rov->rtk.rb  ,svr->solopt);
+    n+=outsolexs(buff+n,&rov->rtk.sol,rov->rtk.ssat,svr->solopt);
+    strwrite(rov->stream+1,buff,n);
+    rov->nsol++;
+}
+/* positioning worker thread ---------------------------------------------------
+* positioning worker of rovers of multi-rover mode. a worker takes a rover
+* from the job queue and processes all queued observation data of the rover.
+* a rover is queued only once until the worker releases it, so the epochs of
+* a rover are processed in order by one worker at a time
+*-----------------------------------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI workthread(void *arg)
+#else
+static void *workthread(void *arg)
+#endif
+{
+    rtksvr_t *svr=(rtksvr_t *)arg;
+    rtkrov_t *rov;
+    rovobs_t *ob;
+    obsd_t data[MAXOBS*2];
+    int i;
+    
+    tracet(3,"workthread:\n");
+    
+    for (;;) {
+        lock(&svr->qlock);
+        while (svr->state&&svr->njob<=0) {
+            waitcond(&svr->jobcond,&svr->qlock,1000);
+        }
+        if (svr->njob<=0) {
+            unlock(&svr->qlock);
+            break;
+        }
+        i=svr->jobq[svr->jobp];
+        svr->jobp=(svr->jobp+1)%svr->nrov;
+        svr->njob--;
+        unlock(&svr->qlock);
+        
+        rov=svr->rov+i;
+        while ((ob=(rovobs_t *)spscrbuf(&rov->obsq))) {
+            procrov(svr,rov,ob,data);
+            spscpop(&rov->obsq);
+        }
+        /* release rover or queue it again if data arrived */
+        lock(&svr->qlock);
+        if (spscnum(&rov->obsq)>0) pushjob(svr,i); else rov->job=0;
+        unlock(&svr->qlock);
+    }
+    return 0;
+}
+/* start rover of multi-rover mode -------------------------------------------*/
+static int startrov(rtksvr_t *svr, rtkrov_t *rov, const prcopt_t *prcopt)
+{
+    gtime_t time;
+    int i,rw;
+    
+    rtkfree(&rov->rtk);
+    rtkinit(&rov->rtk,prcopt);
+    rov->rtk.opt.pcorlog=svr->rtk.opt.pcorlog; /* shared with rtk server */
+    for (i=0;i<6;i++) {
+        rov->rtk.rb[i]=i<3?prcopt->rb[i]:0.0;
+    }
+    rov->job=0;
+    rov->nobs=rov->nsol=rov->nfcn=0;
+    rov->cputime=0;
+    
+    /* initialize receiver raw or rtcm control */
+    if (rov->format==STRFMT_RTCM2||rov->format==STRFMT_RTCM3) {
+        if (!init_rtcm(&rov->rtcm)) return 0;
+        strcpy(rov->rtcm.opt,rov->opt);
+    }
+    else {
+        if (!init_raw(&rov->raw)) return 0;
+        strcpy(rov->raw.opt,rov->opt);
+    }
+    /* observation data queue to positioning workers */
+    if (!spscinit(&rov->obsq,sizeof(rovobs_t),NROVQ)) return 0;
+    
+    /* open input and solution streams */
+    rw=rov->strs[0]!=STR_FILE?STR_MODE_RW:STR_MODE_R;
+    if (!stropen(rov->stream  ,rov->strs[0],rw        ,rov->paths[0])||
+        !stropen(rov->stream+1,rov->strs[1],STR_MODE_W,rov->paths[1])) {
+        return 0;
+    }
+    /* sync input file with rover input file of rtk server */
+    strsync(svr->stream,rov->stream);
+    
+    /* set initial time for rtcm and raw */
+    time=rov->strs[0]==STR_FILE?strgettime(rov->stream):utc2gpst(timeget());
+    rov->raw.time=rov->rtcm.time=time;
+    
+    /* write solution header to solution stream */
+    writesolhead(rov->stream+1,svr->solopt);
+    return 1;
+}
+/* stop rover of multi-rover mode --------------------------------------------*/
+static void stoprov(rtkrov_t *rov)
+{
+    strclose(rov->stream  );
+    strclose(rov->stream+1);
+    if (rov->format==STRFMT_RTCM2||rov->format==STRFMT_RTCM3) {
+        free_rtcm(&rov->rtcm);
+    }
+    else free_raw(&rov->raw);
+    spscfree(&rov->obsq);
+}
+/* free rovers of multi-rover mode -------------------------------------------*/
+static void freerov(rtksvr_t *svr)
+{
+    int i;
+    
+    for (i=0;i<svr->nrov;i++) rtkfree(&svr->rov[i].rtk);
+    free(svr->rov    ); svr->rov    =NULL;
+    free(svr->jobq   ); svr->jobq   =NULL;
+    free(svr->wthread); svr->wthread=NULL;
+    svr->nrov=svr->nwork=svr->njob=svr->jobp=0;
+}
+/* create/join rtk server thread ---------------------------------------------*/
+#ifdef WIN32
+static int createthread(thread_t *thread, LPTHREAD_START_ROUTINE func,
+                        void *arg)
+{
+    return (*thread=CreateThread(NULL,0,func,arg,0,NULL))!=NULL;
+}
+static void jointhread(thread_t thread)
+{
+    WaitForSingleObject(thread,INFINITE);
+    CloseHandle(thread);
+}
+#else
+static int createthread(thread_t *thread, void *(*func)(void *), void *arg)
+{
+    return !pthread_create(thread,NULL,func,arg);
+}
+static void jointhread(thread_t thread)
+{
+    pthread_join(thread,NULL);
+}
+#endif
+/* rtk server thread -----------------------------------------------------------
+* positioning thread of rtk server. the input streams are read and decoded by
+* an input thread for each stream and the decoded observation data and
+* navigation data are queued as events to the positioning thread. the
+* solutions are queued to the solution output thread writing them to the
+* output streams. the positioning thread waits for the input events without
+* polling cycle. in multi-rover mode, the rovers are read by a rover input
+* thread and positioned by worker threads with the navigation and base
+* station data updated by the positioning thread.
+*-----------------------------------------------------------------------------*/
 #ifdef WIN32
 static DWORD WINAPI rtksvrthread(void *arg)
 #else
@@ -388,12 +1043,11 @@ static void *rtksvrthread(void *arg)
 #endif
 {
     rtksvr_t *svr=(rtksvr_t *)arg;
+    svrev_t *ev;
     obs_t obs;
     obsd_t data[MAXOBS*2];
-    double tt;
     unsigned int tick,ticknmea,tick1hz;
-    unsigned char *p,*q;
-    int i,j,n,fobs[3]={0},cycle,cputime;
+    int i,n,nin=0,nw=0,out,rin=0;
     
     tracet(3,"rtksvrthread:\n");
     
@@ -401,70 +1055,63 @@ static void *rtksvrthread(void *arg)
     svr->tick=tickget();
     ticknmea=tick1hz=svr->tick-1000;
     
-    for (cycle=0;svr->state;cycle++) {
-        tick=tickget();
+    /* start solution output and input threads */
+    svr->ostate=1;
+    if (!(out=createthread(&svr->othread,outputthread,svr))) {
+        svr->ostate=0;
+    }
+    for (nin=0;nin<3;nin++) {
+        svr->arg[nin].svr=svr;
+        svr->arg[nin].index=nin;
+        if (!createthread(svr->ithread+nin,inputthread,svr->arg+nin)) break;
+    }
+    /* start rover input and positioning worker threads of multi-rover */
+    if (svr->nrov>0) {
+        rin=createthread(&svr->rthread,rovinputthread,svr);
+        for (nw=0;nw<svr->nwork;nw++) {
+            if (!createthread(svr->wthread+nw,workthread,svr)) break;
+        }
+    }
+    if (!out||nin<3||(svr->nrov>0&&(!rin||nw<svr->nwork))) {
+        tracet(1,"rtksvrthread: thread create error\n");
+        svr->state=0;
+    }
+    while (svr->state) {
         
-        for (i=0;i<3;i++) {
-            p=svr->buff[i]+svr->nb[i]; q=svr->buff[i]+svr->buffsize;
-            
-            /* read receiver raw/rtcm data from input stream */
-            if ((n=strread(svr->stream+i,p,q-p))<=0) {
-                continue;
-            }
-            /* write receiver raw/rtcm data to log stream */
-            strwrite(svr->stream+i+5,p,n);
-            svr->nb[i]+=n;
-            
-            /* save peek buffer */
-            rtksvrlock(svr);
-            n=n<svr->buffsize-svr->npb[i]?n:svr->buffsize-svr->npb[i];
-            memcpy(svr->pbuf[i]+svr->npb[i],p,n);
-            svr->npb[i]+=n;
-            rtksvrunlock(svr);
-        }
-        for (i=0;i<3;i++) {
-            if (svr->format[i]==STRFMT_SP3||svr->format[i]==STRFMT_RNXCLK) {
-                /* decode download file */
-                decodefile(svr,i);
-            }
-            else {
-                /* decode receiver raw/rtcm data */
-                fobs[i]=decoderaw(svr,i);
+        /* update by base station and correction events */
+        for (i=1,n=0;i<3;i++) {
+            while ((ev=(svrev_t *)spscrbuf(svr->evq+i))) {
+                addlat(svr,svr->lat[i]+LATSTG_DEC,ev->tick,ev->tdec);
+                addlat(svr,svr->lat[i]+LATSTG_QUE,ev->tdec,tickus());
+                rtksvrlock(svr);
+                wrlock(&svr->navlock);
+                updatesvr(svr,ev,i);
+                wrunlock(&svr->navlock);
+                rtksvrunlock(svr);
+                spscpop(svr->evq+i);
+                n++;
             }
         }
-        for (i=0;i<fobs[0];i++) { /* for each rover observation data */
-            obs.n=0;
-            for (j=0;j<svr->obs[0][i].n&&obs.n<MAXOBS*2;j++) {
-                obs.data[obs.n++]=svr->obs[0][i].data[j];
-            }
-            for (j=0;j<svr->obs[1][0].n&&obs.n<MAXOBS*2;j++) {
-                obs.data[obs.n++]=svr->obs[1][0].data[j];
+        /* rover event */
+        if ((ev=(svrev_t *)spscrbuf(svr->evq))) {
+            if (ev->type==1) { /* rover observation data */
+                procobs(svr,ev,&obs);
             }
-            /* rtk positioning */
-            rtksvrlock(svr);
-            rtkpos(&svr->rtk,obs.data,obs.n,&svr->nav);
-            rtksvrunlock(svr);
-            
-            if (svr->rtk.sol.stat!=SOLQ_NONE) {
-                
-                /* adjust current time */
-                tt=(int)(tickget()-tick)/1000.0+DTTOL;
-                timeset(gpst2utc(timeadd(svr->rtk.sol.time,tt)));
-                
-                /* write solution */
-                writesol(svr,i);
-            }
-            /* if cpu overload, inclement obs outage counter and break */
-            if ((int)(tickget()-tick)>=svr->cycle) {
-                svr->prcout+=fobs[0]-i-1;
-#if 0 /* omitted v.2.4.1 */
-                break;
-#endif
+            else {
+                rtksvrlock(svr);
+                wrlock(&svr->navlock);
+                updatesvr(svr,ev,0);
+                wrunlock(&svr->navlock);
+                rtksvrunlock(svr);
             }
+            spscpop(svr->evq);
+            n++;
         }
+        tick=tickget();
+        
         /* send null solution if no solution (1hz) */
         if (svr->rtk.sol.stat==SOLQ_NONE&&(int)(tick-tick1hz)>=1000) {
-            writesol(svr,0);
+            writesol(svr,NULL);
             tick1hz=tick;
         }
         /* send nmea request to base/nrtk input stream */
@@ -479,23 +1126,41 @@ static void *rtksvrthread(void *arg)
             }
             ticknmea=tick;
         }
-        if ((cputime=(int)(tickget()-tick))>0) svr->cputime=cputime;
-        
-        /* sleep until next cycle */
-        sleepms(svr->cycle-cputime);
+        /* wait for input events until next cycle */
+        if (!n) waitev(svr,svr->cycle);
+    }
+    /* stop input threads and solution output thread */
+    for (i=0;i<nin;i++) jointhread(svr->ithread[i]);
+    if (rin) jointhread(svr->rthread);
+    
+    /* stop positioning workers after processing queued jobs */
+    lock(&svr->qlock);
+    broadcastcond(&svr->jobcond);
+    unlock(&svr->qlock);
+    for (i=0;i<nw;i++) jointhread(svr->wthread[i]);
+    if (out) {
+        lock(&svr->qlock);
+        svr->ostate=0;
+        signalcond(&svr->solcond);
+        unlock(&svr->qlock);
+        jointhread(svr->othread);
+    }
+    /* free precise products of unprocessed events */
+    for (i=0;i<3;i++) {
+        while ((ev=(svrev_t *)spscrbuf(svr->evq+i))) {
+            if (ev->type==SVREV_PEPH) free(ev->peph);
+            if (ev->type==SVREV_PCLK) free(ev->pclk);
+            spscpop(svr->evq+i);
+        }
     }
     for (i=0;i<MAXSTRRTK;i++) strclose(svr->stream+i);
     for (i=0;i<3;i++) {
-        svr->nb[i]=svr->npb[i]=0;
-        free(svr->buff[i]); svr->buff[i]=NULL;
-        free(svr->pbuf[i]); svr->pbuf[i]=NULL;
         free_raw (svr->raw +i);
         free_rtcm(svr->rtcm+i);
+        spscfree(svr->evq+i);
     }
-    for (i=0;i<2;i++) {
-        svr->nsb[i]=0;
-        free(svr->sbuf[i]); svr->sbuf[i]=NULL;
-    }
+    spscfree(&svr->solq);
+    for (i=0;i<svr->nrov;i++) stoprov(svr->rov+i);
     return 0;
 }
 /* initialize rtk server -------------------------------------------------------
@@ -521,12 +1186,9 @@ extern int rtksvrinit(rtksvr_t *svr)
     for (i=0;i<2;i++) svr->solopt[i]=solopt_default;
     svr->navsel=svr->nsbs=svr->nsol=0;
     rtkinit(&svr->rtk,&prcopt_default);
-    for (i=0;i<3;i++) svr->nb[i]=0;
-    for (i=0;i<2;i++) svr->nsb[i]=0;
-    for (i=0;i<3;i++) svr->npb[i]=0;
-    for (i=0;i<3;i++) svr->buff[i]=NULL;
-    for (i=0;i<2;i++) svr->sbuf[i]=NULL;
-    for (i=0;i<3;i++) svr->pbuf[i]=NULL;
+    memset(&svr->pcorlog,0,sizeof(pcorlog_t));
+    for (i=0;i<3;i++) memset(svr->buff+i,0,sizeof(ringbuf_t));
+    for (i=0;i<2;i++) memset(svr->sbuf+i,0,sizeof(ringbuf_t));
     for (i=0;i<MAXSOLBUF;i++) svr->solbuf[i]=sol0;
     for (i=0;i<3;i++) for (j=0;j<10;j++) svr->nmsg[i][j]=0;
     for (i=0;i<3;i++) svr->ftime[i]=time0;
@@ -534,7 +1196,18 @@ extern int rtksvrinit(rtksvr_t *svr)
     svr->moni=NULL;
     svr->tick=0;
     svr->thread=0;
-    svr->cputime=svr->prcout=0;
+    svr->cputime=svr->prcout=svr->solout=0;
+    svr->ostate=0;
+    for (i=0;i<3;i++) memset(svr->evq+i,0,sizeof(spscq_t));
+    memset(&svr->solq,0,sizeof(spscq_t));
+    for (i=0;i<MAXPRNGLO;i++) svr->fcn[i]=-999;
+    svr->nfcn=0;
+    for (i=0;i<3;i++) for (j=0;j<NLATSTG;j++) svr->lat[i][j].n=0;
+    svr->outlat=0;
+    svr->nrov=svr->nwork=svr->njob=svr->jobp=0;
+    svr->rov=NULL;
+    svr->wthread=NULL;
+    svr->jobq=NULL;
     
     if (!(svr->nav.eph =(eph_t  *)malloc(sizeof(eph_t )*MAXSAT *2))||
         !(svr->nav.geph=(geph_t *)malloc(sizeof(geph_t)*NSATGLO*2))||
@@ -562,6 +1235,12 @@ extern int rtksvrinit(rtksvr_t *svr)
     for (i=0;i<MAXSTRRTK;i++) strinit(svr->stream+i);
     
     initlock(&svr->lock);
+    initlock(&svr->qlock);
+    initlock(&svr->latlock);
+    initcond(&svr->evcond);
+    initcond(&svr->solcond);
+    initcond(&svr->jobcond);
+    initrwlock(&svr->navlock);
     
     return 1;
 }
@@ -580,7 +1259,12 @@ extern void rtksvrfree(rtksvr_t *svr)
     for (i=0;i<3;i++) for (j=0;j<MAXOBSBUF;j++) {
         free(svr->obs[i][j].data);
     }
+    for (i=0;i<3;i++) spscfree(svr->evq+i);
+    spscfree(&svr->solq);
+    for (i=0;i<3;i++) ringfree(svr->buff+i);
+    for (i=0;i<2;i++) ringfree(svr->sbuf+i);
     rtkfree(&svr->rtk);
+    freerov(svr);
 }
 /* lock/unlock rtk server ------------------------------------------------------
 * lock/unlock rtk server
@@ -593,7 +1277,7 @@ extern void rtksvrunlock(rtksvr_t *svr) {unlock(&svr->lock);}
 /* start rtk server ------------------------------------------------------------
 * start rtk server thread
 * args   : rtksvr_t *svr    IO rtk server
-*          int     cycle    I  server cycle (ms)
+*          int     cycle    I  input polling and idle wait cycle (ms)
 *          int     buffsize I  input buffer size (bytes)
 *          int     *strs    I  stream types (STR_???)
 *                              types[0]=input stream rover
@@ -636,7 +1320,7 @@ extern int rtksvrstart(rtksvr_t *svr, int cycle, int buffsize, int *strs,
                        solopt_t *solopt, stream_t *moni)
 {
     gtime_t time,time0={0};
-    int i,j,rw;
+    int i,j,n,rw;
     
     tracet(3,"rtksvrstart: cycle=%d buffsize=%d navsel=%d nmeacycle=%d nmeareq=%d\n",
            cycle,buffsize,navsel,nmeacycle,nmeareq);
@@ -653,20 +1337,32 @@ extern int rtksvrstart(rtksvr_t *svr, int cycle, int buffsize, int *strs,
     svr->navsel=navsel;
     svr->nsbs=0;
     svr->nsol=0;
-    svr->prcout=0;
+    svr->prcout=svr->solout=0;
     rtkfree(&svr->rtk);
     rtkinit(&svr->rtk,prcopt);
     
+    /* open pseudorange correction log flushed by thread */
+    if (pcorlogopen(&svr->pcorlog,"log",PCORLOGBUFF,PCORLOGFLUSH)) {
+        svr->rtk.opt.pcorlog=&svr->pcorlog;
+    }
+    
     for (i=0;i<3;i++) { /* input/log streams */
-        svr->nb[i]=svr->npb[i]=0;
-        if (!(svr->buff[i]=(unsigned char *)malloc(buffsize))||
-            !(svr->pbuf[i]=(unsigned char *)malloc(buffsize))) {
+        
+        /* input ring buffer kept for monitors until next start */
+        ringfree(svr->buff+i);
+        if (!ringinit(svr->buff+i,svr->buffsize*2)) {
             tracet(1,"rtksvrstart: malloc error\n");
             return 0;
         }
         for (j=0;j<10;j++) svr->nmsg[i][j]=0;
         for (j=0;j<MAXOBSBUF;j++) svr->obs[i][j].n=0;
         
+        /* decoded input event queue */
+        if (!spscinit(svr->evq+i,sizeof(svrev_t),MAXOBSBUF)) {
+            tracet(1,"rtksvrstart: malloc error\n");
+            return 0;
+        }
+        
         /* initialize receiver raw and rtcm control */
         init_raw (svr->raw +i);
         init_rtcm(svr->rtcm+i);
@@ -678,8 +1374,20 @@ extern int rtksvrstart(rtksvr_t *svr, int cycle, int buffsize, int *strs,
         /* connect dgps corrections */
         svr->rtcm[i].dgps=svr->nav.dgps;
     }
-    for (i=0;i<2;i++) { /* output peek buffer */
-        if (!(svr->sbuf[i]=(unsigned char *)malloc(buffsize))) {
+    if (!spscinit(&svr->solq,sizeof(svrsol_t),NSOLQ)) {
+        tracet(1,"rtksvrstart: malloc error\n");
+        return 0;
+    }
+    for (i=0;i<MAXPRNGLO;i++) svr->fcn[i]=-999;
+    svr->nfcn=0;
+    for (i=0;i<3;i++) for (j=0;j<NLATSTG;j++) svr->lat[i][j].n=0;
+    
+    for (i=0;i<2;i++) { /* output ring buffer */
+        
+        /* hold all solutions queued to output thread without overwrite */
+        n=(NSOLQ+1)*MAXSOLOUT*2;
+        ringfree(svr->sbuf+i);
+        if (!ringinit(svr->sbuf+i,n>svr->buffsize*2?n:svr->buffsize*2)) {
             tracet(1,"rtksvrstart: malloc error\n");
             return 0;
         }
@@ -728,13 +1436,23 @@ extern int rtksvrstart(rtksvr_t *svr, int cycle, int buffsize, int *strs,
     for (i=3;i<5;i++) {
         writesolhead(svr->stream+i,svr->solopt+i-3);
     }
+    /* start rovers of multi-rover mode */
+    svr->njob=svr->jobp=0;
+    for (n=0;n<svr->nrov;n++) {
+        if (!startrov(svr,svr->rov+n,prcopt)) {
+            tracet(1,"rtksvrstart: rover start error: rover=%d\n",n);
+            break;
+        }
+    }
     /* create rtk server thread */
 #ifdef WIN32
-    if (!(svr->thread=CreateThread(NULL,0,rtksvrthread,svr,0,NULL))) {
+    if (n<svr->nrov||
+        !(svr->thread=CreateThread(NULL,0,rtksvrthread,svr,0,NULL))) {
 #else
-    if (pthread_create(&svr->thread,NULL,rtksvrthread,svr)) {
+    if (n<svr->nrov||pthread_create(&svr->thread,NULL,rtksvrthread,svr)) {
 #endif
         for (i=0;i<MAXSTRRTK;i++) strclose(svr->stream+i);
+        for (i=0;i<=n&&i<svr->nrov;i++) stoprov(svr->rov+i);
         return 0;
     }
     return 1;
@@ -771,6 +1489,66 @@ extern void rtksvrstop(rtksvr_t *svr, char **cmds)
 #else
     pthread_join(svr->thread,NULL);
 #endif
+    svr->rtk.opt.pcorlog=NULL;
+    for (i=0;i<svr->nrov;i++) svr->rov[i].rtk.opt.pcorlog=NULL;
+    pcorlogclose(&svr->pcorlog);
+}
+/* set rovers of multi-rover mode ----------------------------------------------
+* set rovers positioned by worker threads with the navigation and base station
+* data shared with the rtk server
+* args   : rtksvr_t *svr    IO rtk server
+*          int     nrov     I  number of rovers (0:multi-rover mode off)
+*          int     nwork    I  number of positioning worker threads
+*          int     *strs    I  stream types (STR_???)
+*                              strs[i*2  ]=input stream rover i
+*                              strs[i*2+1]=output stream solution rover i
+*          char    **paths  I  stream paths (same as strs)
+*          int     *formats I  input stream formats of rovers (STRFMT_???)
+*          char    **rcvopts I receiver options of rovers
+* return : status (1:ok 0:error)
+* notes  : call it before rtksvrstart(). the rovers are started and stopped
+*          with the rtk server and processed by the processing options of
+*          rtksvrstart(). the solutions are output with the solution 1 options.
+*          the ephemerides of the rovers are not used. the navigation data are
+*          input by the rover, base station or correction stream of the rtk
+*          server. the solution status of rtkopenstat() is not separated by
+*          rovers and should be off in multi-rover mode.
+*-----------------------------------------------------------------------------*/
+extern int rtksvrsetrov(rtksvr_t *svr, int nrov, int nwork, const int *strs,
+                        char **paths, const int *formats, char **rcvopts)
+{
+    rtkrov_t *rov;
+    int i,j;
+    
+    tracet(3,"rtksvrsetrov: nrov=%d nwork=%d\n",nrov,nwork);
+    
+    if (svr->state) return 0;
+    
+    freerov(svr);
+    if (nrov<=0) return 1;
+    
+    if (nwork<1) nwork=1;
+    if (!(svr->rov=(rtkrov_t *)calloc(nrov,sizeof(rtkrov_t)))||
+        !(svr->jobq=(int *)malloc(sizeof(int)*nrov))||
+        !(svr->wthread=(thread_t *)malloc(sizeof(thread_t)*nwork))) {
+        tracet(1,"rtksvrsetrov: malloc error\n");
+        freerov(svr);
+        return 0;
+    }
+    svr->nrov=nrov;
+    svr->nwork=nwork;
+    
+    for (i=0;i<nrov;i++) {
+        rov=svr->rov+i;
+        for (j=0;j<2;j++) {
+            rov->strs[j]=strs[i*2+j];
+            strncpy(rov->paths[j],paths[i*2+j],MAXSTRPATH-1);
+            strinit(rov->stream+j);
+        }
+        strncpy(rov->opt,rcvopts[i],sizeof(rov->opt)-1);
+        rov->format=formats[i];
+    }
+    return 1;
 }
 /* open output/log stream ------------------------------------------------------
 * open output/log stream
@@ -894,3 +1672,74 @@ extern void rtksvrsstat(rtksvr_t *svr, int *sstat, char *msg)
     }
     rtksvrunlock(svr);
 }
+/* peek input/solution data ----------------------------------------------------
+* read input stream data or solution data of rtk server for monitor without
+* lock
+* args   : rtksvr_t *svr    I  rtk server
+*          int     index    I  data index
+*                              (0:rover,1:base,2:corr,3:sol1,4:sol2)
+*          unsigned int *rp IO reader cursor of the monitor
+*                              (set 0 to read from the oldest data)
+*          unsigned char *buff O data buffer
+*          int     nmax     I  max data length (bytes)
+* return : data length (bytes)
+* notes  : each monitor should hold its own reader cursor. the data not read
+*          before overwritten by the server are skipped.
+*-----------------------------------------------------------------------------*/
+extern int rtksvrpeek(rtksvr_t *svr, int index, unsigned int *rp,
+                      unsigned char *buff, int nmax)
+{
+    tracet(4,"rtksvrpeek: index=%d\n",index);
+    
+    if (index<0||index>4) return 0;
+    
+    return ringread(index<3?svr->buff+index:svr->sbuf+index-3,rp,buff,nmax);
+}
+/* get latency statistics ------------------------------------------------------
+* get percentiles of latency of rtk server for recent epochs
+* args   : rtksvr_t *svr    I  rtk server
+*          int     index    I  input stream index (0:rover,1:base,2:corr)
+*          int     stage    I  latency stage (LATSTG_???)
+*          double  *lat     O  latency {p50,p95,p99,max} (ms)
+* return : number of samples (0: no sample)
+* notes  : the samples are the last NLATWIN epochs of the rover observation
+*          data, or the last NLATWIN decoded data of the base station and
+*          correction. only the stages LATSTG_DEC and LATSTG_QUE are available
+*          for the base station and correction.
+*          the latency of each epoch is output to the solution status as
+*          $LAT record if svr->outlat is set (see rtkoutlat()).
+*-----------------------------------------------------------------------------*/
+extern int rtksvrlat(rtksvr_t *svr, int index, int stage, double *lat)
+{
+    static const double p[]={0.50,0.95,0.99,1.00};
+    latstat_t *latst;
+    double *x;
+    int i,j,n;
+    
+    tracet(4,"rtksvrlat: index=%d stage=%d\n",index,stage);
+    
+    for (i=0;i<4;i++) lat[i]=0.0;
+    
+    if (index<0||index>2||stage<0||stage>=NLATSTG) return 0;
+    
+    latst=svr->lat[index]+stage;
+    if (!(x=(double *)malloc(sizeof(double)*NLATWIN))) return 0;
+    
+    lock(&svr->latlock);
+    n=latst->n<NLATWIN?(int)latst->n:NLATWIN;
+    for (i=0;i<n;i++) x[i]=latst->lat[i];
+    unlock(&svr->latlock);
+    
+    if (n<=0) {
+        free(x);
+        return 0;
+    }
+    qsort(x,n,sizeof(double),cmplat);
+    
+    for (i=0;i<4;i++) {
+        j=(int)ceil(p[i]*n)-1;
+        lat[i]=x[j<0?0:j];
+    }
+    free(x);
+    return n;
+}
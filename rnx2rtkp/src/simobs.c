@@ -0,0 +1,271 @@
+/*------------------------------------------------------------------------------
+* simobs.c : synthetic gnss observation generator
+*
+* generate pseudorange, carrier-phase, doppler and snr of static receivers from
+* broadcast or precise ephemerides with the models used by the positioning
+* (satposs(), geodist(), tropmodel() and ionmodel()), and with random noise,
+* cycle slips and outages. the observation data are used as inputs of the
+* throughput and memory benchmarks without real data.
+*
+* version : $Revision:$ $Date:$
+* history : 2026/10/18 1.0  new
+*-----------------------------------------------------------------------------*/
+#include "rtklib.h"
+
+#define SQR(x)      ((x)*(x))
+#define RANGE0      2.2E7               /* initial guess of range (m) */
+#define REL_HUMI    0.7                 /* relative humidity for saastamoinen */
+#define SNR0        30.0                /* snr at elevation 0 deg (dBHz) */
+#define SNR90       50.0                /* snr at elevation 90 deg (dBHz) */
+#define MAXAMB      1E6                 /* max initial ambiguity (cycle) */
+#define MAXSLIP     100                 /* max cycle slip (cycle) */
+
+/* default simulator options -------------------------------------------------*/
+const simopt_t simopt_default={
+    SYS_GPS,2,EPHOPT_BRDC,15.0*D2R,     /* navsys,nfreq,ephopt,elmask */
+    0.3,0.003,0.05,                     /* errp,errl,errd */
+    0.0,0.0,60.0,                       /* sliprate,outrate,outlen */
+    1                                   /* seed */
+};
+/* observation code of each system and frequency index -----------------------*/
+static unsigned char simcode(int sys, int frq)
+{
+    static const unsigned char codes[][NFREQ]={
+        {CODE_L1C,CODE_L2W,CODE_L5Q},   /* GPS */
+        {CODE_L1C,CODE_L2P,0       },   /* GLO */
+        {CODE_L1C,0       ,CODE_L5Q},   /* GAL */
+        {CODE_L1C,CODE_L2L,CODE_L5Q},   /* QZS */
+        {CODE_L1I,0       ,CODE_L7I}    /* CMP */
+    };
+    int i;
+    
+    switch (sys) {
+        case SYS_GPS: i=0; break;
+        case SYS_GLO: i=1; break;
+        case SYS_GAL: i=2; break;
+        case SYS_QZS: i=3; break;
+        case SYS_CMP: i=4; break;
+        default: return 0;
+    }
+    return frq<NFREQ?codes[i][frq]:0;
+}
+/* satellite group delay of L1 code (m) -------------------------------------*/
+static double simtgd(int sat, const nav_t *nav)
+{
+    int i;
+    
+    if (!(satsys(sat,NULL)&(SYS_GPS|SYS_GAL|SYS_QZS))) return 0.0;
+    
+    for (i=0;i<nav->n;i++) {
+        if (nav->eph[i].sat==sat) return CLIGHT*nav->eph[i].tgd[0];
+    }
+    return 0.0;
+}
+/* uniform random number in [0,1) --------------------------------------------*/
+static double urand(simobs_t *sim)
+{
+    sim->seed^=sim->seed<<13;
+    sim->seed^=sim->seed>>17;
+    sim->seed^=sim->seed<<5;
+    return (sim->seed>>8)/16777216.0;
+}
+/* gaussian random number with zero mean and unit variance -------------------*/
+static double grand(simobs_t *sim)
+{
+    double u1=urand(sim),u2=urand(sim);
+    
+    if (u1<=0.0) u1=1E-12;
+    return sqrt(-2.0*log(u1))*cos(2.0*PI*u2);
+}
+/* initialize observation simulator --------------------------------------------
+* initialize observation simulator of a static receiver
+* args   : simobs_t *sim    O   observation simulator
+*          double *rr       I   receiver position (ecef) (m)
+*          int    rcv       I   receiver number
+*          simopt_t *opt    I   simulator options
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void initsimobs(simobs_t *sim, const double *rr, int rcv,
+                       const simopt_t *opt)
+{
+    int i;
+    
+    trace(3,"initsimobs: rr=%.3f %.3f %.3f rcv=%d\n",rr[0],rr[1],rr[2],rcv);
+    
+    memset(sim,0,sizeof(simobs_t));
+    sim->opt=*opt;
+    for (i=0;i<3;i++) sim->rr[i]=rr[i];
+    ecef2pos(rr,sim->pos);
+    sim->rcv=rcv;
+    sim->seed=opt->seed*2654435761u+rcv;
+    if (!sim->seed) sim->seed=1;
+}
+/* generate observation data of an epoch ---------------------------------------
+* generate observation data of a static receiver at an epoch
+* args   : simobs_t *sim    IO  observation simulator
+*          gtime_t time     I   receiver sampling time (gpst)
+*          nav_t  *nav      I   navigation data
+*          obsd_t *obs      O   observation data (MAXOBS records)
+* return : number of observation data (sorted by satellite)
+* notes  : pseudorange P=r-c*dts+T+I+TGD+ep, carrier-phase
+*          L=(r-c*dts+T-I+el)/lam+N and doppler D=-(e'*vs-c*ddts)/lam+ed, where
+*          r is geometric distance including sagnac effect, T is saastamoinen
+*          troposphere, I is broadcast ionosphere and TGD is broadcast group
+*          delay (gps, galileo and qzss) scaled to the frequency, N is integer
+*          ambiguity and ep, el and ed are noises with std of opt->errp,
+*          opt->errl and opt->errd divided by sin(el). receiver clock bias is
+*          zero. the satellite position at transmission time is computed with
+*          the pseudorange as a receiver does in satposs().
+*          a cycle slip (LLI=1) is generated with probability sliprate*dt and
+*          an outage of outlen (s) with probability outrate*dt per satellite
+*          and epoch, where dt is the epoch interval. after an outage, the
+*          ambiguity is reset with LLI=1.
+*-----------------------------------------------------------------------------*/
+extern int simobsepoch(simobs_t *sim, gtime_t time, const nav_t *nav,
+                       obsd_t *obs)
+{
+    const simopt_t *opt=&sim->opt;
+    obsd_t data[MAXOBS];
+    double rs[MAXOBS*6],dts[MAXOBS*2],var[MAXOBS],e[3],azel[2],r,rate,dt;
+    double trop,ion,tgd,lam,lam1=CLIGHT/FREQ1,err,sinel;
+    int i,j,k,n,m,ns,sat,prn,sys,svh[MAXOBS],slip;
+    
+    trace(4,"simobsepoch: time=%s\n",time_str(time,1));
+    
+    dt=sim->time.time?timediff(time,sim->time):0.0;
+    sim->time=time;
+    
+    for (prn=1,ns=0;prn<=MAXSAT&&ns<MAXOBS;) {
+        
+        /* satellites at transmission time by initial guess of range */
+        for (n=0;prn<=MAXSAT&&n<MAXOBS;prn++) {
+            sys=satsys(prn,NULL);
+            if (!(sys&opt->navsys)||!simcode(sys,0)) continue;
+            if (timediff(time,sim->tout[prn-1])<0.0) continue; /* outage */
+            memset(data+n,0,sizeof(obsd_t));
+            data[n].time=time;
+            data[n].sat=(unsigned char)prn;
+            data[n++].P[0]=RANGE0;
+        }
+        for (k=0;k<2;k++) {
+            satposs(time,data,n,nav,opt->ephopt,rs,dts,var,svh);
+            
+            /* update pseudorange without noise and recompute */
+            for (i=0;i<n;i++) {
+                if ((r=geodist(rs+i*6,sim->rr,e))<=0.0) {
+                    data[i].P[0]=0.0;
+                    continue;
+                }
+                satazel(sim->pos,e,azel);
+                trop=tropmodel(time,sim->pos,azel,REL_HUMI);
+                ion=ionmodel(time,nav->ion_gps,sim->pos,azel);
+                data[i].P[0]=r-CLIGHT*dts[i*2]+trop+ion;
+            }
+        }
+        for (i=0;i<n&&ns<MAXOBS;i++) {
+            if (data[i].P[0]==0.0||svh[i]<0) continue;
+            if ((r=geodist(rs+i*6,sim->rr,e))<=0.0) continue;
+            if (satazel(sim->pos,e,azel)<opt->elmask) {
+                sim->lock[data[i].sat-1]=0;
+                continue;
+            }
+            sat=data[i].sat;
+            sys=satsys(sat,NULL);
+            
+            /* outage */
+            if (dt>0.0&&opt->outrate>0.0&&urand(sim)<opt->outrate*dt) {
+                sim->tout[sat-1]=timeadd(time,opt->outlen);
+                sim->lock[sat-1]=0;
+                continue;
+            }
+            /* cycle slip */
+            slip=!sim->lock[sat-1]||
+                 (dt>0.0&&opt->sliprate>0.0&&urand(sim)<opt->sliprate*dt);
+            
+            trop=tropmodel(time,sim->pos,azel,REL_HUMI);
+            ion=ionmodel(time,nav->ion_gps,sim->pos,azel);
+            tgd=simtgd(sat,nav);
+            rate=dot(rs+i*6+3,e,3)-CLIGHT*dts[1+i*2];
+            sinel=sin(azel[1]);
+            
+            obs[ns]=data[i];
+            obs[ns].rcv=(unsigned char)sim->rcv;
+            obs[ns].P[0]=0.0;
+            
+            for (j=m=0;j<opt->nfreq&&j<NFREQ;j++) {
+                if (!(obs[ns].code[j]=simcode(sys,j))) continue;
+                if ((lam=satwavelen(sat,j,nav))<=0.0) {
+                    obs[ns].code[j]=CODE_NONE;
+                    continue;
+                }
+                if (!sim->lock[sat-1]) {
+                    sim->amb[sat-1][j]=floor(MAXAMB*(2.0*urand(sim)-1.0));
+                }
+                else if (slip) {
+                    sim->amb[sat-1][j]+=1+(int)(urand(sim)*MAXSLIP);
+                }
+                err=1.0/sinel;
+                obs[ns].P[j]=r-CLIGHT*dts[i*2]+trop+(ion+tgd)*SQR(lam/lam1)+
+                             opt->errp*err*grand(sim);
+                obs[ns].L[j]=(r-CLIGHT*dts[i*2]+trop-ion*SQR(lam/lam1)+
+                              opt->errl*err*grand(sim))/lam+sim->amb[sat-1][j];
+                obs[ns].D[j]=(float)(-rate/lam+opt->errd*err*grand(sim));
+                obs[ns].SNR[j]=(unsigned char)((SNR0+(SNR90-SNR0)*sinel)*4.0+0.5);
+                obs[ns].LLI[j]=slip?1:0;
+                m++;
+            }
+            if (m<=0) continue;
+            sim->lock[sat-1]=1;
+            ns++;
+        }
+    }
+    return ns;
+}
+/* generate observation data ---------------------------------------------------
+* generate observation data of a static receiver for a time span
+* args   : gtime_t ts,te    I   start and end time (gpst)
+*          double tint      I   time interval (s)
+*          double *rr       I   receiver position (ecef) (m)
+*          int    rcv       I   receiver number
+*          simopt_t *opt    I   simulator options
+*          nav_t  *nav      I   navigation data
+*          obs_t  *obs      IO  observation data (appended)
+* return : number of epochs (-1:memory allocation error)
+*-----------------------------------------------------------------------------*/
+extern int simobs(gtime_t ts, gtime_t te, double tint, const double *rr,
+                  int rcv, const simopt_t *opt, const nav_t *nav, obs_t *obs)
+{
+    simobs_t *sim;
+    obsd_t data[MAXOBS],*obs_data;
+    gtime_t time;
+    int i,j,n,nep=0;
+    
+    trace(3,"simobs: ts=%s tint=%.1f rcv=%d\n",time_str(ts,0),tint,rcv);
+    
+    if (tint<=0.0) return 0;
+    
+    if (!(sim=(simobs_t *)malloc(sizeof(simobs_t)))) return -1;
+    initsimobs(sim,rr,rcv,opt);
+    
+    for (i=0;;i++) {
+        time=timeadd(ts,tint*i);
+        if (timediff(time,te)>1E-9) break;
+        
+        if ((n=simobsepoch(sim,time,nav,data))<=0) continue;
+        
+        if (obs->n+n>obs->nmax) {
+            obs->nmax=obs->nmax<=0?8192:obs->nmax*2;
+            if (obs->nmax<obs->n+n) obs->nmax=obs->n+n;
+            if (!(obs_data=(obsd_t *)realloc(obs->data,sizeof(obsd_t)*obs->nmax))) {
+                free(obs->data); obs->data=NULL; obs->n=obs->nmax=0;
+                free(sim);
+                return -1;
+            }
+            obs->data=obs_data;
+        }
+        for (j=0;j<n;j++) obs->data[obs->n++]=data[j];
+        nep++;
+    }
+    free(sim);
+    return nep;
+}
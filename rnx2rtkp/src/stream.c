@@ -59,6 +59,10 @@
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <poll.h>
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
 #endif
 
 static const char rcsid[]="$Id$";
@@ -872,10 +876,12 @@ static int recv_nb(socket_t sock, unsigned char *buff, int n)
 {
     struct timeval tv={0};
     fd_set rs;
+    int nr;
     
     FD_ZERO(&rs); FD_SET(sock,&rs);
     if (!select(sock+1,&rs,NULL,NULL,&tv)) return 0;
-    return recv(sock,(char *)buff,n,0);
+    nr=recv(sock,(char *)buff,n,0);
+    return nr==0?-1:nr; /* readable with no data: disconnected by peer */
 }
 /* non-block send ------------------------------------------------------------*/
 static int send_nb(socket_t sock, unsigned char *buff, int n)
@@ -1769,6 +1775,42 @@ static int stateftp(ftp_t *ftp)
 {
     return !ftp?0:(ftp->state==0?2:(ftp->state<=2?3:-1));
 }
+/* get descriptors to wait for input data -----------------------------------*/
+static int getfds(stream_t *stream, socket_t *fd)
+{
+    tcpsvr_t *tcpsvr;
+    tcpcli_t *tcpcli;
+    int i,n=0;
+    
+    if (!(stream->mode&STR_MODE_R)||!stream->port) return 0;
+    
+    switch (stream->type) {
+#ifndef WIN32
+        case STR_SERIAL:
+            fd[n++]=((serial_t *)stream->port)->dev;
+            break;
+        case STR_FILE:
+            if (((file_t *)stream->port)->fp==stdin) fd[n++]=0;
+            break;
+#endif
+        case STR_TCPSVR:
+            tcpsvr=(tcpsvr_t *)stream->port;
+            if (tcpsvr->svr.state<=0) break;
+            
+            /* server socket only if a client can be accepted */
+            for (i=0;i<MAXCLI;i++) if (tcpsvr->cli[i].state==0) break;
+            if (i<MAXCLI) fd[n++]=tcpsvr->svr.sock;
+            if (tcpsvr->cli[0].state==2) fd[n++]=tcpsvr->cli[0].sock;
+            break;
+        case STR_TCPCLI:
+        case STR_NTRIPCLI:
+            if (stream->type==STR_TCPCLI) tcpcli=(tcpcli_t *)stream->port;
+            else tcpcli=((ntrip_t *)stream->port)->tcp;
+            if (tcpcli->svr.state==2) fd[n++]=tcpcli->svr.sock;
+            break;
+    }
+    return n;
+}
 /* initialize stream environment -----------------------------------------------
 * initialize stream environment
 * args   : none
@@ -1803,6 +1845,8 @@ extern void strinit(stream_t *stream)
     stream->port=NULL;
     stream->path[0]='\0';
     stream->msg [0]='\0';
+    stream->efd=-1;
+    stream->nfd=0;
 }
 /* open stream -----------------------------------------------------------------
 * open stream for read or write
@@ -1896,6 +1940,11 @@ extern void strclose(stream_t *stream)
     stream->path[0]='\0';
     stream->msg[0]='\0';
     stream->port=NULL;
+#ifdef __linux__
+    if (stream->efd>=0) close(stream->efd);
+#endif
+    stream->efd=-1;
+    stream->nfd=0;
 }
 /* sync streams ----------------------------------------------------------------
 * sync time for streams
@@ -1962,6 +2011,169 @@ extern int strread(stream_t *stream, unsigned char *buff, int n)
     strunlock(stream);
     return nr;
 }
+/* wait stream input ---------------------------------------------------------
+* wait until input data of stream is available
+* args   : stream_t *stream I  stream
+*          int    msec      I  timeout (ms)
+* return : status (1:data available,0:timeout)
+* notes  : tcp server/client, ntrip client, serial and stdin streams are waited
+*          for by epoll (linux) or select (others). other streams or streams
+*          not connected are not waited for and the function only sleeps msec.
+*          the data should be read by strread() after return even if timeout
+*          to update the connection states.
+*-----------------------------------------------------------------------------*/
+extern int strwait(stream_t *stream, int msec)
+{
+    socket_t fd[2];
+    int i,j,n,stat=0;
+#ifdef __linux__
+    struct epoll_event ev[2]={{0}},ev0={0};
+    int efd;
+#else
+    struct timeval tv;
+    fd_set rs;
+    socket_t nfds=0;
+#endif
+    tracet(4,"strwait: msec=%d\n",msec);
+    
+    if (msec<0) msec=0;
+    
+    strlock(stream);
+    
+    n=getfds(stream,fd);
+#ifdef __linux__
+    if (n>0&&stream->efd<0) stream->efd=epoll_create(2);
+    
+    /* update descriptors registered to epoll */
+    if ((efd=stream->efd)>=0) {
+        for (i=0;i<stream->nfd;i++) {
+            for (j=0;j<n;j++) if (fd[j]==stream->fd[i]) break;
+            if (j<n) continue;
+            epoll_ctl(efd,EPOLL_CTL_DEL,stream->fd[i],&ev0);
+        }
+        for (j=0;j<n;j++) {
+            for (i=0;i<stream->nfd;i++) if (fd[j]==stream->fd[i]) break;
+            if (i<stream->nfd) continue;
+            ev0.events=EPOLLIN;
+            ev0.data.fd=fd[j];
+            if (epoll_ctl(efd,EPOLL_CTL_ADD,fd[j],&ev0)<0&&errno==EEXIST) {
+                epoll_ctl(efd,EPOLL_CTL_MOD,fd[j],&ev0);
+            }
+        }
+        for (j=0;j<n;j++) stream->fd[j]=fd[j];
+        stream->nfd=n;
+    }
+    else n=0;
+#endif
+    strunlock(stream);
+    
+    if (n<=0) {
+        sleepms(msec);
+        return 0;
+    }
+#ifdef __linux__
+    if ((n=epoll_wait(efd,ev,2,msec))>0) {
+        stat=1;
+        for (i=0;i<n;i++) {
+            if (!(ev[i].events&(EPOLLERR|EPOLLHUP))) continue;
+            
+            /* avoid busy loop by device error or hang-up */
+            strlock(stream);
+            epoll_ctl(efd,EPOLL_CTL_DEL,ev[i].data.fd,&ev0);
+            strunlock(stream);
+            sleepms(msec);
+            stat=0;
+        }
+    }
+    else if (n==0) {
+        /* re-register descriptors closed and reused while waiting */
+        strlock(stream);
+        stream->nfd=0;
+        strunlock(stream);
+    }
+#else
+    FD_ZERO(&rs);
+    for (i=0;i<n;i++) {
+        FD_SET(fd[i],&rs);
+        if (fd[i]>=nfds) nfds=fd[i]+1;
+    }
+    tv.tv_sec=msec/1000;
+    tv.tv_usec=(msec%1000)*1000;
+    stat=select((int)nfds,&rs,NULL,NULL,&tv)>0;
+#endif
+    tracet(5,"strwait: exit stat=%d\n",stat);
+    return stat;
+}
+/* wait input of streams -----------------------------------------------------
+* wait until input data of any of streams is available
+* args   : stream_t **streams I streams
+*          int    n         I  number of streams
+*          int    msec      I  timeout (ms)
+* return : status (1:data available,0:timeout)
+* notes  : same as strwait() but the descriptors of all streams are polled
+*          at once by poll (select for windows) without registration to
+*          epoll. it is for a thread reading many streams.
+*-----------------------------------------------------------------------------*/
+extern int strwaits(stream_t **streams, int n, int msec)
+{
+    socket_t fd[2];
+    int i,j,m=0,stat=0;
+#ifdef WIN32
+    struct timeval tv;
+    fd_set rs;
+#else
+    struct pollfd *pfd;
+#endif
+    tracet(4,"strwaits: n=%d msec=%d\n",n,msec);
+    
+    if (msec<0) msec=0;
+
+#ifdef WIN32
+    FD_ZERO(&rs);
+    for (i=0;i<n;i++) {
+        strlock(streams[i]);
+        for (j=getfds(streams[i],fd)-1;j>=0&&m<FD_SETSIZE;j--,m++) {
+            FD_SET(fd[j],&rs);
+        }
+        strunlock(streams[i]);
+    }
+    if (m<=0) {
+        sleepms(msec);
+        return 0;
+    }
+    tv.tv_sec=msec/1000;
+    tv.tv_usec=(msec%1000)*1000;
+    stat=select(0,&rs,NULL,NULL,&tv)>0;
+#else
+    if (n<=0||!(pfd=(struct pollfd *)malloc(sizeof(struct pollfd)*n*2))) {
+        sleepms(msec);
+        return 0;
+    }
+    for (i=0;i<n;i++) {
+        strlock(streams[i]);
+        for (j=getfds(streams[i],fd)-1;j>=0;j--,m++) {
+            pfd[m].fd=fd[j];
+            pfd[m].events=POLLIN;
+            pfd[m].revents=0;
+        }
+        strunlock(streams[i]);
+    }
+    if (m<=0) {
+        free(pfd);
+        sleepms(msec);
+        return 0;
+    }
+    if (poll(pfd,m,msec)>0) {
+        for (i=0;i<m;i++) if (pfd[i].revents&POLLIN) stat=1;
+        
+        /* avoid busy loop by device error or hang-up */
+        if (!stat) sleepms(msec);
+    }
+    free(pfd);
+#endif
+    tracet(5,"strwaits: exit stat=%d\n",stat);
+    return stat;
+}
 /* write stream ----------------------------------------------------------------
 * write data to stream (unblocked)
 * args   : stream_t *stream I   stream
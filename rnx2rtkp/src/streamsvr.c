@@ -361,7 +361,7 @@ static void *strsvrthread(void *arg)
 {
     strsvr_t *svr=(strsvr_t *)arg;
     unsigned int tick,ticknmea;
-    int i,n;
+    int i,n,cyc;
     
     tracet(3,"strsvrthread:\n");
     
@@ -395,7 +395,19 @@ static void *strsvrthread(void *arg)
         }
         unlock(&svr->lock);
         
-        sleepms(svr->cycle-(int)(tickget()-tick));
+        /* wait for input data of socket or serial, sleep for others */
+        cyc=svr->cycle-(int)(tickget()-tick);
+        switch (svr->stream[0].type) {
+            case STR_SERIAL:
+            case STR_TCPSVR:
+            case STR_TCPCLI:
+            case STR_NTRIPCLI:
+                if (n<=0) strwait(svr->stream,cyc);
+                break;
+            default:
+                sleepms(cyc);
+                break;
+        }
     }
     for (i=0;i<svr->nstr;i++) strclose(svr->stream+i);
     svr->npb=0;
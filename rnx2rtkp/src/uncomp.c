@@ -0,0 +1,1083 @@
+/*------------------------------------------------------------------------------
+* uncomp.c : in-process uncompression of gzip, compress and hatanaka files
+*
+* references :
+*     [1] P.Deutsch, DEFLATE Compressed Data Format Specification version 1.3,
+*         RFC 1951, May 1996
+*     [2] P.Deutsch, GZIP file format specification version 4.3, RFC 1952,
+*         May 1996
+*     [3] PKWARE Inc., APPNOTE.TXT - .ZIP File Format Specification
+*     [4] Y.Hatanaka, A Compression Format and Tools for GNSS Observation
+*         Data, Bulletin of the Geographical Survey Institute, Vol.55, 2008
+*
+* version : $Revision:$ $Date:$
+* history : 2026/10/18 1.0  new
+*-----------------------------------------------------------------------------*/
+#define _GNU_SOURCE
+#include "rtklib.h"
+
+#if defined(WIN32)||!defined(__GLIBC__)
+#define UNCTMPFILE                      /* uncompress to anonymous tmpfile() */
+#endif
+
+#define UNCBUFSIZ   65536               /* input/output buffer size */
+#define WINSIZE     32768               /* deflate window size */
+#define MAXHBITS    15                  /* max bits of huffman code */
+#define FASTBITS    9                   /* bits of huffman fast lookup */
+#define MAXLZWBITS  16                  /* max bits of lzw code */
+#define MAXCRXSAT   256                 /* max satellites of hatanaka epoch */
+#define MAXCRXORD   5                   /* max difference order of hatanaka */
+#define MAXCRXLEN   4096                /* max line length of hatanaka */
+
+#define UNC_NONE    0                   /* compression: none */
+#define UNC_GZIP    1                   /* compression: gzip */
+#define UNC_LZW     2                   /* compression: compress (lzw) */
+#define UNC_ZIP     3                   /* compression: zip */
+
+/* type definitions ----------------------------------------------------------*/
+typedef struct {                        /* huffman decode table type */
+    short fast[1<<FASTBITS];            /* fast lookup (sym<<4|len, -1:slow) */
+    short count[MAXHBITS+1];            /* number of codes of each length */
+    short symbol[288];                  /* symbols ordered by code */
+} huff_t;
+
+typedef struct {                        /* hatanaka satellite state type */
+    char id[4];                         /* satellite id */
+    int  prev;                          /* included in previous epoch */
+    long long y[MAXOBSTYPE][MAXCRXORD+1]; /* differences of each order */
+    signed char ord[MAXOBSTYPE];        /* current order (-1:no arc) */
+    signed char arc[MAXOBSTYPE];        /* arc order */
+    char flag[MAXOBSTYPE*2+1];          /* lli and signal strength flags */
+} crxsat_t;
+
+typedef struct {                        /* hatanaka decoder type */
+    int ver;                            /* crinex version (1:ver.2,3:ver.3) */
+    int head;                           /* in header */
+    int ntype[128];                     /* number of obs types by system code */
+    char epoch[MAXCRXLEN];              /* last epoch record */
+    long long clk[MAXCRXORD+1];         /* clock differences of each order */
+    signed char clkord,clkarc;          /* clock current order and arc order */
+    crxsat_t *sat;                      /* satellite states */
+    int nsat;                           /* number of satellite states */
+} crx_t;
+
+typedef struct {                        /* uncompression stream type */
+    FILE *fp;                           /* compressed file */
+    int type;                           /* compression (UNC_???) */
+    int stat;                           /* status (0:ok,1:end,-1:error) */
+    unsigned char ibuf[UNCBUFSIZ];      /* input buffer */
+    int ip,ni,over;                     /* input position/size and overrun */
+    unsigned long bitbuf;               /* bit buffer */
+    int nbit;                           /* number of bits in bit buffer */
+    unsigned char obuf[UNCBUFSIZ];      /* output buffer */
+    int op,no;                          /* output position and size */
+    unsigned char win[WINSIZE];         /* deflate window */
+    unsigned int wpos,wlen;             /* window position and length */
+    int blk;                            /* block (0:header,1:stored,2:huff) */
+    int final;                          /* final block */
+    unsigned int len,dist;              /* stored length or pending match */
+    unsigned long crc,size;             /* crc-32 and size of gzip member */
+    huff_t lit,dst;                     /* literal/length and distance codes */
+    unsigned short *prefix;             /* lzw prefix table */
+    unsigned char *suffix,*stack;       /* lzw suffix table and stack */
+    int maxbits,block,bits,freeent;     /* lzw max bits,block mode,bits,free */
+    int oldcode,finchar,ncode,nstack;   /* lzw old code,char,codes,stack size */
+    crx_t *crx;                         /* hatanaka decoder (NULL:none) */
+    char *text;                         /* hatanaka decoded text */
+    int tp,nt,ntmax;                    /* text position, size and max size */
+} unc_t;
+
+static const unsigned short lbase[]={ /* length base (ref [1] 3.2.5) */
+    3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,
+    163,195,227,258
+};
+static const unsigned char lext[]={ /* length extra bits */
+    0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0
+};
+static const unsigned short dbase[]={ /* distance base */
+    1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,
+    2049,3073,4097,6145,8193,12289,16385,24577
+};
+static const unsigned char dext[]={ /* distance extra bits */
+    0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13
+};
+static const unsigned char clorder[]={ /* code length code order */
+    16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15
+};
+/* crc-32 of gzip (ref [2] 8) ------------------------------------------------*/
+static unsigned long crc32g(unsigned long crc, const unsigned char *buff,
+                            int len)
+{
+    static unsigned long table[256];
+    static int init=0;
+    unsigned long c;
+    int i,j;
+
+    if (!init) {
+        for (i=0;i<256;i++) {
+            for (c=(unsigned long)i,j=0;j<8;j++) {
+                c=c&1?0xEDB88320UL^(c>>1):c>>1;
+            }
+            table[i]=c;
+        }
+        init=1;
+    }
+    crc^=0xFFFFFFFFUL;
+    for (i=0;i<len;i++) crc=table[(crc^buff[i])&0xFF]^(crc>>8);
+    return crc^0xFFFFFFFFUL;
+}
+/* get byte of compressed file (-1:end of file) ------------------------------*/
+static int getbyte(unc_t *unc)
+{
+    if (unc->ip>=unc->ni) {
+        unc->ip=0;
+        if ((unc->ni=(int)fread(unc->ibuf,1,UNCBUFSIZ,unc->fp))<=0) {
+            unc->ni=0;
+            return -1;
+        }
+    }
+    return unc->ibuf[unc->ip++];
+}
+/* fill bit buffer (bits after end of file are 0) ----------------------------*/
+static int needbits(unc_t *unc, int n)
+{
+    int c;
+
+    while (unc->nbit<n) {
+        if ((c=getbyte(unc))<0) {
+            if (++unc->over>4) return 0;
+            c=0;
+        }
+        unc->bitbuf|=(unsigned long)c<<unc->nbit;
+        unc->nbit+=8;
+    }
+    return 1;
+}
+/* get bits (lsb first) ------------------------------------------------------*/
+static int getbitsz(unc_t *unc, int n)
+{
+    int val;
+
+    if (n<=0) return 0;
+    if (!needbits(unc,n)) return -1;
+    val=(int)(unc->bitbuf&((1UL<<n)-1));
+    unc->bitbuf>>=n;
+    unc->nbit-=n;
+    return val;
+}
+/* get byte at byte boundary of bit stream -----------------------------------*/
+static int getbytea(unc_t *unc)
+{
+    int c;
+
+    unc->bitbuf>>=unc->nbit%8;
+    unc->nbit-=unc->nbit%8;
+
+    if (unc->nbit>=8) {
+        c=(int)(unc->bitbuf&0xFF);
+        unc->bitbuf>>=8;
+        unc->nbit-=8;
+        return c;
+    }
+    return getbyte(unc);
+}
+/* construct huffman decode table (ref [1] 3.2.2) ----------------------------*/
+static int huffinit(huff_t *h, const unsigned char *len, int n)
+{
+    short offs[MAXHBITS+2];
+    int i,j,left,code,next[MAXHBITS+2],rev;
+
+    for (i=0;i<=MAXHBITS;i++) h->count[i]=0;
+    for (i=0;i<n;i++) h->count[len[i]]++;
+
+    for (i=1,left=1;i<=MAXHBITS;i++) {
+        left<<=1;
+        if ((left-=h->count[i])<0) return 0; /* over-subscribed */
+    }
+    for (i=1,offs[1]=0;i<MAXHBITS;i++) offs[i+1]=offs[i]+h->count[i];
+    for (i=0;i<n;i++) {
+        if (len[i]) h->symbol[offs[len[i]]++]=(short)i;
+    }
+    /* fast lookup table of short codes */
+    for (i=0;i<(1<<FASTBITS);i++) h->fast[i]=-1;
+    for (i=1,code=0;i<=MAXHBITS;i++) {
+        next[i]=code;
+        code=(code+h->count[i])<<1;
+    }
+    for (i=0;i<n;i++) {
+        if (!len[i]) continue;
+        code=next[len[i]]++;
+        if (len[i]>FASTBITS) continue;
+        for (j=rev=0;j<len[i];j++) rev|=((code>>j)&1)<<(len[i]-1-j);
+        for (j=rev;j<(1<<FASTBITS);j+=1<<len[i]) {
+            h->fast[j]=(short)(i<<4|len[i]);
+        }
+    }
+    return 1;
+}
+/* decode huffman symbol (-1:error) ------------------------------------------*/
+static int huffdec(unc_t *unc, const huff_t *h)
+{
+    int i,code=0,first=0,index=0,count,bit;
+
+    if (!needbits(unc,FASTBITS)) return -1;
+
+    if ((i=h->fast[unc->bitbuf&((1<<FASTBITS)-1)])>=0) {
+        unc->bitbuf>>=i&15;
+        unc->nbit-=i&15;
+        return i>>4;
+    }
+    /* slow decoding bit by bit (puff) */
+    for (i=1;i<=MAXHBITS;i++) {
+        if ((bit=getbitsz(unc,1))<0) return -1;
+        code|=bit;
+        count=h->count[i];
+        if (code-count<first) return h->symbol[index+(code-first)];
+        index+=count;
+        first+=count;
+        first<<=1;
+        code<<=1;
+    }
+    return -1;
+}
+/* read dynamic huffman codes (ref [1] 3.2.7) --------------------------------*/
+static int dynhuff(unc_t *unc)
+{
+    unsigned char len[320];
+    int i,sym,nlen,ndist,ncode,rep,val;
+
+    nlen =getbitsz(unc,5)+257;
+    ndist=getbitsz(unc,5)+1;
+    ncode=getbitsz(unc,4)+4;
+    if (nlen>286||ndist>30) return 0;
+
+    memset(len,0,sizeof(len));
+    for (i=0;i<ncode;i++) {
+        if ((val=getbitsz(unc,3))<0) return 0;
+        len[clorder[i]]=(unsigned char)val;
+    }
+    if (!huffinit(&unc->lit,len,19)) return 0;
+
+    for (i=0;i<nlen+ndist;) {
+        if ((sym=huffdec(unc,&unc->lit))<0) return 0;
+        if (sym<16) {
+            len[i++]=(unsigned char)sym;
+            continue;
+        }
+        if (sym==16) {
+            if (i==0) return 0;
+            val=len[i-1];
+            rep=3+getbitsz(unc,2);
+        }
+        else {
+            val=0;
+            rep=sym==17?3+getbitsz(unc,3):11+getbitsz(unc,7);
+        }
+        if (i+rep>nlen+ndist) return 0;
+        while (rep--) len[i++]=(unsigned char)val;
+    }
+    if (len[256]==0) return 0;
+
+    return huffinit(&unc->lit,len,nlen)&&huffinit(&unc->dst,len+nlen,ndist);
+}
+/* fixed huffman codes (ref [1] 3.2.6) ---------------------------------------*/
+static void fixhuff(unc_t *unc)
+{
+    unsigned char len[288];
+    int i;
+
+    for (i=0;i<144;i++) len[i]=8;
+    for (;i<256;i++) len[i]=9;
+    for (;i<280;i++) len[i]=7;
+    for (;i<288;i++) len[i]=8;
+    huffinit(&unc->lit,len,288);
+
+    for (i=0;i<30;i++) len[i]=5;
+    huffinit(&unc->dst,len,30);
+}
+/* output byte of deflate stream ---------------------------------------------*/
+static void putbyte(unc_t *unc, unsigned char c)
+{
+    unc->obuf[unc->no++]=c;
+    unc->win[unc->wpos++&(WINSIZE-1)]=c;
+    if (unc->wlen<WINSIZE) unc->wlen++;
+}
+/* read gzip or zip member header (ref [2] 2.3, [3] 4.3.7) -------------------*/
+static int readhead(unc_t *unc)
+{
+    unsigned char h[30];
+    int i,c,n,flag;
+
+    if ((c=getbytea(unc))<0) return 0; /* end of file */
+    h[0]=(unsigned char)c;
+    for (i=1;i<4;i++) {
+        if ((c=getbytea(unc))<0) return -1;
+        h[i]=(unsigned char)c;
+    }
+    if (h[0]==0x1F&&h[1]==0x8B) { /* gzip */
+        if (h[2]!=8) return -1;
+        flag=h[3];
+        for (i=0;i<6;i++) if (getbytea(unc)<0) return -1;
+        if (flag&4) { /* FEXTRA */
+            n=getbytea(unc); n|=getbytea(unc)<<8;
+            while (n-->0) if (getbytea(unc)<0) return -1;
+        }
+        if (flag&8) { /* FNAME */
+            while ((c=getbytea(unc))>0) ;
+            if (c<0) return -1;
+        }
+        if (flag&16) { /* FCOMMENT */
+            while ((c=getbytea(unc))>0) ;
+            if (c<0) return -1;
+        }
+        if (flag&2) { /* FHCRC */
+            if (getbytea(unc)<0||getbytea(unc)<0) return -1;
+        }
+        unc->type=UNC_GZIP;
+    }
+    else if (h[0]=='P'&&h[1]=='K'&&h[2]==3&&h[3]==4) { /* zip local header */
+        if (unc->type==UNC_ZIP) return 0; /* first member only as gzip -d */
+        for (i=4;i<30;i++) {
+            if ((c=getbytea(unc))<0) return -1;
+            h[i]=(unsigned char)c;
+        }
+        if (h[8]!=8||h[9]!=0) { /* deflate only */
+            trace(2,"unsupported zip compression method: %d\n",h[8]|h[9]<<8);
+            return -1;
+        }
+        n=(h[26]|h[27]<<8)+(h[28]|h[29]<<8);
+        while (n-->0) if (getbytea(unc)<0) return -1;
+        unc->type=UNC_ZIP;
+    }
+    else if (unc->type==UNC_GZIP) { /* trailing garbage ignored as gzip -d */
+        return 0;
+    }
+    else return -1;
+
+    unc->blk=0;
+    unc->final=0;
+    unc->crc=unc->size=0;
+    return 1;
+}
+/* read gzip member trailer --------------------------------------------------*/
+static int readtail(unc_t *unc)
+{
+    unsigned long crc=0,size=0;
+    int i,c;
+
+    if (unc->type==UNC_ZIP) return 1;
+
+    for (i=0;i<4;i++) {
+        if ((c=getbytea(unc))<0) return 0;
+        crc|=(unsigned long)c<<(i*8);
+    }
+    for (i=0;i<4;i++) {
+        if ((c=getbytea(unc))<0) return 0;
+        size|=(unsigned long)c<<(i*8);
+    }
+    if (crc!=unc->crc||size!=(unc->size&0xFFFFFFFFUL)) {
+        trace(2,"gzip crc/size error: crc=%08lX %08lX\n",crc,unc->crc);
+        return 0;
+    }
+    return 1;
+}
+/* inflate deflate stream to output buffer (ref [1] 3.2.3) -------------------*/
+static int inflate(unc_t *unc)
+{
+    int i,sym,n0=unc->no,stat=0;
+
+    while (unc->no<UNCBUFSIZ-258&&!stat) {
+
+        /* pending match */
+        if (unc->len&&unc->blk==2) {
+            for (;unc->len&&unc->no<UNCBUFSIZ;unc->len--) {
+                putbyte(unc,unc->win[(unc->wpos-unc->dist)&(WINSIZE-1)]);
+            }
+            continue;
+        }
+        if (unc->blk==0) { /* block header */
+            if (unc->final) {
+                unc->crc=crc32g(unc->crc,unc->obuf+n0,unc->no-n0);
+                unc->size+=unc->no-n0;
+                n0=unc->no;
+                if (!readtail(unc)) return -1;
+                if ((stat=readhead(unc))<=0) return stat<0?-1:1;
+                continue;
+            }
+            unc->final=getbitsz(unc,1);
+            switch (getbitsz(unc,2)) {
+                case 0: /* stored */
+                    unc->len =getbytea(unc); unc->len|=getbytea(unc)<<8;
+                    i        =getbytea(unc); i       |=getbytea(unc)<<8;
+                    if ((unc->len^0xFFFF)!=(unsigned int)i) return -1;
+                    unc->blk=1;
+                    break;
+                case 1: /* fixed huffman */
+                    fixhuff(unc);
+                    unc->blk=2;
+                    break;
+                case 2: /* dynamic huffman */
+                    if (!dynhuff(unc)) return -1;
+                    unc->blk=2;
+                    break;
+                default:
+                    return -1;
+            }
+            if (unc->blk==2) unc->len=0;
+            continue;
+        }
+        if (unc->blk==1) { /* stored block */
+            for (;unc->len&&unc->no<UNCBUFSIZ;unc->len--) {
+                if ((i=getbytea(unc))<0) return -1;
+                putbyte(unc,(unsigned char)i);
+            }
+            if (!unc->len) unc->blk=0;
+            continue;
+        }
+        /* huffman block */
+        if ((sym=huffdec(unc,&unc->lit))<0||unc->over>4) return -1;
+
+        if (sym<256) {
+            putbyte(unc,(unsigned char)sym);
+        }
+        else if (sym==256) { /* end of block */
+            unc->blk=0;
+        }
+        else {
+            if ((sym-=257)>=29) return -1;
+            unc->len=lbase[sym]+getbitsz(unc,lext[sym]);
+            if ((sym=huffdec(unc,&unc->dst))<0||sym>=30) return -1;
+            unc->dist=dbase[sym]+getbitsz(unc,dext[sym]);
+            if (unc->dist>unc->wlen) return -1;
+        }
+    }
+    unc->crc=crc32g(unc->crc,unc->obuf+n0,unc->no-n0);
+    unc->size+=unc->no-n0;
+    return 0;
+}
+/* initialize lzw decoder (compress .Z) --------------------------------------*/
+static int initlzw(unc_t *unc)
+{
+    int c;
+
+    if ((c=getbyte(unc))<0) return 0;
+    unc->maxbits=c&0x1F;
+    unc->block=c&0x80;
+    if (unc->maxbits<9||unc->maxbits>MAXLZWBITS) return 0;
+
+    if (!(unc->prefix=(unsigned short *)malloc(sizeof(short)<<MAXLZWBITS))||
+        !(unc->suffix=(unsigned char *)malloc(1<<MAXLZWBITS))||
+        !(unc->stack=(unsigned char *)malloc(1<<MAXLZWBITS))) {
+        return 0;
+    }
+    for (c=0;c<256;c++) {
+        unc->prefix[c]=0;
+        unc->suffix[c]=(unsigned char)c;
+    }
+    unc->bits=9;
+    unc->freeent=unc->block?257:256;
+    unc->oldcode=-1;
+    unc->ncode=unc->nstack=0;
+    unc->type=UNC_LZW;
+    return 1;
+}
+/* skip lzw codes to the end of a group of 8 codes ---------------------------*/
+static void skiplzw(unc_t *unc)
+{
+    for (;unc->ncode%8;unc->ncode++) {
+        if (!needbits(unc,unc->bits)||unc->over) break;
+        unc->bitbuf>>=unc->bits;
+        unc->nbit-=unc->bits;
+    }
+    unc->ncode=0;
+}
+/* decode lzw codes to output buffer -----------------------------------------*/
+static int unlzw(unc_t *unc)
+{
+    int code,incode,maxcode,maxmax=1<<unc->maxbits;
+
+    while (unc->no<UNCBUFSIZ) {
+
+        /* pending output on stack */
+        if (unc->nstack>0) {
+            while (unc->nstack>0&&unc->no<UNCBUFSIZ) {
+                unc->obuf[unc->no++]=unc->stack[--unc->nstack];
+            }
+            continue;
+        }
+        maxcode=unc->bits==unc->maxbits?maxmax:(1<<unc->bits)-1;
+        if (unc->freeent>maxcode) {
+            skiplzw(unc);
+            unc->bits++;
+            continue;
+        }
+        /* no more complete code */
+        if (!needbits(unc,unc->bits)||unc->over) return 1;
+
+        code=(int)(unc->bitbuf&((1UL<<unc->bits)-1));
+        unc->bitbuf>>=unc->bits;
+        unc->nbit-=unc->bits;
+        unc->ncode++;
+
+        if (unc->oldcode<0) { /* first code */
+            if (code>=256) return -1;
+            unc->oldcode=unc->finchar=code;
+            unc->obuf[unc->no++]=(unsigned char)code;
+            continue;
+        }
+        if (code==256&&unc->block) { /* clear */
+            skiplzw(unc);
+            unc->freeent=256;
+            unc->bits=9;
+            continue;
+        }
+        incode=code;
+        if (code>=unc->freeent) { /* KwKwK */
+            if (code>unc->freeent) return -1;
+            unc->stack[unc->nstack++]=(unsigned char)unc->finchar;
+            code=unc->oldcode;
+        }
+        while (code>=256) {
+            unc->stack[unc->nstack++]=unc->suffix[code];
+            code=unc->prefix[code];
+        }
+        unc->stack[unc->nstack++]=(unsigned char)(unc->finchar=code);
+
+        if (unc->freeent<maxmax) {
+            unc->prefix[unc->freeent]=(unsigned short)unc->oldcode;
+            unc->suffix[unc->freeent]=(unsigned char)unc->finchar;
+            unc->freeent++;
+        }
+        unc->oldcode=incode;
+    }
+    return 0;
+}
+/* fill output buffer of uncompressed data -----------------------------------*/
+static int fillunc(unc_t *unc)
+{
+    int n;
+
+    if (unc->stat) return 0;
+
+    if (unc->op>=unc->no) unc->op=unc->no=0;
+    if (unc->op>0) {
+        memmove(unc->obuf,unc->obuf+unc->op,unc->no-unc->op);
+        unc->no-=unc->op;
+        unc->op=0;
+    }
+    switch (unc->type) {
+        case UNC_GZIP:
+        case UNC_ZIP : unc->stat=inflate(unc); break;
+        case UNC_LZW : unc->stat=unlzw(unc); break;
+        default:
+            n=(int)fread(unc->obuf+unc->no,1,UNCBUFSIZ-unc->no,unc->fp);
+            if (n<=0) unc->stat=1; else unc->no+=n;
+            break;
+    }
+    if (unc->stat<0) {
+        trace(2,"uncompress error: type=%d\n",unc->type);
+    }
+    return unc->op<unc->no;
+}
+/* get line of uncompressed data ---------------------------------------------*/
+static char *getsunc(unc_t *unc, char *buff, int size)
+{
+    char *p=buff;
+
+    while (p<buff+size-1) {
+        if (unc->op>=unc->no&&!fillunc(unc)) break;
+        if ((*p++=(char)unc->obuf[unc->op++])=='\n') break;
+    }
+    if (p==buff) return NULL;
+    *p='\0';
+    return buff;
+}
+/* add decoded text of hatanaka ----------------------------------------------*/
+static int addtext(unc_t *unc, const char *str, int n)
+{
+    char *p;
+
+    if (unc->nt+n+1>unc->ntmax) {
+        unc->ntmax=unc->nt+n+1>unc->ntmax*2?unc->nt+n+1:unc->ntmax*2;
+        if (!(p=(char *)realloc(unc->text,unc->ntmax))) return 0;
+        unc->text=p;
+    }
+    memcpy(unc->text+unc->nt,str,n);
+    unc->nt+=n;
+    return 1;
+}
+/* add line of decoded text without tail spaces ------------------------------*/
+static int addline(unc_t *unc, const char *str, int n)
+{
+    while (n>0&&(str[n-1]==' '||str[n-1]=='\n'||str[n-1]=='\r')) n--;
+    return addtext(unc,str,n)&&addtext(unc,"\n",1);
+}
+/* recover text difference of hatanaka (ref [4]) -----------------------------*/
+static void repairstr(char *str, const char *diff, int size)
+{
+    int i,n=(int)strlen(str);
+
+    for (i=0;diff[i]&&diff[i]!='\n'&&diff[i]!='\r'&&i<size-1;i++) {
+        if (i>=n) str[i]=' ';
+        if      (diff[i]=='&') str[i]=' ';
+        else if (diff[i]!=' ') str[i]=diff[i];
+    }
+    if (i>n) str[i]='\0';
+}
+/* recover value from difference of hatanaka ---------------------------------*/
+static int repairval(const char *field, long long *y, signed char *ord,
+                     signed char *arc)
+{
+    int i;
+
+    if (field[1]=='&') { /* initialize arc */
+        if (field[0]<'0'||field[0]>'0'+MAXCRXORD) return 0;
+        *arc=(signed char)(field[0]-'0');
+        *ord=0;
+        y[0]=strtoll(field+2,NULL,10);
+        return 1;
+    }
+    if (*ord<0) return 0; /* no arc */
+
+    if (*ord<*arc) (*ord)++;
+    y[*ord]=strtoll(field,NULL,10);
+    for (i=*ord-1;i>=0;i--) y[i]+=y[i+1];
+    return 1;
+}
+/* value to string with decimals ---------------------------------------------*/
+static void val2str(long long y, int dec, int width, char *str)
+{
+    long long a=y<0?-y:y,s=1;
+    char tmp[64];
+    int i;
+
+    for (i=0;i<dec;i++) s*=10;
+    sprintf(tmp,"%s%lld.%0*lld",y<0?"-":"",a/s,dec,a%s);
+    sprintf(str,"%*s",width,tmp);
+}
+/* find hatanaka satellite state ---------------------------------------------*/
+static crxsat_t *crxsat(crx_t *crx, const char *id)
+{
+    int i,j;
+
+    for (i=0;i<crx->nsat;i++) {
+        if (!strncmp(crx->sat[i].id,id,3)) return crx->sat+i;
+    }
+    if (crx->nsat>=MAXCRXSAT) return NULL;
+
+    i=crx->nsat++;
+    memset(crx->sat+i,0,sizeof(crxsat_t));
+    sprintf(crx->sat[i].id,"%.3s",id);
+    for (j=0;j<MAXOBSTYPE;j++) crx->sat[i].ord[j]=-1;
+    return crx->sat+i;
+}
+/* decode hatanaka header record ---------------------------------------------*/
+static int decode_crxh(unc_t *unc, char *buff)
+{
+    crx_t *crx=unc->crx;
+    char *label=buff+60;
+
+    if (strlen(buff)>60) {
+        if (strstr(label,"CRINEX VERS")) {
+            crx->ver=(int)str2num(buff,0,9);
+            return 1;
+        }
+        if (strstr(label,"CRINEX PROG")) return 1;
+
+        if (strstr(label,"# / TYPES OF OBSERV")&&buff[5]!=' ') {
+            crx->ntype['G']=(int)str2num(buff,0,6);
+        }
+        else if (strstr(label,"SYS / # / OBS TYPES")&&buff[0]!=' ') {
+            crx->ntype[buff[0]&0x7F]=(int)str2num(buff,3,3);
+        }
+        else if (strstr(label,"END OF HEADER")) {
+            crx->head=0;
+        }
+    }
+    return addline(unc,buff,(int)strlen(buff));
+}
+/* decode hatanaka epoch -------------------------------------------------------
+* decode a compressed epoch of hatanaka and add the rinex records to text
+*-----------------------------------------------------------------------------*/
+static int decode_crxe(unc_t *unc, char *buff)
+{
+    crx_t *crx=unc->crx;
+    crxsat_t *sat[MAXCRXSAT];
+    char line[MAXCRXLEN],str[MAXCRXLEN],*p,*q,id[4]="";
+    int i,j,k,n,nsat,ntype,flag,clk=0,v3=crx->ver>=3;
+    int iflag=v3?31:28,isat=v3?41:32;
+
+    /* recover epoch record */
+    if ((v3&&buff[0]=='>')||(!v3&&buff[0]=='&')) {
+        strncpy(line,buff,MAXCRXLEN-1); line[MAXCRXLEN-1]='\0';
+        if (!v3) line[0]=' ';
+        if ((p=strchr(line,'\n'))) *p='\0';
+    }
+    else {
+        strcpy(line,crx->epoch);
+        repairstr(line,buff,MAXCRXLEN);
+    }
+    flag=line[iflag]-'0';
+    nsat=(int)str2num(line,iflag+1,3);
+
+    /* special event records are copied */
+    if (2<=flag&&flag<=5) {
+        if (!addline(unc,line,(int)strlen(line))) return 0;
+        for (i=0;i<nsat;i++) {
+            if (!getsunc(unc,str,MAXCRXLEN)) return 0;
+            if (!addline(unc,str,(int)strlen(str))) return 0;
+        }
+        return 1;
+    }
+    strcpy(crx->epoch,line);
+    if (nsat<0||nsat>MAXCRXSAT||(int)strlen(line)<isat+nsat*3) {
+        trace(2,"hatanaka epoch error: %s\n",line);
+        return 0;
+    }
+    /* receiver clock offset */
+    if (!getsunc(unc,str,MAXCRXLEN)) return 0;
+    if ((p=strchr(str,'\n'))) *p='\0';
+    if (*str&&repairval(str,crx->clk,&crx->clkord,&crx->clkarc)) {
+        clk=1;
+    }
+    else crx->clkord=-1;
+
+    for (i=0;i<crx->nsat;i++) crx->sat[i].prev=0;
+
+    /* epoch record of rinex */
+    if (v3) {
+        n=sprintf(str,"%.35s",line);
+        if (clk) {
+            n+=sprintf(str+n,"%*s",41-n,"");
+            val2str(crx->clk[0],12,15,str+n);
+        }
+        if (!addline(unc,str,(int)strlen(str))) return 0;
+    }
+    else {
+        for (i=0;i==0||i<nsat;i+=12) {
+            n=i==0?sprintf(str,"%-32.32s",line):sprintf(str,"%32s","");
+            for (j=i;j<nsat&&j<i+12;j++) {
+                n+=sprintf(str+n,"%.3s",line+isat+j*3);
+            }
+            if (i==0&&clk) {
+                n+=sprintf(str+n,"%*s",68-n,"");
+                val2str(crx->clk[0],9,12,str+n);
+            }
+            if (!addline(unc,str,(int)strlen(str))) return 0;
+        }
+    }
+    /* obs data records */
+    for (i=0;i<nsat;i++) {
+        sprintf(id,"%.3s",line+isat+i*3);
+        if (!(sat[i]=crxsat(crx,id))) return 0;
+    }
+    for (i=0;i<nsat;i++) {
+        if (!getsunc(unc,buff,MAXCRXLEN)) return 0;
+        if ((p=strchr(buff,'\n'))) *p='\0';
+
+        ntype=crx->ntype[v3?(sat[i]->id[0]==' '?'G':sat[i]->id[0]&0x7F):'G'];
+        if (ntype>MAXOBSTYPE) ntype=MAXOBSTYPE;
+
+        for (j=0,p=buff;j<ntype;j++) {
+            if ((q=strchr(p,' '))) *q='\0';
+            if (!*p||!repairval(p,sat[i]->y[j],sat[i]->ord+j,sat[i]->arc+j)) {
+                sat[i]->ord[j]=-1;
+            }
+            p=q?q+1:p+strlen(p);
+        }
+        /* lli and signal strength flags */
+        if (!sat[i]->flag[0]) {
+            sprintf(sat[i]->flag,"%*s",ntype*2,"");
+        }
+        repairstr(sat[i]->flag,p,sizeof(sat[i]->flag));
+        for (k=(int)strlen(sat[i]->flag);k<ntype*2;k++) sat[i]->flag[k]=' ';
+        sat[i]->flag[ntype*2]='\0';
+        sat[i]->prev=1;
+
+        n=v3?sprintf(str,"%.3s",sat[i]->id):0;
+        for (j=0;j<ntype;j++) {
+            if (sat[i]->ord[j]>=0) val2str(sat[i]->y[j][0],3,14,str+n);
+            else sprintf(str+n,"%14s","");
+            str[n+14]=sat[i]->flag[j*2];
+            str[n+15]=sat[i]->flag[j*2+1];
+            str[n+=16]='\0';
+
+            if (!v3&&(j%5==4||j==ntype-1)) { /* ver.2 80 columns */
+                if (!addline(unc,str,n)) return 0;
+                n=0;
+            }
+        }
+        if (v3&&!addline(unc,str,n)) return 0;
+    }
+    /* satellites not in the epoch */
+    for (i=0;i<crx->nsat;i++) {
+        if (!crx->sat[i].prev) {
+            for (j=0;j<MAXOBSTYPE;j++) crx->sat[i].ord[j]=-1;
+            crx->sat[i].flag[0]='\0';
+        }
+    }
+    return 1;
+}
+/* fill decoded text of hatanaka ---------------------------------------------*/
+static int fillcrx(unc_t *unc)
+{
+    char buff[MAXCRXLEN];
+
+    unc->tp=unc->nt=0;
+
+    while (unc->nt<UNCBUFSIZ) {
+        if (!getsunc(unc,buff,MAXCRXLEN)) break;
+
+        if (unc->crx->head) {
+            if (!decode_crxh(unc,buff)) return 0;
+        }
+        else if (*buff&&*buff!='\n'&&!decode_crxe(unc,buff)) {
+            trace(2,"hatanaka decode error\n");
+            unc->stat=-1;
+            break;
+        }
+    }
+    return unc->nt>0;
+}
+/* read uncompressed data ----------------------------------------------------*/
+static int readunc(unc_t *unc, char *buff, int size)
+{
+    int n=0,m;
+
+    while (n<size) {
+        if (unc->crx) {
+            if (unc->tp>=unc->nt&&!fillcrx(unc)) break;
+            m=unc->nt-unc->tp<size-n?unc->nt-unc->tp:size-n;
+            memcpy(buff+n,unc->text+unc->tp,m);
+            unc->tp+=m;
+        }
+        else {
+            if (unc->op>=unc->no&&!fillunc(unc)) break;
+            m=unc->no-unc->op<size-n?unc->no-unc->op:size-n;
+            memcpy(buff+n,unc->obuf+unc->op,m);
+            unc->op+=m;
+        }
+        n+=m;
+    }
+    return n>0||unc->stat>=0?n:-1;
+}
+/* close uncompression stream ------------------------------------------------*/
+static void closeunc(unc_t *unc)
+{
+    if (!unc) return;
+    if (unc->fp) fclose(unc->fp);
+    free(unc->prefix);
+    free(unc->suffix);
+    free(unc->stack);
+    if (unc->crx) free(unc->crx->sat);
+    free(unc->crx);
+    free(unc->text);
+    free(unc);
+}
+/* open uncompression stream -------------------------------------------------*/
+static unc_t *openunc(const char *file, int zip, int crx)
+{
+    unc_t *unc;
+    char buff[MAXCRXLEN];
+    int c;
+
+    if (!(unc=(unc_t *)calloc(1,sizeof(unc_t)))) return NULL;
+
+    if (!(unc->fp=fopen(file,"rb"))) {
+        free(unc);
+        return NULL;
+    }
+    if (zip) {
+        c=getbyte(unc);
+        if (c==0x1F&&(c=getbyte(unc))==0x9D) { /* compress (lzw) */
+            if (!initlzw(unc)) {
+                closeunc(unc);
+                return NULL;
+            }
+        }
+        else { /* gzip or zip */
+            unc->ip=0;
+            if (readhead(unc)<=0) {
+                trace(2,"not in gzip format: %s\n",file);
+                closeunc(unc);
+                return NULL;
+            }
+        }
+    }
+    /* hatanaka compressed rinex */
+    if (crx) {
+        if (!getsunc(unc,buff,MAXCRXLEN)||!strstr(buff,"CRINEX VERS")) {
+            trace(2,"not in hatanaka format: %s\n",file);
+            closeunc(unc);
+            return NULL;
+        }
+        if (!(unc->crx=(crx_t *)calloc(1,sizeof(crx_t)))||
+            !(unc->crx->sat=(crxsat_t *)malloc(sizeof(crxsat_t)*MAXCRXSAT))) {
+            closeunc(unc);
+            return NULL;
+        }
+        unc->crx->head=1;
+        unc->crx->clkord=-1;
+        decode_crxh(unc,buff);
+    }
+    return unc;
+}
+#ifndef UNCTMPFILE
+/* cookie functions of uncompression stream ----------------------------------*/
+static ssize_t readcookie(void *cookie, char *buff, size_t size)
+{
+    return (ssize_t)readunc((unc_t *)cookie,buff,(int)size);
+}
+static int closecookie(void *cookie)
+{
+    closeunc((unc_t *)cookie);
+    return 0;
+}
+#endif
+/* compressed file type by extension -----------------------------------------*/
+static void unctype(const char *file, int *zip, int *crx, int *tar)
+{
+    const char *p,*q;
+
+    *zip=*crx=*tar=0;
+
+    if (!(p=strrchr(file,'.'))) return;
+
+    if (!strcmp(p,".z"  )||!strcmp(p,".Z"  )||
+        !strcmp(p,".gz" )||!strcmp(p,".GZ" )||
+        !strcmp(p,".zip")||!strcmp(p,".ZIP")) {
+        *zip=1;
+        for (q=p-1;q>file&&*q!='.';q--) ;
+        if (q<=file) return;
+        p=q;
+    }
+    if (!strncmp(p,".tar",4)) {
+        *tar=1;
+    }
+    else if (!strncmp(p,".crx",4)||!strncmp(p,".CRX",4)||
+             ((int)strspn(p+1,"0123456789")==2&&(p[3]=='d'||p[3]=='D'))) {
+        *crx=1;
+    }
+}
+/* copy file to anonymous tmpfile --------------------------------------------*/
+static FILE *copytmpfile(const char *file)
+{
+    FILE *ifp,*fp;
+    char buff[4096];
+    size_t n;
+
+    if (!(ifp=fopen(file,"rb"))) return NULL;
+
+    if ((fp=tmpfile())) {
+        while ((n=fread(buff,1,sizeof(buff),ifp))>0) fwrite(buff,1,n,fp);
+        rewind(fp);
+    }
+    fclose(ifp);
+    return fp;
+}
+/* open file with uncompression ------------------------------------------------
+* open file for reading with in-process uncompression of gzip (.gz,.z), zip
+* (.zip), compress (.Z) and hatanaka-compressed rinex (.??d,.crx)
+* args   : char   *file     I   file path
+*          int    *plain    O   plain original file opened (1:yes,0:no)
+*                               (NULL: not output)
+* return : file pointer (NULL:error)
+* notes  : the compression is recognized by the file extension. the file
+*          without the extensions is opened as a normal file and *plain is
+*          set to 1. only the plain file can be reopened by the file path.
+*          compressed files are decoded on the fly without external commands
+*          and temporary files. the returned stream is closed by fclose().
+*          on linux (glibc), the stream of a compressed file is not seekable.
+*          on windows and others, the data are uncompressed to an anonymous
+*          tmpfile(), which is seekable.
+*          tar files are extracted by uncompress() and copied to an anonymous
+*          tmpfile(). the extracted file is removed.
+*-----------------------------------------------------------------------------*/
+extern FILE *uncfopen(const char *file, int *plain)
+{
+    FILE *fp;
+    unc_t *unc;
+    char tfile[1024];
+    int zip,crx,tar;
+#ifdef UNCTMPFILE
+    char buff[UNCBUFSIZ];
+    int n;
+#else
+    cookie_io_functions_t func={readcookie,NULL,NULL,closecookie};
+#endif
+
+    trace(3,"uncfopen: file=%s\n",file);
+
+    unctype(file,&zip,&crx,&tar);
+
+    if (plain) *plain=!zip&&!crx&&!tar;
+
+    if (tar) { /* extract tar file to temporary file */
+        if (uncompress(file,tfile)<=0) return NULL;
+        fp=copytmpfile(tfile);
+        remove(tfile);
+        return fp;
+    }
+    if (!zip&&!crx) return fopen(file,"r");
+
+    if (!(unc=openunc(file,zip,crx))) return NULL;
+
+#ifdef UNCTMPFILE
+    if (!(fp=tmpfile())) {
+        closeunc(unc);
+        return NULL;
+    }
+    while ((n=readunc(unc,buff,UNCBUFSIZ))>0) {
+        fwrite(buff,1,n,fp);
+    }
+    closeunc(unc);
+    if (n<0) {
+        fclose(fp);
+        return NULL;
+    }
+    rewind(fp);
+#else
+    if (!(fp=fopencookie(unc,"r",func))) {
+        closeunc(unc);
+        return NULL;
+    }
+#endif
+    return fp;
+}
+/* uncompress file to output file ----------------------------------------------
+* uncompress gzip, zip, compress and hatanaka-compressed file to output file
+* args   : char   *file     I   input file
+*          char   *outfile  I   output file
+*          int    zip       I   uncompress gzip/zip/compress (0:no,1:yes)
+*          int    crx       I   uncompact hatanaka-compression (0:no,1:yes)
+* return : status (1:ok,0:error)
+*-----------------------------------------------------------------------------*/
+extern int uncompfile(const char *file, const char *outfile, int zip,
+                      int crx)
+{
+    FILE *fp;
+    unc_t *unc;
+    char buff[UNCBUFSIZ];
+    int n;
+
+    trace(3,"uncompfile: file=%s outfile=%s zip=%d crx=%d\n",file,outfile,
+          zip,crx);
+
+    if (!(unc=openunc(file,zip,crx))) return 0;
+
+    if (!(fp=fopen(outfile,"wb"))) {
+        closeunc(unc);
+        return 0;
+    }
+    while ((n=readunc(unc,buff,UNCBUFSIZ))>0) {
+        fwrite(buff,1,n,fp);
+    }
+    fclose(fp);
+    closeunc(unc);
+
+    if (n<0) {
+        remove(outfile);
+        return 0;
+    }
+    return 1;
+}